@@ -18,14 +18,26 @@ extern "C" {
 #include "task.h"
 #include "queue.h"
 #endif
+#include "ump_ring.h"
+
+/* Exported types ------------------------------------------------------------*/
+// Item of xUmpRxQueue
+typedef struct {
+  uint32_t ump[4];   // UMP message (unused words undefined)
+  TickType_t time;   // Tick it was queued at
+} UmpRxItem_t;
 
 /* Exported functions prototypes ---------------------------------------------*/
 void vMidi2UartToUmpTask(void *pvParameters);
 void vMidi2UmpToUartTask(void *pvParameters);
 BaseType_t MIDI2_InitQueues(void);
+void MIDI2_InvalidateDinCache(void);
+void MIDI2_NotifyDinOut(void);
 
 /* Exported variables --------------------------------------------------------*/
-extern QueueHandle_t xUmpTxQueue;
+extern UmpRing_t ump_tx_ring;     // Converted UMPs to USB
+extern UmpRing_t ump_tx_rt_ring;  // System Real-Time UMPs to USB, sent first
+extern UmpRing_t ump_rx_rt_ring;  // System Real-Time UMPs to DIN, taken first
 extern QueueHandle_t xUmpRxQueue;
 
 #ifdef __cplusplus
@@ -0,0 +1,83 @@
+/**
+  * @file           : midi_cc_aggregator.h
+  * @brief          : RPN / NRPN and 14-bit CC aggregation for MIDI 1.0 to MIDI 2.0 upconversion
+  *
+  * MIDI 1.0 carries high-resolution controllers as several 7-bit CCs: an MSB /
+  * LSB pair (CC n and n+32), or an RPN / NRPN transaction (CC 101/100 or
+  * 99/98 selecting the parameter, CC 6/38 carrying the value). Converted one
+  * by one they reach the host as up to four MIDI 2.0 UMPs.
+  *
+  * The aggregator keeps per-channel state and emits one MIDI 2.0 Control
+  * Change, Registered Controller or Assignable Controller UMP (message type
+  * 0x4) with the combined value scaled to 32 bits. Data Increment / Decrement
+  * (CC 96 / 97) of a selected parameter become Relative Registered /
+  * Assignable Controller UMPs of one 14-bit step. An MSB waits up to
+  * MIDI_UMP_CC_HOLD_OFF_US for its LSB; after that it is sent alone. Only
+  * controllers that have been seen with an LSB before are held, so 7-bit
+  * controllers are never delayed.
+  *
+  * Any other channel message flushes the held values of its channel first,
+  * so the order of messages on a channel is kept. Messages of other channels
+  * may pass a held value, as channels are independent. System Common and
+  * SysEx are not: the caller sends MIDI_CcAggregator_FlushAll output first.
+  *
+  * A held value keeps the JR Timestamp of its event. Each output message is
+  * preceded by its own JR Timestamp UMP when it has one, so a value sent
+  * later still carries its capture time and not that of a later event.
+  */
+
+#ifndef __MIDI_CC_AGGREGATOR_H__
+#define __MIDI_CC_AGGREGATOR_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+// Most UMP words one call can produce (two flushed holds + one new message,
+// each with its JR Timestamp)
+#define MIDI_CC_AGGREGATOR_MAX_WORDS 9
+
+/* Exported types ------------------------------------------------------------*/
+// Controller state of one channel
+typedef struct {
+  uint32_t lsb_seen;       // Bit n: CC n (0-31) has been followed by its LSB
+  uint32_t held_cc_time;   // Arrival time of the held CC MSB
+  uint32_t data_time;      // Arrival time of the held RPN / NRPN data MSB
+  uint32_t held_cc_stamp;  // JR Timestamp UMP of the held CC MSB (0: none)
+  uint32_t data_stamp;     // JR Timestamp UMP of the held data MSB (0: none)
+  uint8_t msb[32];         // Last MSB per controller 0-31 (0xFF: unknown)
+  uint8_t held_cc;         // Controller whose MSB waits for its LSB (0xFF: none)
+  uint8_t param_status;    // 0x2 RPN, 0x3 NRPN (MIDI 2.0 status), 0: none selected
+  uint8_t param_msb;       // CC 101 / 99 (0xFF: unknown)
+  uint8_t param_lsb;       // CC 100 / 98 (0xFF: unknown)
+  uint8_t data_msb;        // Last CC 6 value (0xFF: unknown)
+  bool data_held;          // data_msb waits for CC 38
+} MidiCcChannel_t;
+
+typedef struct {
+  MidiCcChannel_t channels[16];
+  uint32_t hold_off_us;    // Longest wait for an LSB
+  uint32_t merged;         // CCs folded into another UMP (caller may read and clear)
+  uint8_t group;           // UMP group of the output
+} MidiCcAggregator_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_CcAggregator_Init(MidiCcAggregator_t *aggregator, uint32_t hold_off_us, uint8_t group);
+uint32_t MIDI_CcAggregator_Process(MidiCcAggregator_t *aggregator, uint32_t event, uint32_t now,
+                                   uint32_t stamp, uint32_t *ump, bool *pass);
+uint32_t MIDI_CcAggregator_Flush(MidiCcAggregator_t *aggregator, uint32_t now, uint32_t *ump,
+                                 uint32_t max_words);
+uint32_t MIDI_CcAggregator_FlushAll(MidiCcAggregator_t *aggregator, uint32_t *ump, uint32_t max_words);
+bool MIDI_CcAggregator_IsHolding(const MidiCcAggregator_t *aggregator);
+uint32_t MIDI_CcAggregator_ScaleUp(uint32_t value, uint8_t source_bits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_CC_AGGREGATOR_H__ */
@@ -0,0 +1,46 @@
+/**
+  * @file           : midi_clock.h
+  * @brief          : Recovered Timing Clock output from TIM2 alarms
+  *
+  * Timing Clock and Start / Continue / Stop forwarded to DIN, and to USB in
+  * MIDI 2.0 mode, pass through a clock PLL (midi_clock_pll.h) instead of the
+  * normal queues. Each path sends its messages from a TIM2 compare
+  * interrupt at the smoothed times, so the output no longer carries the USB
+  * frame bunching or the task scheduling of the input. With MIDI_CLOCK_PLL
+  * set to 0 they are left to the callers and forwarded as they arrive.
+  *
+  * After a Flex Data Set Tempo from the host, DIN Timing Clock comes from a
+  * clock generator (midi_clock_gen.h) on the same alarm instead, until the
+  * host sends Timing Clock after Stop or the USB device is (un)mounted.
+  */
+
+#ifndef __MIDI_CLOCK_H__
+#define __MIDI_CLOCK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported types ------------------------------------------------------------*/
+// Clock recovery paths (index of the MIDIStats_t clock jitter fields)
+typedef enum {
+  MIDI_CLOCK_PATH_DIN = 0,  // USB OUT to DIN OUT
+  MIDI_CLOCK_PATH_USB,      // DIN IN to USB IN (MIDI 2.0 mode)
+} MidiClockPath_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_Clock_Init(void);
+void MIDI_Clock_Reset(void);
+bool MIDI_Clock_ToDin(uint8_t status, uint32_t time);
+bool MIDI_Clock_UmpToDin(const uint32_t *ump, uint32_t time);
+bool MIDI_Clock_ToUsb(uint8_t status, uint32_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_CLOCK_H__ */
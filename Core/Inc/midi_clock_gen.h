@@ -0,0 +1,58 @@
+/**
+  * @file           : midi_clock_gen.h
+  * @brief          : 24 PPQN Timing Clock generator driven by Set Tempo
+  *
+  * Once the host has sent a Flex Data Set Tempo, the device is the clock
+  * master of the DIN port: Timing Clock runs at that tempo, and Start /
+  * Continue / Stop are sent ahead of the next clock. Start also restarts the
+  * beat, so the first clock after it is beat one. A host Timing Clock after
+  * Stop hands the clock back to the host (see MIDI_ClockGen_HostClock).
+  *
+  * The beat length is kept in the 10 ns unit of Set Tempo and each clock
+  * time is derived from the beat start, so rounding to the microsecond
+  * timer never accumulates. A tempo change takes effect at the next beat
+  * boundary.
+  */
+
+#ifndef __MIDI_CLOCK_GEN_H__
+#define __MIDI_CLOCK_GEN_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_CLOCK_GEN_PPQN 24U
+#define MIDI_CLOCK_GEN_MIN_TEMPO 2400000U    // 10 ns units per quarter: 1 ms clocks (2500 BPM)
+#define MIDI_CLOCK_GEN_MAX_TEMPO 300000000U  // 125 ms clocks (20 BPM)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  uint32_t tempo;          // Current quarter note length (10 ns units, 0: no tempo yet)
+  uint32_t next_tempo;     // Tempo for the next beat
+  uint32_t beat_time;      // Time of the first clock of the current beat
+  uint8_t beat_frac;       // Remainder of beat_time (10 ns units, 0-99)
+  uint8_t tick;            // Next clock within the beat (0-23)
+  uint32_t transport_time; // Time the transport message was given
+  uint8_t transport;       // FA, FB or FC to send before the next clock (0: none)
+  bool stopped;            // Stop was the last transport message
+} MidiClockGen_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_ClockGen_Init(MidiClockGen_t *gen);
+bool MIDI_ClockGen_SetTempo(MidiClockGen_t *gen, uint32_t tempo, uint32_t now);
+void MIDI_ClockGen_Transport(MidiClockGen_t *gen, uint8_t status, uint32_t now);
+bool MIDI_ClockGen_IsActive(const MidiClockGen_t *gen);
+bool MIDI_ClockGen_HostClock(MidiClockGen_t *gen);
+bool MIDI_ClockGen_NextTime(const MidiClockGen_t *gen, uint32_t *time);
+bool MIDI_ClockGen_Pop(MidiClockGen_t *gen, uint32_t now, uint8_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_CLOCK_GEN_H__ */
@@ -0,0 +1,73 @@
+/**
+  * @file           : midi_clock_pll.h
+  * @brief          : Timing Clock recovery with a software PLL
+  *
+  * Timing Clock (F8) that crossed USB arrives in bunches per frame, and DIN
+  * input is seen only when the receive path polls it. The PLL tracks the
+  * clock period and phase with an alpha-beta filter (phase gain 1/4, period
+  * gain 1/8) and schedules each clock at its smoothed time plus a fixed
+  * delay, so the output runs at the smoothed rate while every input clock
+  * still yields exactly one output clock.
+  *
+  * Start, Continue and Stop take the same delay, so they keep their place
+  * between the clocks. After Start or Continue the next clock re-anchors the
+  * phase while the tempo estimate is kept. A clock that misses its
+  * prediction by more than half a period (tempo jump) or follows a gap
+  * re-locks at once.
+  *
+  * Jitter is reported as a running mean (1/16 weight per clock) of the input
+  * deviation from the prediction and of the output interval deviation from
+  * the period.
+  */
+
+#ifndef __MIDI_CLOCK_PLL_H__
+#define __MIDI_CLOCK_PLL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_CLOCK_PLL_QUEUE_SIZE 16          // Messages waiting for output (must be a power of two)
+#define MIDI_CLOCK_PLL_MIN_PERIOD_US 2000U    // 24 PPQN at 1250 BPM
+#define MIDI_CLOCK_PLL_MAX_PERIOD_US 125000U  // 24 PPQN at 20 BPM
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  uint32_t time;           // Output time
+  uint8_t status;          // F8, FA, FB or FC
+} MidiClockPllEntry_t;
+
+typedef struct {
+  MidiClockPllEntry_t queue[MIDI_CLOCK_PLL_QUEUE_SIZE];
+  uint16_t head;           // Free-running write index
+  uint16_t tail;           // Free-running read index
+  uint32_t delay_us;       // Added to every output time
+  uint32_t period_us;      // Smoothed clock period (valid if locked)
+  uint32_t phase;          // Smoothed time of the last input clock (valid if locked)
+  uint32_t last_input;     // Arrival of the last input clock
+  uint32_t last_queued;    // Output time of the last queued message
+  uint32_t last_output;    // Time the last clock was sent
+  uint32_t in_jitter_q4;   // Mean input deviation (1/16 us)
+  uint32_t out_jitter_q4;  // Mean output interval deviation (1/16 us)
+  bool has_input;          // last_input is set
+  bool locked;             // period_us / phase are set
+  bool realign;            // The next clock re-anchors the phase
+  bool has_output;         // last_output is set
+} MidiClockPll_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_ClockPll_Init(MidiClockPll_t *pll, uint32_t delay_us);
+bool MIDI_ClockPll_Input(MidiClockPll_t *pll, uint8_t status, uint32_t time);
+bool MIDI_ClockPll_NextTime(const MidiClockPll_t *pll, uint32_t *time);
+bool MIDI_ClockPll_Pop(MidiClockPll_t *pll, uint32_t now, uint8_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_CLOCK_PLL_H__ */
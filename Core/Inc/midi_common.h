@@ -20,6 +20,7 @@ extern "C" {
 #include <main.h>
 #include "mock_freertos.h"
 #endif
+#include "midi_ring.h"
 
 /* Exported types ------------------------------------------------------------*/
 // Simple MIDI message structure
@@ -39,6 +40,15 @@ typedef struct {
     uint8_t length;   // Actual length of MIDI data (1-3 bytes)
 } MIDIPacket_t;
 
+// Resolution of the frame-relative arrival time histogram
+#define MIDI_FRAME_PHASE_BINS 8
+
+// DIN TX scheduler traffic classes (see midi_scheduler.h)
+#define MIDI_TX_CLASS_COUNT 4
+
+// Timing Clock recovery paths (see midi_clock.h)
+#define MIDI_CLOCK_PATH_COUNT 2
+
 // MIDI statistics structure for debugging
 typedef struct {
     uint32_t uart_rx_count;
@@ -50,6 +60,26 @@ typedef struct {
     uint32_t usb_errors;
     uint32_t dma_overruns;
     uint32_t queue_full_errors;
+    uint32_t usb_tx_retries;         // USB IN packets held back by a full TX FIFO / busy endpoint
+    uint32_t usb_sof_count;          // USB frames seen (SOF sync)
+    uint32_t din_rx_frame_phase[MIDI_FRAME_PHASE_BINS];  // DIN arrivals per 1/8 USB frame after SOF
+    uint32_t rt_in_latency_max_us;   // Worst DIN RX -> USB IN realtime latency
+    uint32_t rt_out_latency_max_us;  // Worst USB OUT (or release time) -> DIN TX realtime latency
+    uint32_t din_tx_status_saved;    // Status bytes left out by running status
+    uint32_t din_tx_drops[MIDI_TX_CLASS_COUNT];         // Messages dropped per DIN TX class
+    uint32_t din_tx_late[MIDI_TX_CLASS_COUNT];          // Messages sent after the latency bound
+    uint32_t din_tx_delay_max_us[MIDI_TX_CLASS_COUNT];  // Worst queueing delay per class
+    uint32_t din_tx_coalesced;       // Controller values replaced by a newer queued value
+    uint32_t din_tx_selectors_skipped;  // Bank / RPN / NRPN selector CCs the receiver already had
+    uint32_t din_tx_sched_late;      // Timestamped messages that arrived after their release time
+    uint32_t din_tx_dejitter_missed; // USB OUT transfers sent at once for lack of ring space (de-jitter)
+    uint32_t ump_cc_merged;          // MIDI 1.0 CCs folded into a MIDI 2.0 controller message
+    uint32_t clock_in_jitter_us[MIDI_CLOCK_PATH_COUNT];   // Mean Timing Clock input deviation per path
+    uint32_t clock_out_jitter_us[MIDI_CLOCK_PATH_COUNT];  // Mean recovered clock interval deviation per path
+    uint32_t evicted_uart_to_usb;    // Stale DIN IN events dropped on the way to USB
+    uint32_t evicted_usb_to_uart;    // Stale USB OUT events dropped on the way to DIN (MIDI 1.0 mode)
+    uint32_t evicted_ump_tx;         // Stale UMPs dropped on the way to USB
+    uint32_t evicted_ump_rx;         // Stale UMPs dropped on the way to DIN
 } MIDIStats_t;
 
 /* Exported constants --------------------------------------------------------*/
@@ -60,6 +90,44 @@ typedef struct {
 #define MIDI_FILTER_TIMING_CLOCK 0    // Set to 0 to pass through Timing Clock (0xF8)
 #define MIDI_AUTO_ACTIVE_SENSING 1    // Set to 0 to disable automatic Active Sensing transmission
 
+// USB IN scheduling
+#define MIDI_USB_SOF_SYNC 1           // Set to 0 to flush USB IN data on a deadline instead of once per USB frame
+#define MIDI_USB_SOF_FLUSH_LEAD_US 100  // Flush this long before the next SOF
+
+// DIN OUT encoding
+#define MIDI_DIN_RUNNING_STATUS 1       // Set to 0 to send every status byte
+#define MIDI_DIN_NOTE_OFF_AS_NOTE_ON 0  // Set to 1 to send Note Off as Note On velocity 0 (longer runs)
+
+// DIN OUT scheduling
+#define MIDI_DIN_TX_LATENCY_BOUND_US 10000  // Drop Note On / other channel messages that would wait longer
+#define MIDI_DIN_TX_REORDER_US 2000         // Send in arrival order until the oldest message waited this long
+#define MIDI_DIN_TX_STARVATION_US 30000     // A message waiting this long goes before higher classes
+#define MIDI_DIN_TX_COALESCE 1              // Set to 0 to send every queued controller value
+#define MIDI_DIN_TX_TIMESTAMPS 1            // Set to 0 to ignore JR Timestamps / Delta Clockstamps from the host
+#define MIDI_DIN_TX_LOOKAHEAD_US 2000       // Fixed delay of timestamped messages (covers USB frame bunching)
+#define MIDI_DIN_TX_DEJITTER_US 0           // MIDI 1.0 mode: constant USB OUT to DIN delay, events spread
+                                            // over their USB frame (0: send at once; 2000 suits most hosts).
+                                            // Start value; the host may change it (USB_CONFIG_DEJITTER)
+
+// DIN IN to MIDI 2.0 upconversion
+#define MIDI_UMP_CC_AGGREGATION 1    // Set to 0 to convert RPN / NRPN / 14-bit CCs one by one
+#define MIDI_UMP_CC_HOLD_OFF_US 3000 // Longest wait of an MSB for its LSB (about three CCs on the wire)
+#define MIDI_UMP_FUSED_CONVERTER 1   // Set to 0 to use the two-stage AM MIDI 2.0 Library converters
+#define MIDI_UMP_JR_CLOCK_INTERVAL_MS 200  // JR Clock period while the host has JR Timestamps enabled
+
+// Timing Clock recovery
+#define MIDI_CLOCK_PLL 1                // Set to 0 to forward Timing Clock as it arrives
+#define MIDI_CLOCK_PLL_DELAY_US 2000    // Fixed delay of recovered clocks (covers USB frame bunching)
+#define MIDI_CLOCK_GENERATOR 1          // Set to 0 to ignore Flex Data Set Tempo (no DIN clock master)
+
+// Stale event eviction: controllers, pressure, pitch bend, Timing Clock and
+// Active Sensing that waited longer than this in a queue are dropped; notes,
+// SysEx and transport are kept (0: no limit)
+#define MIDI_UART_TO_USB_MAX_AGE_MS 100  // DIN IN to USB rings
+#define MIDI_USB_TO_UART_MAX_AGE_MS 100  // USB OUT to DIN rings (MIDI 1.0 mode)
+#define MIDI_UMP_TX_MAX_AGE_MS 100       // UMP rings to USB
+#define MIDI_UMP_RX_MAX_AGE_MS 100       // UMP queue to DIN
+
 // LED control settings
 #define MIDI_RX_LED_MIN_ON_TIME_MS 1  // Minimum LED on time in milliseconds for RX visibility
 #define MIDI_TX_LED_MIN_ON_TIME_MS 1  // Minimum LED on time in milliseconds for TX visibility
@@ -113,8 +181,10 @@ typedef struct {
 #define USB_MIDI_CIN_1BYTE_DATA    0xF   // Single Byte
 
 /* Exported variables --------------------------------------------------------*/
-extern QueueHandle_t xUartToUsbQueue;  // UART RX -> USB TX
-extern QueueHandle_t xUsbToUartQueue;  // USB RX -> UART TX
+extern MidiRing_t uart_to_usb_ring;  // UART RX -> USB TX (USB-MIDI event words)
+extern MidiRing_t usb_to_uart_ring;  // USB RX -> UART TX (USB-MIDI event words)
+extern MidiRing_t uart_to_usb_rt_ring;  // UART RX -> USB TX, System Real-Time only
+extern MidiRing_t usb_to_uart_rt_ring;  // USB RX -> UART TX, System Real-Time only
 #ifndef TESTING
 extern UART_HandleTypeDef huart2;
 #endif
@@ -124,11 +194,6 @@ extern uint8_t dma_rx_buffer[DMA_RX_BUFFER_SIZE];
 extern volatile uint32_t dma_rx_head;  // DMA write position
 extern volatile uint32_t dma_rx_tail;  // Processing read position
 
-// MIDI parsing state
-extern volatile uint8_t midi_msg_buffer[3];
-extern volatile uint8_t midi_msg_index;
-extern volatile uint8_t midi_running_status;
-
 // MIDI statistics
 extern MIDIStats_t midi_stats;
 
@@ -138,7 +203,6 @@ extern SemaphoreHandle_t xLedMutex;
 /* Exported functions prototypes ---------------------------------------------*/
 BaseType_t MIDI_InitQueues(void);
 uint8_t MIDI_GetCIN(uint8_t status, uint8_t length);
-void MIDI_ResetRunningStatus(void);
 void MIDI_GetStatistics(MIDIStats_t* stats);
 uint8_t MIDI_GetLengthFromCIN(uint8_t cin);
 uint8_t MIDI_ToUsbPacket(const MIDIMessage_t* midi_msg, uint8_t* usb_packet, uint8_t cable);
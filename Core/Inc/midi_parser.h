@@ -0,0 +1,126 @@
+/**
+  * @file           : midi_parser.h
+  * @brief          : Table-driven MIDI 1.0 byte stream parser
+  *
+  * Converts spans of a MIDI 1.0 byte stream (e.g. a DIN port DMA ring) into
+  * 32-bit USB-MIDI event words. All parsing state lives in a MidiParser_t, so
+  * one instance can be used per port.
+  *
+  * Event word layout (little-endian, identical to a USB-MIDI event packet in memory):
+  *   bits  0- 3: Code Index Number (CIN)
+  *   bits  4- 7: Cable number
+  *   bits  8-15: MIDI byte 0 (status, or SysEx byte)
+  *   bits 16-23: MIDI byte 1
+  *   bits 24-31: MIDI byte 2
+  */
+
+#ifndef __MIDI_PARSER_H__
+#define __MIDI_PARSER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+// Maximum number of events a single input byte can produce
+// (aborted SysEx end + the single-byte message that aborted it)
+#define MIDI_PARSER_MAX_EVENTS_PER_BYTE 2
+
+// Status table entry layout: kind (bits 6-7), message length (bits 4-5), CIN (bits 0-3)
+#define MIDI_PARSER_KIND_MASK      0xC0
+#define MIDI_PARSER_KIND_DATA      0x00  // Data byte (0x00-0x7F)
+#define MIDI_PARSER_KIND_CHANNEL   0x40  // Channel Voice status, sets running status
+#define MIDI_PARSER_KIND_COMMON    0x80  // System Common / SysEx status, clears running status
+#define MIDI_PARSER_KIND_REALTIME  0xC0  // System Real-Time, may appear anywhere
+#define MIDI_PARSER_LENGTH_SHIFT   4
+#define MIDI_PARSER_LENGTH_MASK    0x30
+#define MIDI_PARSER_CIN_MASK       0x0F
+
+/* Exported macros -----------------------------------------------------------*/
+#define MIDI_EVENT_CIN(event)      ((uint8_t)((event) & 0x0F))
+#define MIDI_EVENT_BYTE(event, n)  ((uint8_t)((event) >> (8 * ((n) + 1))))  // MIDI byte n (0-2)
+#define MIDI_EVENT_IS_SYSEX(event) (MIDI_EVENT_CIN(event) >= 0x4 && MIDI_EVENT_CIN(event) <= 0x7)
+#define MIDI_EVENT_IS_REALTIME(event) \
+  ((MIDI_EVENT_CIN(event) == 0xF || MIDI_EVENT_CIN(event) == 0x5) && MIDI_EVENT_BYTE(event, 0) >= 0xF8)
+
+// Controllers that only carry a value, so a newer one makes an older one
+// redundant. Bank Select (0 / 32), Data Entry (6 / 38), the switches 64-69
+// (Sustain to Hold 2), Data Increment / Decrement and NRPN / RPN select
+// (96-101) and channel mode messages (120-127) depend on their order.
+#define MIDI_CC_IS_VALUE(controller) \
+  ((controller) != 0 && (controller) != 6 && (controller) != 32 && (controller) != 38 && \
+   ((controller) < 64 || (controller) > 69) && ((controller) < 96 || (controller) > 101) && \
+   (controller) < 120)
+
+// Channel messages that only carry a value: the controllers above, pressure
+// and pitch bend
+#define MIDI_EVENT_IS_VALUE(event) \
+  ((MIDI_EVENT_CIN(event) == 0xB && MIDI_CC_IS_VALUE(MIDI_EVENT_BYTE(event, 1))) || \
+   MIDI_EVENT_CIN(event) == 0xA || MIDI_EVENT_CIN(event) == 0xD || MIDI_EVENT_CIN(event) == 0xE)
+
+// Events a queue may drop once they are stale: value messages (a late value is
+// worse than a missing one), Timing Clock and Active Sensing. Notes, program
+// changes, selectors, switches, SysEx, transport and CIN 0x0 markers stay.
+#define MIDI_EVENT_IS_EVICTABLE(event) \
+  (MIDI_EVENT_IS_VALUE(event) || \
+   (MIDI_EVENT_IS_REALTIME(event) && \
+    (MIDI_EVENT_BYTE(event, 0) == 0xF8 || MIDI_EVENT_BYTE(event, 0) == 0xFE)))
+
+// Capture time marker placed ahead of a DIN input event while UMP Jitter
+// Reduction is on. The parser never produces CIN 0x0; bytes 1-2 hold the JR time.
+#define MIDI_EVENT_TIMESTAMP(jr_time)  ((uint32_t)(uint16_t)(jr_time) << 16)
+#define MIDI_EVENT_IS_TIMESTAMP(event) (MIDI_EVENT_CIN(event) == 0x0)
+#define MIDI_EVENT_JR_TIME(event)      ((uint16_t)((event) >> 16))
+#define MIDI_EVENT_IS_CAPTURE_TIME(event) \
+  (MIDI_EVENT_IS_TIMESTAMP(event) && MIDI_EVENT_BYTE(event, 0) == 0)  // Not a release marker
+
+// Release marker placed ahead of the data events of one USB OUT transfer in
+// de-jitter mode (same CIN 0x0 form): bytes 1-2 hold the release time of the
+// first event (low 16 bits, microseconds), byte 0 the number of events spread
+// over one USB frame.
+#define MIDI_EVENT_RELEASE(time, count) \
+  (MIDI_EVENT_TIMESTAMP(time) | ((uint32_t)(uint8_t)(count) << 8))
+#define MIDI_EVENT_RELEASE_TIME(event)  ((uint16_t)((event) >> 16))
+#define MIDI_EVENT_RELEASE_COUNT(event) MIDI_EVENT_BYTE(event, 0)
+
+// Build an event word from / write it to a 4-byte USB-MIDI event packet
+#define MIDI_EVENT_FROM_PACKET(p) \
+  ((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8) | ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+#define MIDI_EVENT_TO_PACKET(event, p) do { \
+    (p)[0] = (uint8_t)(event); (p)[1] = (uint8_t)((event) >> 8); \
+    (p)[2] = (uint8_t)((event) >> 16); (p)[3] = (uint8_t)((event) >> 24); \
+  } while (0)
+
+/* Exported types ------------------------------------------------------------*/
+// Parser state for one MIDI 1.0 input port
+typedef struct {
+  uint32_t word;             // Event word being assembled
+  uint32_t running_word;     // Header + status of the running status message (0 if none)
+  uint32_t errors;           // Aborted SysEx messages (caller may read and clear)
+  uint8_t shift;             // Bit position of the next byte in word
+  uint8_t remaining;         // Data bytes still needed to complete word
+  uint8_t running_remaining; // Data bytes needed by a running status message
+  uint8_t cable;             // Cable number placed in every event
+  bool in_sysex;             // Currently inside a SysEx message
+} MidiParser_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern const uint8_t midi_parser_table[256];
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_Parser_Init(MidiParser_t *parser, uint8_t cable);
+void MIDI_Parser_Reset(MidiParser_t *parser);
+size_t MIDI_Parser_Process(MidiParser_t *parser, const uint8_t *data, size_t length,
+                           uint32_t *events, size_t max_events, size_t *event_count);
+uint8_t MIDI_Parser_EventLength(uint32_t event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_PARSER_H__ */
@@ -0,0 +1,54 @@
+/**
+  * @file           : midi_ring.h
+  * @brief          : Lock-free single-producer/single-consumer MIDI event ring
+  *
+  * Carries pre-encoded 32-bit USB-MIDI event words (see midi_parser.h) between
+  * exactly one producer task and one consumer task. Push and pop never enter a
+  * critical section; the consumer is woken with a direct task notification.
+  * Each event keeps the tick it was pushed at, so the consumer can drop
+  * droppable events that waited too long (MIDI_Ring_PopFresh).
+  */
+
+#ifndef __MIDI_RING_H__
+#define __MIDI_RING_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#ifndef TESTING
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include "mock_freertos.h"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_RING_SIZE 64  // Events per ring (must be a power of two)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  uint32_t events[MIDI_RING_SIZE];
+  TickType_t times[MIDI_RING_SIZE];  // Tick each event was pushed at
+  volatile uint32_t head;       // Free-running write counter (producer only)
+  volatile uint32_t tail;       // Free-running read counter (consumer only)
+  TaskHandle_t consumer;        // Task notified when events are pushed
+} MidiRing_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_Ring_Init(MidiRing_t *ring);
+void MIDI_Ring_SetConsumer(MidiRing_t *ring, TaskHandle_t task);
+uint32_t MIDI_Ring_Push(MidiRing_t *ring, const uint32_t *events, uint32_t count);
+uint32_t MIDI_Ring_PushWait(MidiRing_t *ring, const uint32_t *events, uint32_t count, TickType_t timeout);
+uint32_t MIDI_Ring_Pop(MidiRing_t *ring, uint32_t *events, uint32_t max_count);
+uint32_t MIDI_Ring_PopFresh(MidiRing_t *ring, uint32_t *events, uint32_t max_count,
+                            TickType_t max_age, uint32_t *evicted);
+uint32_t MIDI_Ring_Count(const MidiRing_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_RING_H__ */
@@ -0,0 +1,46 @@
+/**
+  * @file           : midi_running_status.h
+  * @brief          : MIDI 1.0 running status encoder for DIN OUT
+  *
+  * Leaves out Channel Voice status bytes that repeat the status already in
+  * effect on the wire. System Common and SysEx messages clear running status;
+  * System Real-Time bytes may appear anywhere and leave it unchanged.
+  *
+  * Optionally, Note Off is sent as Note On with velocity 0, so note streams
+  * keep a single status. The release velocity is lost in that mode.
+  */
+
+#ifndef __MIDI_RUNNING_STATUS_H__
+#define __MIDI_RUNNING_STATUS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Exported types ------------------------------------------------------------*/
+// Encoder state for one MIDI 1.0 output port
+typedef struct {
+  uint8_t status;         // Running status on the wire (0 if none)
+  uint8_t data_length;    // Data bytes per message of the current status
+  uint8_t data_index;     // Position of the next data byte in its message
+  bool note_off_as_on;    // Send Note Off as Note On with velocity 0
+  bool clear_velocity;    // Current message is a converted Note Off
+} MidiRunningStatus_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_RunningStatus_Init(MidiRunningStatus_t *encoder, bool note_off_as_on);
+void MIDI_RunningStatus_Reset(MidiRunningStatus_t *encoder);
+bool MIDI_RunningStatus_Next(MidiRunningStatus_t *encoder, uint8_t *byte);
+size_t MIDI_RunningStatus_Encode(MidiRunningStatus_t *encoder, const uint8_t *data,
+                                 size_t length, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_RUNNING_STATUS_H__ */
@@ -0,0 +1,91 @@
+/**
+  * @file           : midi_scheduler.h
+  * @brief          : Bandwidth-aware priority scheduler for DIN MIDI OUT
+  *
+  * USB can deliver far more than the 3125 bytes/s a DIN port carries. Events
+  * wait here in one queue per traffic class until the wire has room:
+  *   - Realtime: always sent first, never reordered against each other
+  *   - Note:     Note On / Note Off
+  *   - Voice:    other Channel Voice messages and System Common
+  *   - SysEx:    SysEx chunks, never interrupted by non-realtime messages
+  *
+  * While the backlog is short, messages leave in arrival order. Once the oldest
+  * message has waited MIDI_DIN_TX_REORDER_US the classes are served by strict
+  * priority, except that a message waiting MIDI_DIN_TX_STARVATION_US goes
+  * first, and a note never passes a Program Change, Bank Select or other
+  * order-sensitive Voice message that arrived before it. Note On and
+  * continuous controller values whose estimated wire delay would exceed
+  * MIDI_DIN_TX_LATENCY_BOUND_US are dropped on arrival; Note Off,
+  * order-sensitive channel messages (Program Change, Bank Select, RPN/NRPN,
+  * switch controllers such as Sustain), System Common and SysEx are never
+  * dropped: when their queue is full MIDI_Scheduler_Push refuses them and the
+  * caller retries.
+  *
+  * With coalescing enabled, a continuous controller value (Pitch Bend,
+  * pressure, CCs other than switches and selectors) that is still queued is
+  * overwritten in place by a newer value for the same channel / controller /
+  * note, so a backed-up sweep sends its latest value instead of stale ones.
+  * Values never move past a message that arrived after them and is not
+  * coalesced (notes, Program Change, Bank Select, RPN/NRPN data entry,
+  * SysEx, ...).
+  */
+
+#ifndef __MIDI_SCHEDULER_H__
+#define __MIDI_SCHEDULER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_common.h"
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_SCHEDULER_QUEUE_SIZE 32  // Events per class (must be a power of two)
+#define MIDI_SCHEDULER_BYTE_US 320    // Wire time of one byte at 31250 baud (10 bits)
+
+/* Exported types ------------------------------------------------------------*/
+// Traffic classes, highest priority first (MIDI_TX_CLASS_COUNT in midi_common.h)
+typedef enum {
+  MIDI_TX_CLASS_REALTIME = 0,
+  MIDI_TX_CLASS_NOTE,
+  MIDI_TX_CLASS_VOICE,
+  MIDI_TX_CLASS_SYSEX
+} MidiTxClass_t;
+
+typedef struct {
+  uint32_t event;  // USB-MIDI event word
+  uint32_t time;   // Arrival time (MIDI_Time_Now() units)
+  uint32_t seq;    // Arrival order across classes
+} MidiSchedulerEntry_t;
+
+typedef struct {
+  MidiSchedulerEntry_t entries[MIDI_SCHEDULER_QUEUE_SIZE];
+  uint16_t head;   // Free-running write index
+  uint16_t tail;   // Free-running read index
+  uint16_t bytes;  // MIDI bytes queued
+} MidiSchedulerQueue_t;
+
+typedef struct {
+  MidiSchedulerQueue_t queues[MIDI_TX_CLASS_COUNT];
+  uint32_t next_seq;
+  uint32_t barrier_seq;  // Arrival order of the last message values must not pass
+  bool in_sysex;         // A SysEx message has started on the wire
+  bool coalesce;         // Latest-value-wins for queued controller values
+} MidiScheduler_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_Scheduler_Init(MidiScheduler_t *scheduler, bool coalesce);
+MidiTxClass_t MIDI_Scheduler_Classify(uint32_t event);
+bool MIDI_Scheduler_IsCoalescable(uint32_t event);
+bool MIDI_Scheduler_Push(MidiScheduler_t *scheduler, uint32_t event, uint32_t now, uint32_t wire_pending);
+bool MIDI_Scheduler_Peek(const MidiScheduler_t *scheduler, uint32_t now, uint32_t *event);
+bool MIDI_Scheduler_Pop(MidiScheduler_t *scheduler, uint32_t now, uint32_t *event);
+uint32_t MIDI_Scheduler_QueuedBytes(const MidiScheduler_t *scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_SCHEDULER_H__ */
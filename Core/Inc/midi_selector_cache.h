@@ -0,0 +1,51 @@
+/**
+  * @file           : midi_selector_cache.h
+  * @brief          : Per-channel Bank Select / RPN / NRPN selector cache for DIN OUT
+  *
+  * MIDI 2.0 Program Change (bank valid) and RPN/NRPN messages become full
+  * CC 0/32 + PC and CC 101/100 (99/98) + 6/38 sequences in MIDI 1.0. The
+  * cache remembers the bank and parameter selectors last written to the DIN
+  * port and leaves out selector CCs that would not change them, so an RPN
+  * sweep only sends its data entry bytes.
+  *
+  * Invalidate the cache whenever the receiver may have lost or reset its
+  * state: System Reset, UART errors, or a reconnect.
+  */
+
+#ifndef __MIDI_SELECTOR_CACHE_H__
+#define __MIDI_SELECTOR_CACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_SELECTOR_UNKNOWN 0xFF  // Selector value not known to be on the receiver
+
+/* Exported types ------------------------------------------------------------*/
+// Selector state of one channel as last written to the wire
+typedef struct {
+  uint8_t bank_msb;     // CC 0
+  uint8_t bank_lsb;     // CC 32
+  uint8_t param_type;   // MSB selector CC of the active parameter (101 RPN, 99 NRPN), or unknown
+  uint8_t param_msb;    // CC 101 / 99
+  uint8_t param_lsb;    // CC 100 / 98
+} MidiSelectorChannel_t;
+
+typedef struct {
+  MidiSelectorChannel_t channels[16];
+} MidiSelectorCache_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_SelectorCache_Invalidate(MidiSelectorCache_t *cache);
+bool MIDI_SelectorCache_Filter(MidiSelectorCache_t *cache, const uint8_t *data, uint8_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_SELECTOR_CACHE_H__ */
@@ -0,0 +1,84 @@
+/**
+  * @file           : midi_time.h
+  * @brief          : Microsecond timebase for MIDI timing measurements
+  */
+
+#ifndef __MIDI_TIME_H__
+#define __MIDI_TIME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#ifndef TESTING
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include <main.h>
+#include "mock_freertos.h"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_TIME_TIMER        TIM2        // 32-bit timer, free-running at 1 MHz
+#define MIDI_TIME_TICK_HZ      1000000U
+#define MIDI_TIME_IRQ_PRIORITY 6           // Below configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define MIDI_TIME_FRAME_US     1000U       // Full-speed USB frame period
+#define MIDI_TIME_DIN_BYTE_US  320U        // Wire time of one DIN byte (10 bits at 31250 baud)
+#define MIDI_TIME_JR_TICK_US   32U         // UMP Jitter Reduction clock period (1/31250 s)
+#define MIDI_TIME_SOF_IDLE_US  1000000U    // SOF interrupt is turned off after this long without frame timing use
+
+/* Exported macros -----------------------------------------------------------*/
+// 16-bit JR time of a MIDI_Time_Now() value (wraps every ~2.1 s)
+#define MIDI_TIME_TO_JR(time)  ((uint16_t)((time) / MIDI_TIME_JR_TICK_US))
+
+/* Exported types ------------------------------------------------------------*/
+// One-shot alarms, each on its own TIM2 compare channel
+typedef enum {
+  MIDI_TIME_ALARM_USB_FLUSH = 0,  // CH1: USB IN flush (one IN task runs per mode)
+  MIDI_TIME_ALARM_DIN_OUT,        // CH2: timed DIN OUT release (one OUT task runs per mode)
+  MIDI_TIME_ALARM_CLOCK_DIN,      // CH3: recovered Timing Clock to DIN (callback)
+  MIDI_TIME_ALARM_CLOCK_USB,      // CH4: recovered Timing Clock to USB (callback)
+  MIDI_TIME_ALARM_COUNT
+} MidiTimeAlarm_t;
+
+/**
+  * @brief  Alarm callback, run in the TIM2 interrupt
+  * @param  when: Time the alarm was set for; set to the next time to re-arm
+  * @param  pxHigherPriorityTaskWoken: Passed to the FromISR calls
+  * @retval true to re-arm at *when, false to stay disarmed
+  */
+typedef bool (*MidiTimeCallback_t)(uint32_t *when, BaseType_t *pxHigherPriorityTaskWoken);
+
+/**
+  * @brief  Turn the USB SOF interrupt on or off
+  * @param  enable: true to receive MIDI_Time_SofFromISR calls
+  * @param  in_isr: true when called from an interrupt
+  * @retval None
+  */
+typedef void (*MidiTimeSofControl_t)(bool enable, bool in_isr);
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_Time_Init(void);
+uint32_t MIDI_Time_Now(void);
+void MIDI_Time_SetAlarm(MidiTimeAlarm_t alarm, uint32_t when, TaskHandle_t task);
+void MIDI_Time_CancelAlarm(MidiTimeAlarm_t alarm);
+void MIDI_Time_SetCallback(MidiTimeAlarm_t alarm, MidiTimeCallback_t callback);
+void MIDI_Time_ArmCallback(MidiTimeAlarm_t alarm, uint32_t when);
+void MIDI_Time_IRQHandler(void);
+void MIDI_Time_SetSofControl(MidiTimeSofControl_t control);
+void MIDI_Time_SofFromISR(uint32_t frame_count);
+bool MIDI_Time_FramePhase(uint32_t time, uint32_t *phase_us);
+bool MIDI_Time_NextFrameFlush(uint32_t time, uint32_t lead_us, uint32_t *flush_time);
+uint32_t MIDI_Time_StampRealtime(uint32_t event, uint32_t time);
+uint32_t MIDI_Time_RealtimeStamp(uint32_t event);
+uint32_t MIDI_Time_Expand(uint16_t time);
+uint32_t MIDI_Time_UnstampRealtime(uint32_t event, uint32_t *latency_max_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_TIME_H__ */
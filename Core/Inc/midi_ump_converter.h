@@ -0,0 +1,76 @@
+/**
+  * @file           : midi_ump_converter.h
+  * @brief          : Single-pass MIDI 1.0 event to MIDI 2.0 Protocol UMP converter
+  *
+  * Converts the USB-MIDI event words of the DIN input parser straight to
+  * Universal MIDI Packets:
+  *   - Channel voice messages become MIDI 2.0 channel voice (message type 0x4)
+  *     with 7-bit values scaled through constant tables
+  *   - System Common becomes a System message (message type 0x1)
+  *   - SysEx is packed into 7-bit SysEx packets (message type 0x3, 6 bytes each)
+  *
+  * Bank Select MSB / LSB are kept per channel and sent with the next Program
+  * Change (bank valid option), as the MIDI 1.0 to 2.0 translation rules ask.
+  * RPN / NRPN and 14-bit controller pairs are combined before this stage (see
+  * midi_cc_aggregator.h); here they are converted one CC at a time.
+  *
+  * When the host selects the MIDI 1.0 Protocol, channel voice messages are
+  * wrapped unchanged in 32-bit MIDI 1.0 channel voice UMPs (message type 0x2)
+  * instead, and Bank Select passes through as ordinary controllers.
+  */
+
+#ifndef __MIDI_UMP_CONVERTER_H__
+#define __MIDI_UMP_CONVERTER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+// Most UMP words one event can produce (a full SysEx packet + the end packet)
+#define MIDI_UMP_CONVERTER_MAX_WORDS 4
+
+/* Exported macros -----------------------------------------------------------*/
+// Message type of a UMP from its first word
+#define MIDI_UMP_TYPE(word)  ((uint8_t)((word) >> 28))
+
+// 32-bit System message (message type 0x1)
+#define MIDI_UMP_SYSTEM(group, status, data1, data2) \
+  (0x10000000U | ((uint32_t)(group) << 24) | ((uint32_t)(status) << 16) | \
+   ((uint32_t)(data1) << 8) | (uint32_t)(data2))
+
+// JR Clock / JR Timestamp utility messages (message type 0x0), time in 32 us units
+#define MIDI_UMP_JR_CLOCK(jr_time)     (0x00100000U | (uint32_t)(uint16_t)(jr_time))
+#define MIDI_UMP_JR_TIMESTAMP(jr_time) (0x00200000U | (uint32_t)(uint16_t)(jr_time))
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  uint8_t sysex[6];          // SysEx bytes waiting for a full packet
+  uint8_t sysex_count;
+  bool in_sysex;             // Between F0 and F7
+  bool sysex_started;        // A Start packet was sent for the current SysEx
+  uint8_t bank_msb[16];      // Bank Select MSB per channel (0xFF: none)
+  uint8_t bank_lsb[16];      // Bank Select LSB per channel (0xFF: none)
+  uint8_t group;             // UMP group of the output
+  bool midi1_protocol;       // Channel voice as MIDI 1.0 Protocol (message type 0x2)
+} MidiUmpConverter_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern const uint16_t midi_ump_scale7to16[128];
+extern const uint32_t midi_ump_scale7to32[128];
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_UmpConverter_Init(MidiUmpConverter_t *converter, uint8_t group);
+void MIDI_UmpConverter_SetProtocol(MidiUmpConverter_t *converter, bool midi1_protocol);
+uint32_t MIDI_UmpConverter_Process(MidiUmpConverter_t *converter, uint32_t event, uint32_t *ump);
+uint32_t MIDI_UmpConverter_Scale14To32(uint16_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_UMP_CONVERTER_H__ */
@@ -0,0 +1,46 @@
+/**
+  * @file           : midi_ump_encoder.h
+  * @brief          : Direct UMP to MIDI 1.0 encoder for the DIN output
+  *
+  * Turns each complete UMP into MIDI 1.0 messages as USB-MIDI event words
+  * (see midi_parser.h), ready for the DIN TX scheduler:
+  *   - System messages (message type 0x1) and MIDI 1.0 channel voice (0x2)
+  *     are copied byte for byte
+  *   - 7-bit SysEx packets (0x3) become F0 ... F7 in 3-byte SysEx events
+  *   - MIDI 2.0 channel voice (0x4) is scaled down to 7 / 14 bits; Registered
+  *     and Assignable Controllers become RPN / NRPN sequences, Program Change
+  *     with the bank valid option is preceded by Bank Select
+  * Other message types have no MIDI 1.0 equivalent and are left out.
+  */
+
+#ifndef __MIDI_UMP_ENCODER_H__
+#define __MIDI_UMP_ENCODER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+// Most events one UMP can produce (an RPN / NRPN sequence, or F0 + 6 bytes + F7)
+#define MIDI_UMP_ENCODER_MAX_EVENTS 4
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  uint8_t sysex[3];          // SysEx bytes of the event being assembled
+  uint8_t sysex_count;
+  bool in_sysex;             // F0 sent, F7 not yet
+} MidiUmpEncoder_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_UmpEncoder_Init(MidiUmpEncoder_t *encoder);
+uint32_t MIDI_UmpEncoder_Process(MidiUmpEncoder_t *encoder, const uint32_t *ump, uint32_t *events);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_UMP_ENCODER_H__ */
@@ -0,0 +1,71 @@
+/**
+  * @file           : midi_ump_timeline.h
+  * @brief          : Timestamp-ordered UMP release for the DIN output
+  *
+  * The host may place UMP Utility messages (message type 0x0) in front of a
+  * message to say when it is meant to happen:
+  *   - JR Timestamp: sender time in 1/31250 s ticks. The offset to the local
+  *     clock is taken from the host's JR Clock messages (the one that arrived
+  *     with the least delay wins) or, without them, from the first timestamp.
+  *   - Delta Clockstamp: ticks since the previous message, in units set by
+  *     Delta Clockstamp Ticks Per Quarter Note and the tempo (120 BPM unless
+  *     set).
+  * Each timed message is released at its local time plus a fixed look-ahead,
+  * which absorbs the bunching of USB frames. Messages without a timestamp are
+  * due at once, but never overtake timed messages that are already due.
+  *
+  * A timed message whose release time has passed on arrival is late: it is
+  * counted and released at once. An offset that would make messages later
+  * than the look-ahead is resynchronized.
+  */
+
+#ifndef __MIDI_UMP_TIMELINE_H__
+#define __MIDI_UMP_TIMELINE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define MIDI_UMP_TIMELINE_SIZE 32                 // Messages held at once
+#define MIDI_UMP_TIMELINE_JR_TICK_US 32U          // JR clock period (1/31250 s)
+#define MIDI_UMP_TIMELINE_QUARTER_US 500000U      // Default tempo (120 BPM)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  uint32_t ump[4];
+  uint32_t time;           // Release time (caller's clock)
+} MidiUmpTimelineEntry_t;
+
+typedef struct {
+  MidiUmpTimelineEntry_t entries[MIDI_UMP_TIMELINE_SIZE];  // Ordered by release time
+  uint32_t count;
+  uint32_t lookahead_us;   // Added to every timestamp
+  uint32_t next_time;      // Release time of the next message (valid if next_timed)
+  uint32_t dc_time;        // Timeline position Delta Clockstamps count from
+  uint32_t quarter_us;     // Tempo for Delta Clockstamps
+  uint32_t late;           // Timed messages released late (caller may read and clear)
+  uint16_t jr_offset;      // Local minus sender JR time
+  uint16_t dc_tpq;         // Delta Clockstamp ticks per quarter note (0: unknown)
+  bool next_timed;         // A timestamp applies to the next message
+  bool jr_synced;          // jr_offset is set
+  bool jr_clock_seen;      // jr_offset follows the host's JR Clock
+  bool dc_valid;           // dc_time is set
+} MidiUmpTimeline_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void MIDI_UmpTimeline_Init(MidiUmpTimeline_t *timeline, uint32_t lookahead_us);
+bool MIDI_UmpTimeline_Push(MidiUmpTimeline_t *timeline, const uint32_t *ump, uint32_t now);
+bool MIDI_UmpTimeline_NextTime(const MidiUmpTimeline_t *timeline, uint32_t *time);
+const uint32_t *MIDI_UmpTimeline_Peek(const MidiUmpTimeline_t *timeline, uint32_t now);
+void MIDI_UmpTimeline_Pop(MidiUmpTimeline_t *timeline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MIDI_UMP_TIMELINE_H__ */
@@ -12,6 +12,7 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include <stdbool.h>
 #ifndef TESTING
 #include "FreeRTOS.h"
 #include "task.h"
@@ -25,27 +26,19 @@ extern "C" {
 #endif
 
 /* Exported constants --------------------------------------------------------*/
-#define UART_TX_BUFFER_SIZE 512     // Size for DMA TX buffer (enough for SysEx)
-#define UART_TX_QUEUE_LENGTH 32     // Number of TX buffer entries in queue
-
-/* Exported types ------------------------------------------------------------*/
-// UART TX buffer structure for DMA
-typedef struct {
-    uint8_t data[UART_TX_BUFFER_SIZE];
-    uint16_t length;
-    volatile uint8_t in_use;  // Flag to indicate buffer is being transmitted
-} UartTxBuffer_t;
-
-/* Exported variables --------------------------------------------------------*/
-extern SemaphoreHandle_t xUartTxCompleteSemaphore;  // Semaphore for TX completion
-extern volatile uint8_t uart_tx_dma_busy;           // DMA busy flag
+#define UART_RX_EVENT_BATCH_SIZE 16 // Parsed events buffered per parser call
+#define UART_RX_BACKLOG_SIZE 32     // Data events held while the UART->USB ring is full
+#define UART_TO_USB_BATCH_SIZE 16   // Events popped from the UART->USB ring at once
+#define USB_MIDI_TX_PACKET_SIZE 64  // USB MIDI bulk IN endpoint size (16 events)
+#define USB_TX_FLUSH_DEADLINE_US 250 // Longest time an event waits for a packet to fill
 
 /* Exported function prototypes ---------------------------------------------*/
 void vUartRxMidiTask(void *pvParameters);
 void vUartToUsbTask(void *pvParameters);
 void vUsbToUartTask(void *pvParameters);
-void UART_TX_DMA_Init(void);
-BaseType_t UART_TX_SendDMA(const uint8_t *data, uint16_t length);
+void UART_RX_NotifyFromISR(BaseType_t *pxHigherPriorityTaskWoken);
+void UART_RX_MarkFromISR(uint16_t position, bool idle);
+void UART_RX_ErrorFromISR(BaseType_t *pxHigherPriorityTaskWoken);
 
 #ifdef __cplusplus
 }
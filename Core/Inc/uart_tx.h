@@ -0,0 +1,45 @@
+/**
+  * @file           : uart_tx.h
+  * @brief          : DIN MIDI OUT byte ring with chained UART DMA transfers
+  *
+  * Producers append complete messages without waiting for the wire. The DMA
+  * transfer complete interrupt starts the next contiguous span of the ring at
+  * once, so bytes leave back to back at the full 31250 baud rate.
+  */
+
+#ifndef __UART_TX_H__
+#define __UART_TX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#ifndef TESTING
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include <main.h>
+#include "mock_freertos.h"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define UART_TX_RING_SIZE 512  // Bytes, must be a power of two (enough for SysEx chunks)
+#define UART_TX_LOW_WATER 4    // Bytes left queued when producers add more; keeps
+                               // the queue ahead of realtime bytes short (1.28 ms)
+
+/* Exported functions prototypes ---------------------------------------------*/
+void UART_TX_Init(void);
+BaseType_t UART_TX_Write(const uint8_t *data, uint16_t length);
+BaseType_t UART_TX_WriteFromISR(const uint8_t *data, uint16_t length);
+uint16_t UART_TX_Pending(void);
+BaseType_t UART_TX_WaitPending(uint16_t max_pending, TickType_t timeout);
+void UART_TX_CompleteFromISR(BaseType_t *pxHigherPriorityTaskWoken);
+void UART_TX_ErrorFromISR(BaseType_t *pxHigherPriorityTaskWoken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_TX_H__ */
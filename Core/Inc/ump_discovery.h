@@ -150,6 +150,11 @@ typedef uint32_t muid_t;
 // Initialization
 void UMP_Discovery_Init(void);
 
+// Protocol selected with Stream Configuration Requests
+uint8_t UMP_GetProtocol(void);
+bool UMP_GetTxJitterReduction(void);
+void UMP_ResetProtocol(void);
+
 // Process incoming UMP Stream messages
 void UMP_ProcessStreamMessage(uint32_t* ump_data, uint8_t word_count);
 void UMP_ProcessDataMessage(uint32_t* ump_data, uint8_t word_count);
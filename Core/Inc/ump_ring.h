@@ -0,0 +1,72 @@
+/**
+  * @file           : ump_ring.h
+  * @brief          : Variable-length UMP word ring
+  *
+  * Carries complete UMP messages packed word by word, so a 32-bit message
+  * takes one word instead of a 16-byte queue item. Several producers may
+  * write; a single consumer reads whole messages, as many as fit in the
+  * space it offers (e.g. one USB bulk packet). The consumer is woken with a
+  * direct task notification. Each message keeps the tick it was written at,
+  * so the consumer can drop droppable messages that waited too long.
+  */
+
+#ifndef __UMP_RING_H__
+#define __UMP_RING_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#ifndef TESTING
+#include "FreeRTOS.h"
+#include "task.h"
+#else
+#include "mock_freertos.h"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define UMP_RING_WORDS 64  // Words per ring (must be a power of two)
+
+/* Exported macros -----------------------------------------------------------*/
+// Number of words in the UMP message starting with first_word (UMP 1.1, all 16 types)
+#define UMP_WORD_COUNT(first_word) (ump_word_count[(first_word) >> 28])
+
+// JR Timestamp: capture time of the message that follows it
+#define UMP_IS_JR_TIMESTAMP(first_word) (((first_word) & 0xF0F00000U) == 0x00200000U)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  uint32_t words[UMP_RING_WORDS];
+  TickType_t times[UMP_RING_WORDS];  // Write tick, at the first word of each message
+  volatile uint32_t head;       // Free-running write counter
+  volatile uint32_t tail;       // Free-running read counter
+  TaskHandle_t consumer;        // Task notified when a message is written
+} UmpRing_t;
+
+/* Exported variables --------------------------------------------------------*/
+extern const uint8_t ump_word_count[16];
+
+/* Exported functions prototypes ---------------------------------------------*/
+void UMP_Ring_Init(UmpRing_t *ring);
+void UMP_Ring_SetConsumer(UmpRing_t *ring, TaskHandle_t task);
+bool UMP_Ring_Write(UmpRing_t *ring, const uint32_t *ump);
+bool UMP_Ring_WriteStamped(UmpRing_t *ring, uint32_t stamp, const uint32_t *ump);
+bool UMP_Ring_WriteWait(UmpRing_t *ring, const uint32_t *ump, TickType_t timeout);
+bool UMP_Ring_WriteFromISR(UmpRing_t *ring, const uint32_t *ump, BaseType_t *pxHigherPriorityTaskWoken);
+bool UMP_Ring_WriteStampedFromISR(UmpRing_t *ring, uint32_t stamp, const uint32_t *ump,
+                                  BaseType_t *pxHigherPriorityTaskWoken);
+uint32_t UMP_Ring_Read(UmpRing_t *ring, uint32_t *words, uint32_t max_words, uint32_t *message_count);
+uint32_t UMP_Ring_ReadFresh(UmpRing_t *ring, uint32_t *words, uint32_t max_words, uint32_t *message_count,
+                            TickType_t max_age, uint32_t *evicted);
+void UMP_Ring_Clear(UmpRing_t *ring);
+uint32_t UMP_Ring_Count(const UmpRing_t *ring);
+bool UMP_IsEvictable(uint32_t first_word);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UMP_RING_H__ */
@@ -17,13 +17,24 @@ extern "C" {
 #include "task.h"
 #endif
 
+/* Exported constants --------------------------------------------------------*/
+#define UMP_TX_PACKET_WORDS 16  // Words per USB IN write (one 64-byte bulk packet)
+#define UMP_RX_BULK_WORDS 64    // Words read from the USB OUT FIFO at once
+
+/* Exported types ------------------------------------------------------------*/
+// Receives one complete UMP message (the words stay in the caller's buffer)
+typedef void (*UmpDispatch_t)(uint32_t *ump_data, uint8_t word_count);
+
 /* Exported functions prototypes ---------------------------------------------*/
 void vUmpToUsbTask(void *pvParameters);
 void vUsbToUmpTask(void *pvParameters);
+void UMP_RxNotify(void);
+uint32_t UMP_FrameMessages(uint32_t *words, uint32_t count, UmpDispatch_t dispatch);
 
 #ifdef TESTING
-// Expose GetUmpWordCount for testing
+// Expose GetUmpWordCount and DispatchUmp for testing
 uint8_t GetUmpWordCount(uint32_t first_word);
+void DispatchUmp(uint32_t *ump_data, uint8_t word_count);
 #endif
 
 #ifdef __cplusplus
@@ -21,6 +21,7 @@ void tud_suspend_cb(bool remote_wakeup_en);
 void tud_resume_cb(void);
 void tud_midi_mount_cb(uint8_t itf);
 void tud_midi_rx_cb(uint8_t itf);
+void tud_ump_rx_cb(uint8_t itf);
 
 #ifdef __cplusplus
 }
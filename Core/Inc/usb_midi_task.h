@@ -25,9 +25,32 @@ extern "C" {
 #include "midi_common.h"
 #endif
 
+/* Exported constants --------------------------------------------------------*/
+// DIN output is queued in short bursts picked by the DIN TX scheduler
+// (midi_scheduler.h), so realtime bytes can be slipped in between messages
+// (or SysEx chunks): a realtime byte waits at most for the UART_TX_LOW_WATER
+// bytes still queued (1.28 ms at 31250 baud)
+#define USB_TO_UART_BURST_BYTES 4     // Data bytes per DMA transfer (one message always fits)
+#define USB_TO_UART_RT_MAX 8          // Realtime bytes placed ahead of the data in one transfer
+#define USB_RX_BATCH_SIZE 32          // Events read from the MIDI OUT endpoint at once
+#define USB_DEJITTER_MAX_US 20000     // Longest de-jitter delay (16-bit stamps cover +/-32 ms)
+
+// Device configuration SysEx from the host (MIDI 1.0 mode). It is passed on
+// to DIN like any other SysEx; the converter acts on it as well:
+//   F0 7D <family LSB> <model LSB> 01 <delay ms> F7  set the de-jitter delay (0: off)
+#define USB_CONFIG_SYSEX_LENGTH 7
+#define USB_CONFIG_DEJITTER 0x01
+
+#if MIDI_DIN_TX_DEJITTER_US > USB_DEJITTER_MAX_US
+#error "MIDI_DIN_TX_DEJITTER_US must not exceed USB_DEJITTER_MAX_US"
+#endif
+
 /* Exported function prototypes ---------------------------------------------*/
 void vUsbRxMidiTask(void *pvParameters);
 void vUsbToUartTask(void *pvParameters);
+void USB_MIDI_RxNotify(void);
+void USB_MIDI_SetDejitterDelay(uint32_t delay_us);
+uint32_t USB_MIDI_GetDejitterDelay(void);
 
 #ifdef __cplusplus
 }
@@ -29,7 +29,10 @@
 #include "usb_device_task.h"
 #include "usb_midi_task.h"
 #include "uart_midi_task.h"
+#include "uart_tx.h"
 #include "midi_common.h"
+#include "midi_time.h"
+#include "midi_clock.h"
 #include "mode_manager.h"
 #include "midi2_task.h"
 #include "app_ump_device.h"
@@ -132,8 +135,14 @@ int main(void)
     Error_Handler();
   }
   
-  /* Initialize UART TX DMA */
-  UART_TX_DMA_Init();
+  /* Initialize UART TX ring */
+  UART_TX_Init();
+
+  /* Start the microsecond timebase used for MIDI timing statistics */
+  MIDI_Time_Init();
+
+  /* Timing Clock recovery sends from TIM2 alarms */
+  MIDI_Clock_Init();
 
   /* Initialize MIDI 2.0 system if in MIDI 2.0 mode */
   if (ModeManager_GetMode() == MIDI_MODE_2_0) {
@@ -299,7 +308,7 @@ static void MX_USB_OTG_FS_PCD_Init(void)
   hpcd_USB_OTG_FS.Init.speed = PCD_SPEED_FULL;
   hpcd_USB_OTG_FS.Init.dma_enable = DISABLE;
   hpcd_USB_OTG_FS.Init.phy_itface = PCD_PHY_EMBEDDED;
-  hpcd_USB_OTG_FS.Init.Sof_enable = DISABLE;
+  hpcd_USB_OTG_FS.Init.Sof_enable = ENABLE;
   hpcd_USB_OTG_FS.Init.low_power_enable = DISABLE;
   hpcd_USB_OTG_FS.Init.lpm_enable = DISABLE;
   hpcd_USB_OTG_FS.Init.vbus_sensing_enable = DISABLE;
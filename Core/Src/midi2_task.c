@@ -10,7 +10,18 @@
 #include "midi2_wrapper.h"
 #include "main.h"  // For LED pin definitions
 #include "ump_discovery.h"  // For Discovery Reply tracking
-#include "uart_midi_task.h"  // For UART_TX_SendDMA
+#include "uart_midi_task.h"  // For UART_TO_USB_BATCH_SIZE
+#include "uart_tx.h"
+#include "midi_parser.h"
+#include "midi_cc_aggregator.h"
+#include "midi_ump_converter.h"
+#include "midi_ump_encoder.h"
+#include "midi_scheduler.h"
+#include "midi_ump_timeline.h"
+#include "midi_selector_cache.h"
+#include "midi_time.h"
+#include "midi_clock.h"
+#include "usb_midi_task.h"  // For USB_TO_UART_BURST_BYTES
 #include <string.h>
 
 /* Private includes ----------------------------------------------------------*/
@@ -24,14 +35,50 @@
 // Global converter instances for 2-stage conversion
 static midi2_converter_handle_t g_bs_to_ump_converter = NULL;      // MIDI1.0 → UMP
 static midi2_converter_handle_t g_ump_to_midi2_converter = NULL;   // UMP → MIDI2.0
-static midi2_converter_handle_t g_ump_to_midi1_converter = NULL;   // UMP → MIDI1.0
+static MidiScheduler_t din_scheduler;  // DIN OUT traffic classes (UMP to UART task only)
+static MidiSelectorCache_t din_selectors;  // Bank / RPN / NRPN selectors on the DIN receiver
+static volatile bool din_selectors_stale = true;  // Set by MIDI2_InvalidateDinCache
+static uint32_t din_selector_losses = 0;  // UART errors + voice drops when the cache was last valid
+static MidiUmpEncoder_t din_encoder;      // UMP to DIN bytes (UMP to UART task only)
+static uint32_t din_held_events[MIDI_UMP_ENCODER_MAX_EVENTS];  // Events waiting for scheduler room
+static uint32_t din_held_count = 0;
+static uint32_t din_held_index = 0;
+static TaskHandle_t xUmpToUartTaskHandle = NULL;  // Notified by MIDI2_NotifyDinOut
+#if MIDI_DIN_TX_TIMESTAMPS
+static MidiUmpTimeline_t din_timeline;    // Timestamped UMPs waiting for their release time
+#endif
+#if MIDI_UMP_FUSED_CONVERTER
+static MidiUmpConverter_t ump_converter;  // MIDI 1.0 to MIDI 2.0 Protocol (UART to UMP task only)
+#endif
+static uint32_t jr_timestamp = 0;  // JR Timestamp UMP for the next converted message (0: none)
+#if MIDI_UMP_CC_AGGREGATION
+static MidiCcAggregator_t cc_aggregator;  // RPN / NRPN / 14-bit CC state (UART to UMP task only)
+#endif
 
 /* Exported variables --------------------------------------------------------*/
-QueueHandle_t xUmpTxQueue;
+UmpRing_t ump_tx_ring;
+UmpRing_t ump_tx_rt_ring;
+UmpRing_t ump_rx_rt_ring;
 QueueHandle_t xUmpRxQueue;
 
 /* Private function prototypes -----------------------------------------------*/
 static BaseType_t InitMIDI2Converters(void);
+static BaseType_t ReceiveDinUmp(uint32_t *ump_data, TickType_t wait);
+static BaseType_t TakeDinUmp(UmpRxItem_t *item, TickType_t wait);
+static bool TakeDinRealtime(UmpRxItem_t *item);
+static bool IsStaleDinUmp(const UmpRxItem_t *item);
+static void ConvertUmpToDin(const uint32_t *ump_data);
+#if MIDI_DIN_TX_TIMESTAMPS
+static void QueueTimedDinUmp(const uint32_t *ump_data);
+static void ReleaseDueDinUmps(void);
+#endif
+static bool QueueHeldDinEvents(void);
+static bool QueueDinEvent(uint32_t event);
+static bool SendDinBursts(void);
+static void SendUmp(const uint32_t *ump);
+#if MIDI_UMP_FUSED_CONVERTER || MIDI_UMP_CC_AGGREGATION
+static void SendUmps(const uint32_t *words, uint32_t count);
+#endif
 
 /* Public functions ----------------------------------------------------------*/
 
@@ -41,20 +88,18 @@ static BaseType_t InitMIDI2Converters(void);
   */
 BaseType_t MIDI2_InitQueues(void)
 {
-  xUmpTxQueue = xQueueCreate(UMP_QUEUE_LENGTH, sizeof(uint32_t) * 4);  // 4 words per UMP packet
-  if (xUmpTxQueue == NULL) {
-    return pdFAIL;
-  }
+  // UMPs to USB are packed word by word (consumer registers at task start)
+  UMP_Ring_Init(&ump_tx_ring);
+  UMP_Ring_Init(&ump_tx_rt_ring);
+  UMP_Ring_Init(&ump_rx_rt_ring);  // Realtime to DIN keeps its order on its own lane
   
-  xUmpRxQueue = xQueueCreate(UMP_QUEUE_LENGTH, sizeof(uint32_t) * 4);  // 4 words per UMP packet
+  xUmpRxQueue = xQueueCreate(UMP_QUEUE_LENGTH, sizeof(UmpRxItem_t));  // UMP packet and arrival tick
   if (xUmpRxQueue == NULL) {
-    vQueueDelete(xUmpTxQueue);
     return pdFAIL;
   }
   
   // Initialize converters
   if (InitMIDI2Converters() != pdPASS) {
-    vQueueDelete(xUmpTxQueue);
     vQueueDelete(xUmpRxQueue);
     return pdFAIL;
   }
@@ -63,7 +108,28 @@ BaseType_t MIDI2_InitQueues(void)
 }
 
 /**
-  * @brief  MIDI 2.0 Task: Convert UART MIDI 1.0 to UMP using AM MIDI 2.0 Library
+  * @brief  Make the UMP to DIN path resend Bank Select / RPN / NRPN selectors
+  * @note   Call when the DIN receiver may have lost its state (e.g. on reconnect)
+  * @retval None
+  */
+void MIDI2_InvalidateDinCache(void)
+{
+  din_selectors_stale = true;
+}
+
+/**
+  * @brief  Wake the UMP to UART task after a UMP was queued on xUmpRxQueue
+  * @retval None
+  */
+void MIDI2_NotifyDinOut(void)
+{
+  if (xUmpToUartTaskHandle != NULL) {
+    xTaskNotifyGive(xUmpToUartTaskHandle);
+  }
+}
+
+/**
+  * @brief  MIDI 2.0 Task: Convert UART MIDI 1.0 to UMP
   * @param  pvParameters: Task parameters
   * @retval None
   */
@@ -72,103 +138,197 @@ void vMidi2UartToUmpTask(void *pvParameters)
   /* Prevent unused parameter warning */
   (void)pvParameters;
   
-  MIDIPacket_t midi_packet;
+  uint32_t events[UART_TO_USB_BATCH_SIZE];
+#if MIDI_UMP_FUSED_CONVERTER
+  uint32_t conv_words[MIDI_UMP_CONVERTER_MAX_WORDS];
+  MIDI_UmpConverter_Init(&ump_converter, 0);
+#else
   uint32_t ump_data[4] = {0};  // UMP message buffer (up to 16 bytes)
+  uint8_t midi1_count = 0;     // Stage 1 words gathered in ump_data (MIDI 1.0 Protocol)
+#endif
+  
+  MIDI_Ring_SetConsumer(&uart_to_usb_ring, xTaskGetCurrentTaskHandle());
+  MIDI_Ring_SetConsumer(&uart_to_usb_rt_ring, xTaskGetCurrentTaskHandle());
+#if MIDI_UMP_CC_AGGREGATION
+  uint32_t agg_words[MIDI_CC_AGGREGATOR_MAX_WORDS];
+  MIDI_CcAggregator_Init(&cc_aggregator, MIDI_UMP_CC_HOLD_OFF_US, 0);
+#endif
+  
+  uint32_t jr_clock_time = MIDI_Time_Now();  // Last JR Clock sent
   
   for(;;)
   {
-    // Wait for MIDI 1.0 packet from UART
-    if (xQueueReceive(xUartToUsbQueue, &midi_packet, portMAX_DELAY) == pdTRUE) {
-
-      // Apply filters at UMP conversion stage (same as MIDI 1.0 mode)
-#if MIDI_FILTER_TIMING_CLOCK
-      if (midi_packet.length == 1 && midi_packet.data[0] == MIDI_TIMING_CLOCK) {
-        continue;  // Skip this message, immediately get next from queue
+    // Wait for MIDI 1.0 events from UART
+    bool jr = UMP_GetTxJitterReduction();
+    TickType_t wait = jr ? pdMS_TO_TICKS(MIDI_UMP_JR_CLOCK_INTERVAL_MS) : portMAX_DELAY;
+#if MIDI_UMP_CC_AGGREGATION
+    // A held MSB must go out once its hold-off time has passed
+    if (MIDI_CcAggregator_IsHolding(&cc_aggregator) &&
+        wait > pdMS_TO_TICKS(MIDI_UMP_CC_HOLD_OFF_US / 1000U) + 1U) {
+      wait = pdMS_TO_TICKS(MIDI_UMP_CC_HOLD_OFF_US / 1000U) + 1U;
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
+    uint32_t expired;
+    while ((expired = MIDI_CcAggregator_Flush(&cc_aggregator, MIDI_Time_Now(), agg_words,
+                                              MIDI_CC_AGGREGATOR_MAX_WORDS)) > 0) {
+      SendUmps(agg_words, expired);
+    }
+#else
+    ulTaskNotifyTake(pdTRUE, wait);
+#endif
+    
+    // With JR the host maps our clock to its own through periodic JR Clock
+    // messages; they go on the realtime lane so their time is not stale
+    jr = UMP_GetTxJitterReduction();
+    uint32_t now = MIDI_Time_Now();
+    if (jr && (now - jr_clock_time) >= MIDI_UMP_JR_CLOCK_INTERVAL_MS * 1000U) {
+      uint32_t jr_clock = MIDI_UMP_JR_CLOCK(MIDI_TIME_TO_JR(now));
+      if (UMP_Ring_Write(&ump_tx_rt_ring, &jr_clock)) {
+        jr_clock_time = now;
       }
+    }
+    
+    // The host may have selected the MIDI 1.0 Protocol: channel voice is then
+    // sent as 32-bit MIDI 1.0 UMPs without the MIDI 2.0 translation
+    bool midi1_protocol = (UMP_GetProtocol() == UMP_PROTOCOL_MIDI_1_0);
+#if MIDI_UMP_FUSED_CONVERTER
+    MIDI_UmpConverter_SetProtocol(&ump_converter, midi1_protocol);
+#else
+    if (!midi1_protocol) {
+      midi1_count = 0;
+    }
+#endif
+    
+    uint32_t count;
+    do {
+      // Realtime becomes a MT 0x1 System message directly and is queued ahead
+      // of converted data (it needs no converter state)
+      uint32_t rt_event;
+      while (MIDI_Ring_PopFresh(&uart_to_usb_rt_ring, &rt_event, 1, pdMS_TO_TICKS(MIDI_UART_TO_USB_MAX_AGE_MS),
+                                &midi_stats.evicted_uart_to_usb) == 1) {
+        uint32_t captured = MIDI_Time_RealtimeStamp(rt_event);
+        rt_event = MIDI_Time_UnstampRealtime(rt_event, &midi_stats.rt_in_latency_max_us);
+        uint8_t status = MIDI_EVENT_BYTE(rt_event, 0);
+        
+        // Apply filters at UMP conversion stage (same as MIDI 1.0 mode)
+#if MIDI_FILTER_TIMING_CLOCK
+        if (status == MIDI_TIMING_CLOCK) {
+          continue;
+        }
 #endif
-
 #if MIDI_FILTER_ACTIVE_SENSING
-      if (midi_packet.length == 1 && midi_packet.data[0] == MIDI_ACTIVE_SENSING) {
-        continue;  // Skip this message, immediately get next from queue
-      }
+        if (status == MIDI_ACTIVE_SENSING) {
+          continue;
+        }
 #endif
-
-      // Handle different MIDI message types based on reference implementation
-      if (midi_packet.length == 1) {
-        // Single-byte message (System Realtime like F8 Clock)
-        uint8_t midi_byte = midi_packet.data[0];
+        if (MIDI_Clock_ToUsb(status, captured)) {
+          continue;  // Clock and transport are sent by the clock PLL
+        }
+        uint32_t ump_rt = MIDI_UMP_SYSTEM(0, status, 0, 0);
+        uint32_t ump_jr = jr ? MIDI_UMP_JR_TIMESTAMP(MIDI_TIME_TO_JR(captured)) : 0;
+        if (!UMP_Ring_WriteStamped(&ump_tx_rt_ring, ump_jr, &ump_rt)) {
+          midi_stats.queue_full_errors++;
+        }
+      }
+      
+      count = MIDI_Ring_PopFresh(&uart_to_usb_ring, events, UART_TO_USB_BATCH_SIZE,
+                                 pdMS_TO_TICKS(MIDI_UART_TO_USB_MAX_AGE_MS), &midi_stats.evicted_uart_to_usb);
+      for (uint32_t e = 0; e < count; e++) {
+        uint32_t event = events[e];
         
-        // Check if it's a system realtime message (F8-FF)
-        if (midi_byte >= 0xF8) {
-          // Process system realtime message directly
-          midi2_bs_to_ump_process_byte(g_bs_to_ump_converter, midi_byte);
-          
-          // Process available UMP messages
-          while (midi2_bs_to_ump_available(g_bs_to_ump_converter)) {
-            uint32_t ump_midi1_word = midi2_bs_to_ump_read(g_bs_to_ump_converter);
-            
-            // Stage 2: Convert UMP (MIDI 1.0 Protocol) to UMP (MIDI 2.0 Protocol)  
-            midi2_ump_to_midi2_process(g_ump_to_midi2_converter, ump_midi1_word);
-            
-            // Process converted MIDI 2.0 UMP messages
-            uint8_t word_count = 0;
-            while (midi2_ump_to_midi2_available(g_ump_to_midi2_converter) && word_count < 4) {
-              ump_data[word_count] = midi2_ump_to_midi2_read(g_ump_to_midi2_converter);
-              word_count++;
-            }
-            
-            // Send MIDI 2.0 UMP message to USB if we have data
-            if (word_count > 0) {
-              // Clear unused words (but don't send them)
-              for (uint8_t j = word_count; j < 4; j++) {
-                ump_data[j] = 0;
-              }
-              
-              // Send UMP message to USB - queue will contain proper word count info
-              xQueueSend(xUmpTxQueue, ump_data, 0);
+        if (MIDI_EVENT_IS_TIMESTAMP(event)) {
+          // Capture time of the next event, sent ahead of its first UMP
+          jr_timestamp = MIDI_UMP_JR_TIMESTAMP(MIDI_EVENT_JR_TIME(event));
+          continue;
+        }
+
+#if MIDI_UMP_CC_AGGREGATION
+        // RPN / NRPN transactions and MSB / LSB pairs become single MIDI 2.0
+        // controller messages; everything else goes through the converter
+        bool pass = true;
+        if (!midi1_protocol) {
+          // The aggregator output carries its own stamps: a held value keeps
+          // the stamp of its event
+          uint32_t stamp = jr_timestamp;
+          jr_timestamp = 0;
+          if (MIDI_EVENT_BYTE(event, 0) >= MIDI_SYSEX_START) {
+            // System Common / SysEx must not overtake a held value of any channel
+            uint32_t held;
+            while ((held = MIDI_CcAggregator_FlushAll(&cc_aggregator, agg_words,
+                                                      MIDI_CC_AGGREGATOR_MAX_WORDS)) > 0) {
+              SendUmps(agg_words, held);
             }
           }
+          uint32_t agg_count = MIDI_CcAggregator_Process(&cc_aggregator, event, MIDI_Time_Now(),
+                                                         stamp, agg_words, &pass);
+          SendUmps(agg_words, agg_count);
+          midi_stats.ump_cc_merged += cc_aggregator.merged;
+          cc_aggregator.merged = 0;
+          jr_timestamp = pass ? stamp : 0;
         }
-      } else {
-        // Multi-byte message (Note On/Off, CC, Pitch Bend, etc.)
-        
+        if (!pass) {
+          continue;
+        }
+#endif
+
+#if MIDI_UMP_FUSED_CONVERTER
+        // Single pass from the parsed event to UMPs of the selected protocol
+        SendUmps(conv_words, MIDI_UmpConverter_Process(&ump_converter, event, conv_words));
+#else
+        // Feed every packet through the byte stream converter: channel
+        // messages, System Common and streamed SysEx chunks alike
+        // (a lone F7 or F6 must reach the converter too)
         // Stage 1: Convert MIDI 1.0 bytes to UMP (MIDI 1.0 Protocol)
-        for (uint8_t i = 0; i < midi_packet.length; i++) {
-          midi2_bs_to_ump_process_byte(g_bs_to_ump_converter, midi_packet.data[i]);
+        uint8_t length = MIDI_Parser_EventLength(event);
+        for (uint8_t i = 0; i < length; i++) {
+          midi2_bs_to_ump_process_byte(g_bs_to_ump_converter, MIDI_EVENT_BYTE(event, i));
         }
-        
+
         // Process available UMP messages and convert to MIDI 2.0
         while (midi2_bs_to_ump_available(g_bs_to_ump_converter)) {
           uint32_t ump_midi1_word = midi2_bs_to_ump_read(g_bs_to_ump_converter);
-          
+
+          if (midi1_protocol) {
+            // MIDI 1.0 Protocol: the stage 1 UMPs go out as they are
+            ump_data[midi1_count++] = ump_midi1_word;
+            if (midi1_count == UMP_WORD_COUNT(ump_data[0])) {
+              SendUmp(ump_data);
+              midi1_count = 0;
+            }
+            continue;
+          }
+
           // Stage 2: Convert UMP (MIDI 1.0 Protocol) to UMP (MIDI 2.0 Protocol)
           midi2_ump_to_midi2_process(g_ump_to_midi2_converter, ump_midi1_word);
-          
+
           // Process converted MIDI 2.0 UMP messages
           uint8_t word_count = 0;
           while (midi2_ump_to_midi2_available(g_ump_to_midi2_converter) && word_count < 4) {
             ump_data[word_count] = midi2_ump_to_midi2_read(g_ump_to_midi2_converter);
             word_count++;
           }
-          
+
           // Send MIDI 2.0 UMP message to USB if we have data
           if (word_count > 0) {
             // Clear unused words (but don't send them)
             for (uint8_t j = word_count; j < 4; j++) {
               ump_data[j] = 0;
             }
-            
-            // Send UMP message to USB - queue will contain proper word count info
-            xQueueSend(xUmpTxQueue, ump_data, 0);
+
+            // Send UMP message to USB - the ring takes the size from the message type
+            SendUmp(ump_data);
           }
         }
+#endif
+        // A stamp never outlives its event, even if it produced no UMP
+        jr_timestamp = 0;
       }
-    }
+    } while (count > 0);
   }
 }
 
 /**
-  * @brief  MIDI 2.0 Task: Convert UMP to UART MIDI 1.0 using AM MIDI 2.0 Library
+  * @brief  MIDI 2.0 Task: Convert UMP to UART MIDI 1.0
   * @param  pvParameters: Task parameters
   * @retval None
   */
@@ -184,6 +344,13 @@ void vMidi2UmpToUartTask(void *pvParameters)
   TickType_t lastActiveSensingTime = xTaskGetTickCount();  // Initialize for Active Sensing
   const TickType_t ACTIVE_SENSING_INTERVAL = pdMS_TO_TICKS(300);  // 300ms interval (MIDI standard)
   
+  MIDI_Scheduler_Init(&din_scheduler, MIDI_DIN_TX_COALESCE);
+  MIDI_UmpEncoder_Init(&din_encoder);
+#if MIDI_DIN_TX_TIMESTAMPS
+  MIDI_UmpTimeline_Init(&din_timeline, MIDI_DIN_TX_LOOKAHEAD_US);
+#endif
+  xUmpToUartTaskHandle = xTaskGetCurrentTaskHandle();
+  
   for(;;)
   {
     // Check if LED needs to be turned off
@@ -198,112 +365,41 @@ void vMidi2UmpToUartTask(void *pvParameters)
       }
     }
     
-    // Wait for UMP message from USB (with timeout for LED update)
-    if (xQueueReceive(xUmpRxQueue, ump_data, pdMS_TO_TICKS(10)) == pdTRUE) {
-      
-      // Process each UMP word through the converter
-      for (int i = 0; i < 4; i++) {
-        if (ump_data[i] != 0) {
-          midi2_ump_to_midi1_process(g_ump_to_midi1_converter, ump_data[i]);
-        }
-      }
-      
-      // Read resulting MIDI 1.0 bytes and assemble complete messages
-      static uint8_t midi_buffer[3];
-      static uint8_t midi_index = 0;
-      static uint8_t expected_length = 0;
-      
-      while (midi2_ump_to_midi1_available(g_ump_to_midi1_converter)) {
-        uint8_t midi_byte = midi2_ump_to_midi1_read(g_ump_to_midi1_converter);
-        
-        // Handle running status and message assembly
-        if (midi_byte & 0x80) {  // Status byte
-          // If we had an incomplete message, send what we have
-          if (midi_index > 0) {
-            midi_packet.length = midi_index;
-            memcpy(midi_packet.data, midi_buffer, midi_index);
-            
-            // Turn on LED before sending
-            if (xSemaphoreTake(xLedMutex, 0) == pdTRUE) {
-              HAL_GPIO_WritePin(TxMIDI_GPIO_Port, TxMIDI_Pin, GPIO_PIN_SET);
-              xSemaphoreGive(xLedMutex);
-            }
-            ledOnTime = xTaskGetTickCount();
-            
-            UART_TX_SendDMA(midi_packet.data, midi_packet.length);
-          }
-          
-          // Start new message
-          midi_buffer[0] = midi_byte;
-          midi_index = 1;
-          
-          // Determine expected message length
-          uint8_t status = midi_byte & 0xF0;
-          switch (status) {
-            case 0x80:  // Note Off
-            case 0x90:  // Note On
-            case 0xA0:  // Aftertouch
-            case 0xB0:  // Control Change
-            case 0xE0:  // Pitch Bend
-              expected_length = 3;
-              break;
-            case 0xC0:  // Program Change
-            case 0xD0:  // Channel Pressure
-              expected_length = 2;
-              break;
-            case 0xF0:  // System messages
-              if (midi_byte == 0xF0) {  // SysEx - handle separately
-                expected_length = 0;  // Variable length
-              } else if (midi_byte == 0xF1 || midi_byte == 0xF3) {
-                expected_length = 2;
-              } else if (midi_byte == 0xF2) {
-                expected_length = 3;
-              } else {
-                expected_length = 1;  // Real-time messages
-              }
-              break;
-            default:
-              expected_length = 1;
-              break;
-          }
-          
-          // Send immediately if single-byte message
-          if (expected_length == 1) {
-            midi_packet.data[0] = midi_byte;
-            midi_packet.length = 1;
-            
-            // Turn on LED before sending
-            if (xSemaphoreTake(xLedMutex, 0) == pdTRUE) {
-              HAL_GPIO_WritePin(TxMIDI_GPIO_Port, TxMIDI_Pin, GPIO_PIN_SET);
-              xSemaphoreGive(xLedMutex);
-            }
-            ledOnTime = xTaskGetTickCount();
-            
-            UART_TX_SendDMA(midi_packet.data, midi_packet.length);
-            midi_index = 0;
-          }
-        } else {  // Data byte
-          if (midi_index > 0 && midi_index < 3) {
-            midi_buffer[midi_index++] = midi_byte;
-            
-            // Check if message is complete
-            if (midi_index == expected_length) {
-              midi_packet.length = expected_length;
-              memcpy(midi_packet.data, midi_buffer, expected_length);
-              
-              // Turn on LED before sending
-              if (xSemaphoreTake(xLedMutex, 0) == pdTRUE) {
-                HAL_GPIO_WritePin(TxMIDI_GPIO_Port, TxMIDI_Pin, GPIO_PIN_SET);
-                xSemaphoreGive(xLedMutex);
-              }
-              ledOnTime = xTaskGetTickCount();
-              
-              UART_TX_SendDMA(midi_packet.data, midi_packet.length);
-              midi_index = 0;
-            }
-          }
-        }
+    // Wait for UMP message from USB (with timeout for LED update). While the
+    // scheduler holds a backlog, wake every tick to keep the wire busy.
+    TickType_t wait = (MIDI_Scheduler_QueuedBytes(&din_scheduler) > 0) ? 1 : pdMS_TO_TICKS(10);
+#if MIDI_DIN_TX_TIMESTAMPS
+    // Also wake at the next release time, to the microsecond
+    uint32_t release_time;
+    if (MIDI_UmpTimeline_NextTime(&din_timeline, &release_time)) {
+      MIDI_Time_SetAlarm(MIDI_TIME_ALARM_DIN_OUT, release_time, xUmpToUartTaskHandle);
+    }
+#endif
+    BaseType_t received = ReceiveDinUmp(ump_data, wait);
+    
+    // Convert everything that is queued, so the scheduler sees the whole
+    // backlog (and can coalesce controller sweeps) before choosing what to send
+    while (received == pdTRUE) {
+#if MIDI_DIN_TX_TIMESTAMPS
+      QueueTimedDinUmp(ump_data);
+#else
+      ConvertUmpToDin(ump_data);
+#endif
+      received = ReceiveDinUmp(ump_data, 0);
+    }
+#if MIDI_DIN_TX_TIMESTAMPS
+    MIDI_Time_CancelAlarm(MIDI_TIME_ALARM_DIN_OUT);
+    ReleaseDueDinUmps();
+#endif
+    
+    if (SendDinBursts()) {
+      // Turn on LED when sending
+      if (xSemaphoreTake(xLedMutex, 0) == pdTRUE) {
+        HAL_GPIO_WritePin(TxMIDI_GPIO_Port, TxMIDI_Pin, GPIO_PIN_SET);
+        xSemaphoreGive(xLedMutex);
       }
+      ledOnTime = xTaskGetTickCount();
+      lastActiveSensingTime = ledOnTime;
     }
     
     // Process Active Sensing for MIDI 2.0 mode
@@ -321,7 +417,7 @@ void vMidi2UmpToUartTask(void *pvParameters)
       }
       ledOnTime = xTaskGetTickCount();
       
-      UART_TX_SendDMA(midi_packet.data, midi_packet.length);
+      UART_TX_Write(midi_packet.data, midi_packet.length);
       lastActiveSensingTime = currentTime;
     }
 #endif
@@ -330,6 +426,298 @@ void vMidi2UmpToUartTask(void *pvParameters)
 
 /* Private functions ---------------------------------------------------------*/
 
+/**
+  * @brief  Take the next UMP for DIN output that is not too old
+  * @note   Evictable messages (see UMP_IsEvictable) queued longer than
+  *         MIDI_UMP_RX_MAX_AGE_MS are dropped and counted instead, together
+  *         with a JR Timestamp in front of them.
+  * @param  ump_data: Set to the UMP packet (4 words)
+  * @param  wait: Maximum time to wait in ticks
+  * @retval pdTRUE if a UMP was taken
+  */
+static BaseType_t ReceiveDinUmp(uint32_t *ump_data, TickType_t wait)
+{
+  UmpRxItem_t item;
+  UmpRxItem_t next;
+  
+  while (TakeDinUmp(&item, wait) == pdTRUE) {
+    wait = 0;
+    if (UMP_IS_JR_TIMESTAMP(item.ump[0]) && xQueuePeek(xUmpRxQueue, &next, 0) == pdTRUE &&
+        IsStaleDinUmp(&next)) {
+      // The timestamp would otherwise time the message after the dropped one
+      xQueueReceive(xUmpRxQueue, &next, 0);
+      midi_stats.evicted_ump_rx++;
+      continue;
+    }
+    if (IsStaleDinUmp(&item)) {
+      midi_stats.evicted_ump_rx++;
+      continue;
+    }
+    memcpy(ump_data, item.ump, sizeof(item.ump));
+    return pdTRUE;
+  }
+  return pdFALSE;
+}
+
+/**
+  * @brief  Check whether a queued UMP for DIN output may be dropped
+  * @param  item: Queued UMP
+  * @retval true if evictable and queued longer than MIDI_UMP_RX_MAX_AGE_MS
+  */
+static bool IsStaleDinUmp(const UmpRxItem_t *item)
+{
+  return MIDI_UMP_RX_MAX_AGE_MS > 0 && UMP_IsEvictable(item->ump[0]) &&
+         (TickType_t)(xTaskGetTickCount() - item->time) > pdMS_TO_TICKS(MIDI_UMP_RX_MAX_AGE_MS);
+}
+
+/**
+  * @brief  Take the next queued UMP for DIN output
+  * @note   System Real-Time on its own lane goes first, in arrival order.
+  *         While encoded events wait for room in the scheduler, nothing else
+  *         is taken and the wait covers the wire draining instead. Otherwise
+  *         the wait is a task notification, so new UMPs on either lane and
+  *         the release alarm end it.
+  * @param  item: Set to the queued UMP
+  * @param  wait: Maximum time to wait in ticks
+  * @retval pdTRUE if a UMP was taken
+  */
+static BaseType_t TakeDinUmp(UmpRxItem_t *item, TickType_t wait)
+{
+  if (TakeDinRealtime(item)) {
+    return pdTRUE;
+  }
+  
+  if (QueueHeldDinEvents()) {
+    if (wait > 0 && uxQueueMessagesWaiting(xUmpRxQueue) == 0) {
+      ulTaskNotifyTake(pdTRUE, wait);
+      if (TakeDinRealtime(item)) {
+        return pdTRUE;
+      }
+    }
+    return xQueueReceive(xUmpRxQueue, item, 0);
+  }
+  
+  if (wait > 0) {
+    UART_TX_WaitPending(UART_TX_LOW_WATER, wait);
+  }
+  return pdFALSE;
+}
+
+/**
+  * @brief  Take the oldest System Real-Time UMP for DIN output
+  * @note   Stale Timing Clock and Active Sensing are dropped by the ring
+  * @param  item: Set to the UMP
+  * @retval true if one was taken
+  */
+static bool TakeDinRealtime(UmpRxItem_t *item)
+{
+  uint32_t messages;
+  
+  memset(item, 0, sizeof(*item));
+  if (UMP_Ring_ReadFresh(&ump_rx_rt_ring, item->ump, 1, &messages, pdMS_TO_TICKS(MIDI_UMP_RX_MAX_AGE_MS),
+                         &midi_stats.evicted_ump_rx) == 0) {
+    return false;
+  }
+  item->time = xTaskGetTickCount();
+  return true;
+}
+
+/**
+  * @brief  Encode one UMP for the DIN TX scheduler
+  * @param  ump_data: UMP packet (4 words)
+  * @retval None
+  */
+static void ConvertUmpToDin(const uint32_t *ump_data)
+{
+  if (MIDI_Clock_UmpToDin(ump_data, MIDI_Time_Now())) {
+    return;  // Clock, transport and tempo are handled by midi_clock
+  }
+
+  uint32_t events[MIDI_UMP_ENCODER_MAX_EVENTS];
+  uint32_t count = MIDI_UmpEncoder_Process(&din_encoder, ump_data, events);
+  
+  for (uint32_t i = 0; i < count; i++) {
+    if (!QueueDinEvent(events[i])) {
+      // A full scheduler queue refuses the event (never realtime), and
+      // nothing but realtime is encoded until the rest has been taken
+      memcpy(din_held_events, &events[i], (count - i) * sizeof(uint32_t));
+      din_held_count = count - i;
+      din_held_index = 0;
+      return;
+    }
+  }
+}
+
+#if MIDI_DIN_TX_TIMESTAMPS
+/**
+  * @brief  Hold one UMP until its release time
+  * @param  ump_data: UMP packet (4 words)
+  * @retval None
+  */
+static void QueueTimedDinUmp(const uint32_t *ump_data)
+{
+  if (!MIDI_UmpTimeline_Push(&din_timeline, ump_data, MIDI_Time_Now())) {
+    // Timeline full: send at once. Only realtime is taken while events are
+    // held (see ReceiveDinUmp), so the encoder can always take it.
+    ConvertUmpToDin(ump_data);
+  }
+}
+
+/**
+  * @brief  Encode the held UMPs whose release time has come
+  * @note   While encoded events wait for room in the scheduler only System
+  *         Real-Time is released; the rest keeps its order behind it.
+  * @retval None
+  */
+static void ReleaseDueDinUmps(void)
+{
+  const uint32_t *ump;
+  while ((ump = MIDI_UmpTimeline_Peek(&din_timeline, MIDI_Time_Now())) != NULL) {
+    bool realtime = (ump[0] >> 28) == 0x1 && ((ump[0] >> 16) & 0xFF) >= MIDI_TIMING_CLOCK;
+    if (!realtime && !QueueHeldDinEvents()) {
+      break;
+    }
+    ConvertUmpToDin(ump);
+    MIDI_UmpTimeline_Pop(&din_timeline);
+  }
+  
+  midi_stats.din_tx_sched_late += din_timeline.late;
+  din_timeline.late = 0;
+}
+#endif
+
+/**
+  * @brief  Retry the events the scheduler refused
+  * @retval true if none are left
+  */
+static bool QueueHeldDinEvents(void)
+{
+  while (din_held_index < din_held_count) {
+    if (!QueueDinEvent(din_held_events[din_held_index])) {
+      return false;
+    }
+    din_held_index++;
+  }
+  return true;
+}
+
+/**
+  * @brief  Hand a MIDI 1.0 event to the DIN TX scheduler
+  * @note   Selector CCs that repeat what the receiver already has are left out
+  * @param  event: USB-MIDI event word
+  * @retval false if the event's scheduler queue is full and it must be retried
+  */
+static bool QueueDinEvent(uint32_t event)
+{
+  if (!MIDI_EVENT_IS_SYSEX(event)) {
+    // Forget the selectors once bytes may have been lost on the way
+    uint32_t losses = midi_stats.uart_tx_errors + midi_stats.din_tx_drops[MIDI_TX_CLASS_VOICE];
+    if (din_selectors_stale || losses != din_selector_losses) {
+      din_selectors_stale = false;
+      din_selector_losses = losses;
+      MIDI_SelectorCache_Invalidate(&din_selectors);
+    }
+    const uint8_t data[3] = {MIDI_EVENT_BYTE(event, 0), MIDI_EVENT_BYTE(event, 1), MIDI_EVENT_BYTE(event, 2)};
+    if (!MIDI_SelectorCache_Filter(&din_selectors, data, MIDI_Parser_EventLength(event))) {
+      midi_stats.din_tx_selectors_skipped++;
+      return true;
+    }
+  }
+  
+  if (!MIDI_Scheduler_Push(&din_scheduler, event, MIDI_Time_Now(), UART_TX_Pending())) {
+    if (!MIDI_EVENT_IS_SYSEX(event)) {
+      din_selectors_stale = true;  // The cache took it as sent; the retry must not be skipped
+    }
+    return false;
+  }
+  return true;
+}
+
+/**
+  * @brief  Queue scheduled messages on the UART while the wire is nearly idle
+  * @note   Short bursts keep realtime messages from waiting behind a long
+  *         UART queue (see USB_TO_UART_BURST_BYTES)
+  * @retval true if anything was queued
+  */
+static bool SendDinBursts(void)
+{
+  uint8_t tx_data[USB_TO_UART_RT_MAX + USB_TO_UART_BURST_BYTES];
+  bool sent = false;
+  
+  while (UART_TX_Pending() <= UART_TX_LOW_WATER) {
+    uint16_t length = 0;
+    uint16_t data_length = 0;
+    uint16_t rt_count = 0;
+    uint32_t now = MIDI_Time_Now();
+    uint32_t event;
+    
+    while (MIDI_Scheduler_Peek(&din_scheduler, now, &event)) {
+      uint8_t midi_length = MIDI_Parser_EventLength(event);
+      bool realtime = MIDI_EVENT_IS_REALTIME(event);
+      if (realtime ? (rt_count >= USB_TO_UART_RT_MAX) :
+          (data_length > 0 && data_length + midi_length > USB_TO_UART_BURST_BYTES)) {
+        break;  // Next burst
+      }
+      MIDI_Scheduler_Pop(&din_scheduler, now, &event);
+      
+      if (realtime) {
+        rt_count++;
+      } else {
+        data_length += midi_length;
+      }
+      for (uint8_t j = 0; j < midi_length; j++) {
+        tx_data[length++] = MIDI_EVENT_BYTE(event, j);
+      }
+    }
+    
+    if (length == 0) {
+      break;
+    }
+    if (UART_TX_Write(tx_data, length) != pdTRUE) {
+      midi_stats.uart_tx_errors++;
+    }
+    sent = true;
+  }
+  return sent;
+}
+
+#if MIDI_UMP_FUSED_CONVERTER || MIDI_UMP_CC_AGGREGATION
+/**
+  * @brief  Queue converted UMPs for USB
+  * @note   A JR Timestamp UMP among them stamps the message that follows it
+  * @param  words: Complete UMP messages of the CC aggregator or the converter
+  * @param  count: Number of words
+  * @retval None
+  */
+static void SendUmps(const uint32_t *words, uint32_t count)
+{
+  uint32_t i = 0;
+  while (i < count) {
+    if (UMP_IS_JR_TIMESTAMP(words[i])) {
+      jr_timestamp = words[i];
+    } else {
+      SendUmp(&words[i]);
+    }
+    i += UMP_WORD_COUNT(words[i]);
+  }
+}
+#endif
+
+/**
+  * @brief  Queue one converted UMP for USB
+  * @note   The first UMP of an event carries the event's JR Timestamp. Both
+  *         are queued together or dropped together.
+  * @param  ump: UMP message
+  * @retval None
+  */
+static void SendUmp(const uint32_t *ump)
+{
+  if (!UMP_Ring_WriteStamped(&ump_tx_ring, jr_timestamp, ump)) {
+    midi_stats.queue_full_errors++;
+  }
+  jr_timestamp = 0;
+}
+
 /**
   * @brief  Initialize MIDI 2.0 converter instances
   * @retval pdPASS if successful, pdFAIL otherwise
@@ -348,14 +736,5 @@ static BaseType_t InitMIDI2Converters(void)
     return pdFAIL;
   }
   
-  g_ump_to_midi1_converter = midi2_ump_to_midi1_create();
-  if (g_ump_to_midi1_converter == NULL) {
-    midi2_bs_to_ump_destroy(g_bs_to_ump_converter);
-    midi2_ump_to_midi2_destroy(g_ump_to_midi2_converter);
-    g_bs_to_ump_converter = NULL;
-    g_ump_to_midi2_converter = NULL;
-    return pdFAIL;
-  }
-  
   return pdPASS;
 }
@@ -0,0 +1,444 @@
+/**
+  * @file           : midi_cc_aggregator.c
+  * @brief          : RPN / NRPN and 14-bit CC aggregation implementation
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_cc_aggregator.h"
+#include "midi_parser.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define AGG_CONTROL_CHANGE          0xB0
+#define AGG_UNKNOWN                 0xFF
+
+// MIDI 2.0 channel voice status (message type 0x4)
+#define UMP_MT4                     0x40000000U
+#define UMP_STATUS_REGISTERED       0x2
+#define UMP_STATUS_ASSIGNABLE       0x3
+#define UMP_STATUS_RELATIVE_OFFSET  0x2   // Relative Registered / Assignable Controller (0x4 / 0x5)
+#define UMP_STATUS_CONTROL_CHANGE   0xB
+
+#define CC_BANK_SELECT_MSB          0
+#define CC_DATA_ENTRY_MSB           6
+#define CC_PAIR_LSB_OFFSET          32
+#define CC_DATA_ENTRY_LSB           38
+#define CC_PAIR_LAST_LSB            63
+#define CC_DATA_INCREMENT           96
+#define CC_DATA_DECREMENT           97
+#define CC_NRPN_LSB                 98
+#define CC_NRPN_MSB                 99
+#define CC_RPN_LSB                  100
+#define CC_RPN_MSB                  101
+#define CC_RESET_ALL_CONTROLLERS    121
+
+// One step of a 14-bit Data Entry value at 32-bit resolution
+#define AGG_RELATIVE_STEP           (1U << 18)
+
+// Words of one output message with its JR Timestamp (0: none)
+#define AGG_MESSAGE_WORDS(stamp)    (((stamp) != 0) ? 3U : 2U)
+
+/* Private function prototypes -----------------------------------------------*/
+static void ResetChannel(MidiCcChannel_t *channel);
+static uint32_t FlushHeld(MidiCcAggregator_t *aggregator, uint32_t now, bool all, uint32_t *ump,
+                          uint32_t max_words);
+static uint32_t FlushChannel(const MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                             uint8_t number, uint32_t *ump);
+static uint32_t FlushHeldCc(const MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                            uint8_t number, uint32_t *ump);
+static uint32_t FlushHeldData(const MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                              uint8_t number, uint32_t *ump);
+static uint32_t SelectParameter(MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                                uint8_t number, uint8_t status, bool msb, uint8_t value, uint32_t *ump);
+static uint32_t WriteUmp(const MidiCcAggregator_t *aggregator, uint32_t stamp, uint8_t status,
+                         uint8_t number, uint8_t index1, uint8_t index2, uint32_t value, uint32_t *ump);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an aggregator with no controller history
+  * @param  aggregator: Aggregator instance
+  * @param  hold_off_us: Longest wait of an MSB for its LSB
+  * @param  group: UMP group placed in the output
+  * @retval None
+  */
+void MIDI_CcAggregator_Init(MidiCcAggregator_t *aggregator, uint32_t hold_off_us, uint8_t group)
+{
+  for (uint8_t i = 0; i < 16; i++) {
+    ResetChannel(&aggregator->channels[i]);
+  }
+  aggregator->hold_off_us = hold_off_us;
+  aggregator->merged = 0;
+  aggregator->group = group & 0x0F;
+}
+
+/**
+  * @brief  Run one MIDI 1.0 event through the aggregator
+  * @note   Held values of the event's channel that must go first are written
+  *         to ump before the event's own output.
+  * @param  aggregator: Aggregator instance
+  * @param  event: USB-MIDI event word
+  * @param  now: Arrival time in microseconds
+  * @param  stamp: JR Timestamp UMP of the event (0: none), kept with a held value
+  * @param  ump: Output, room for MIDI_CC_AGGREGATOR_MAX_WORDS words (64-bit UMPs,
+  *         each preceded by its JR Timestamp UMP if it has one)
+  * @param  pass: Set to true if the caller must convert the event itself
+  *         (after sending the returned words), false if it was consumed
+  * @retval Number of UMP words written
+  */
+uint32_t MIDI_CcAggregator_Process(MidiCcAggregator_t *aggregator, uint32_t event, uint32_t now,
+                                   uint32_t stamp, uint32_t *ump, bool *pass)
+{
+  uint8_t status = MIDI_EVENT_BYTE(event, 0);
+  *pass = true;
+  if (status < 0x80 || status >= 0xF0) {
+    return 0;
+  }
+
+  uint8_t number = status & 0x0F;
+  MidiCcChannel_t *channel = &aggregator->channels[number];
+  if ((status & 0xF0) != AGG_CONTROL_CHANGE) {
+    return FlushChannel(aggregator, channel, number, ump);
+  }
+
+  uint8_t controller = MIDI_EVENT_BYTE(event, 1);
+  uint8_t value = MIDI_EVENT_BYTE(event, 2);
+  bool parameter_selected = channel->param_status != 0 &&
+                            channel->param_msb != AGG_UNKNOWN && channel->param_lsb != AGG_UNKNOWN;
+  uint32_t count;
+
+  switch (controller) {
+    case CC_RPN_MSB:
+      *pass = false;
+      return SelectParameter(aggregator, channel, number, UMP_STATUS_REGISTERED, true, value, ump);
+    case CC_RPN_LSB:
+      *pass = false;
+      return SelectParameter(aggregator, channel, number, UMP_STATUS_REGISTERED, false, value, ump);
+    case CC_NRPN_MSB:
+      *pass = false;
+      return SelectParameter(aggregator, channel, number, UMP_STATUS_ASSIGNABLE, true, value, ump);
+    case CC_NRPN_LSB:
+      *pass = false;
+      return SelectParameter(aggregator, channel, number, UMP_STATUS_ASSIGNABLE, false, value, ump);
+
+    case CC_DATA_ENTRY_MSB:
+      if (!parameter_selected) {
+        break;
+      }
+      // A value still waiting for its LSB goes out as it is
+      count = FlushChannel(aggregator, channel, number, ump);
+      channel->data_msb = value;
+      channel->data_held = true;
+      channel->data_time = now;
+      channel->data_stamp = stamp;
+      *pass = false;
+      return count;
+
+    case CC_DATA_ENTRY_LSB:
+      if (!parameter_selected || channel->data_msb == AGG_UNKNOWN) {
+        break;
+      }
+      count = FlushHeldCc(aggregator, channel, number, ump);
+      if (channel->data_held) {
+        channel->data_held = false;
+        aggregator->merged++;
+      }
+      *pass = false;
+      return count + WriteUmp(aggregator, stamp, channel->param_status, number, channel->param_msb,
+                              channel->param_lsb,
+                              MIDI_CcAggregator_ScaleUp(((uint32_t)channel->data_msb << 7) | value, 14),
+                              &ump[count]);
+
+    case CC_DATA_INCREMENT:
+    case CC_DATA_DECREMENT:
+      if (!parameter_selected) {
+        break;
+      }
+      // One step up or down of the selected parameter; a held value goes first
+      count = FlushChannel(aggregator, channel, number, ump);
+      *pass = false;
+      return count + WriteUmp(aggregator, stamp, channel->param_status + UMP_STATUS_RELATIVE_OFFSET,
+                              number, channel->param_msb, channel->param_lsb,
+                              (controller == CC_DATA_INCREMENT) ? AGG_RELATIVE_STEP : 0U - AGG_RELATIVE_STEP,
+                              &ump[count]);
+
+    case CC_RESET_ALL_CONTROLLERS:
+      count = FlushChannel(aggregator, channel, number, ump);
+      channel->param_status = 0;
+      channel->param_msb = AGG_UNKNOWN;
+      channel->param_lsb = AGG_UNKNOWN;
+      channel->data_msb = AGG_UNKNOWN;
+      return count;
+
+    default:
+      break;
+  }
+
+  if (controller > CC_BANK_SELECT_MSB && controller < CC_PAIR_LSB_OFFSET &&
+      controller != CC_DATA_ENTRY_MSB) {
+    count = FlushChannel(aggregator, channel, number, ump);
+    channel->msb[controller] = value;
+    *pass = false;
+    if (channel->lsb_seen & (1U << controller)) {
+      channel->held_cc = controller;
+      channel->held_cc_time = now;
+      channel->held_cc_stamp = stamp;
+      return count;
+    }
+    return count + WriteUmp(aggregator, stamp, UMP_STATUS_CONTROL_CHANGE, number, controller, 0,
+                            MIDI_CcAggregator_ScaleUp(value, 7), &ump[count]);
+  }
+
+  if (controller > CC_PAIR_LSB_OFFSET && controller <= CC_PAIR_LAST_LSB &&
+      controller != CC_DATA_ENTRY_LSB) {
+    uint8_t msb_controller = controller - CC_PAIR_LSB_OFFSET;
+    if (channel->msb[msb_controller] != AGG_UNKNOWN) {
+      channel->lsb_seen |= 1U << msb_controller;
+      count = 0;
+      if (channel->held_cc == msb_controller) {
+        channel->held_cc = AGG_UNKNOWN;
+        aggregator->merged++;
+      } else {
+        count = FlushChannel(aggregator, channel, number, ump);
+      }
+      *pass = false;
+      return count + WriteUmp(aggregator, stamp, UMP_STATUS_CONTROL_CHANGE, number, msb_controller, 0,
+                              MIDI_CcAggregator_ScaleUp(((uint32_t)channel->msb[msb_controller] << 7) | value, 14),
+                              &ump[count]);
+    }
+  }
+
+  // Bank Select, Data Entry / Increment / Decrement without a parameter,
+  // lone LSBs and the other controllers are converted as they are
+  return FlushChannel(aggregator, channel, number, ump);
+}
+
+/**
+  * @brief  Send the held values whose hold-off time has passed
+  * @param  aggregator: Aggregator instance
+  * @param  now: Current time in microseconds
+  * @param  ump: Output buffer
+  * @param  max_words: Room in ump (values that do not fit stay held)
+  * @retval Number of UMP words written
+  */
+uint32_t MIDI_CcAggregator_Flush(MidiCcAggregator_t *aggregator, uint32_t now, uint32_t *ump,
+                                 uint32_t max_words)
+{
+  return FlushHeld(aggregator, now, false, ump, max_words);
+}
+
+/**
+  * @brief  Send the held values of every channel at once
+  * @note   System Common and SysEx belong to no channel; the caller sends
+  *         this output before them so they do not overtake a held value.
+  * @param  aggregator: Aggregator instance
+  * @param  ump: Output buffer
+  * @param  max_words: Room in ump (values that do not fit stay held)
+  * @retval Number of UMP words written (call again while not 0)
+  */
+uint32_t MIDI_CcAggregator_FlushAll(MidiCcAggregator_t *aggregator, uint32_t *ump, uint32_t max_words)
+{
+  return FlushHeld(aggregator, 0, true, ump, max_words);
+}
+
+/**
+  * @brief  Check whether any value waits for its LSB
+  * @param  aggregator: Aggregator instance
+  * @retval true if MIDI_CcAggregator_Flush must be called later
+  */
+bool MIDI_CcAggregator_IsHolding(const MidiCcAggregator_t *aggregator)
+{
+  for (uint8_t i = 0; i < 16; i++) {
+    if (aggregator->channels[i].held_cc != AGG_UNKNOWN || aggregator->channels[i].data_held) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+  * @brief  Scale a 7- or 14-bit value to 32 bits (MIDI 2.0 min-center-max scaling)
+  * @note   0 stays 0, the center value maps to 0x80000000 and the maximum to 0xFFFFFFFF.
+  * @param  value: Value to scale
+  * @param  source_bits: Width of value (7 or 14)
+  * @retval 32-bit value
+  */
+uint32_t MIDI_CcAggregator_ScaleUp(uint32_t value, uint8_t source_bits)
+{
+  uint8_t scale_bits = 32 - source_bits;
+  uint32_t result = value << scale_bits;
+  if (value <= (1U << (source_bits - 1))) {
+    return result;
+  }
+
+  // Above the center, repeat the bits below the top bit to fill the range
+  uint8_t repeat_bits = source_bits - 1;
+  uint32_t repeat = (value & ((1U << repeat_bits) - 1U)) << (scale_bits - repeat_bits);
+  while (repeat != 0) {
+    result |= repeat;
+    repeat >>= repeat_bits;
+  }
+  return result;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Forget all controller state of a channel
+  * @param  channel: Channel state
+  * @retval None
+  */
+static void ResetChannel(MidiCcChannel_t *channel)
+{
+  memset(channel, 0, sizeof(*channel));
+  memset(channel->msb, AGG_UNKNOWN, sizeof(channel->msb));
+  channel->held_cc = AGG_UNKNOWN;
+  channel->param_msb = AGG_UNKNOWN;
+  channel->param_lsb = AGG_UNKNOWN;
+  channel->data_msb = AGG_UNKNOWN;
+}
+
+/**
+  * @brief  Send held values of all channels
+  * @param  aggregator: Aggregator instance
+  * @param  now: Current time in microseconds
+  * @param  all: true to send them all, false only those past their hold-off time
+  * @param  ump: Output buffer
+  * @param  max_words: Room in ump (values that do not fit stay held)
+  * @retval Number of UMP words written
+  */
+static uint32_t FlushHeld(MidiCcAggregator_t *aggregator, uint32_t now, bool all, uint32_t *ump,
+                          uint32_t max_words)
+{
+  uint32_t count = 0;
+
+  for (uint8_t number = 0; number < 16; number++) {
+    MidiCcChannel_t *channel = &aggregator->channels[number];
+    if (channel->held_cc != AGG_UNKNOWN &&
+        count + AGG_MESSAGE_WORDS(channel->held_cc_stamp) <= max_words &&
+        (all || now - channel->held_cc_time >= aggregator->hold_off_us)) {
+      count += FlushHeldCc(aggregator, channel, number, &ump[count]);
+    }
+    if (channel->data_held && count + AGG_MESSAGE_WORDS(channel->data_stamp) <= max_words &&
+        (all || now - channel->data_time >= aggregator->hold_off_us)) {
+      count += FlushHeldData(aggregator, channel, number, &ump[count]);
+    }
+  }
+  return count;
+}
+
+/**
+  * @brief  Send every held value of a channel
+  * @param  aggregator: Aggregator instance
+  * @param  channel: Channel state
+  * @param  number: Channel number (0-15)
+  * @param  ump: Output, room for 6 words
+  * @retval Number of UMP words written
+  */
+static uint32_t FlushChannel(const MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                             uint8_t number, uint32_t *ump)
+{
+  uint32_t count = FlushHeldCc(aggregator, channel, number, ump);
+  return count + FlushHeldData(aggregator, channel, number, &ump[count]);
+}
+
+/**
+  * @brief  Send a held CC MSB without its LSB
+  * @param  aggregator: Aggregator instance
+  * @param  channel: Channel state
+  * @param  number: Channel number (0-15)
+  * @param  ump: Output, room for 3 words
+  * @retval Number of UMP words written
+  */
+static uint32_t FlushHeldCc(const MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                            uint8_t number, uint32_t *ump)
+{
+  if (channel->held_cc == AGG_UNKNOWN) {
+    return 0;
+  }
+  uint8_t controller = channel->held_cc;
+  channel->held_cc = AGG_UNKNOWN;
+  return WriteUmp(aggregator, channel->held_cc_stamp, UMP_STATUS_CONTROL_CHANGE, number, controller,
+                  0, MIDI_CcAggregator_ScaleUp(channel->msb[controller], 7), ump);
+}
+
+/**
+  * @brief  Send a held Data Entry MSB without its LSB
+  * @note   The LSB is taken as 0, as a MIDI 1.0 receiver would.
+  * @param  aggregator: Aggregator instance
+  * @param  channel: Channel state
+  * @param  number: Channel number (0-15)
+  * @param  ump: Output, room for 3 words
+  * @retval Number of UMP words written
+  */
+static uint32_t FlushHeldData(const MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                              uint8_t number, uint32_t *ump)
+{
+  if (!channel->data_held) {
+    return 0;
+  }
+  channel->data_held = false;
+  return WriteUmp(aggregator, channel->data_stamp, channel->param_status, number, channel->param_msb,
+                  channel->param_lsb, MIDI_CcAggregator_ScaleUp((uint32_t)channel->data_msb << 7, 14), ump);
+}
+
+/**
+  * @brief  Update the RPN / NRPN selection of a channel
+  * @note   A held value belongs to the previous parameter and is sent first.
+  *         The null parameter (127/127) deselects.
+  * @param  aggregator: Aggregator instance
+  * @param  channel: Channel state
+  * @param  number: Channel number (0-15)
+  * @param  status: UMP_STATUS_REGISTERED or UMP_STATUS_ASSIGNABLE
+  * @param  msb: true for CC 101 / 99, false for CC 100 / 98
+  * @param  value: Controller value
+  * @param  ump: Output, room for 6 words
+  * @retval Number of UMP words written
+  */
+static uint32_t SelectParameter(MidiCcAggregator_t *aggregator, MidiCcChannel_t *channel,
+                                uint8_t number, uint8_t status, bool msb, uint8_t value, uint32_t *ump)
+{
+  uint32_t count = FlushChannel(aggregator, channel, number, ump);
+  aggregator->merged++;
+
+  if (channel->param_status != status) {
+    channel->param_status = status;
+    channel->param_msb = AGG_UNKNOWN;
+    channel->param_lsb = AGG_UNKNOWN;
+  }
+  if (msb) {
+    channel->param_msb = value;
+  } else {
+    channel->param_lsb = value;
+  }
+  // The value of the new parameter is unknown until the next Data Entry MSB
+  channel->data_msb = AGG_UNKNOWN;
+
+  if (channel->param_msb == 0x7F && channel->param_lsb == 0x7F) {
+    channel->param_status = 0;
+  }
+  return count;
+}
+
+/**
+  * @brief  Write a 64-bit MIDI 2.0 channel voice message
+  * @param  aggregator: Aggregator instance
+  * @param  stamp: JR Timestamp UMP written ahead of the message (0: none)
+  * @param  status: MIDI 2.0 status nibble
+  * @param  number: Channel number (0-15)
+  * @param  index1: Bank / controller index
+  * @param  index2: Parameter index (0 for Control Change)
+  * @param  value: 32-bit data
+  * @param  ump: Output, room for 3 words
+  * @retval Number of UMP words written (2, or 3 with a stamp)
+  */
+static uint32_t WriteUmp(const MidiCcAggregator_t *aggregator, uint32_t stamp, uint8_t status,
+                         uint8_t number, uint8_t index1, uint8_t index2, uint32_t value, uint32_t *ump)
+{
+  uint32_t count = 0;
+  if (stamp != 0) {
+    ump[count++] = stamp;
+  }
+  ump[count++] = UMP_MT4 | ((uint32_t)aggregator->group << 24) | ((uint32_t)status << 20) |
+                 ((uint32_t)number << 16) | ((uint32_t)(index1 & 0x7F) << 8) | (index2 & 0x7F);
+  ump[count++] = value;
+  return count;
+}
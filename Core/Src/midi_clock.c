@@ -0,0 +1,246 @@
+/**
+  * @file           : midi_clock.c
+  * @brief          : Recovered Timing Clock output from TIM2 alarms
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_clock.h"
+#include "midi_clock_pll.h"
+#include "midi_clock_gen.h"
+#include "midi_common.h"
+#include "midi_time.h"
+#include "midi_ump_converter.h"  // For MIDI_UMP_SYSTEM / MIDI_UMP_JR_TIMESTAMP
+#include "midi2_task.h"          // For ump_tx_rt_ring
+#include "ump_discovery.h"       // For UMP_GetTxJitterReduction
+#include "uart_tx.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define FLEX_SET_TEMPO 0x0000  // Flex Data status bank 0x00, status 0x00
+
+/* Private variables ---------------------------------------------------------*/
+static MidiClockPll_t clock_pll[MIDI_CLOCK_PATH_COUNT];  // Shared with the TIM2 interrupt
+static MidiClockGen_t clock_gen;  // DIN clock master after a host Set Tempo (shared with TIM2)
+
+// Alarm that sends the output of each path
+static const MidiTimeAlarm_t clock_alarm[MIDI_CLOCK_PATH_COUNT] = {
+  MIDI_TIME_ALARM_CLOCK_DIN,
+  MIDI_TIME_ALARM_CLOCK_USB,
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static bool ClockInput(MidiClockPath_t path, uint8_t status, uint32_t time);
+static bool PathNextTime(MidiClockPath_t path, uint32_t *time);
+static void ArmPath(MidiClockPath_t path);
+static bool SendDinClock(uint32_t *when, BaseType_t *pxHigherPriorityTaskWoken);
+static bool SendUsbClock(uint32_t *when, BaseType_t *pxHigherPriorityTaskWoken);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Reset both clock paths and hook their TIM2 alarms
+  * @note   Call after MIDI_Time_Init
+  * @retval None
+  */
+void MIDI_Clock_Init(void)
+{
+  for (uint32_t i = 0; i < MIDI_CLOCK_PATH_COUNT; i++) {
+    MIDI_ClockPll_Init(&clock_pll[i], MIDI_CLOCK_PLL_DELAY_US);
+  }
+  MIDI_ClockGen_Init(&clock_gen);
+  MIDI_Time_SetCallback(MIDI_TIME_ALARM_CLOCK_DIN, SendDinClock);
+  MIDI_Time_SetCallback(MIDI_TIME_ALARM_CLOCK_USB, SendUsbClock);
+}
+
+/**
+  * @brief  Give the DIN clock back to the host
+  * @note   Called on USB mount / unmount: a new host session starts
+  *         without a Set Tempo, so the generator must not stay the master.
+  * @retval None
+  */
+void MIDI_Clock_Reset(void)
+{
+  taskENTER_CRITICAL();
+  MIDI_ClockGen_Init(&clock_gen);
+  taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  Take a clock or transport message bound for DIN OUT
+  * @param  status: Status byte
+  * @param  time: Arrival (or release) time (MIDI_Time_Now() units)
+  * @retval true if taken; false if the caller sends it itself (not F8 / FA /
+  *         FB / FC, MIDI_CLOCK_PLL is 0, or the path is full)
+  */
+bool MIDI_Clock_ToDin(uint8_t status, uint32_t time)
+{
+  return ClockInput(MIDI_CLOCK_PATH_DIN, status, time);
+}
+
+/**
+  * @brief  Take a UMP bound for DIN OUT if it is clock, transport or tempo
+  * @note   Flex Data Set Tempo makes the device the DIN clock master: from
+  *         then on the host's Timing Clock is dropped and Start / Continue /
+  *         Stop go to the clock generator, until a host Timing Clock after
+  *         Stop or a USB mount / unmount (MIDI_Clock_Reset).
+  * @param  ump: UMP message
+  * @param  time: Release time (MIDI_Time_Now() units)
+  * @retval true if taken; false if the caller encodes it
+  */
+bool MIDI_Clock_UmpToDin(const uint32_t *ump, uint32_t time)
+{
+  uint8_t message_type = (uint8_t)(ump[0] >> 28);
+
+  if (message_type == 0x1) {
+    return ClockInput(MIDI_CLOCK_PATH_DIN, (uint8_t)(ump[0] >> 16), time);
+  }
+
+#if MIDI_CLOCK_GENERATOR
+  // Flex Data, complete in one UMP, status bank 0x00 / status 0x00
+  if (message_type == 0xD && ((ump[0] >> 22) & 0x3) == 0x0 &&
+      (ump[0] & 0xFFFF) == FLEX_SET_TEMPO) {
+    taskENTER_CRITICAL();
+    if (MIDI_ClockGen_SetTempo(&clock_gen, ump[1], time)) {
+      ArmPath(MIDI_CLOCK_PATH_DIN);
+    }
+    taskEXIT_CRITICAL();
+    return true;
+  }
+#endif
+  return false;
+}
+
+/**
+  * @brief  Take a clock or transport message bound for USB IN (MIDI 2.0 mode)
+  * @param  status: Status byte
+  * @param  time: Capture time at DIN IN (MIDI_Time_Now() units)
+  * @retval true if taken; false if the caller sends it itself
+  */
+bool MIDI_Clock_ToUsb(uint8_t status, uint32_t time)
+{
+  return ClockInput(MIDI_CLOCK_PATH_USB, status, time);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Queue a message on a clock path and arm its alarm
+  * @param  path: Clock path
+  * @param  status: Status byte
+  * @param  time: Input time
+  * @retval true if taken
+  */
+static bool ClockInput(MidiClockPath_t path, uint8_t status, uint32_t time)
+{
+  if (status != MIDI_TIMING_CLOCK && status != MIDI_START &&
+      status != MIDI_CONTINUE && status != MIDI_STOP) {
+    return false;
+  }
+
+  bool taken = true;
+  taskENTER_CRITICAL();
+  if (path == MIDI_CLOCK_PATH_DIN && MIDI_ClockGen_IsActive(&clock_gen) &&
+      (status != MIDI_TIMING_CLOCK || MIDI_ClockGen_HostClock(&clock_gen))) {
+    // The generator is the clock source; only transport is passed on
+    if (status != MIDI_TIMING_CLOCK) {
+      MIDI_ClockGen_Transport(&clock_gen, status, time);
+      ArmPath(path);
+    }
+  } else if (!MIDI_CLOCK_PLL) {
+    taken = false;
+  } else {
+    MidiClockPll_t *pll = &clock_pll[path];
+    taken = MIDI_ClockPll_Input(pll, status, time);
+    midi_stats.clock_in_jitter_us[path] = pll->in_jitter_q4 >> 4;
+    if (taken) {
+      ArmPath(path);
+    }
+  }
+  taskEXIT_CRITICAL();
+
+  if (!taken && MIDI_CLOCK_PLL) {
+    midi_stats.queue_full_errors++;
+  }
+  return taken;
+}
+
+/**
+  * @brief  Get the time of the next message of a clock path
+  * @param  path: Clock path
+  * @param  time: Set to the earliest queued time
+  * @retval false if nothing is queued
+  */
+static bool PathNextTime(MidiClockPath_t path, uint32_t *time)
+{
+  bool queued = MIDI_ClockPll_NextTime(&clock_pll[path], time);
+
+  uint32_t generated;
+  if (path == MIDI_CLOCK_PATH_DIN && MIDI_ClockGen_NextTime(&clock_gen, &generated)) {
+    if (!queued || (int32_t)(generated - *time) < 0) {
+      *time = generated;
+    }
+    queued = true;
+  }
+  return queued;
+}
+
+/**
+  * @brief  Arm the alarm of a clock path for its next message
+  * @note   Called with the TIM2 interrupt masked
+  * @param  path: Clock path
+  * @retval None
+  */
+static void ArmPath(MidiClockPath_t path)
+{
+  uint32_t next;
+  if (PathNextTime(path, &next)) {
+    MIDI_Time_ArmCallback(clock_alarm[path], next);
+  }
+}
+
+/**
+  * @brief  TIM2 alarm callback: send the due DIN clock messages
+  * @note   Recovered clocks and generated clocks share the alarm
+  * @param  when: Set to the time of the next queued or generated message
+  * @param  pxHigherPriorityTaskWoken: Unused (UART TX needs no task)
+  * @retval true if more messages are pending
+  */
+static bool SendDinClock(uint32_t *when, BaseType_t *pxHigherPriorityTaskWoken)
+{
+  MidiClockPll_t *pll = &clock_pll[MIDI_CLOCK_PATH_DIN];
+  uint32_t now = MIDI_Time_Now();
+  uint8_t status;
+  (void)pxHigherPriorityTaskWoken;
+
+  while (MIDI_ClockPll_Pop(pll, now, &status) || MIDI_ClockGen_Pop(&clock_gen, now, &status)) {
+    if (UART_TX_WriteFromISR(&status, 1) == pdTRUE) {
+      midi_stats.uart_tx_count++;
+    } else {
+      midi_stats.uart_tx_errors++;
+    }
+  }
+  midi_stats.clock_out_jitter_us[MIDI_CLOCK_PATH_DIN] = pll->out_jitter_q4 >> 4;
+  return PathNextTime(MIDI_CLOCK_PATH_DIN, when);
+}
+
+/**
+  * @brief  TIM2 alarm callback: send the due USB clock messages
+  * @note   Each message carries a JR Timestamp of its send time while the
+  *         host has JR Timestamps enabled
+  * @param  when: Set to the time of the next queued message
+  * @param  pxHigherPriorityTaskWoken: Set if the USB IN task should run next
+  * @retval true if more messages are queued
+  */
+static bool SendUsbClock(uint32_t *when, BaseType_t *pxHigherPriorityTaskWoken)
+{
+  MidiClockPll_t *pll = &clock_pll[MIDI_CLOCK_PATH_USB];
+  uint8_t status;
+  uint32_t now = MIDI_Time_Now();
+
+  while (MIDI_ClockPll_Pop(pll, now, &status)) {
+    uint32_t ump_rt = MIDI_UMP_SYSTEM(0, status, 0, 0);
+    uint32_t ump_jr = UMP_GetTxJitterReduction() ? MIDI_UMP_JR_TIMESTAMP(MIDI_TIME_TO_JR(now)) : 0;
+    if (!UMP_Ring_WriteStampedFromISR(&ump_tx_rt_ring, ump_jr, &ump_rt, pxHigherPriorityTaskWoken)) {
+      midi_stats.queue_full_errors++;
+    }
+  }
+  midi_stats.clock_out_jitter_us[MIDI_CLOCK_PATH_USB] = pll->out_jitter_q4 >> 4;
+  return MIDI_ClockPll_NextTime(pll, when);
+}
@@ -0,0 +1,171 @@
+/**
+  * @file           : midi_clock_gen.c
+  * @brief          : 24 PPQN Timing Clock generator driven by Set Tempo
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_clock_gen.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define STATUS_TIMING_CLOCK 0xF8
+#define STATUS_START        0xFA
+#define STATUS_STOP         0xFC
+#define UNITS_PER_US        100U  // Set Tempo units (10 ns) per microsecond
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t ClockTime(const MidiClockGen_t *gen);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize a generator without a tempo (inactive)
+  * @param  gen: Generator instance
+  * @retval None
+  */
+void MIDI_ClockGen_Init(MidiClockGen_t *gen)
+{
+  memset(gen, 0, sizeof(*gen));
+}
+
+/**
+  * @brief  Take a Set Tempo value
+  * @note   The first tempo starts the clock at once; later ones apply from
+  *         the next beat.
+  * @param  gen: Generator instance
+  * @param  tempo: Quarter note length in 10 ns units
+  * @param  now: Current time (microseconds)
+  * @retval false if the tempo is out of range (ignored)
+  */
+bool MIDI_ClockGen_SetTempo(MidiClockGen_t *gen, uint32_t tempo, uint32_t now)
+{
+  if (tempo < MIDI_CLOCK_GEN_MIN_TEMPO || tempo > MIDI_CLOCK_GEN_MAX_TEMPO) {
+    return false;
+  }
+
+  gen->next_tempo = tempo;
+  if (gen->tempo == 0) {
+    gen->tempo = tempo;
+    gen->beat_time = now;
+    gen->beat_frac = 0;
+    gen->tick = 0;
+  }
+  return true;
+}
+
+/**
+  * @brief  Take Start, Continue or Stop
+  * @note   The message is sent at once. Start also restarts the beat (with
+  *         any new tempo) so that the clock following it is beat one.
+  * @param  gen: Generator instance
+  * @param  status: FA (Start), FB (Continue) or FC (Stop)
+  * @param  now: Current time (microseconds)
+  * @retval None
+  */
+void MIDI_ClockGen_Transport(MidiClockGen_t *gen, uint8_t status, uint32_t now)
+{
+  gen->transport = status;
+  gen->transport_time = now;
+  gen->stopped = (status == STATUS_STOP);
+
+  if (status == STATUS_START && gen->tempo != 0) {
+    gen->tempo = gen->next_tempo;
+    gen->beat_time = now;
+    gen->beat_frac = 0;
+    gen->tick = 0;
+  }
+}
+
+/**
+  * @brief  Check whether the generator is the clock source
+  * @param  gen: Generator instance
+  * @retval true once a valid tempo was set
+  */
+bool MIDI_ClockGen_IsActive(const MidiClockGen_t *gen)
+{
+  return gen->tempo != 0;
+}
+
+/**
+  * @brief  Take a Timing Clock from the host
+  * @note   While the transport runs, the host's clock is dropped. Once Stop
+  *         has been sent, a host clock means the host is the master again:
+  *         the generator resets to inactive.
+  * @param  gen: Generator instance
+  * @retval true if the generator stays the clock source (drop the clock)
+  */
+bool MIDI_ClockGen_HostClock(MidiClockGen_t *gen)
+{
+  if (gen->tempo == 0) {
+    return false;
+  }
+  if (!gen->stopped || gen->transport != 0) {
+    return true;
+  }
+  MIDI_ClockGen_Init(gen);
+  return false;
+}
+
+/**
+  * @brief  Get the time of the next message
+  * @param  gen: Generator instance
+  * @param  time: Set to the time
+  * @retval false if there is nothing to send (no tempo, no transport)
+  */
+bool MIDI_ClockGen_NextTime(const MidiClockGen_t *gen, uint32_t *time)
+{
+  if (gen->transport != 0) {
+    *time = gen->transport_time;
+    return true;
+  }
+  if (gen->tempo == 0) {
+    return false;
+  }
+  *time = ClockTime(gen);
+  return true;
+}
+
+/**
+  * @brief  Take the next message if its time has come
+  * @param  gen: Generator instance
+  * @param  now: Current time (microseconds)
+  * @param  status: Set to the status byte
+  * @retval false if nothing is due
+  */
+bool MIDI_ClockGen_Pop(MidiClockGen_t *gen, uint32_t now, uint8_t *status)
+{
+  if (gen->transport != 0) {
+    if ((int32_t)(gen->transport_time - now) > 0) {
+      return false;
+    }
+    *status = gen->transport;
+    gen->transport = 0;
+    return true;
+  }
+
+  if (gen->tempo == 0 || (int32_t)(ClockTime(gen) - now) > 0) {
+    return false;
+  }
+
+  *status = STATUS_TIMING_CLOCK;
+  if (++gen->tick == MIDI_CLOCK_GEN_PPQN) {
+    // Beat boundary: carry the sub-microsecond remainder, apply a new tempo
+    uint32_t length = gen->beat_frac + gen->tempo;
+    gen->beat_time += length / UNITS_PER_US;
+    gen->beat_frac = (uint8_t)(length % UNITS_PER_US);
+    gen->tick = 0;
+    gen->tempo = gen->next_tempo;
+  }
+  return true;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Get the time of the next clock, rounded to the microsecond
+  * @param  gen: Generator instance (with a tempo)
+  * @retval Clock time
+  */
+static uint32_t ClockTime(const MidiClockGen_t *gen)
+{
+  uint64_t offset = gen->beat_frac + (uint64_t)gen->tick * gen->tempo / MIDI_CLOCK_GEN_PPQN;
+  return gen->beat_time + (uint32_t)((offset + UNITS_PER_US / 2U) / UNITS_PER_US);
+}
@@ -0,0 +1,188 @@
+/**
+  * @file           : midi_clock_pll.c
+  * @brief          : Timing Clock recovery with a software PLL
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_clock_pll.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define QUEUE_MASK (MIDI_CLOCK_PLL_QUEUE_SIZE - 1U)
+
+#if (MIDI_CLOCK_PLL_QUEUE_SIZE & QUEUE_MASK) != 0
+#error "MIDI_CLOCK_PLL_QUEUE_SIZE must be a power of two"
+#endif
+
+#define STATUS_TIMING_CLOCK 0xF8
+#define STATUS_START        0xFA
+#define STATUS_CONTINUE     0xFB
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t TrackClock(MidiClockPll_t *pll, uint32_t time);
+static void UpdateJitter(uint32_t *jitter_q4, int32_t deviation);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an unlocked PLL with an empty output queue
+  * @param  pll: PLL instance
+  * @param  delay_us: Fixed delay of the output (covers the input jitter)
+  * @retval None
+  */
+void MIDI_ClockPll_Init(MidiClockPll_t *pll, uint32_t delay_us)
+{
+  memset(pll, 0, sizeof(*pll));
+  pll->delay_us = delay_us;
+}
+
+/**
+  * @brief  Take a Timing Clock or transport message
+  * @param  pll: PLL instance
+  * @param  status: F8 (Timing Clock), FA (Start), FB (Continue) or FC (Stop)
+  * @param  time: Arrival time (microseconds)
+  * @retval false if the output queue is full (the message is not taken)
+  */
+bool MIDI_ClockPll_Input(MidiClockPll_t *pll, uint8_t status, uint32_t time)
+{
+  if ((uint16_t)(pll->head - pll->tail) == MIDI_CLOCK_PLL_QUEUE_SIZE) {
+    return false;
+  }
+
+  uint32_t out;
+  if (status == STATUS_TIMING_CLOCK) {
+    out = TrackClock(pll, time) + pll->delay_us;
+  } else {
+    out = time + pll->delay_us;
+    if (status == STATUS_START || status == STATUS_CONTINUE) {
+      pll->realign = true;
+    }
+  }
+
+  // Never before the input, never before what is already queued
+  if ((int32_t)(out - time) < 0) {
+    out = time;
+  }
+  if (pll->head != pll->tail && (int32_t)(out - pll->last_queued) < 0) {
+    out = pll->last_queued;
+  }
+
+  MidiClockPllEntry_t *entry = &pll->queue[pll->head & QUEUE_MASK];
+  entry->time = out;
+  entry->status = status;
+  pll->head++;
+  pll->last_queued = out;
+  return true;
+}
+
+/**
+  * @brief  Get the output time of the next queued message
+  * @param  pll: PLL instance
+  * @param  time: Set to the output time
+  * @retval false if nothing is queued
+  */
+bool MIDI_ClockPll_NextTime(const MidiClockPll_t *pll, uint32_t *time)
+{
+  if (pll->head == pll->tail) {
+    return false;
+  }
+  *time = pll->queue[pll->tail & QUEUE_MASK].time;
+  return true;
+}
+
+/**
+  * @brief  Take the next message if its output time has come
+  * @param  pll: PLL instance
+  * @param  now: Current time (microseconds), the time the message is sent
+  * @param  status: Set to the status byte
+  * @retval false if nothing is due
+  */
+bool MIDI_ClockPll_Pop(MidiClockPll_t *pll, uint32_t now, uint8_t *status)
+{
+  if (pll->head == pll->tail) {
+    return false;
+  }
+  const MidiClockPllEntry_t *entry = &pll->queue[pll->tail & QUEUE_MASK];
+  if ((int32_t)(entry->time - now) > 0) {
+    return false;
+  }
+
+  *status = entry->status;
+  pll->tail++;
+
+  if (*status == STATUS_TIMING_CLOCK) {
+    if (pll->has_output && pll->locked) {
+      UpdateJitter(&pll->out_jitter_q4, (int32_t)(now - pll->last_output) - (int32_t)pll->period_us);
+    }
+    pll->last_output = now;
+    pll->has_output = true;
+  }
+  return true;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Update the period and phase estimate with an input clock
+  * @param  pll: PLL instance
+  * @param  time: Arrival time of the clock
+  * @retval Smoothed time of the clock
+  */
+static uint32_t TrackClock(MidiClockPll_t *pll, uint32_t time)
+{
+  uint32_t interval = time - pll->last_input;
+  bool continuous = pll->has_input &&
+                    interval >= MIDI_CLOCK_PLL_MIN_PERIOD_US && interval <= MIDI_CLOCK_PLL_MAX_PERIOD_US;
+  pll->last_input = time;
+  pll->has_input = true;
+
+  if (!continuous) {
+    // First clock or a gap: no tempo yet
+    pll->locked = false;
+    pll->realign = false;
+    pll->phase = time;
+    return time;
+  }
+
+  if (!pll->locked) {
+    pll->period_us = interval;
+    pll->phase = time;
+    pll->locked = true;
+    pll->realign = false;
+    return time;
+  }
+
+  if (pll->realign) {
+    // First clock after Start / Continue: the tempo holds, the phase restarts
+    pll->phase = time;
+    pll->realign = false;
+    return time;
+  }
+
+  int32_t error = (int32_t)(time - (pll->phase + pll->period_us));
+  int32_t half_period = (int32_t)(pll->period_us / 2U);
+  if (error > half_period || error < -half_period) {
+    // Tempo jump: re-lock on the last interval
+    pll->period_us = interval;
+    pll->phase = time;
+    return time;
+  }
+
+  UpdateJitter(&pll->in_jitter_q4, error);
+  pll->phase += pll->period_us + (uint32_t)(error / 4);
+  pll->period_us += (uint32_t)(error / 8);
+  if (pll->period_us < MIDI_CLOCK_PLL_MIN_PERIOD_US) {
+    pll->period_us = MIDI_CLOCK_PLL_MIN_PERIOD_US;
+  }
+  return pll->phase;
+}
+
+/**
+  * @brief  Fold one deviation into a running mean
+  * @param  jitter_q4: Running mean of the magnitude (1/16 us)
+  * @param  deviation: Deviation in microseconds
+  * @retval None
+  */
+static void UpdateJitter(uint32_t *jitter_q4, int32_t deviation)
+{
+  uint32_t magnitude = (uint32_t)((deviation < 0) ? -deviation : deviation);
+  *jitter_q4 = *jitter_q4 - (*jitter_q4 >> 4) + magnitude;
+}
@@ -7,9 +7,11 @@
 #include "midi_common.h"
 
 /* Private variables ---------------------------------------------------------*/
-// Queues for MIDI packet communication
-QueueHandle_t xUartToUsbQueue;  // UART RX -> USB TX
-QueueHandle_t xUsbToUartQueue;  // USB RX -> UART TX
+// Event rings for MIDI packet communication
+MidiRing_t uart_to_usb_ring;  // UART RX -> USB TX
+MidiRing_t usb_to_uart_ring;  // USB RX -> UART TX
+MidiRing_t uart_to_usb_rt_ring;  // UART RX -> USB TX, System Real-Time
+MidiRing_t usb_to_uart_rt_ring;  // USB RX -> UART TX, System Real-Time
 
 // MIDI statistics
 MIDIStats_t midi_stats = {0};
@@ -22,30 +24,24 @@ uint8_t dma_rx_buffer[DMA_RX_BUFFER_SIZE];
 volatile uint32_t dma_rx_head = 0;  // DMA write position
 volatile uint32_t dma_rx_tail = 0;  // Processing read position
 
-// MIDI parsing state
-volatile uint8_t midi_msg_buffer[3];
-volatile uint8_t midi_msg_index = 0;
-volatile uint8_t midi_running_status = 0;
-
 /* Exported functions --------------------------------------------------------*/
 /**
-  * @brief  Initialize MIDI queues
+  * @brief  Initialize MIDI event rings
   * @retval pdPASS if successful, pdFAIL otherwise
   */
 BaseType_t MIDI_InitQueues(void)
 {
-  /* Create MIDI packet queues */
-  // Increased queue size to handle larger SysEx messages
-  // A 1024-byte SysEx requires ~342 packets of 3 bytes each
-  // Using 64 to balance memory usage and capacity
-  xUartToUsbQueue = xQueueCreate(64, sizeof(MIDIPacket_t));
-  xUsbToUartQueue = xQueueCreate(64, sizeof(MIDIPacket_t));
+  /* Reset MIDI event rings (statically allocated, consumers register at task start) */
+  MIDI_Ring_Init(&uart_to_usb_ring);
+  MIDI_Ring_Init(&usb_to_uart_ring);
+  MIDI_Ring_Init(&uart_to_usb_rt_ring);
+  MIDI_Ring_Init(&usb_to_uart_rt_ring);
   
   /* Create LED control mutex */
   xLedMutex = xSemaphoreCreateMutex();
   
   /* Check if all resources were created successfully */
-  if (xUartToUsbQueue == NULL || xUsbToUartQueue == NULL || xLedMutex == NULL)
+  if (xLedMutex == NULL)
   {
     return pdFAIL;
   }
@@ -83,16 +79,6 @@ uint8_t MIDI_GetCIN(uint8_t status, uint8_t length)
   return USB_MIDI_CIN_MISC; // Miscellaneous function codes
 }
 
-/**
-  * @brief  Reset MIDI running status (e.g., on System messages)
-  * @retval None
-  */
-void MIDI_ResetRunningStatus(void)
-{
-  midi_running_status = 0;
-  midi_msg_index = 0;
-}
-
 /**
   * @brief  Get copy of MIDI statistics
   * @param  stats: Pointer to statistics structure to fill
@@ -0,0 +1,222 @@
+/**
+  * @file           : midi_parser.c
+  * @brief          : Table-driven MIDI 1.0 byte stream parser implementation
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_parser.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define PARSER_ENTRY(kind, length, cin) \
+  ((uint8_t)((kind) | ((length) << MIDI_PARSER_LENGTH_SHIFT) | (cin)))
+
+#define PARSER_ROW16(e) e, e, e, e, e, e, e, e, e, e, e, e, e, e, e, e
+
+#define PARSER_SYSEX_START  0xF0
+#define PARSER_SYSEX_END    0xF7
+#define PARSER_CIN_SYSEX    0x4   // SysEx starts or continues (3 bytes)
+
+/* Exported variables --------------------------------------------------------*/
+// Status byte -> kind / message length / USB-MIDI CIN, resolved at compile time
+const uint8_t midi_parser_table[256] = {
+  // 0x00-0x7F: data bytes
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_DATA, 0, 0x0)),
+  // 0x80-0xEF: Channel Voice messages
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_CHANNEL, 3, 0x8)),  // Note Off
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_CHANNEL, 3, 0x9)),  // Note On
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_CHANNEL, 3, 0xA)),  // Poly Key Pressure
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_CHANNEL, 3, 0xB)),  // Control Change
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_CHANNEL, 2, 0xC)),  // Program Change
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_CHANNEL, 2, 0xD)),  // Channel Pressure
+  PARSER_ROW16(PARSER_ENTRY(MIDI_PARSER_KIND_CHANNEL, 3, 0xE)),  // Pitch Bend
+  // 0xF0-0xF7: System Common messages
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 1, 0x4),  // F0 SysEx Start
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 2, 0x2),  // F1 MTC Quarter Frame
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 3, 0x3),  // F2 Song Position Pointer
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 2, 0x2),  // F3 Song Select
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 0, 0x0),  // F4 Undefined (dropped)
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 0, 0x0),  // F5 Undefined (dropped)
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 1, 0x5),  // F6 Tune Request
+  PARSER_ENTRY(MIDI_PARSER_KIND_COMMON, 1, 0x5),  // F7 SysEx End
+  // 0xF8-0xFF: System Real-Time messages (single byte)
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+  PARSER_ENTRY(MIDI_PARSER_KIND_REALTIME, 1, 0xF),
+};
+
+/* Private variables ---------------------------------------------------------*/
+// USB-MIDI CIN -> number of MIDI bytes in the event
+static const uint8_t cin_length_table[16] = {
+  0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Close the SysEx being assembled with an F7 and return its final event
+  * @param  parser: Parser instance
+  * @retval Event word with the matching SysEx end CIN
+  */
+static uint32_t EndSysEx(MidiParser_t *parser)
+{
+  // Bytes in the final chunk including F7: 1-3, CIN 0x5-0x7
+  uint32_t count = ((uint32_t)parser->shift - 8) / 8 + 1;
+  uint32_t event = (parser->word & ~(uint32_t)MIDI_PARSER_CIN_MASK) |
+                   ((uint32_t)PARSER_SYSEX_END << parser->shift) |
+                   (PARSER_CIN_SYSEX + count);
+
+  parser->in_sysex = false;
+  parser->remaining = 0;
+  return event;
+}
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize a parser instance
+  * @param  parser: Parser instance
+  * @param  cable: Cable number (0-15) placed in every event
+  * @retval None
+  */
+void MIDI_Parser_Init(MidiParser_t *parser, uint8_t cable)
+{
+  parser->cable = cable & 0x0F;
+  parser->errors = 0;
+  MIDI_Parser_Reset(parser);
+}
+
+/**
+  * @brief  Drop running status and any partial message (e.g. after a receive error)
+  * @param  parser: Parser instance
+  * @retval None
+  */
+void MIDI_Parser_Reset(MidiParser_t *parser)
+{
+  parser->word = 0;
+  parser->running_word = 0;
+  parser->shift = 0;
+  parser->remaining = 0;
+  parser->running_remaining = 0;
+  parser->in_sysex = false;
+}
+
+/**
+  * @brief  Parse a contiguous span of MIDI 1.0 bytes into USB-MIDI event words
+  * @note   Stops early when fewer than MIDI_PARSER_MAX_EVENTS_PER_BYTE event
+  *         slots are left; call again with the unconsumed bytes.
+  *         SysEx is emitted in 3-byte chunks as it arrives. A non-realtime
+  *         status byte inside a SysEx terminates it with an F7 and counts an error.
+  * @param  parser: Parser instance
+  * @param  data: Input bytes
+  * @param  length: Number of input bytes
+  * @param  events: Output event words
+  * @param  max_events: Capacity of events
+  * @param  event_count: Set to the number of events written
+  * @retval Number of input bytes consumed
+  */
+size_t MIDI_Parser_Process(MidiParser_t *parser, const uint8_t *data, size_t length,
+                           uint32_t *events, size_t max_events, size_t *event_count)
+{
+  const uint32_t header = (uint32_t)parser->cable << 4;
+  size_t consumed = 0;
+  size_t count = 0;
+
+  while (consumed < length && (max_events - count) >= MIDI_PARSER_MAX_EVENTS_PER_BYTE) {
+    const uint8_t byte = data[consumed++];
+    const uint8_t entry = midi_parser_table[byte];
+
+    switch (entry & MIDI_PARSER_KIND_MASK) {
+      case MIDI_PARSER_KIND_DATA:
+        if (parser->remaining == 0) {
+          break;  // Stray data byte without status
+        }
+        parser->word |= (uint32_t)byte << parser->shift;
+        parser->shift += 8;
+        if (--parser->remaining == 0) {
+          events[count++] = parser->word;
+          if (parser->in_sysex) {
+            // Continue with the next 3-byte SysEx chunk
+            parser->word = header | PARSER_CIN_SYSEX;
+            parser->shift = 8;
+            parser->remaining = 3;
+          } else {
+            // Running status (running_remaining is 0 after System Common)
+            parser->word = parser->running_word;
+            parser->shift = 16;
+            parser->remaining = parser->running_remaining;
+          }
+        }
+        break;
+
+      case MIDI_PARSER_KIND_CHANNEL:
+        if (parser->in_sysex) {
+          events[count++] = EndSysEx(parser);
+          parser->errors++;
+        }
+        parser->running_word = header | (entry & MIDI_PARSER_CIN_MASK) | ((uint32_t)byte << 8);
+        parser->running_remaining = ((entry & MIDI_PARSER_LENGTH_MASK) >> MIDI_PARSER_LENGTH_SHIFT) - 1;
+        parser->word = parser->running_word;
+        parser->shift = 16;
+        parser->remaining = parser->running_remaining;
+        break;
+
+      case MIDI_PARSER_KIND_COMMON:
+        if (byte == PARSER_SYSEX_END) {
+          if (parser->in_sysex) {
+            events[count++] = EndSysEx(parser);
+          }
+          parser->running_word = 0;
+          parser->running_remaining = 0;
+          break;
+        }
+        if (parser->in_sysex) {
+          events[count++] = EndSysEx(parser);
+          parser->errors++;
+        }
+        parser->running_word = 0;
+        parser->running_remaining = 0;
+        parser->word = header | (entry & MIDI_PARSER_CIN_MASK) | ((uint32_t)byte << 8);
+        parser->shift = 16;
+        if (byte == PARSER_SYSEX_START) {
+          parser->in_sysex = true;
+          parser->remaining = 2;
+        } else if ((entry & MIDI_PARSER_LENGTH_MASK) == (1 << MIDI_PARSER_LENGTH_SHIFT)) {
+          events[count++] = parser->word;  // Tune Request
+          parser->remaining = 0;
+        } else {
+          // Undefined F4/F5 have length 0 and are dropped
+          parser->remaining = (entry & MIDI_PARSER_LENGTH_MASK) ?
+                              ((entry & MIDI_PARSER_LENGTH_MASK) >> MIDI_PARSER_LENGTH_SHIFT) - 1 : 0;
+        }
+        break;
+
+      default:  // MIDI_PARSER_KIND_REALTIME
+        // Never affects running status or SysEx state
+        events[count++] = header | (entry & MIDI_PARSER_CIN_MASK) | ((uint32_t)byte << 8);
+        break;
+    }
+  }
+
+  *event_count = count;
+  return consumed;
+}
+
+/**
+  * @brief  Get the number of MIDI bytes carried by an event word
+  * @param  event: USB-MIDI event word
+  * @retval MIDI message length (0-3 bytes)
+  */
+uint8_t MIDI_Parser_EventLength(uint32_t event)
+{
+  return cin_length_table[event & MIDI_PARSER_CIN_MASK];
+}
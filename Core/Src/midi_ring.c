@@ -0,0 +1,183 @@
+/**
+  * @file           : midi_ring.c
+  * @brief          : Lock-free single-producer/single-consumer MIDI event ring
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_ring.h"
+#include "midi_parser.h"  // For MIDI_EVENT_IS_EVICTABLE
+
+/* Private defines -----------------------------------------------------------*/
+#define RING_MASK (MIDI_RING_SIZE - 1)
+
+#if (MIDI_RING_SIZE & RING_MASK) != 0
+#error "MIDI_RING_SIZE must be a power of two"
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an empty ring
+  * @param  ring: Ring instance
+  * @retval None
+  */
+void MIDI_Ring_Init(MidiRing_t *ring)
+{
+  ring->head = 0;
+  ring->tail = 0;
+  ring->consumer = NULL;
+}
+
+/**
+  * @brief  Register the task that is notified when events are pushed
+  * @param  ring: Ring instance
+  * @param  task: Consumer task handle (NULL to disable notifications)
+  * @retval None
+  */
+void MIDI_Ring_SetConsumer(MidiRing_t *ring, TaskHandle_t task)
+{
+  ring->consumer = task;
+}
+
+/**
+  * @brief  Push a batch of events without blocking (producer side only)
+  * @param  ring: Ring instance
+  * @param  events: Events to push
+  * @param  count: Number of events
+  * @retval Number of events pushed (less than count if the ring is full)
+  */
+uint32_t MIDI_Ring_Push(MidiRing_t *ring, const uint32_t *events, uint32_t count)
+{
+  uint32_t head = ring->head;
+  uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  uint32_t space = MIDI_RING_SIZE - (head - tail);
+
+  if (count > space) {
+    count = space;
+  }
+  TickType_t now = xTaskGetTickCount();
+  for (uint32_t i = 0; i < count; i++) {
+    ring->events[(head + i) & RING_MASK] = events[i];
+    ring->times[(head + i) & RING_MASK] = now;
+  }
+
+  if (count > 0) {
+    // Publish the events before the new head becomes visible to the consumer
+    __atomic_store_n(&ring->head, head + count, __ATOMIC_RELEASE);
+    if (ring->consumer != NULL) {
+      xTaskNotifyGive(ring->consumer);
+    }
+  }
+  return count;
+}
+
+/**
+  * @brief  Push a batch of events, waiting up to timeout for free space
+  * @note   Used for SysEx, which must not lose data when the consumer lags.
+  *         The producer re-checks once per tick while the ring is full.
+  * @param  ring: Ring instance
+  * @param  events: Events to push
+  * @param  count: Number of events
+  * @param  timeout: Maximum time to wait for space
+  * @retval Number of events pushed
+  */
+uint32_t MIDI_Ring_PushWait(MidiRing_t *ring, const uint32_t *events, uint32_t count, TickType_t timeout)
+{
+  uint32_t pushed = MIDI_Ring_Push(ring, events, count);
+  TickType_t waited = 0;
+
+  while (pushed < count && waited < timeout) {
+    vTaskDelay(1);
+    waited++;
+    pushed += MIDI_Ring_Push(ring, &events[pushed], count - pushed);
+  }
+  return pushed;
+}
+
+/**
+  * @brief  Pop up to max_count events (consumer side only)
+  * @param  ring: Ring instance
+  * @param  events: Destination buffer
+  * @param  max_count: Capacity of events
+  * @retval Number of events popped
+  */
+uint32_t MIDI_Ring_Pop(MidiRing_t *ring, uint32_t *events, uint32_t max_count)
+{
+  uint32_t tail = ring->tail;
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t count = head - tail;
+
+  if (count > max_count) {
+    count = max_count;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    events[i] = ring->events[(tail + i) & RING_MASK];
+  }
+
+  if (count > 0) {
+    // Release the slots only after they have been read
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+  }
+  return count;
+}
+
+/**
+  * @brief  Pop up to max_count events, dropping stale ones that may be lost
+  *         (consumer side only)
+  * @note   An event pushed more than max_age ticks ago is dropped if
+  *         MIDI_EVENT_IS_EVICTABLE; note messages and the like are kept at
+  *         any age. A capture time marker is popped or dropped together with
+  *         the event after it, so it never stamps a later event. Dropped
+  *         events do not count toward max_count.
+  * @param  ring: Ring instance
+  * @param  events: Destination buffer
+  * @param  max_count: Capacity of events (at least 2 to pop a marker with
+  *         its event; with less room a marker at the front stays queued)
+  * @param  max_age: Age limit in ticks (0: no limit)
+  * @param  evicted: Incremented for each dropped event
+  * @retval Number of events popped (0 only if the ring is empty or a
+  *         capture time marker at the front has no event or no room yet)
+  */
+uint32_t MIDI_Ring_PopFresh(MidiRing_t *ring, uint32_t *events, uint32_t max_count,
+                            TickType_t max_age, uint32_t *evicted)
+{
+  uint32_t tail = ring->tail;
+  uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  TickType_t now = xTaskGetTickCount();
+  uint32_t count = 0;
+
+  while (tail != head && count < max_count) {
+    uint32_t span = 1;
+    if (MIDI_EVENT_IS_CAPTURE_TIME(ring->events[tail & RING_MASK])) {
+      if (tail + 1 == head || count + 2 > max_count) {
+        break;  // Wait for its event, or for room next to it
+      }
+      span = 2;
+    }
+    uint32_t last = tail + span - 1;
+    if (max_age > 0 && (TickType_t)(now - ring->times[last & RING_MASK]) > max_age &&
+        MIDI_EVENT_IS_EVICTABLE(ring->events[last & RING_MASK])) {
+      (*evicted)++;
+    } else {
+      for (uint32_t i = 0; i < span; i++) {
+        events[count++] = ring->events[(tail + i) & RING_MASK];
+      }
+    }
+    tail += span;
+  }
+
+  if (tail != ring->tail) {
+    // Release the slots only after they have been read
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+  }
+  return count;
+}
+
+/**
+  * @brief  Get the number of events waiting in the ring
+  * @param  ring: Ring instance
+  * @retval Number of queued events
+  */
+uint32_t MIDI_Ring_Count(const MidiRing_t *ring)
+{
+  return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,109 @@
+/**
+  * @file           : midi_running_status.c
+  * @brief          : MIDI 1.0 running status encoder implementation
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_running_status.h"
+#include "midi_parser.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define RUNNING_STATUS_NOTE_OFF  0x80
+#define RUNNING_STATUS_NOTE_ON   0x90
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an encoder
+  * @param  encoder: Encoder instance
+  * @param  note_off_as_on: Send Note Off as Note On with velocity 0
+  * @retval None
+  */
+void MIDI_RunningStatus_Init(MidiRunningStatus_t *encoder, bool note_off_as_on)
+{
+  encoder->note_off_as_on = note_off_as_on;
+  MIDI_RunningStatus_Reset(encoder);
+}
+
+/**
+  * @brief  Forget the running status, so the next message carries its status byte
+  * @note   Call when the receiver may have lost bytes (UART error, reconnect)
+  * @param  encoder: Encoder instance
+  * @retval None
+  */
+void MIDI_RunningStatus_Reset(MidiRunningStatus_t *encoder)
+{
+  encoder->status = 0;
+  encoder->data_length = 0;
+  encoder->data_index = 0;
+  encoder->clear_velocity = false;
+}
+
+/**
+  * @brief  Encode one byte of a complete-message MIDI 1.0 stream
+  * @param  encoder: Encoder instance
+  * @param  byte: Byte to send; may be rewritten (Note Off conversion)
+  * @retval true if the byte goes on the wire, false if it is left out
+  */
+bool MIDI_RunningStatus_Next(MidiRunningStatus_t *encoder, uint8_t *byte)
+{
+  uint8_t value = *byte;
+  uint8_t kind = midi_parser_table[value] & MIDI_PARSER_KIND_MASK;
+
+  switch (kind) {
+    case MIDI_PARSER_KIND_DATA:
+      if (encoder->data_length != 0) {
+        if (encoder->clear_velocity && encoder->data_index == 1) {
+          *byte = 0;
+        }
+        if (++encoder->data_index >= encoder->data_length) {
+          encoder->data_index = 0;
+        }
+      }
+      return true;
+
+    case MIDI_PARSER_KIND_CHANNEL:
+      encoder->clear_velocity = false;
+      if (encoder->note_off_as_on && (value & 0xF0) == RUNNING_STATUS_NOTE_OFF) {
+        value = RUNNING_STATUS_NOTE_ON | (value & 0x0F);
+        encoder->clear_velocity = true;
+      }
+      encoder->data_index = 0;
+      if (value == encoder->status) {
+        return false;
+      }
+      encoder->status = value;
+      encoder->data_length =
+        ((midi_parser_table[value] & MIDI_PARSER_LENGTH_MASK) >> MIDI_PARSER_LENGTH_SHIFT) - 1;
+      *byte = value;
+      return true;
+
+    case MIDI_PARSER_KIND_COMMON:
+      MIDI_RunningStatus_Reset(encoder);
+      return true;
+
+    default:  // System Real-Time
+      return true;
+  }
+}
+
+/**
+  * @brief  Encode a span of complete MIDI 1.0 messages
+  * @param  encoder: Encoder instance
+  * @param  data: Input bytes
+  * @param  length: Number of input bytes
+  * @param  out: Output buffer, at least length bytes (may equal data)
+  * @retval Number of bytes written to out
+  */
+size_t MIDI_RunningStatus_Encode(MidiRunningStatus_t *encoder, const uint8_t *data,
+                                 size_t length, uint8_t *out)
+{
+  size_t count = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    uint8_t byte = data[i];
+    if (MIDI_RunningStatus_Next(encoder, &byte)) {
+      out[count++] = byte;
+    }
+  }
+  return count;
+}
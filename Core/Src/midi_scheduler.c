@@ -0,0 +1,332 @@
+/**
+  * @file           : midi_scheduler.c
+  * @brief          : Bandwidth-aware priority scheduler for DIN MIDI OUT
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_scheduler.h"
+#include "midi_parser.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define SCHEDULER_QUEUE_MASK (MIDI_SCHEDULER_QUEUE_SIZE - 1U)
+#define SCHEDULER_NONE (-1)
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t SelectClass(const MidiScheduler_t *scheduler, uint32_t now);
+static bool IsDroppable(uint32_t event);
+static bool Coalesce(MidiScheduler_t *scheduler, uint32_t event);
+static bool HasOrderedBefore(const MidiSchedulerQueue_t *queue, uint32_t seq);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize a scheduler with empty queues
+  * @param  scheduler: Scheduler instance
+  * @param  coalesce: Replace queued controller values with newer ones
+  * @retval None
+  */
+void MIDI_Scheduler_Init(MidiScheduler_t *scheduler, bool coalesce)
+{
+  for (uint32_t c = 0; c < MIDI_TX_CLASS_COUNT; c++) {
+    scheduler->queues[c].head = 0;
+    scheduler->queues[c].tail = 0;
+    scheduler->queues[c].bytes = 0;
+  }
+  scheduler->next_seq = 0;
+  scheduler->barrier_seq = 0;
+  scheduler->in_sysex = false;
+  scheduler->coalesce = coalesce;
+}
+
+/**
+  * @brief  Get the traffic class of an event
+  * @param  event: USB-MIDI event word
+  * @retval Traffic class
+  */
+MidiTxClass_t MIDI_Scheduler_Classify(uint32_t event)
+{
+  uint8_t cin = MIDI_EVENT_CIN(event);
+  uint8_t status = MIDI_EVENT_BYTE(event, 0);
+
+  if (MIDI_EVENT_IS_REALTIME(event)) {
+    return MIDI_TX_CLASS_REALTIME;
+  }
+  if (cin == USB_MIDI_CIN_NOTE_OFF || cin == USB_MIDI_CIN_NOTE_ON) {
+    return MIDI_TX_CLASS_NOTE;
+  }
+  if (cin >= USB_MIDI_CIN_POLY_KEYPRESS && cin <= USB_MIDI_CIN_PITCH_BEND) {
+    return MIDI_TX_CLASS_VOICE;
+  }
+  if (cin == USB_MIDI_CIN_SYSEX_START || cin == USB_MIDI_CIN_SYSEX_END_2 ||
+      cin == USB_MIDI_CIN_SYSEX_END_3 || status == MIDI_SYSEX_END ||
+      (cin == USB_MIDI_CIN_1BYTE_DATA && status < MIDI_STATUS_MASK)) {
+    return MIDI_TX_CLASS_SYSEX;
+  }
+  return MIDI_TX_CLASS_VOICE;  // System Common
+}
+
+/**
+  * @brief  Check whether a newer value of an event may replace a queued one
+  * @param  event: USB-MIDI event word
+  * @note   Switch controllers (Sustain, Sostenuto, ...) are excluded: an
+  *         off value must always reach the wire
+  * @retval true for Pitch Bend, Channel / Poly Pressure and continuous CCs
+  *         (MIDI_EVENT_IS_VALUE)
+  */
+bool MIDI_Scheduler_IsCoalescable(uint32_t event)
+{
+  return MIDI_EVENT_IS_VALUE(event);
+}
+
+/**
+  * @brief  Queue an event for DIN output
+  * @param  scheduler: Scheduler instance
+  * @param  event: USB-MIDI event word
+  * @param  now: Current time (MIDI_Time_Now() units)
+  * @param  wire_pending: Bytes already handed to the UART and not yet sent
+  * @retval true if the event was taken (queued or dropped), false if its
+  *         queue is full and the caller should retry later
+  */
+bool MIDI_Scheduler_Push(MidiScheduler_t *scheduler, uint32_t event, uint32_t now, uint32_t wire_pending)
+{
+  MidiTxClass_t cls = MIDI_Scheduler_Classify(event);
+  MidiSchedulerQueue_t *queue = &scheduler->queues[cls];
+  uint8_t length = MIDI_Parser_EventLength(event);
+
+  if (cls != MIDI_TX_CLASS_REALTIME) {
+    if (!MIDI_Scheduler_IsCoalescable(event)) {
+      scheduler->barrier_seq = scheduler->next_seq;
+    } else if (scheduler->coalesce && Coalesce(scheduler, event)) {
+      midi_stats.din_tx_coalesced++;
+      return true;
+    }
+  }
+
+  if ((uint16_t)(queue->head - queue->tail) >= MIDI_SCHEDULER_QUEUE_SIZE) {
+    // Back-pressure for everything that must not be lost (Note Off, Program
+    // Change, selectors, System Common, SysEx). Realtime has its own lane
+    // that never waits, so it is dropped like Note On and controller values.
+    if (cls != MIDI_TX_CLASS_REALTIME && !IsDroppable(event)) {
+      return false;
+    }
+    midi_stats.din_tx_drops[cls]++;
+    return true;
+  }
+
+  if (IsDroppable(event)) {
+    // Under congestion this class waits for itself and every higher class
+    uint32_t ahead = wire_pending + length;
+    for (uint32_t c = 0; c <= (uint32_t)cls; c++) {
+      ahead += scheduler->queues[c].bytes;
+    }
+    if (ahead * MIDI_SCHEDULER_BYTE_US > MIDI_DIN_TX_LATENCY_BOUND_US) {
+      midi_stats.din_tx_drops[cls]++;
+      return true;
+    }
+  }
+
+  MidiSchedulerEntry_t *entry = &queue->entries[queue->head & SCHEDULER_QUEUE_MASK];
+  entry->event = event;
+  entry->time = now;
+  entry->seq = scheduler->next_seq++;
+  queue->head++;
+  queue->bytes += length;
+  return true;
+}
+
+/**
+  * @brief  Get the event that MIDI_Scheduler_Pop would return, without removing it
+  * @param  scheduler: Scheduler instance
+  * @param  now: Current time (MIDI_Time_Now() units)
+  * @param  event: Set to the next event
+  * @retval true if an event may be sent now
+  */
+bool MIDI_Scheduler_Peek(const MidiScheduler_t *scheduler, uint32_t now, uint32_t *event)
+{
+  int32_t cls = SelectClass(scheduler, now);
+  if (cls == SCHEDULER_NONE) {
+    return false;
+  }
+
+  const MidiSchedulerQueue_t *queue = &scheduler->queues[cls];
+  *event = queue->entries[queue->tail & SCHEDULER_QUEUE_MASK].event;
+  return true;
+}
+
+/**
+  * @brief  Remove the next event to send and record its queueing delay
+  * @param  scheduler: Scheduler instance
+  * @param  now: Current time (MIDI_Time_Now() units)
+  * @param  event: Set to the event
+  * @retval true if an event was removed
+  */
+bool MIDI_Scheduler_Pop(MidiScheduler_t *scheduler, uint32_t now, uint32_t *event)
+{
+  int32_t cls = SelectClass(scheduler, now);
+  if (cls == SCHEDULER_NONE) {
+    return false;
+  }
+
+  MidiSchedulerQueue_t *queue = &scheduler->queues[cls];
+  const MidiSchedulerEntry_t *entry = &queue->entries[queue->tail & SCHEDULER_QUEUE_MASK];
+  uint32_t delay = now - entry->time;
+  *event = entry->event;
+  queue->tail++;
+  queue->bytes -= MIDI_Parser_EventLength(*event);
+
+  if (delay > midi_stats.din_tx_delay_max_us[cls]) {
+    midi_stats.din_tx_delay_max_us[cls] = delay;
+  }
+  if (delay > MIDI_DIN_TX_LATENCY_BOUND_US) {
+    midi_stats.din_tx_late[cls]++;
+  }
+
+  if (cls == MIDI_TX_CLASS_SYSEX) {
+    uint8_t cin = MIDI_EVENT_CIN(*event);
+    if (cin == USB_MIDI_CIN_SYSEX_START) {
+      scheduler->in_sysex = true;
+    } else if (cin != USB_MIDI_CIN_1BYTE_DATA) {
+      scheduler->in_sysex = false;
+    }
+  } else if (cls != MIDI_TX_CLASS_REALTIME) {
+    scheduler->in_sysex = false;  // Only after an abandoned SysEx
+  }
+  return true;
+}
+
+/**
+  * @brief  Get the number of MIDI bytes waiting in all classes
+  * @param  scheduler: Scheduler instance
+  * @retval Queued bytes
+  */
+uint32_t MIDI_Scheduler_QueuedBytes(const MidiScheduler_t *scheduler)
+{
+  uint32_t bytes = 0;
+  for (uint32_t c = 0; c < MIDI_TX_CLASS_COUNT; c++) {
+    bytes += scheduler->queues[c].bytes;
+  }
+  return bytes;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Choose the class whose head event goes next
+  * @param  scheduler: Scheduler instance
+  * @param  now: Current time
+  * @retval Class index, or SCHEDULER_NONE if nothing may be sent
+  */
+static int32_t SelectClass(const MidiScheduler_t *scheduler, uint32_t now)
+{
+  const MidiSchedulerQueue_t *queues = scheduler->queues;
+
+  if (queues[MIDI_TX_CLASS_REALTIME].head != queues[MIDI_TX_CLASS_REALTIME].tail) {
+    return MIDI_TX_CLASS_REALTIME;
+  }
+
+  // Oldest waiting non-realtime message
+  int32_t oldest = SCHEDULER_NONE;
+  uint32_t oldest_seq = 0;
+  for (int32_t c = MIDI_TX_CLASS_NOTE; c < MIDI_TX_CLASS_COUNT; c++) {
+    if (queues[c].head != queues[c].tail) {
+      uint32_t seq = queues[c].entries[queues[c].tail & SCHEDULER_QUEUE_MASK].seq;
+      if (oldest == SCHEDULER_NONE || (int32_t)(seq - oldest_seq) < 0) {
+        oldest = c;
+        oldest_seq = seq;
+      }
+    }
+  }
+  if (oldest == SCHEDULER_NONE) {
+    return SCHEDULER_NONE;
+  }
+  uint32_t oldest_age = now - queues[oldest].entries[queues[oldest].tail & SCHEDULER_QUEUE_MASK].time;
+
+  // Any other status byte would end the SysEx on the wire. Wait for its next
+  // chunk unless the rest never arrives.
+  if (scheduler->in_sysex) {
+    if (queues[MIDI_TX_CLASS_SYSEX].head != queues[MIDI_TX_CLASS_SYSEX].tail) {
+      return MIDI_TX_CLASS_SYSEX;
+    }
+    return (oldest_age >= MIDI_DIN_TX_STARVATION_US) ? oldest : SCHEDULER_NONE;
+  }
+
+  // Arrival order while the backlog is short, and for starving messages
+  if (oldest_age < MIDI_DIN_TX_REORDER_US || oldest_age >= MIDI_DIN_TX_STARVATION_US) {
+    return oldest;
+  }
+
+  for (int32_t c = MIDI_TX_CLASS_NOTE; c < MIDI_TX_CLASS_COUNT; c++) {
+    if (queues[c].head != queues[c].tail) {
+      // A note must not sound before the Program Change / Bank Select sent
+      // ahead of it; the Voice queue goes first up to that message
+      if (c == MIDI_TX_CLASS_NOTE &&
+          HasOrderedBefore(&queues[MIDI_TX_CLASS_VOICE], queues[c].entries[queues[c].tail & SCHEDULER_QUEUE_MASK].seq)) {
+        return MIDI_TX_CLASS_VOICE;
+      }
+      return c;
+    }
+  }
+  return SCHEDULER_NONE;
+}
+
+/**
+  * @brief  Check whether a queue holds an order-sensitive message older than seq
+  * @param  queue: Class queue (in arrival order)
+  * @param  seq: Arrival order to compare with
+  * @retval true if a message that is not a controller value arrived before seq
+  */
+static bool HasOrderedBefore(const MidiSchedulerQueue_t *queue, uint32_t seq)
+{
+  for (uint16_t i = queue->tail; i != queue->head; i++) {
+    const MidiSchedulerEntry_t *entry = &queue->entries[i & SCHEDULER_QUEUE_MASK];
+    if ((int32_t)(entry->seq - seq) >= 0) {
+      break;
+    }
+    if (!MIDI_Scheduler_IsCoalescable(entry->event)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+  * @brief  Check whether an event may be dropped when it would arrive too late
+  * @note   Note Off (including Note On velocity 0) is kept so no note hangs, and
+  *         order-sensitive messages (Program Change, selectors, data entry) are
+  *         kept so later messages still apply to the right program / parameter
+  * @param  event: USB-MIDI event word
+  * @retval true for Note On and continuous controller values
+  */
+static bool IsDroppable(uint32_t event)
+{
+  if (MIDI_EVENT_CIN(event) == USB_MIDI_CIN_NOTE_ON) {
+    return MIDI_EVENT_BYTE(event, 2) != 0;
+  }
+  return MIDI_Scheduler_IsCoalescable(event);
+}
+
+/**
+  * @brief  Overwrite a queued value of the same controller with a newer one
+  * @note   Only entries that arrived after the last barrier are candidates, so
+  *         the new value never moves ahead of an order-sensitive message
+  * @param  scheduler: Scheduler instance
+  * @param  event: Coalescable USB-MIDI event word
+  * @retval true if a queued entry now carries the event
+  */
+static bool Coalesce(MidiScheduler_t *scheduler, uint32_t event)
+{
+  MidiSchedulerQueue_t *queue = &scheduler->queues[MIDI_TX_CLASS_VOICE];
+  // Cable and status; plus the controller / note number for CC and Poly Pressure
+  uint32_t key_mask = (MIDI_EVENT_CIN(event) == USB_MIDI_CIN_CHAN_PRESSURE ||
+                       MIDI_EVENT_CIN(event) == USB_MIDI_CIN_PITCH_BEND) ? 0x0000FFFFU : 0x00FFFFFFU;
+
+  for (uint16_t i = queue->head; i != queue->tail; i--) {
+    MidiSchedulerEntry_t *entry = &queue->entries[(uint16_t)(i - 1) & SCHEDULER_QUEUE_MASK];
+    if ((int32_t)(entry->seq - scheduler->barrier_seq) < 0) {
+      break;
+    }
+    if (((entry->event ^ event) & key_mask) == 0) {
+      entry->event = event;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,114 @@
+/**
+  * @file           : midi_selector_cache.c
+  * @brief          : Per-channel Bank Select / RPN / NRPN selector cache implementation
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_selector_cache.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define SELECTOR_CONTROL_CHANGE     0xB0
+#define SELECTOR_SYSTEM_RESET       0xFF
+
+#define CC_BANK_SELECT_MSB          0
+#define CC_BANK_SELECT_LSB          32
+#define CC_NRPN_LSB                 98
+#define CC_NRPN_MSB                 99
+#define CC_RPN_LSB                  100
+#define CC_RPN_MSB                  101
+#define CC_RESET_ALL_CONTROLLERS    121
+
+/* Private function prototypes -----------------------------------------------*/
+static bool UpdateParameter(MidiSelectorChannel_t *channel, uint8_t type, bool msb, uint8_t value);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Forget all selectors, so the next selector CCs are sent again
+  * @param  cache: Cache instance
+  * @retval None
+  */
+void MIDI_SelectorCache_Invalidate(MidiSelectorCache_t *cache)
+{
+  memset(cache, MIDI_SELECTOR_UNKNOWN, sizeof(*cache));
+}
+
+/**
+  * @brief  Update the cache with a message and decide whether it goes on the wire
+  * @param  cache: Cache instance
+  * @param  data: Complete MIDI 1.0 message (status first)
+  * @param  length: Message length (1-3)
+  * @retval true to send the message, false if it repeats a selector the receiver already has
+  */
+bool MIDI_SelectorCache_Filter(MidiSelectorCache_t *cache, const uint8_t *data, uint8_t length)
+{
+  if (data[0] == SELECTOR_SYSTEM_RESET) {
+    MIDI_SelectorCache_Invalidate(cache);
+    return true;
+  }
+  if ((data[0] & 0xF0) != SELECTOR_CONTROL_CHANGE || length != 3) {
+    return true;
+  }
+
+  MidiSelectorChannel_t *channel = &cache->channels[data[0] & 0x0F];
+  uint8_t value = data[2];
+
+  switch (data[1]) {
+    case CC_BANK_SELECT_MSB:
+      if (channel->bank_msb == value) {
+        return false;
+      }
+      channel->bank_msb = value;
+      return true;
+
+    case CC_BANK_SELECT_LSB:
+      if (channel->bank_lsb == value) {
+        return false;
+      }
+      channel->bank_lsb = value;
+      return true;
+
+    case CC_RPN_MSB:
+      return UpdateParameter(channel, CC_RPN_MSB, true, value);
+    case CC_RPN_LSB:
+      return UpdateParameter(channel, CC_RPN_MSB, false, value);
+    case CC_NRPN_MSB:
+      return UpdateParameter(channel, CC_NRPN_MSB, true, value);
+    case CC_NRPN_LSB:
+      return UpdateParameter(channel, CC_NRPN_MSB, false, value);
+
+    case CC_RESET_ALL_CONTROLLERS:
+      // Resets the parameter selection to null on the receiver (RP-015)
+      channel->param_type = MIDI_SELECTOR_UNKNOWN;
+      return true;
+
+    default:
+      return true;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Update one half of the RPN / NRPN selector
+  * @note   Switching between RPN and NRPN forgets both halves, so the first
+  *         selection of the other type is always sent in full
+  * @param  channel: Channel state
+  * @param  type: CC_RPN_MSB or CC_NRPN_MSB
+  * @param  msb: true for the MSB selector, false for the LSB
+  * @param  value: Selector value
+  * @retval true to send the selector CC
+  */
+static bool UpdateParameter(MidiSelectorChannel_t *channel, uint8_t type, bool msb, uint8_t value)
+{
+  uint8_t *selector = msb ? &channel->param_msb : &channel->param_lsb;
+
+  if (channel->param_type != type) {
+    channel->param_type = type;
+    channel->param_msb = MIDI_SELECTOR_UNKNOWN;
+    channel->param_lsb = MIDI_SELECTOR_UNKNOWN;
+  } else if (*selector == value) {
+    return false;
+  }
+  *selector = value;
+  return true;
+}
@@ -0,0 +1,314 @@
+/**
+  * @file           : midi_time.c
+  * @brief          : Microsecond timebase for MIDI timing measurements
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_time.h"
+
+/* Private variables ---------------------------------------------------------*/
+static TIM_HandleTypeDef htim_midi_time;
+static TaskHandle_t alarm_tasks[MIDI_TIME_ALARM_COUNT];  // Task notified by each alarm
+static MidiTimeCallback_t alarm_callbacks[MIDI_TIME_ALARM_COUNT];  // Or callback run by it
+static volatile uint32_t sof_time = 0;      // Time of the last USB Start Of Frame
+static volatile bool sof_seen = false;      // At least one SOF received
+static MidiTimeSofControl_t sof_control;    // Turns SOF on only while frame timing is used
+static volatile bool sof_enabled = false;   // SOF turned on through sof_control
+static volatile uint32_t sof_used_time = 0; // Last use of the frame timing
+static volatile uint32_t sof_request_time = 0;  // Last request to turn SOF on
+
+// Compare register, interrupt flag and software event of each alarm channel
+static volatile uint32_t * const alarm_ccr[MIDI_TIME_ALARM_COUNT] = {
+  &MIDI_TIME_TIMER->CCR1,
+  &MIDI_TIME_TIMER->CCR2,
+  &MIDI_TIME_TIMER->CCR3,
+  &MIDI_TIME_TIMER->CCR4,
+};
+static const uint32_t alarm_flag[MIDI_TIME_ALARM_COUNT] = {
+  TIM_DIER_CC1IE,  // TIM_SR_CCxIF uses the same bit position
+  TIM_DIER_CC2IE,
+  TIM_DIER_CC3IE,
+  TIM_DIER_CC4IE,
+};
+static const uint32_t alarm_event[MIDI_TIME_ALARM_COUNT] = {
+  TIM_EGR_CC1G,
+  TIM_EGR_CC2G,
+  TIM_EGR_CC3G,
+  TIM_EGR_CC4G,
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Start TIM2 as a free-running 1 MHz counter
+  * @note   TIM2 is a 32-bit timer on APB1; its clock is twice PCLK1 when the
+  *         APB1 prescaler is not 1.
+  * @retval None
+  */
+void MIDI_Time_Init(void)
+{
+  uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+    timer_clock *= 2U;
+  }
+
+  __HAL_RCC_TIM2_CLK_ENABLE();
+
+  htim_midi_time.Instance = MIDI_TIME_TIMER;
+  htim_midi_time.Init.Prescaler = (timer_clock / MIDI_TIME_TICK_HZ) - 1U;
+  htim_midi_time.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim_midi_time.Init.Period = 0xFFFFFFFFU;
+  htim_midi_time.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim_midi_time.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim_midi_time) != HAL_OK) {
+    Error_Handler();
+  }
+  HAL_TIM_Base_Start(&htim_midi_time);
+
+  // Compare channels stay in frozen mode: only their match flags are used
+  HAL_NVIC_SetPriority(TIM2_IRQn, MIDI_TIME_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+/**
+  * @brief  Get the current time
+  * @retval Microseconds since MIDI_Time_Init (wraps every ~71 minutes)
+  */
+uint32_t MIDI_Time_Now(void)
+{
+  return MIDI_TIME_TIMER->CNT;
+}
+
+/**
+  * @brief  Notify a task once the timer reaches a given time
+  * @note   Re-arming replaces the previous time of the same alarm. A time that
+  *         has already passed notifies the task immediately.
+  * @param  alarm: Alarm to arm
+  * @param  when: Time to fire (MIDI_Time_Now() units)
+  * @param  task: Task to notify with xTaskNotifyGive semantics
+  * @retval None
+  */
+void MIDI_Time_SetAlarm(MidiTimeAlarm_t alarm, uint32_t when, TaskHandle_t task)
+{
+  taskENTER_CRITICAL();
+  alarm_tasks[alarm] = task;
+  *alarm_ccr[alarm] = when;
+  MIDI_TIME_TIMER->SR = ~alarm_flag[alarm];
+  MIDI_TIME_TIMER->DIER |= alarm_flag[alarm];
+  taskEXIT_CRITICAL();
+
+  // The compare match is missed if the counter passed 'when' while arming
+  if ((int32_t)(when - MIDI_Time_Now()) <= 0) {
+    MIDI_Time_CancelAlarm(alarm);
+    xTaskNotifyGive(task);
+  }
+}
+
+/**
+  * @brief  Disarm an alarm
+  * @param  alarm: Alarm to disarm
+  * @retval None
+  */
+void MIDI_Time_CancelAlarm(MidiTimeAlarm_t alarm)
+{
+  taskENTER_CRITICAL();
+  MIDI_TIME_TIMER->DIER &= ~alarm_flag[alarm];
+  taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  Set the callback an alarm runs in the TIM2 interrupt
+  * @note   Used instead of a task notification when the alarm has to act
+  *         at the exact time (e.g. send a byte). Set once before arming.
+  * @param  alarm: Alarm
+  * @param  callback: Callback (NULL: notify the task given to SetAlarm)
+  * @retval None
+  */
+void MIDI_Time_SetCallback(MidiTimeAlarm_t alarm, MidiTimeCallback_t callback)
+{
+  alarm_callbacks[alarm] = callback;
+}
+
+/**
+  * @brief  Arm a callback alarm
+  * @note   Re-arming replaces the previous time. A time that has already
+  *         passed raises the interrupt at once, so the callback always runs
+  *         in interrupt context.
+  * @param  alarm: Alarm with a callback
+  * @param  when: Time to fire (MIDI_Time_Now() units)
+  * @retval None
+  */
+void MIDI_Time_ArmCallback(MidiTimeAlarm_t alarm, uint32_t when)
+{
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  *alarm_ccr[alarm] = when;
+  MIDI_TIME_TIMER->SR = ~alarm_flag[alarm];
+  MIDI_TIME_TIMER->DIER |= alarm_flag[alarm];
+  if ((int32_t)(when - MIDI_Time_Now()) <= 0) {
+    MIDI_TIME_TIMER->EGR = alarm_event[alarm];
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/**
+  * @brief  TIM2 interrupt handler: fire the alarms whose compare value matched
+  * @retval None
+  */
+void MIDI_Time_IRQHandler(void)
+{
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  uint32_t pending = MIDI_TIME_TIMER->SR & MIDI_TIME_TIMER->DIER;
+
+  for (uint32_t i = 0; i < MIDI_TIME_ALARM_COUNT; i++) {
+    if (pending & alarm_flag[i]) {
+      MIDI_TIME_TIMER->DIER &= ~alarm_flag[i];
+      MIDI_TIME_TIMER->SR = ~alarm_flag[i];
+      if (alarm_callbacks[i] != NULL) {
+        uint32_t when = *alarm_ccr[i];
+        if (alarm_callbacks[i](&when, &xHigherPriorityTaskWoken)) {
+          MIDI_Time_ArmCallback((MidiTimeAlarm_t)i, when);
+        }
+      } else if (alarm_tasks[i] != NULL) {
+        vTaskNotifyGiveFromISR(alarm_tasks[i], &xHigherPriorityTaskWoken);
+      }
+    }
+  }
+
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/**
+  * @brief  Set the function that turns the USB SOF interrupt on and off
+  * @note   Without one, SOF is expected to be always on. With one, SOF is
+  *         turned on by the first frame timing query and off again after
+  *         MIDI_TIME_SOF_IDLE_US without queries, so an idle bus does not
+  *         interrupt every frame.
+  * @param  control: SOF control function
+  * @retval None
+  */
+void MIDI_Time_SetSofControl(MidiTimeSofControl_t control)
+{
+  sof_control = control;
+}
+
+/**
+  * @brief  Record the time of a USB Start Of Frame
+  * @param  frame_count: Frame number reported by the USB stack
+  * @retval None
+  */
+void MIDI_Time_SofFromISR(uint32_t frame_count)
+{
+  (void)frame_count;
+  uint32_t now = MIDI_Time_Now();
+  sof_time = now;
+  sof_seen = true;
+
+  if (sof_enabled && sof_control != NULL && (now - sof_used_time) >= MIDI_TIME_SOF_IDLE_US) {
+    sof_enabled = false;
+    sof_control(false, true);
+  }
+}
+
+/**
+  * @brief  Get the position of a time within its USB frame
+  * @note   Task context only: a query turns SOF on (see MIDI_Time_SetSofControl)
+  * @param  time: Time to locate (MIDI_Time_Now() units)
+  * @param  phase_us: Set to microseconds since the frame's SOF (0-999)
+  * @retval false if no SOF was seen during the last two frames (bus idle or suspended)
+  */
+bool MIDI_Time_FramePhase(uint32_t time, uint32_t *phase_us)
+{
+  uint32_t now = MIDI_Time_Now();
+  uint32_t last_sof = sof_time;
+  bool stale = !sof_seen || (now - last_sof) >= 2U * MIDI_TIME_FRAME_US;
+
+  // Keep SOF on while frame timing is in use; ask again if it stays away
+  // (bus reset or suspend), at most once per two frames
+  sof_used_time = now;
+  if (sof_control != NULL && (!sof_enabled || stale) &&
+      (now - sof_request_time) >= 2U * MIDI_TIME_FRAME_US) {
+    sof_enabled = true;
+    sof_request_time = now;
+    sof_control(true, false);
+  }
+  if (stale) {
+    return false;
+  }
+
+  // time may precede the last SOF by a little
+  int32_t offset = (int32_t)(time - last_sof) % (int32_t)MIDI_TIME_FRAME_US;
+  *phase_us = (uint32_t)((offset < 0) ? offset + (int32_t)MIDI_TIME_FRAME_US : offset);
+  return true;
+}
+
+/**
+  * @brief  Get the first frame flush point after a given time
+  * @note   A flush point lies lead_us before the next SOF, so data handed to
+  *         the USB stack there is ready when the next frame begins.
+  * @param  time: Earliest allowed flush time
+  * @param  lead_us: Distance of the flush point before the SOF
+  * @param  flush_time: Set to the flush point
+  * @retval false if no SOF was seen during the last two frames (flush_time unchanged)
+  */
+bool MIDI_Time_NextFrameFlush(uint32_t time, uint32_t lead_us, uint32_t *flush_time)
+{
+  uint32_t phase;
+  if (!MIDI_Time_FramePhase(time, &phase)) {
+    return false;
+  }
+
+  uint32_t point = MIDI_TIME_FRAME_US - lead_us;
+  *flush_time = time + ((phase <= point) ? (point - phase) : (MIDI_TIME_FRAME_US + point - phase));
+  return true;
+}
+
+/**
+  * @brief  Attach a capture time to a realtime event word
+  * @note   Realtime events carry a single MIDI byte, so the two unused upper
+  *         bytes hold the low 16 bits of the capture time (65 ms range).
+  * @param  event: Realtime USB-MIDI event word
+  * @param  time: Capture time (MIDI_Time_Now() units, not in the future)
+  * @retval Event word with timestamp
+  */
+uint32_t MIDI_Time_StampRealtime(uint32_t event, uint32_t time)
+{
+  return (event & 0x0000FFFFU) | (time << 16);
+}
+
+/**
+  * @brief  Get the full capture time of a stamped realtime event word
+  * @note   Valid while the event is less than 65 ms old
+  * @param  event: Event word stamped with MIDI_Time_StampRealtime
+  * @retval Capture time (MIDI_Time_Now() units)
+  */
+uint32_t MIDI_Time_RealtimeStamp(uint32_t event)
+{
+  uint32_t now = MIDI_Time_Now();
+  return now - ((now - (event >> 16)) & 0xFFFFU);
+}
+
+/**
+  * @brief  Get the full time of a 16-bit time stamp
+  * @note   Valid for times less than 32 ms before or after now
+  * @param  time: Low 16 bits of a MIDI_Time_Now() value
+  * @retval Time (MIDI_Time_Now() units)
+  */
+uint32_t MIDI_Time_Expand(uint16_t time)
+{
+  uint32_t now = MIDI_Time_Now();
+  return now + (uint32_t)(int32_t)(int16_t)(time - (uint16_t)now);
+}
+
+/**
+  * @brief  Remove the timestamp from a realtime event word and record its latency
+  * @param  event: Event word stamped with MIDI_Time_StampRealtime
+  * @param  latency_max_us: Statistic updated with the largest latency seen
+  * @retval Event word with the unused bytes cleared
+  */
+uint32_t MIDI_Time_UnstampRealtime(uint32_t event, uint32_t *latency_max_us)
+{
+  uint32_t latency = (MIDI_Time_Now() - (event >> 16)) & 0xFFFFU;
+  if (latency > *latency_max_us) {
+    *latency_max_us = latency;
+  }
+  return event & 0x0000FFFFU;
+}
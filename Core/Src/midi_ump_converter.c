@@ -0,0 +1,329 @@
+/**
+  * @file           : midi_ump_converter.c
+  * @brief          : Single-pass MIDI 1.0 event to MIDI 2.0 Protocol UMP converter implementation
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_ump_converter.h"
+#include "midi_parser.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define CONV_UNKNOWN                0xFF
+
+#define UMP_MT4                     0x40000000U
+#define UMP_MT2                     0x20000000U
+#define UMP_MT3                     0x30000000U
+
+// SysEx7 packet status (upper nibble of byte 1)
+#define SYSEX7_COMPLETE             0x0
+#define SYSEX7_START                0x1
+#define SYSEX7_CONTINUE             0x2
+#define SYSEX7_END                  0x3
+
+#define STATUS_NOTE_OFF             0x80
+#define STATUS_NOTE_ON              0x90
+#define STATUS_POLY_PRESSURE        0xA0
+#define STATUS_CONTROL_CHANGE       0xB0
+#define STATUS_PROGRAM_CHANGE       0xC0
+#define STATUS_CHANNEL_PRESSURE     0xD0
+#define STATUS_PITCH_BEND           0xE0
+#define STATUS_SYSEX_START          0xF0
+#define STATUS_SYSEX_END            0xF7
+
+#define CC_BANK_SELECT_MSB          0
+#define CC_BANK_SELECT_LSB          32
+
+#define NOTE_OFF_DEFAULT_VELOCITY   0x8000  // MIDI 1.0 velocity 64, used for Note On velocity 0
+#define PROGRAM_BANK_VALID          0x01    // Program Change option flag
+
+/* Exported variables --------------------------------------------------------*/
+// MIDI 2.0 min-center-max scaling of 7-bit values: 0 -> 0, 64 -> center, 127 -> max
+const uint16_t midi_ump_scale7to16[128] = {
+  0x0000, 0x0200, 0x0400, 0x0600, 0x0800, 0x0A00, 0x0C00, 0x0E00,
+  0x1000, 0x1200, 0x1400, 0x1600, 0x1800, 0x1A00, 0x1C00, 0x1E00,
+  0x2000, 0x2200, 0x2400, 0x2600, 0x2800, 0x2A00, 0x2C00, 0x2E00,
+  0x3000, 0x3200, 0x3400, 0x3600, 0x3800, 0x3A00, 0x3C00, 0x3E00,
+  0x4000, 0x4200, 0x4400, 0x4600, 0x4800, 0x4A00, 0x4C00, 0x4E00,
+  0x5000, 0x5200, 0x5400, 0x5600, 0x5800, 0x5A00, 0x5C00, 0x5E00,
+  0x6000, 0x6200, 0x6400, 0x6600, 0x6800, 0x6A00, 0x6C00, 0x6E00,
+  0x7000, 0x7200, 0x7400, 0x7600, 0x7800, 0x7A00, 0x7C00, 0x7E00,
+  0x8000, 0x8208, 0x8410, 0x8618, 0x8820, 0x8A28, 0x8C30, 0x8E38,
+  0x9041, 0x9249, 0x9451, 0x9659, 0x9861, 0x9A69, 0x9C71, 0x9E79,
+  0xA082, 0xA28A, 0xA492, 0xA69A, 0xA8A2, 0xAAAA, 0xACB2, 0xAEBA,
+  0xB0C3, 0xB2CB, 0xB4D3, 0xB6DB, 0xB8E3, 0xBAEB, 0xBCF3, 0xBEFB,
+  0xC104, 0xC30C, 0xC514, 0xC71C, 0xC924, 0xCB2C, 0xCD34, 0xCF3C,
+  0xD145, 0xD34D, 0xD555, 0xD75D, 0xD965, 0xDB6D, 0xDD75, 0xDF7D,
+  0xE186, 0xE38E, 0xE596, 0xE79E, 0xE9A6, 0xEBAE, 0xEDB6, 0xEFBE,
+  0xF1C7, 0xF3CF, 0xF5D7, 0xF7DF, 0xF9E7, 0xFBEF, 0xFDF7, 0xFFFF,
+};
+
+const uint32_t midi_ump_scale7to32[128] = {
+  0x00000000U, 0x02000000U, 0x04000000U, 0x06000000U,
+  0x08000000U, 0x0A000000U, 0x0C000000U, 0x0E000000U,
+  0x10000000U, 0x12000000U, 0x14000000U, 0x16000000U,
+  0x18000000U, 0x1A000000U, 0x1C000000U, 0x1E000000U,
+  0x20000000U, 0x22000000U, 0x24000000U, 0x26000000U,
+  0x28000000U, 0x2A000000U, 0x2C000000U, 0x2E000000U,
+  0x30000000U, 0x32000000U, 0x34000000U, 0x36000000U,
+  0x38000000U, 0x3A000000U, 0x3C000000U, 0x3E000000U,
+  0x40000000U, 0x42000000U, 0x44000000U, 0x46000000U,
+  0x48000000U, 0x4A000000U, 0x4C000000U, 0x4E000000U,
+  0x50000000U, 0x52000000U, 0x54000000U, 0x56000000U,
+  0x58000000U, 0x5A000000U, 0x5C000000U, 0x5E000000U,
+  0x60000000U, 0x62000000U, 0x64000000U, 0x66000000U,
+  0x68000000U, 0x6A000000U, 0x6C000000U, 0x6E000000U,
+  0x70000000U, 0x72000000U, 0x74000000U, 0x76000000U,
+  0x78000000U, 0x7A000000U, 0x7C000000U, 0x7E000000U,
+  0x80000000U, 0x82082082U, 0x84104104U, 0x86186186U,
+  0x88208208U, 0x8A28A28AU, 0x8C30C30CU, 0x8E38E38EU,
+  0x90410410U, 0x92492492U, 0x94514514U, 0x96596596U,
+  0x98618618U, 0x9A69A69AU, 0x9C71C71CU, 0x9E79E79EU,
+  0xA0820820U, 0xA28A28A2U, 0xA4924924U, 0xA69A69A6U,
+  0xA8A28A28U, 0xAAAAAAAAU, 0xACB2CB2CU, 0xAEBAEBAEU,
+  0xB0C30C30U, 0xB2CB2CB2U, 0xB4D34D34U, 0xB6DB6DB6U,
+  0xB8E38E38U, 0xBAEBAEBAU, 0xBCF3CF3CU, 0xBEFBEFBEU,
+  0xC1041041U, 0xC30C30C3U, 0xC5145145U, 0xC71C71C7U,
+  0xC9249249U, 0xCB2CB2CBU, 0xCD34D34DU, 0xCF3CF3CFU,
+  0xD1451451U, 0xD34D34D3U, 0xD5555555U, 0xD75D75D7U,
+  0xD9659659U, 0xDB6DB6DBU, 0xDD75D75DU, 0xDF7DF7DFU,
+  0xE1861861U, 0xE38E38E3U, 0xE5965965U, 0xE79E79E7U,
+  0xE9A69A69U, 0xEBAEBAEBU, 0xEDB6DB6DU, 0xEFBEFBEFU,
+  0xF1C71C71U, 0xF3CF3CF3U, 0xF5D75D75U, 0xF7DF7DF7U,
+  0xF9E79E79U, 0xFBEFBEFBU, 0xFDF7DF7DU, 0xFFFFFFFFU,
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t ConvertChannelVoice(MidiUmpConverter_t *converter, uint32_t event, uint32_t *ump);
+static uint32_t SysExByte(MidiUmpConverter_t *converter, uint8_t byte, uint32_t *ump);
+static uint32_t WriteSysExPacket(MidiUmpConverter_t *converter, uint8_t status, uint32_t *ump);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize a converter with no SysEx in progress and no banks selected
+  * @param  converter: Converter instance
+  * @param  group: UMP group placed in the output
+  * @retval None
+  */
+void MIDI_UmpConverter_Init(MidiUmpConverter_t *converter, uint8_t group)
+{
+  memset(converter, 0, sizeof(*converter));
+  memset(converter->bank_msb, CONV_UNKNOWN, sizeof(converter->bank_msb));
+  memset(converter->bank_lsb, CONV_UNKNOWN, sizeof(converter->bank_lsb));
+  converter->group = group & 0x0F;
+}
+
+/**
+  * @brief  Select the protocol of channel voice output
+  * @note   Bank Select values kept for MIDI 2.0 Program Change are forgotten,
+  *         since MIDI 1.0 Protocol output passes them on as they arrive.
+  * @param  converter: Converter instance
+  * @param  midi1_protocol: true for MIDI 1.0 Protocol, false for MIDI 2.0 Protocol
+  * @retval None
+  */
+void MIDI_UmpConverter_SetProtocol(MidiUmpConverter_t *converter, bool midi1_protocol)
+{
+  if (converter->midi1_protocol != midi1_protocol) {
+    converter->midi1_protocol = midi1_protocol;
+    memset(converter->bank_msb, CONV_UNKNOWN, sizeof(converter->bank_msb));
+    memset(converter->bank_lsb, CONV_UNKNOWN, sizeof(converter->bank_lsb));
+  }
+}
+
+/**
+  * @brief  Convert one MIDI 1.0 event to UMPs
+  * @note   Realtime events need no converter state; callers may encode them
+  *         directly with MIDI_UMP_SYSTEM.
+  * @param  converter: Converter instance
+  * @param  event: USB-MIDI event word from the DIN input parser
+  * @param  ump: Output, room for MIDI_UMP_CONVERTER_MAX_WORDS words
+  * @retval Number of UMP words written (complete UMPs only)
+  */
+uint32_t MIDI_UmpConverter_Process(MidiUmpConverter_t *converter, uint32_t event, uint32_t *ump)
+{
+  uint8_t status = MIDI_EVENT_BYTE(event, 0);
+
+  if (status >= STATUS_NOTE_OFF && status < STATUS_SYSEX_START &&
+      MIDI_EVENT_CIN(event) == (status >> 4)) {
+    if (converter->midi1_protocol) {
+      // The event word already holds status and data in UMP byte order
+      ump[0] = UMP_MT2 | ((uint32_t)converter->group << 24) | ((uint32_t)status << 16) |
+               ((uint32_t)(MIDI_EVENT_BYTE(event, 1) & 0x7F) << 8) | (MIDI_EVENT_BYTE(event, 2) & 0x7F);
+      return 1;
+    }
+    return ConvertChannelVoice(converter, event, ump);
+  }
+
+  if (MIDI_EVENT_IS_SYSEX(event)) {
+    // SysEx chunks, or a single-byte System Common message (CIN 0x5)
+    uint32_t count = 0;
+    uint8_t length = MIDI_Parser_EventLength(event);
+    for (uint8_t i = 0; i < length; i++) {
+      count += SysExByte(converter, MIDI_EVENT_BYTE(event, i), &ump[count]);
+    }
+    return count;
+  }
+
+  uint8_t length = MIDI_Parser_EventLength(event);
+  if (status < 0xF1 || length == 0) {
+    return 0;
+  }
+  ump[0] = MIDI_UMP_SYSTEM(converter->group, status,
+                           (length > 1) ? MIDI_EVENT_BYTE(event, 1) : 0,
+                           (length > 2) ? MIDI_EVENT_BYTE(event, 2) : 0);
+  return 1;
+}
+
+/**
+  * @brief  Scale a 14-bit value (Pitch Bend) to 32 bits
+  * @param  value: 14-bit value
+  * @retval 32-bit value (0x2000 maps to 0x80000000)
+  */
+uint32_t MIDI_UmpConverter_Scale14To32(uint16_t value)
+{
+  uint32_t result = (uint32_t)value << 18;
+  if (value <= 0x2000) {
+    return result;
+  }
+
+  // Above the center, repeat the 13 bits below the top bit to fill the range
+  uint32_t repeat = (uint32_t)(value & 0x1FFF) << 5;
+  while (repeat != 0) {
+    result |= repeat;
+    repeat >>= 13;
+  }
+  return result;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Convert a MIDI 1.0 channel voice message to a MIDI 2.0 one
+  * @param  converter: Converter instance
+  * @param  event: Channel voice event word
+  * @param  ump: Output, room for 2 words
+  * @retval Number of UMP words written (0 for Bank Select, 2 otherwise)
+  */
+static uint32_t ConvertChannelVoice(MidiUmpConverter_t *converter, uint32_t event, uint32_t *ump)
+{
+  uint8_t status = MIDI_EVENT_BYTE(event, 0);
+  uint8_t channel = status & 0x0F;
+  uint8_t data1 = MIDI_EVENT_BYTE(event, 1) & 0x7F;
+  uint8_t data2 = MIDI_EVENT_BYTE(event, 2) & 0x7F;
+  uint32_t header = UMP_MT4 | ((uint32_t)converter->group << 24) | ((uint32_t)channel << 16);
+
+  switch (status & 0xF0) {
+    case STATUS_NOTE_ON:
+      if (data2 == 0) {
+        ump[0] = header | ((uint32_t)STATUS_NOTE_OFF << 16) | ((uint32_t)data1 << 8);
+        ump[1] = (uint32_t)NOTE_OFF_DEFAULT_VELOCITY << 16;
+        return 2;
+      }
+      // Fall through
+    case STATUS_NOTE_OFF:
+      ump[0] = header | ((uint32_t)(status & 0xF0) << 16) | ((uint32_t)data1 << 8);
+      ump[1] = (uint32_t)midi_ump_scale7to16[data2] << 16;
+      return 2;
+
+    case STATUS_POLY_PRESSURE:
+      ump[0] = header | ((uint32_t)STATUS_POLY_PRESSURE << 16) | ((uint32_t)data1 << 8);
+      ump[1] = midi_ump_scale7to32[data2];
+      return 2;
+
+    case STATUS_CONTROL_CHANGE:
+      if (data1 == CC_BANK_SELECT_MSB) {
+        converter->bank_msb[channel] = data2;
+        return 0;
+      }
+      if (data1 == CC_BANK_SELECT_LSB) {
+        converter->bank_lsb[channel] = data2;
+        return 0;
+      }
+      ump[0] = header | ((uint32_t)STATUS_CONTROL_CHANGE << 16) | ((uint32_t)data1 << 8);
+      ump[1] = midi_ump_scale7to32[data2];
+      return 2;
+
+    case STATUS_PROGRAM_CHANGE:
+      ump[0] = header | ((uint32_t)STATUS_PROGRAM_CHANGE << 16);
+      ump[1] = (uint32_t)data1 << 24;
+      if (converter->bank_msb[channel] != CONV_UNKNOWN) {
+        uint8_t lsb = (converter->bank_lsb[channel] != CONV_UNKNOWN) ? converter->bank_lsb[channel] : 0;
+        ump[0] |= PROGRAM_BANK_VALID;
+        ump[1] |= ((uint32_t)converter->bank_msb[channel] << 8) | lsb;
+      }
+      return 2;
+
+    case STATUS_CHANNEL_PRESSURE:
+      ump[0] = header | ((uint32_t)STATUS_CHANNEL_PRESSURE << 16);
+      ump[1] = midi_ump_scale7to32[data1];
+      return 2;
+
+    default:  // STATUS_PITCH_BEND
+      ump[0] = header | ((uint32_t)STATUS_PITCH_BEND << 16);
+      ump[1] = MIDI_UmpConverter_Scale14To32((uint16_t)(((uint16_t)data2 << 7) | data1));
+      return 2;
+  }
+}
+
+/**
+  * @brief  Add one byte of a SysEx chunk event
+  * @param  converter: Converter instance
+  * @param  byte: F0, F7, a data byte, or a single-byte System Common status
+  * @param  ump: Output, room for 2 words
+  * @retval Number of UMP words written
+  */
+static uint32_t SysExByte(MidiUmpConverter_t *converter, uint8_t byte, uint32_t *ump)
+{
+  if (byte == STATUS_SYSEX_START) {
+    converter->in_sysex = true;
+    converter->sysex_started = false;
+    converter->sysex_count = 0;
+    return 0;
+  }
+
+  if (byte == STATUS_SYSEX_END) {
+    if (!converter->in_sysex) {
+      return 0;
+    }
+    converter->in_sysex = false;
+    return WriteSysExPacket(converter, converter->sysex_started ? SYSEX7_END : SYSEX7_COMPLETE, ump);
+  }
+
+  if (byte >= 0x80) {
+    // Tune Request and other single-byte System Common
+    ump[0] = MIDI_UMP_SYSTEM(converter->group, byte, 0, 0);
+    return 1;
+  }
+
+  if (!converter->in_sysex) {
+    return 0;
+  }
+
+  // A full packet is sent only when the next byte shows more data follows,
+  // so a SysEx of exactly 6 bytes still goes out as one Complete packet
+  uint32_t count = 0;
+  if (converter->sysex_count == sizeof(converter->sysex)) {
+    count = WriteSysExPacket(converter, converter->sysex_started ? SYSEX7_CONTINUE : SYSEX7_START, ump);
+    converter->sysex_started = true;
+  }
+  converter->sysex[converter->sysex_count++] = byte;
+  return count;
+}
+
+/**
+  * @brief  Send the buffered SysEx bytes as one 7-bit SysEx packet
+  * @param  converter: Converter instance
+  * @param  status: SYSEX7_COMPLETE / START / CONTINUE / END
+  * @param  ump: Output, room for 2 words
+  * @retval Number of UMP words written (2)
+  */
+static uint32_t WriteSysExPacket(MidiUmpConverter_t *converter, uint8_t status, uint32_t *ump)
+{
+  uint8_t bytes[6] = {0};
+  memcpy(bytes, converter->sysex, converter->sysex_count);
+
+  ump[0] = UMP_MT3 | ((uint32_t)converter->group << 24) | ((uint32_t)status << 20) |
+           ((uint32_t)converter->sysex_count << 16) | ((uint32_t)bytes[0] << 8) | bytes[1];
+  ump[1] = ((uint32_t)bytes[2] << 24) | ((uint32_t)bytes[3] << 16) | ((uint32_t)bytes[4] << 8) | bytes[5];
+  converter->sysex_count = 0;
+  return 2;
+}
@@ -0,0 +1,249 @@
+/**
+  * @file           : midi_ump_encoder.c
+  * @brief          : Direct UMP to MIDI 1.0 encoder implementation
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_ump_encoder.h"
+#include "midi_parser.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define UMP_TYPE_SYSTEM             0x1
+#define UMP_TYPE_MIDI1_VOICE        0x2
+#define UMP_TYPE_SYSEX7             0x3
+#define UMP_TYPE_MIDI2_VOICE        0x4
+
+// SysEx7 packet status
+#define SYSEX7_COMPLETE             0x0
+#define SYSEX7_START                0x1
+#define SYSEX7_CONTINUE             0x2
+#define SYSEX7_END                  0x3
+
+// MIDI 2.0 channel voice status
+#define M2_REGISTERED_CONTROLLER    0x2
+#define M2_ASSIGNABLE_CONTROLLER    0x3
+#define M2_NOTE_OFF                 0x8
+#define M2_NOTE_ON                  0x9
+#define M2_POLY_PRESSURE            0xA
+#define M2_CONTROL_CHANGE           0xB
+#define M2_PROGRAM_CHANGE           0xC
+#define M2_CHANNEL_PRESSURE         0xD
+#define M2_PITCH_BEND               0xE
+
+#define PROGRAM_BANK_VALID          0x01
+
+#define CC_BANK_SELECT_MSB          0
+#define CC_DATA_ENTRY_MSB           6
+#define CC_BANK_SELECT_LSB          32
+#define CC_DATA_ENTRY_LSB           38
+#define CC_NRPN_LSB                 98
+#define CC_NRPN_MSB                 99
+#define CC_RPN_LSB                  100
+#define CC_RPN_MSB                  101
+
+#define CIN_SYSEX                   0x4
+#define CIN_SYSEX_END_1             0x5
+
+/* Private macros ------------------------------------------------------------*/
+#define EVENT(cin, b0, b1, b2) \
+  ((uint32_t)(cin) | ((uint32_t)(b0) << 8) | ((uint32_t)(b1) << 16) | ((uint32_t)(b2) << 24))
+#define CC_EVENT(channel, controller, value) \
+  EVENT(0xB, 0xB0 | (channel), (controller), (value))
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t EncodeMidi2Voice(const uint32_t *ump, uint32_t *events);
+static uint32_t EncodeSysEx7(MidiUmpEncoder_t *encoder, const uint32_t *ump, uint32_t *events);
+static uint32_t SysExByte(MidiUmpEncoder_t *encoder, uint8_t byte, uint32_t *events);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an encoder with no SysEx in progress
+  * @param  encoder: Encoder instance
+  * @retval None
+  */
+void MIDI_UmpEncoder_Init(MidiUmpEncoder_t *encoder)
+{
+  memset(encoder, 0, sizeof(*encoder));
+}
+
+/**
+  * @brief  Encode one complete UMP as MIDI 1.0 events
+  * @note   Every word of the UMP is used, whatever its value.
+  * @param  encoder: Encoder instance
+  * @param  ump: Complete UMP (1-4 words, as given by its message type)
+  * @param  events: Output, room for MIDI_UMP_ENCODER_MAX_EVENTS events
+  * @retval Number of events written
+  */
+uint32_t MIDI_UmpEncoder_Process(MidiUmpEncoder_t *encoder, const uint32_t *ump, uint32_t *events)
+{
+  uint8_t status = (uint8_t)(ump[0] >> 16);
+  uint8_t entry;
+  uint8_t length;
+
+  switch (ump[0] >> 28) {
+    case UMP_TYPE_SYSTEM:
+    case UMP_TYPE_MIDI1_VOICE:
+      entry = midi_parser_table[status];
+      length = (entry & MIDI_PARSER_LENGTH_MASK) >> MIDI_PARSER_LENGTH_SHIFT;
+      // SysEx bytes and undefined statuses are not valid here
+      if (length == 0 || status == 0xF0 || status == 0xF7 ||
+          ((ump[0] >> 28) == UMP_TYPE_MIDI1_VOICE) != (status < 0xF0)) {
+        return 0;
+      }
+      events[0] = EVENT(entry & MIDI_PARSER_CIN_MASK, status,
+                        (length > 1) ? (ump[0] >> 8) & 0x7F : 0,
+                        (length > 2) ? ump[0] & 0x7F : 0);
+      return 1;
+
+    case UMP_TYPE_SYSEX7:
+      return EncodeSysEx7(encoder, ump, events);
+
+    case UMP_TYPE_MIDI2_VOICE:
+      return EncodeMidi2Voice(ump, events);
+
+    default:
+      return 0;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Translate a MIDI 2.0 channel voice message to MIDI 1.0
+  * @param  ump: 64-bit UMP
+  * @param  events: Output, room for 4 events
+  * @retval Number of events written
+  */
+static uint32_t EncodeMidi2Voice(const uint32_t *ump, uint32_t *events)
+{
+  uint8_t channel = (ump[0] >> 16) & 0x0F;
+  uint8_t index1 = (ump[0] >> 8) & 0x7F;
+  uint8_t index2 = ump[0] & 0x7F;
+  uint32_t data = ump[1];
+  uint8_t value7 = (uint8_t)(data >> 25);
+
+  switch ((ump[0] >> 20) & 0x0F) {
+    case M2_NOTE_OFF:
+      events[0] = EVENT(0x8, 0x80 | channel, index1, data >> 25);
+      return 1;
+
+    case M2_NOTE_ON: {
+      // Velocity 0 would turn the MIDI 1.0 Note On into a Note Off
+      uint8_t velocity = (uint8_t)(data >> 25);
+      events[0] = EVENT(0x9, 0x90 | channel, index1, (velocity == 0) ? 1 : velocity);
+      return 1;
+    }
+
+    case M2_POLY_PRESSURE:
+      events[0] = EVENT(0xA, 0xA0 | channel, index1, value7);
+      return 1;
+
+    case M2_CONTROL_CHANGE:
+      events[0] = CC_EVENT(channel, index1, value7);
+      return 1;
+
+    case M2_REGISTERED_CONTROLLER:
+    case M2_ASSIGNABLE_CONTROLLER: {
+      bool registered = ((ump[0] >> 20) & 0x0F) == M2_REGISTERED_CONTROLLER;
+      events[0] = CC_EVENT(channel, registered ? CC_RPN_MSB : CC_NRPN_MSB, index1);
+      events[1] = CC_EVENT(channel, registered ? CC_RPN_LSB : CC_NRPN_LSB, index2);
+      events[2] = CC_EVENT(channel, CC_DATA_ENTRY_MSB, value7);
+      events[3] = CC_EVENT(channel, CC_DATA_ENTRY_LSB, (data >> 18) & 0x7F);
+      return 4;
+    }
+
+    case M2_PROGRAM_CHANGE: {
+      uint32_t count = 0;
+      if (ump[0] & PROGRAM_BANK_VALID) {
+        events[count++] = CC_EVENT(channel, CC_BANK_SELECT_MSB, (data >> 8) & 0x7F);
+        events[count++] = CC_EVENT(channel, CC_BANK_SELECT_LSB, data & 0x7F);
+      }
+      events[count++] = EVENT(0xC, 0xC0 | channel, (data >> 24) & 0x7F, 0);
+      return count;
+    }
+
+    case M2_CHANNEL_PRESSURE:
+      events[0] = EVENT(0xD, 0xD0 | channel, value7, 0);
+      return 1;
+
+    case M2_PITCH_BEND:
+      events[0] = EVENT(0xE, 0xE0 | channel, (data >> 18) & 0x7F, value7);
+      return 1;
+
+    default:
+      // Per-note and relative controllers have no MIDI 1.0 form
+      return 0;
+  }
+}
+
+/**
+  * @brief  Translate a 7-bit SysEx packet to SysEx events
+  * @param  encoder: Encoder instance
+  * @param  ump: 64-bit UMP
+  * @param  events: Output, room for 4 events
+  * @retval Number of events written
+  */
+static uint32_t EncodeSysEx7(MidiUmpEncoder_t *encoder, const uint32_t *ump, uint32_t *events)
+{
+  uint8_t status = (ump[0] >> 20) & 0x0F;
+  uint8_t count = (ump[0] >> 16) & 0x0F;
+  const uint8_t bytes[6] = {
+    (uint8_t)(ump[0] >> 8), (uint8_t)ump[0],
+    (uint8_t)(ump[1] >> 24), (uint8_t)(ump[1] >> 16), (uint8_t)(ump[1] >> 8), (uint8_t)ump[1],
+  };
+  uint32_t event_count = 0;
+
+  if (count > 6) {
+    count = 6;
+  }
+
+  if (status == SYSEX7_COMPLETE || status == SYSEX7_START) {
+    // An unterminated SysEx ends here, so the receiver does not merge the two
+    if (encoder->in_sysex) {
+      event_count += SysExByte(encoder, 0xF7, &events[event_count]);
+    }
+    event_count += SysExByte(encoder, 0xF0, &events[event_count]);
+  } else if (!encoder->in_sysex) {
+    return 0;  // Continue / End without a Start
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    event_count += SysExByte(encoder, bytes[i] & 0x7F, &events[event_count]);
+  }
+
+  if (status == SYSEX7_COMPLETE || status == SYSEX7_END) {
+    event_count += SysExByte(encoder, 0xF7, &events[event_count]);
+  }
+  return event_count;
+}
+
+/**
+  * @brief  Add one byte to the SysEx event being assembled
+  * @param  encoder: Encoder instance
+  * @param  byte: F0, F7 or a data byte
+  * @param  events: Output, room for 1 event
+  * @retval Number of events written (0 or 1)
+  */
+static uint32_t SysExByte(MidiUmpEncoder_t *encoder, uint8_t byte, uint32_t *events)
+{
+  if (byte == 0xF0) {
+    encoder->in_sysex = true;
+    encoder->sysex_count = 0;
+  }
+  encoder->sysex[encoder->sysex_count++] = byte;
+
+  if (byte == 0xF7) {
+    encoder->in_sysex = false;
+    events[0] = EVENT(CIN_SYSEX_END_1 + encoder->sysex_count - 1, encoder->sysex[0],
+                      (encoder->sysex_count > 1) ? encoder->sysex[1] : 0,
+                      (encoder->sysex_count > 2) ? encoder->sysex[2] : 0);
+    encoder->sysex_count = 0;
+    return 1;
+  }
+  if (encoder->sysex_count == 3) {
+    events[0] = EVENT(CIN_SYSEX, encoder->sysex[0], encoder->sysex[1], encoder->sysex[2]);
+    encoder->sysex_count = 0;
+    return 1;
+  }
+  return 0;
+}
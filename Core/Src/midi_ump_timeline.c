@@ -0,0 +1,200 @@
+/**
+  * @file           : midi_ump_timeline.c
+  * @brief          : Timestamp-ordered UMP release for the DIN output
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "midi_ump_timeline.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+// UMP Utility message statuses (message type 0x0, bits 23-20)
+#define UTILITY_JR_CLOCK        0x1
+#define UTILITY_JR_TIMESTAMP    0x2
+#define UTILITY_DCTPQ           0x3
+#define UTILITY_DELTA_CLOCK     0x4
+
+/* Private function prototypes -----------------------------------------------*/
+static void TrackJrOffset(MidiUmpTimeline_t *timeline, uint16_t jr, uint32_t now);
+static uint32_t JrToLocal(const MidiUmpTimeline_t *timeline, uint16_t jr, uint32_t now);
+static void SetNextTime(MidiUmpTimeline_t *timeline, uint32_t time);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an empty timeline
+  * @param  timeline: Timeline instance
+  * @param  lookahead_us: Delay added to every timestamp
+  * @retval None
+  */
+void MIDI_UmpTimeline_Init(MidiUmpTimeline_t *timeline, uint32_t lookahead_us)
+{
+  memset(timeline, 0, sizeof(*timeline));
+  timeline->lookahead_us = lookahead_us;
+  timeline->quarter_us = MIDI_UMP_TIMELINE_QUARTER_US;
+}
+
+/**
+  * @brief  Take one UMP from the host
+  * @note   Utility messages only update the timing state. Any other message is
+  *         queued for its release time; a JR Timestamp or Delta Clockstamp
+  *         applies to the next message only.
+  * @param  timeline: Timeline instance
+  * @param  ump: UMP message (up to 4 words)
+  * @param  now: Current time (microseconds)
+  * @retval false if the timeline is full (the message is not taken)
+  */
+bool MIDI_UmpTimeline_Push(MidiUmpTimeline_t *timeline, const uint32_t *ump, uint32_t now)
+{
+  if ((ump[0] >> 28) == 0x0) {
+    uint16_t value = (uint16_t)ump[0];
+    switch ((ump[0] >> 20) & 0xF) {
+      case UTILITY_JR_CLOCK:
+        TrackJrOffset(timeline, value, now);
+        timeline->jr_clock_seen = true;
+        break;
+      case UTILITY_JR_TIMESTAMP:
+        if (!timeline->jr_clock_seen) {
+          TrackJrOffset(timeline, value, now);
+        }
+        SetNextTime(timeline, JrToLocal(timeline, value, now) + timeline->lookahead_us);
+        break;
+      case UTILITY_DCTPQ:
+        timeline->dc_tpq = value;
+        break;
+      case UTILITY_DELTA_CLOCK:
+        if (timeline->dc_tpq != 0) {
+          uint32_t base = timeline->dc_valid ? timeline->dc_time : now + timeline->lookahead_us;
+          uint64_t delta_us = (uint64_t)(ump[0] & 0xFFFFFU) * timeline->quarter_us / timeline->dc_tpq;
+          SetNextTime(timeline, base + (uint32_t)delta_us);
+        }
+        break;
+      default:
+        break;  // NOOP and unknown utility messages
+    }
+    return true;
+  }
+
+  if (timeline->count == MIDI_UMP_TIMELINE_SIZE) {
+    timeline->next_timed = false;  // The caller sends the message some other way
+    return false;
+  }
+
+  uint32_t time = now;
+  if (timeline->next_timed) {
+    timeline->next_timed = false;
+    if ((int32_t)(timeline->next_time - now) >= 0) {
+      time = timeline->next_time;
+    } else {
+      // Released at once; later Delta Clockstamps count from a fresh position
+      timeline->late++;
+      timeline->dc_time = now + timeline->lookahead_us;
+    }
+  }
+
+  // Stay behind every message due at the same time or earlier
+  uint32_t i = timeline->count;
+  while (i > 0 && (int32_t)(timeline->entries[i - 1].time - time) > 0) {
+    i--;
+  }
+  memmove(&timeline->entries[i + 1], &timeline->entries[i],
+          (timeline->count - i) * sizeof(MidiUmpTimelineEntry_t));
+  memcpy(timeline->entries[i].ump, ump, sizeof(timeline->entries[i].ump));
+  timeline->entries[i].time = time;
+  timeline->count++;
+  return true;
+}
+
+/**
+  * @brief  Get the release time of the first queued message
+  * @param  timeline: Timeline instance
+  * @param  time: Set to the release time
+  * @retval false if the timeline is empty
+  */
+bool MIDI_UmpTimeline_NextTime(const MidiUmpTimeline_t *timeline, uint32_t *time)
+{
+  if (timeline->count == 0) {
+    return false;
+  }
+  *time = timeline->entries[0].time;
+  return true;
+}
+
+/**
+  * @brief  Get the first queued message if it is due
+  * @param  timeline: Timeline instance
+  * @param  now: Current time (microseconds)
+  * @retval UMP message (4 words), or NULL if none is due
+  */
+const uint32_t *MIDI_UmpTimeline_Peek(const MidiUmpTimeline_t *timeline, uint32_t now)
+{
+  if (timeline->count == 0 || (int32_t)(timeline->entries[0].time - now) > 0) {
+    return NULL;
+  }
+  return timeline->entries[0].ump;
+}
+
+/**
+  * @brief  Remove the first queued message
+  * @param  timeline: Timeline instance
+  * @retval None
+  */
+void MIDI_UmpTimeline_Pop(MidiUmpTimeline_t *timeline)
+{
+  if (timeline->count == 0) {
+    return;
+  }
+  timeline->count--;
+  memmove(&timeline->entries[0], &timeline->entries[1],
+          timeline->count * sizeof(MidiUmpTimelineEntry_t));
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Update the sender to local JR offset from a sender time seen now
+  * @note   The smallest offset belongs to the sample that arrived with the
+  *         least delay. One that grew beyond the look-ahead (clock drift, host
+  *         restart) is taken over as it is.
+  * @param  timeline: Timeline instance
+  * @param  jr: Sender JR time
+  * @param  now: Current time (microseconds)
+  * @retval None
+  */
+static void TrackJrOffset(MidiUmpTimeline_t *timeline, uint16_t jr, uint32_t now)
+{
+  uint16_t sample = (uint16_t)(now / MIDI_UMP_TIMELINE_JR_TICK_US) - jr;
+  int16_t growth = (int16_t)(sample - timeline->jr_offset);
+
+  if (!timeline->jr_synced || growth < 0 ||
+      (uint32_t)growth * MIDI_UMP_TIMELINE_JR_TICK_US > timeline->lookahead_us) {
+    timeline->jr_offset = sample;
+    timeline->jr_synced = true;
+  }
+}
+
+/**
+  * @brief  Convert a sender JR time to the local time nearest to now
+  * @param  timeline: Timeline instance
+  * @param  jr: Sender JR time
+  * @param  now: Current time (microseconds)
+  * @retval Local time (microseconds, within about +/-1 s of now)
+  */
+static uint32_t JrToLocal(const MidiUmpTimeline_t *timeline, uint16_t jr, uint32_t now)
+{
+  uint16_t local_jr = (uint16_t)(jr + timeline->jr_offset);
+  int16_t ahead = (int16_t)(local_jr - (uint16_t)(now / MIDI_UMP_TIMELINE_JR_TICK_US));
+  return now - (now % MIDI_UMP_TIMELINE_JR_TICK_US) + (uint32_t)((int32_t)ahead * (int32_t)MIDI_UMP_TIMELINE_JR_TICK_US);
+}
+
+/**
+  * @brief  Set the release time of the next message
+  * @param  timeline: Timeline instance
+  * @param  time: Release time (microseconds)
+  * @retval None
+  */
+static void SetNextTime(MidiUmpTimeline_t *timeline, uint32_t time)
+{
+  timeline->next_time = time;
+  timeline->next_timed = true;
+  timeline->dc_time = time;
+  timeline->dc_valid = true;
+}
@@ -25,6 +25,9 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "tusb.h"
+#include "uart_midi_task.h"
+#include "uart_tx.h"
+#include "midi_time.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -239,6 +242,14 @@ void USART2_IRQHandler(void)
   /* USER CODE END USART2_IRQn 1 */
 }
 
+/**
+  * @brief This function handles TIM2 global interrupt (MIDI timebase alarms).
+  */
+void TIM2_IRQHandler(void)
+{
+  MIDI_Time_IRQHandler();
+}
+
 /**
   * @brief UART TX Complete callback
   * @param huart: UART handle
@@ -246,18 +257,32 @@ void USART2_IRQHandler(void)
   */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
-  extern SemaphoreHandle_t xUartTxCompleteSemaphore;
-  extern volatile uint8_t uart_tx_dma_busy;
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
   
   if (huart->Instance == USART2) {
-    // Clear DMA busy flag
-    uart_tx_dma_busy = 0;
+    // Start the next queued span right away
+    UART_TX_CompleteFromISR(&xHigherPriorityTaskWoken);
     
-    // Signal that TX is complete
-    if (xUartTxCompleteSemaphore != NULL) {
-      xSemaphoreGiveFromISR(xUartTxCompleteSemaphore, &xHigherPriorityTaskWoken);
-    }
+    // Yield if a higher priority task was woken
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+  }
+}
+
+/**
+  * @brief UART RX event callback (IDLE line, DMA half transfer or DMA transfer complete)
+  * @param huart: UART handle
+  * @param Size: Number of bytes received in the DMA buffer
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  
+  if (huart->Instance == USART2) {
+    // Note when the bytes up to Size arrived, then wake the UART RX task to
+    // process them (it reads the DMA counter itself)
+    UART_RX_MarkFromISR(Size, HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE);
+    UART_RX_NotifyFromISR(&xHigherPriorityTaskWoken);
     
     // Yield if a higher priority task was woken
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
@@ -271,22 +296,18 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
   */
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
-  extern SemaphoreHandle_t xUartTxCompleteSemaphore;
-  extern volatile uint8_t uart_tx_dma_busy;
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
   
   if (huart->Instance == USART2) {
-    // Clear DMA busy flag on error
-    uart_tx_dma_busy = 0;
-    
-    // Signal that TX is complete (even on error)
-    if (xUartTxCompleteSemaphore != NULL) {
-      xSemaphoreGiveFromISR(xUartTxCompleteSemaphore, &xHigherPriorityTaskWoken);
-    }
+    // Restart the TX chain if the error aborted the running transfer
+    UART_TX_ErrorFromISR(&xHigherPriorityTaskWoken);
     
     // Clear error flags
     __HAL_UART_CLEAR_FLAG(huart, UART_FLAG_ORE | UART_FLAG_NE | UART_FLAG_FE | UART_FLAG_PE);
     
+    // Re-arm DMA reception if the error aborted it
+    UART_RX_ErrorFromISR(&xHigherPriorityTaskWoken);
+    
     // Yield if a higher priority task was woken
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
   }
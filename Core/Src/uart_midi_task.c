@@ -5,7 +5,11 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "uart_midi_task.h"
+#include "midi_parser.h"
+#include "midi_time.h"
+#include "ump_discovery.h"
 #include "tusb.h"
+#include "device/usbd_pvt.h"  // For usbd_edpt_claim / usbd_edpt_xfer
 #include <string.h>
 #include <stdbool.h>
 
@@ -13,31 +17,88 @@
 extern UART_HandleTypeDef huart2;
 extern UART_HandleTypeDef huart1;
 
+/* Private defines -----------------------------------------------------------*/
+#define USB_MIDI_TX_ENDPOINT 0x81  // MIDI 1.0 bulk IN endpoint (EPNUM_MIDI_IN in usb_descriptors.c)
+
 /* Private variables ---------------------------------------------------------*/
 static TickType_t rxLedOnTime = 0;  // Shared LED on time
+static TaskHandle_t xUartRxTaskHandle = NULL;  // Notified by UART IDLE / DMA HT / DMA TC events
+static volatile uint8_t uart_rx_restart_pending = 0;  // Set when DMA reception was restarted after an error
+static volatile uint32_t rx_mark_time = 0;      // Capture time of the byte before rx_mark_position
+static volatile uint16_t rx_mark_position = 0;  // DMA write position at the last reception event
+
+// Byte stream parser for the DIN MIDI IN port
+static MidiParser_t din_parser;
 
-// SysEx buffer for accumulating SysEx messages from UART
-#define UART_SYSEX_BUFFER_SIZE 1024  // Increased to handle larger SysEx messages
-static struct {
-  uint8_t data[UART_SYSEX_BUFFER_SIZE];
-  uint16_t length;
-  bool in_sysex;
-  bool overflow;  // Track if buffer overflowed
-} uart_sysex_buffer = {.length = 0, .in_sysex = false, .overflow = false};
+// Data events waiting for space in the UART->USB ring. Buffering here instead
+// of blocking keeps the RX task free to forward realtime events meanwhile.
+static uint32_t rx_backlog[UART_RX_BACKLOG_SIZE];
+static uint32_t rx_backlog_count = 0;
+
+// USB IN coalescing: events gathered into one endpoint-sized packet. Two
+// buffers, as the one handed to the endpoint stays in use until it is sent.
+CFG_TUSB_MEM_ALIGN static uint8_t usb_tx_buffers[2][USB_MIDI_TX_PACKET_SIZE];
+static uint8_t *usb_tx_packet = usb_tx_buffers[0];  // Buffer being gathered
+static uint16_t usb_tx_length = 0;    // Bytes buffered in usb_tx_packet
+static uint32_t usb_tx_oldest = 0;    // Arrival time (us) of the first buffered event
+static bool usb_tx_urgent = false;    // Realtime buffered: flush without waiting
 
 /* Private function prototypes -----------------------------------------------*/
 static void CheckDmaBufferOverrun(void);
-static void ProcessMidiByte(uint8_t rx_byte);
+static void ProcessDmaSpan(const uint8_t *data, uint32_t length, uint32_t end_time, bool jr);
+static void ForwardEvents(const uint32_t *events, uint32_t count, uint32_t capture_time, bool jr);
+static void FlushRxBacklog(void);
+static void AppendUsbEvent(uint32_t event);
+static uint32_t GatherUsbEvents(void);
+static bool FlushUsbPacket(void);
+static uint32_t UsbFlushTime(void);
+static void RecordFramePhase(void);
 static void UpdateRxLedState(void);
-static void SendCompleteMessage(void);
 static void TurnOnRxLed(void);
 
 /* Public functions ----------------------------------------------------------*/
 /**
-  * @brief UART RX MIDI Task - receives MIDI data from UART2 DMA circular buffer and parses it
-  * @param pvParameters: Task parameters
+  * @brief Wake the UART RX task from a reception event (IDLE line, DMA half/full transfer)
+  * @param pxHigherPriorityTaskWoken: Set to pdTRUE if a context switch is required
+  * @retval None
+  */
+void UART_RX_NotifyFromISR(BaseType_t *pxHigherPriorityTaskWoken) {
+  if (xUartRxTaskHandle != NULL) {
+    vTaskNotifyGiveFromISR(xUartRxTaskHandle, pxHigherPriorityTaskWoken);
+  }
+}
+
+/**
+  * @brief Record the capture time of the bytes up to the DMA write position
+  * @note  Call from HAL_UARTEx_RxEventCallback before UART_RX_NotifyFromISR
+  * @param position: DMA write position reported by HAL (bytes received in the buffer)
+  * @param idle: true for an IDLE line event, which comes one byte time after the last byte
+  * @retval None
+  */
+void UART_RX_MarkFromISR(uint16_t position, bool idle) {
+  uint32_t now = MIDI_Time_Now();
+  rx_mark_time = idle ? now - MIDI_TIME_DIN_BYTE_US : now;
+  rx_mark_position = position % DMA_RX_BUFFER_SIZE;
+}
+
+/**
+  * @brief Restart DMA reception after a UART error aborted it
+  * @param pxHigherPriorityTaskWoken: Set to pdTRUE if a context switch is required
   * @retval None
   */
+void UART_RX_ErrorFromISR(BaseType_t *pxHigherPriorityTaskWoken) {
+  midi_stats.uart_rx_errors++;
+  
+  // HAL aborts DMA reception on blocking errors (e.g. overrun); without polling
+  // nothing would ever wake the RX task again, so re-arm reception here
+  if (huart2.RxState == HAL_UART_STATE_READY) {
+    if (HAL_UARTEx_ReceiveToIdle_DMA(&huart2, dma_rx_buffer, DMA_RX_BUFFER_SIZE) == HAL_OK) {
+      uart_rx_restart_pending = 1;
+      UART_RX_NotifyFromISR(pxHigherPriorityTaskWoken);
+    }
+  }
+}
+
 /**
   * @brief Check for DMA buffer overrun
   * @retval None
@@ -51,7 +112,7 @@ static void CheckDmaBufferOverrun(void) {
     // Buffer overrun detected
     midi_stats.dma_overruns++;
     dma_rx_tail = dma_rx_head;  // Reset to catch up
-    MIDI_ResetRunningStatus();   // Reset MIDI state
+    MIDI_Parser_Reset(&din_parser);  // Reset MIDI state
   }
 }
 
@@ -68,151 +129,107 @@ static void TurnOnRxLed(void) {
 }
 
 /**
-  * @brief Send complete MIDI message to USB queue
+  * @brief Move backlogged data events into the UART->USB ring
   * @retval None
   */
-static void SendCompleteMessage(void) {
-  
-  uint8_t expected_length = 3;
-  uint8_t status_type = midi_running_status & MIDI_MESSAGE_TYPE_MASK;
+static void FlushRxBacklog(void) {
+  if (rx_backlog_count == 0) {
+    return;
+  }
   
-  if (status_type == MIDI_PROGRAM_CHANGE || status_type == MIDI_CHANNEL_PRESSURE) {
-    expected_length = 2;
+  uint32_t pushed = MIDI_Ring_Push(&uart_to_usb_ring, rx_backlog, rx_backlog_count);
+  rx_backlog_count -= pushed;
+  if (pushed > 0 && rx_backlog_count > 0) {
+    memmove(rx_backlog, &rx_backlog[pushed], rx_backlog_count * sizeof(uint32_t));
   }
+}
+
+/**
+  * @brief Send parsed USB-MIDI events to the USB rings
+  * @param events: Event words from the parser
+  * @param count: Number of events
+  * @param capture_time: Time the last byte of the events was received
+  * @param jr: Put a capture time marker ahead of the data events (UMP Jitter Reduction)
+  * @retval None
+  */
+static void ForwardEvents(const uint32_t *events, uint32_t count, uint32_t capture_time, bool jr) {
+  bool marked = !jr;
   
-  if (midi_msg_index >= expected_length) {
-    MIDIPacket_t midi_packet;
-    for (int i = 0; i < expected_length; i++) {
-      midi_packet.data[i] = midi_msg_buffer[i];
-    }
-    midi_packet.length = expected_length;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t event = events[i];
     
-    // Send to USB output queue
-    if (xQueueSend(xUartToUsbQueue, &midi_packet, 0) != pdTRUE) {
+    if (MIDI_EVENT_IS_REALTIME(event)) {
+      // Realtime overtakes queued data on its own lane, stamped with its capture time
+      event = MIDI_Time_StampRealtime(event, capture_time);
+      if (MIDI_Ring_Push(&uart_to_usb_rt_ring, &event, 1) == 0) {
+        midi_stats.queue_full_errors++;
+      }
+    } else if (rx_backlog_count + (marked ? 1U : 2U) <= UART_RX_BACKLOG_SIZE) {
+      if (!marked) {
+        rx_backlog[rx_backlog_count++] = MIDI_EVENT_TIMESTAMP(MIDI_TIME_TO_JR(capture_time));
+        marked = true;
+      }
+      // Data events keep their order behind anything already waiting
+      rx_backlog[rx_backlog_count++] = event;
+    } else {
       midi_stats.queue_full_errors++;
     }
-    
-    // Turn on LED when message is sent
+  }
+  
+  FlushRxBacklog();
+  
+  if (count > 0) {
+    // Turn on LED when messages are sent
     TurnOnRxLed();
-    
-    // Reset for next message (keep running status)
-    midi_msg_buffer[0] = midi_running_status;
-    midi_msg_index = 1;
   }
 }
 
 /**
-  * @brief Process a single MIDI byte
-  * @param rx_byte: Received MIDI byte
+  * @brief Parse a contiguous span of the DMA buffer and forward the resulting events
+  * @note  With JR the span is parsed byte by byte, so each event carries the
+  *        capture time of its own last byte
+  * @param data: Start of the span
+  * @param length: Number of bytes in the span
+  * @param end_time: Capture time of the last byte of the span
+  * @param jr: Mark data events with their capture time (UMP Jitter Reduction)
   * @retval None
   */
-static void ProcessMidiByte(uint8_t rx_byte) {
+static void ProcessDmaSpan(const uint8_t *data, uint32_t length, uint32_t end_time, bool jr) {
+  uint32_t events[UART_RX_EVENT_BATCH_SIZE];
   
-  midi_stats.uart_rx_count++;
+  midi_stats.uart_rx_count += length;
   
-  if (rx_byte & 0x80) {
-    // Status byte
-    if (rx_byte == MIDI_SYSEX_START) {
-      // Start SysEx message
-      uart_sysex_buffer.in_sysex = true;
-      uart_sysex_buffer.length = 0;
-      uart_sysex_buffer.overflow = false;
-      if (uart_sysex_buffer.length < UART_SYSEX_BUFFER_SIZE) {
-        uart_sysex_buffer.data[uart_sysex_buffer.length++] = rx_byte;
-      } else {
-        uart_sysex_buffer.overflow = true;
-      }
-      midi_msg_index = 0;
-      return;
-    } else if (rx_byte == MIDI_SYSEX_END) {
-      // End SysEx message
-      if (uart_sysex_buffer.in_sysex) {
-        if (uart_sysex_buffer.length < UART_SYSEX_BUFFER_SIZE) {
-          uart_sysex_buffer.data[uart_sysex_buffer.length++] = rx_byte;
-        } else {
-          uart_sysex_buffer.overflow = true;
-        }
-        
-        // Send complete SysEx message to USB queue if no overflow
-        if (!uart_sysex_buffer.overflow) {
-          for (uint16_t offset = 0; offset < uart_sysex_buffer.length; ) {
-            MIDIPacket_t sysex_packet;
-            uint16_t remaining = uart_sysex_buffer.length - offset;
-            uint8_t chunk_size = (remaining > 3) ? 3 : remaining;
-            
-            memcpy(sysex_packet.data, &uart_sysex_buffer.data[offset], chunk_size);
-            sysex_packet.length = chunk_size;
-            
-            // Use blocking send with timeout to ensure delivery
-            if (xQueueSend(xUartToUsbQueue, &sysex_packet, pdMS_TO_TICKS(10)) == pdTRUE) {
-              offset += chunk_size;
-            } else {
-              midi_stats.queue_full_errors++;
-              break;  // Stop if queue is persistently full
-            }
-          }
-        } else {
-          // Log overflow error
-          midi_stats.queue_full_errors++;
-        }
-        
-        // Turn on LED when message is sent
-        TurnOnRxLed();
-      }
-      uart_sysex_buffer.in_sysex = false;
-      uart_sysex_buffer.length = 0;
-      uart_sysex_buffer.overflow = false;
-      midi_msg_index = 0;
-      return;
-    } else if (uart_sysex_buffer.in_sysex) {
-      // In SysEx but received non-SysEx status byte - abort SysEx
-      uart_sysex_buffer.in_sysex = false;
-      uart_sysex_buffer.length = 0;
-      uart_sysex_buffer.overflow = false;
+  if (jr) {
+    for (uint32_t i = 0; i < length; i++) {
+      size_t event_count;
+      MIDI_Parser_Process(&din_parser, &data[i], 1, events, UART_RX_EVENT_BATCH_SIZE, &event_count);
+      ForwardEvents(events, event_count, end_time - (length - 1 - i) * MIDI_TIME_DIN_BYTE_US, true);
     }
-    
-    // Check if this is a real-time message FIRST
-    if (rx_byte >= 0xF8) {
-      // Real-time message (single byte) - DO NOT change running status
-      // Don't filter here - send all to queue for filtering at USB stage
-      MIDIPacket_t midi_packet;
-      midi_packet.data[0] = rx_byte;
-      midi_packet.length = 1;
-      if (xQueueSend(xUartToUsbQueue, &midi_packet, 0) != pdTRUE) {
-        midi_stats.queue_full_errors++;
-      }
-      // Don't change midi_msg_index or midi_running_status
+    length = 0;
+  }
+  
+  while (length > 0) {
+    size_t event_count;
+    size_t consumed = MIDI_Parser_Process(&din_parser, data, length,
+                                          events, UART_RX_EVENT_BATCH_SIZE, &event_count);
+    data += consumed;
+    length -= consumed;
+    ForwardEvents(events, event_count, end_time, false);
+  }
+  
+  // SysEx messages cut short by another status byte
+  midi_stats.uart_rx_errors += din_parser.errors;
+  din_parser.errors = 0;
+}
 
-      // Turn on LED when message is sent
-      TurnOnRxLed();
-    } else if (rx_byte >= 0xF0) {
-      // System Common message - reset running status
-      MIDI_ResetRunningStatus();
-      midi_msg_buffer[0] = rx_byte;
-      midi_msg_index = 1;
-    } else {
-      // Normal Channel Voice status byte (0x80-0xEF)
-      midi_running_status = rx_byte;
-      midi_msg_buffer[0] = rx_byte;
-      midi_msg_index = 1;
-    }
-  } else {
-    // Data byte
-    if (uart_sysex_buffer.in_sysex) {
-      // In SysEx - accumulate data
-      if (uart_sysex_buffer.length < UART_SYSEX_BUFFER_SIZE) {
-        uart_sysex_buffer.data[uart_sysex_buffer.length++] = rx_byte;
-      } else {
-        uart_sysex_buffer.overflow = true;
-      }
-    } else if (midi_running_status != 0 && midi_msg_index < 3) {
-      // Normal MIDI data byte
-      midi_msg_buffer[midi_msg_index] = rx_byte;
-      midi_msg_index++;
-      
-      // Check if we have a complete message
-      SendCompleteMessage();
-    }
+/**
+  * @brief Count a DIN reception in the histogram of its position within the USB frame
+  * @retval None
+  */
+static void RecordFramePhase(void) {
+  uint32_t phase;
+  if (MIDI_Time_FramePhase(MIDI_Time_Now(), &phase)) {
+    midi_stats.din_rx_frame_phase[phase * MIDI_FRAME_PHASE_BINS / MIDI_TIME_FRAME_US]++;
   }
 }
 
@@ -243,109 +260,223 @@ static void UpdateRxLedState(void) {
 void vUartRxMidiTask(void *pvParameters) {
   (void) pvParameters;
   
-  // Start DMA reception in circular mode for UART2
-  if (HAL_UART_Receive_DMA(&huart2, dma_rx_buffer, DMA_RX_BUFFER_SIZE) != HAL_OK) {
+  MIDI_Parser_Init(&din_parser, 0);
+  
+  // Register for reception event notifications before DMA is started
+  xUartRxTaskHandle = xTaskGetCurrentTaskHandle();
+  
+  // Start DMA reception in circular mode for UART2 with IDLE line detection.
+  // HAL reports IDLE, DMA half transfer and DMA transfer complete through
+  // HAL_UARTEx_RxEventCallback, which wakes this task.
+  if (HAL_UARTEx_ReceiveToIdle_DMA(&huart2, dma_rx_buffer, DMA_RX_BUFFER_SIZE) != HAL_OK) {
     // DMA initialization failed
+    xUartRxTaskHandle = NULL;
     vTaskDelete(NULL);
     return;
   }
   
   while (1) {
+    // Block until the UART reports received data; only wake on a timeout
+    // while the RX LED is lit so it can be turned off in time, or every tick
+    // while backlogged events wait for ring space
+    TickType_t wait_ticks = (rxLedOnTime != 0) ? pdMS_TO_TICKS(MIDI_RX_LED_MIN_ON_TIME_MS) : portMAX_DELAY;
+    if (rx_backlog_count > 0) {
+      wait_ticks = 1;
+    }
+    ulTaskNotifyTake(pdTRUE, wait_ticks);
+    
+    FlushRxBacklog();
+    
+    // DMA restarted from the beginning of the buffer after a UART error
+    if (uart_rx_restart_pending) {
+      uart_rx_restart_pending = 0;
+      dma_rx_tail = 0;
+      MIDI_Parser_Reset(&din_parser);
+    }
+    
     // Update DMA head position with critical section
     taskENTER_CRITICAL();
-    dma_rx_head = DMA_RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(huart2.hdmarx);
+    dma_rx_head = (DMA_RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(huart2.hdmarx)) % DMA_RX_BUFFER_SIZE;
+    uint32_t mark_time = rx_mark_time;
+    uint32_t mark_position = rx_mark_position;
     taskEXIT_CRITICAL();
     
     // Check for buffer overrun
     CheckDmaBufferOverrun();
     
-    // Process all available bytes in circular buffer
-    while (dma_rx_tail != dma_rx_head) {
-      uint8_t rx_byte = dma_rx_buffer[dma_rx_tail];
-      dma_rx_tail = (dma_rx_tail + 1) % DMA_RX_BUFFER_SIZE;
-      
-      ProcessMidiByte(rx_byte);
+    // Capture time of the newest byte: bytes that arrived after the last
+    // reception event follow it at the wire rate
+    uint32_t head = dma_rx_head;
+    uint32_t head_time = mark_time +
+        ((head + DMA_RX_BUFFER_SIZE - mark_position) % DMA_RX_BUFFER_SIZE) * MIDI_TIME_DIN_BYTE_US;
+    bool jr = UMP_GetTxJitterReduction();
+    
+    // Process all available bytes in circular buffer as at most two contiguous spans
+    if (head != dma_rx_tail) {
+      RecordFramePhase();
+    }
+    if (head < dma_rx_tail) {
+      ProcessDmaSpan(&dma_rx_buffer[dma_rx_tail], DMA_RX_BUFFER_SIZE - dma_rx_tail,
+                     head_time - head * MIDI_TIME_DIN_BYTE_US, jr);
+      dma_rx_tail = 0;
+    }
+    if (head > dma_rx_tail) {
+      ProcessDmaSpan(&dma_rx_buffer[dma_rx_tail], head - dma_rx_tail, head_time, jr);
+      dma_rx_tail = head;
     }
     
     // Update LED state
     UpdateRxLedState();
-    
-    // Small delay to prevent overwhelming the CPU
-    vTaskDelay(pdMS_TO_TICKS(1));
   }
 }
 
 /**
-  * @brief UART to USB MIDI Task - forwards MIDI packets from UART to USB
-  * @param pvParameters: Task parameters
+  * @brief Add one event word to the USB IN packet being gathered
+  * @param event: USB-MIDI event word
   * @retval None
   */
-void vUartToUsbTask(void *pvParameters) {
-  (void) pvParameters;
-  MIDIPacket_t midi_packet;
-  
-  while (1) {
-    // Wait for MIDI packet from UART RX
-    if (xQueueReceive(xUartToUsbQueue, &midi_packet, portMAX_DELAY) == pdTRUE) {
-
-      // Apply filters here at USB transmission stage
+static void AppendUsbEvent(uint32_t event) {
+  // Apply filters here at USB transmission stage
 #if MIDI_FILTER_TIMING_CLOCK
-      if (midi_packet.length == 1 && midi_packet.data[0] == MIDI_TIMING_CLOCK) {
-        continue;  // Skip this message, immediately get next from queue
-      }
+  if (MIDI_EVENT_CIN(event) == USB_MIDI_CIN_1BYTE_DATA && MIDI_EVENT_BYTE(event, 0) == MIDI_TIMING_CLOCK) {
+    return;
+  }
 #endif
 
 #if MIDI_FILTER_ACTIVE_SENSING
-      if (midi_packet.length == 1 && midi_packet.data[0] == MIDI_ACTIVE_SENSING) {
-        continue;  // Skip this message, immediately get next from queue
-      }
+  if (MIDI_EVENT_CIN(event) == USB_MIDI_CIN_1BYTE_DATA && MIDI_EVENT_BYTE(event, 0) == MIDI_ACTIVE_SENSING) {
+    return;
+  }
 #endif
 
-      // Convert MIDI message to USB MIDI packet
-      uint8_t usb_packet[4] = {0};
-      uint8_t cin;
-      
-      // Check if this is a SysEx message
-      if (midi_packet.data[0] == MIDI_SYSEX_START) {
-        // SysEx start or continue
-        cin = USB_MIDI_CIN_SYSEX_START;
-      } else if (midi_packet.data[midi_packet.length - 1] == MIDI_SYSEX_END) {
-        // SysEx end - determine CIN based on length
-        if (midi_packet.length == 1) {
-          cin = USB_MIDI_CIN_1BYTE;
-        } else if (midi_packet.length == 2) {
-          cin = USB_MIDI_CIN_SYSEX_END_2;
-        } else {
-          cin = USB_MIDI_CIN_SYSEX_END_3;
+  if (usb_tx_length == 0) {
+    usb_tx_oldest = MIDI_Time_Now();
+  }
+  
+  // Event words are already complete USB MIDI packets (cable 0, CIN, 3 bytes)
+  MIDI_EVENT_TO_PACKET(event, &usb_tx_packet[usb_tx_length]);
+  usb_tx_length += 4;
+}
+
+/**
+  * @brief Move events from the rings into the USB IN packet, realtime first
+  * @retval Number of events taken from the rings
+  */
+static uint32_t GatherUsbEvents(void) {
+  uint32_t events[USB_MIDI_TX_PACKET_SIZE / 4];
+  uint32_t taken = 0;
+  uint32_t event;
+  
+  while (usb_tx_length < USB_MIDI_TX_PACKET_SIZE &&
+         MIDI_Ring_PopFresh(&uart_to_usb_rt_ring, &event, 1, pdMS_TO_TICKS(MIDI_UART_TO_USB_MAX_AGE_MS),
+                            &midi_stats.evicted_uart_to_usb) == 1) {
+    AppendUsbEvent(MIDI_Time_UnstampRealtime(event, &midi_stats.rt_in_latency_max_us));
+    usb_tx_urgent = true;
+    taken++;
+  }
+  
+  uint32_t space = (USB_MIDI_TX_PACKET_SIZE - usb_tx_length) / 4;
+  uint32_t count = MIDI_Ring_PopFresh(&uart_to_usb_ring, events, space,
+                                      pdMS_TO_TICKS(MIDI_UART_TO_USB_MAX_AGE_MS),
+                                      &midi_stats.evicted_uart_to_usb);
+  for (uint32_t i = 0; i < count; i++) {
+    AppendUsbEvent(events[i]);
+  }
+  
+  return taken + count;
+}
+
+/**
+  * @brief Hand the gathered USB IN packet to the endpoint as one transfer
+  * @note   The MIDI class TX FIFO is bypassed: each tud_midi_packet_write
+  *         would start its own transfer. The class driver still completes
+  *         the transfer (and adds the zero-length packet after a full one).
+  * @retval true if the packet was sent (or discarded while unmounted), false
+  *         if the endpoint is still busy (the packet stays buffered)
+  */
+static bool FlushUsbPacket(void) {
+  if (!(tud_mounted() && tud_midi_mounted())) {
+    midi_stats.usb_errors += usb_tx_length / 4;
+    usb_tx_length = 0;
+    usb_tx_urgent = false;
+    return true;
+  }
+  
+  if (!usbd_edpt_claim(BOARD_TUD_RHPORT, USB_MIDI_TX_ENDPOINT)) {
+    midi_stats.usb_tx_retries++;
+    return false;
+  }
+  if (!usbd_edpt_xfer(BOARD_TUD_RHPORT, USB_MIDI_TX_ENDPOINT, usb_tx_packet, usb_tx_length)) {
+    usbd_edpt_release(BOARD_TUD_RHPORT, USB_MIDI_TX_ENDPOINT);
+    midi_stats.usb_tx_retries++;
+    return false;
+  }
+  midi_stats.usb_tx_count += usb_tx_length / 4;
+  
+  // Gather into the other buffer while this one is sent
+  usb_tx_packet = (usb_tx_packet == usb_tx_buffers[0]) ? usb_tx_buffers[1] : usb_tx_buffers[0];
+  usb_tx_length = 0;
+  usb_tx_urgent = false;
+  return true;
+}
+
+/**
+  * @brief Get the time at which the gathered USB IN packet is sent
+  * @note   With SOF sync the packet goes out just before the next USB frame;
+  *         without it (or while no SOF arrives) after the coalescing deadline
+  * @retval Flush time (MIDI_Time_Now() units)
+  */
+static uint32_t UsbFlushTime(void) {
+  uint32_t flush_time = usb_tx_oldest + USB_TX_FLUSH_DEADLINE_US;
+#if MIDI_USB_SOF_SYNC
+  MIDI_Time_NextFrameFlush(usb_tx_oldest, MIDI_USB_SOF_FLUSH_LEAD_US, &flush_time);
+#endif
+  return flush_time;
+}
+
+/**
+  * @brief UART to USB MIDI Task - forwards MIDI packets from UART to USB
+  * @note  Events are gathered into endpoint-sized packets. A packet is sent
+  *        when full, when it holds a realtime event, or at its flush time
+  *        (see UsbFlushTime).
+  * @param pvParameters: Task parameters
+  * @retval None
+  */
+void vUartToUsbTask(void *pvParameters) {
+  (void) pvParameters;
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  
+  MIDI_Ring_SetConsumer(&uart_to_usb_ring, self);
+  MIDI_Ring_SetConsumer(&uart_to_usb_rt_ring, self);
+  
+  while (1) {
+    // Wait for events or the flush deadline; while a packet is held back by
+    // a busy IN endpoint, retry every tick
+    ulTaskNotifyTake(pdTRUE, (usb_tx_length == 0) ? portMAX_DELAY : 1);
+    
+    // Fill packets until the rings are empty or TinyUSB stops accepting data.
+    // Events stay in the rings meanwhile rather than being dropped.
+    while (1) {
+      uint32_t taken = GatherUsbEvents();
+      // A capture time marker and its event need two slots: with room for
+      // one event left, a waiting pair makes the packet full
+      if (usb_tx_length == USB_MIDI_TX_PACKET_SIZE ||
+          (taken == 0 && usb_tx_length > USB_MIDI_TX_PACKET_SIZE - 8 &&
+           MIDI_Ring_Count(&uart_to_usb_ring) > 0)) {
+        if (!FlushUsbPacket()) {
+          break;
         }
-      } else if (midi_packet.length == 3 &&
-                 midi_packet.data[0] < 0x80 &&
-                 midi_packet.data[1] < 0x80 &&
-                 midi_packet.data[2] < 0x80) {
-        // SysEx continue (all three bytes are data bytes)
-        cin = USB_MIDI_CIN_SYSEX_START;
-      } else {
-        // Normal MIDI message
-        cin = MIDI_GetCIN(midi_packet.data[0], midi_packet.length);
-      }
-      
-      // Create USB MIDI packet
-      usb_packet[0] = (0x00 << 4) | cin; // Cable 0 in upper nibble, CIN in lower nibble
-      for (int i = 0; i < midi_packet.length && i < 3; i++) {
-        usb_packet[i + 1] = midi_packet.data[i];
+      } else if (taken == 0) {
+        break;
       }
-      
-      // Send USB MIDI packet
-      if (tud_mounted() && tud_midi_mounted()) {
-        if (tud_midi_packet_write(usb_packet)) {
-          midi_stats.usb_tx_count++;
-        } else {
-          midi_stats.usb_errors++;
-          // Add delay when buffer is full to prevent overwhelming
-          vTaskDelay(pdMS_TO_TICKS(1));
-        }
+    }
+    
+    if (usb_tx_length > 0) {
+      uint32_t flush_time = UsbFlushTime();
+      if (usb_tx_urgent || (int32_t)(MIDI_Time_Now() - flush_time) >= 0) {
+        FlushUsbPacket();
       } else {
-        midi_stats.usb_errors++;
+        MIDI_Time_SetAlarm(MIDI_TIME_ALARM_USB_FLUSH, flush_time, self);
       }
     }
   }
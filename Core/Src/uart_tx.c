@@ -0,0 +1,244 @@
+/**
+  * @file           : uart_tx.c
+  * @brief          : DIN MIDI OUT byte ring with chained UART DMA transfers
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_tx.h"
+#include "midi_common.h"
+#include "midi_running_status.h"
+#include <string.h>
+
+/* External variables --------------------------------------------------------*/
+extern UART_HandleTypeDef huart2;
+
+/* Private defines -----------------------------------------------------------*/
+#define UART_TX_RING_MASK (UART_TX_RING_SIZE - 1U)
+
+#if (UART_TX_RING_SIZE & UART_TX_RING_MASK) != 0
+#error "UART_TX_RING_SIZE must be a power of two"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t tx_ring[UART_TX_RING_SIZE];
+static volatile uint32_t tx_head = 0;         // Free-running write index
+static volatile uint32_t tx_tail = 0;         // Free-running index of the first byte not yet sent
+static volatile uint16_t tx_dma_length = 0;   // Bytes in the running DMA transfer (0: idle)
+static TaskHandle_t tx_waiter = NULL;         // Task blocked in UART_TX_WaitPending
+static uint16_t tx_wait_level = 0;
+#if MIDI_DIN_RUNNING_STATUS
+static MidiRunningStatus_t tx_running_status;  // Status in effect on the wire
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static BaseType_t Append(const uint8_t *data, uint16_t length);
+static void StartNextSpan(void);
+static void FinishSpan(BaseType_t *pxHigherPriorityTaskWoken);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Reset the TX ring
+  * @retval None
+  */
+void UART_TX_Init(void)
+{
+  tx_head = 0;
+  tx_tail = 0;
+  tx_dma_length = 0;
+  tx_waiter = NULL;
+#if MIDI_DIN_RUNNING_STATUS
+  MIDI_RunningStatus_Init(&tx_running_status, MIDI_DIN_NOTE_OFF_AS_NOTE_ON);
+#endif
+}
+
+/**
+  * @brief  Queue bytes for transmission (task context)
+  * @note   Never blocks. Either all bytes are queued or none, so messages are not torn.
+  *         data must hold complete messages; repeated status bytes are left out
+  *         when MIDI_DIN_RUNNING_STATUS is enabled.
+  * @param  data: Bytes to send
+  * @param  length: Number of bytes
+  * @retval pdTRUE if queued, pdFALSE if the ring has no room
+  */
+BaseType_t UART_TX_Write(const uint8_t *data, uint16_t length)
+{
+  taskENTER_CRITICAL();
+  BaseType_t result = Append(data, length);
+  taskEXIT_CRITICAL();
+  return result;
+}
+
+/**
+  * @brief  Queue bytes for transmission (interrupt context)
+  * @param  data: Bytes to send
+  * @param  length: Number of bytes
+  * @retval pdTRUE if queued, pdFALSE if the ring has no room
+  */
+BaseType_t UART_TX_WriteFromISR(const uint8_t *data, uint16_t length)
+{
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  BaseType_t result = Append(data, length);
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+  return result;
+}
+
+/**
+  * @brief  Get the number of bytes queued or on the wire (after encoding)
+  * @retval Pending bytes
+  */
+uint16_t UART_TX_Pending(void)
+{
+  return (uint16_t)(tx_head - tx_tail);
+}
+
+/**
+  * @brief  Block until at most max_pending bytes are left to send
+  * @note   Uses the calling task's notification; callers re-check their own
+  *         event sources afterwards.
+  * @param  max_pending: Level to wait for
+  * @param  timeout: Maximum time to wait in ticks
+  * @retval pdTRUE if the level was reached, pdFALSE on timeout
+  */
+BaseType_t UART_TX_WaitPending(uint16_t max_pending, TickType_t timeout)
+{
+  TickType_t start = xTaskGetTickCount();
+
+  while (1) {
+    taskENTER_CRITICAL();
+    if (UART_TX_Pending() <= max_pending) {
+      tx_waiter = NULL;
+      taskEXIT_CRITICAL();
+      return pdTRUE;
+    }
+    tx_waiter = xTaskGetCurrentTaskHandle();
+    tx_wait_level = max_pending;
+    taskEXIT_CRITICAL();
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if (elapsed >= timeout) {
+      taskENTER_CRITICAL();
+      tx_waiter = NULL;
+      taskEXIT_CRITICAL();
+      return pdFALSE;
+    }
+    ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+  }
+}
+
+/**
+  * @brief  Chain the next span after a finished DMA transfer
+  * @note   Call from HAL_UART_TxCpltCallback
+  * @param  pxHigherPriorityTaskWoken: Set to pdTRUE if a context switch is required
+  * @retval None
+  */
+void UART_TX_CompleteFromISR(BaseType_t *pxHigherPriorityTaskWoken)
+{
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  FinishSpan(pxHigherPriorityTaskWoken);
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/**
+  * @brief  Recover from a UART error that aborted the running transfer
+  * @note   Call from HAL_UART_ErrorCallback. The aborted span is skipped.
+  * @param  pxHigherPriorityTaskWoken: Set to pdTRUE if a context switch is required
+  * @retval None
+  */
+void UART_TX_ErrorFromISR(BaseType_t *pxHigherPriorityTaskWoken)
+{
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  if (tx_dma_length != 0 && huart2.gState == HAL_UART_STATE_READY) {
+    midi_stats.uart_tx_errors++;
+#if MIDI_DIN_RUNNING_STATUS
+    // The receiver may have lost a status byte
+    MIDI_RunningStatus_Reset(&tx_running_status);
+#endif
+    FinishSpan(pxHigherPriorityTaskWoken);
+  }
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Copy bytes into the ring and start the DMA if it is idle (interrupts masked)
+  * @param  data: Bytes to send
+  * @param  length: Number of bytes
+  * @retval pdTRUE if queued, pdFALSE if the ring has no room
+  */
+static BaseType_t Append(const uint8_t *data, uint16_t length)
+{
+  if (length == 0 || UART_TX_RING_SIZE - (tx_head - tx_tail) < length) {
+    return pdFALSE;
+  }
+
+#if MIDI_DIN_RUNNING_STATUS
+  // Encoding only shrinks the data, so the room check above still holds
+  uint32_t head = tx_head;
+  for (uint16_t i = 0; i < length; i++) {
+    uint8_t byte = data[i];
+    if (MIDI_RunningStatus_Next(&tx_running_status, &byte)) {
+      tx_ring[head & UART_TX_RING_MASK] = byte;
+      head++;
+    }
+  }
+  midi_stats.din_tx_status_saved += length - (head - tx_head);
+  tx_head = head;
+#else
+  uint32_t index = tx_head & UART_TX_RING_MASK;
+  uint32_t first = UART_TX_RING_SIZE - index;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(&tx_ring[index], data, first);
+  memcpy(tx_ring, &data[first], length - first);
+  tx_head += length;
+#endif
+
+  if (tx_dma_length == 0) {
+    StartNextSpan();
+  }
+  return pdTRUE;
+}
+
+/**
+  * @brief  Start a DMA transfer of the contiguous bytes at the ring tail (interrupts masked)
+  * @retval None
+  */
+static void StartNextSpan(void)
+{
+  uint32_t pending = tx_head - tx_tail;
+  if (pending == 0) {
+    return;
+  }
+
+  uint32_t index = tx_tail & UART_TX_RING_MASK;
+  uint32_t span = UART_TX_RING_SIZE - index;
+  if (span > pending) {
+    span = pending;
+  }
+
+  if (HAL_UART_Transmit_DMA(&huart2, &tx_ring[index], (uint16_t)span) == HAL_OK) {
+    tx_dma_length = (uint16_t)span;
+  } else {
+    // Left queued; the next write or completion retries
+    tx_dma_length = 0;
+    midi_stats.uart_tx_errors++;
+  }
+}
+
+/**
+  * @brief  Release the sent span, chain the next one and wake a waiting producer (interrupts masked)
+  * @param  pxHigherPriorityTaskWoken: Set to pdTRUE if a context switch is required
+  * @retval None
+  */
+static void FinishSpan(BaseType_t *pxHigherPriorityTaskWoken)
+{
+  tx_tail += tx_dma_length;
+  tx_dma_length = 0;
+  StartNextSpan();
+
+  if (tx_waiter != NULL && UART_TX_Pending() <= tx_wait_level) {
+    vTaskNotifyGiveFromISR(tx_waiter, pxHigherPriorityTaskWoken);
+    tx_waiter = NULL;
+  }
+}
@@ -7,6 +7,7 @@
 #include "ump_discovery.h"
 #include "app_ump_device.h"
 #include "midi2_task.h"
+#include "midi_common.h"  // For MIDI_DIN_TX_TIMESTAMPS
 #include "FreeRTOS.h"
 #include "task.h"
 #include <string.h>
@@ -23,10 +24,10 @@ static const ump_endpoint_info_t endpoint_info = {
     .ump_version_major = UMP_VERSION_MAJOR,
     .ump_version_minor = UMP_VERSION_MINOR,
     .num_function_blocks = NUM_FUNCTION_BLOCKS,
-    .supports_midi_2_0 = true,       // MIDI 2.0 only as specified
-    .supports_midi_1_0 = false,      // No MIDI 1.0 support
-    .supports_rx_jitter_reduction = false,  // No JR support
-    .supports_tx_jitter_reduction = false   // No JR support
+    .supports_midi_2_0 = true,       // Default protocol
+    .supports_midi_1_0 = true,       // Selectable with a Stream Configuration Request
+    .supports_rx_jitter_reduction = MIDI_DIN_TX_TIMESTAMPS,  // JR Timestamps time DIN output
+    .supports_tx_jitter_reduction = true    // DIN input capture times as JR Timestamps
 };
 
 static const ump_device_identity_t device_identity = {
@@ -59,8 +60,9 @@ static bool discovery_reply_sent = false;  // Track if Discovery Reply has been
 static const char endpoint_name[] = UMP_ENDPOINT_NAME;
 static const char product_instance_id[] = UMP_PRODUCT_INSTANCE_ID;
 
-// Current protocol status (MIDI 2.0 only, no JR support)
-static ump_protocol_status_t current_protocol = {
+// Current protocol status (MIDI 2.0 by default, JR off)
+// Written by the USB to UMP task, read by the conversion tasks
+static volatile ump_protocol_status_t current_protocol = {
     .protocol = UMP_PROTOCOL_MIDI_2_0,
     .rx_jitter_reduction = false,
     .tx_jitter_reduction = false
@@ -84,6 +86,36 @@ void UMP_Discovery_Init(void)
     muid_initialized = true;
 }
 
+/**
+  * @brief Get the protocol selected by the host
+  * @retval UMP_PROTOCOL_MIDI_1_0 or UMP_PROTOCOL_MIDI_2_0
+  */
+uint8_t UMP_GetProtocol(void)
+{
+    return current_protocol.protocol;
+}
+
+/**
+  * @brief Check whether the host asked for JR Timestamps on received data
+  * @retval true if JR Clock and JR Timestamp messages are to be sent
+  */
+bool UMP_GetTxJitterReduction(void)
+{
+    return current_protocol.tx_jitter_reduction;
+}
+
+/**
+  * @brief Return to the default MIDI 2.0 Protocol without JR
+  * @note  Called when a new host session starts
+  * @retval None
+  */
+void UMP_ResetProtocol(void)
+{
+    current_protocol.protocol = UMP_PROTOCOL_MIDI_2_0;
+    current_protocol.rx_jitter_reduction = false;
+    current_protocol.tx_jitter_reduction = false;
+}
+
 /**
   * @brief Process incoming UMP Stream messages
   * @param ump_data: Pointer to UMP message data
@@ -138,10 +170,23 @@ void UMP_ProcessStreamMessage(uint32_t* ump_data, uint8_t word_count)
 
         case UMP_STREAM_MSG_STREAM_CONFIG_REQUEST:
             {
+                // Word 0: Protocol (bits 15-8), RX JR (bit 1), TX JR (bit 0)
+                uint8_t protocol = (ump_data[0] >> 8) & 0xFF;
+                bool rx_jr = (ump_data[0] & 0x02) != 0;
+                bool tx_jr = (ump_data[0] & 0x01) != 0;
+                
+                // Both protocols are supported; unknown protocols keep the
+                // current one. JR is granted as far as it is supported.
+                if ((protocol == UMP_PROTOCOL_MIDI_1_0 && endpoint_info.supports_midi_1_0) ||
+                    (protocol == UMP_PROTOCOL_MIDI_2_0 && endpoint_info.supports_midi_2_0)) {
+                    current_protocol.protocol = protocol;
+                }
+                current_protocol.rx_jitter_reduction = rx_jr && endpoint_info.supports_rx_jitter_reduction;
+                current_protocol.tx_jitter_reduction = tx_jr && endpoint_info.supports_tx_jitter_reduction;
+                
                 UMP_SendStreamConfigNotification(current_protocol.protocol, 
                                                     current_protocol.rx_jitter_reduction,
                                                     current_protocol.tx_jitter_reduction);
-            
             }
             break;
             
@@ -617,10 +662,8 @@ void MIDICI_ProcessDiscovery(uint8_t* sysex_data, uint16_t length, muid_t source
   */
 void MIDICI_SendDiscoveryReply(muid_t destination_muid)
 {
-    // Clear any pending MIDI messages in the queue to ensure Discovery messages go first
-    if (xUmpTxQueue != NULL) {
-        xQueueReset(xUmpTxQueue);
-    }
+    // Clear any pending MIDI messages in the ring to ensure Discovery messages go first
+    UMP_Ring_Clear(&ump_tx_ring);
     
     // Mark that Discovery Reply has been sent
     discovery_reply_sent = true;
@@ -828,12 +871,10 @@ muid_t MIDICI_GenerateMUID(void)
   */
 static void SendUMPStreamMessage(uint32_t* data, uint8_t word_count)
 {
-    // Send to UMP TX queue
-    if (xUmpTxQueue != NULL) {
-        // Use SendToBack to maintain correct message order
-        // Discovery messages must be sent in sequence
-        xQueueSendToBack(xUmpTxQueue, data, pdMS_TO_TICKS(10));
-    }
+    (void)word_count;  // The ring takes the size from the message type
+    
+    // Discovery messages must be sent in sequence, so wait for room
+    UMP_Ring_WriteWait(&ump_tx_ring, data, pdMS_TO_TICKS(10));
 }
 
 /**
@@ -909,9 +950,7 @@ static void SendSysExAsUMP(uint8_t* sysex_data, uint16_t length)
                      data_bytes[5];                   // Byte 6
         
         // Send UMP message
-        if (xUmpTxQueue != NULL) {
-            xQueueSendToBack(xUmpTxQueue, ump_msg, pdMS_TO_TICKS(10));
-        }
+        UMP_Ring_WriteWait(&ump_tx_ring, ump_msg, pdMS_TO_TICKS(10));
     }
 }
 
@@ -0,0 +1,296 @@
+/**
+  * @file           : ump_ring.c
+  * @brief          : Variable-length UMP word ring
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ump_ring.h"
+#include "midi_parser.h"  // For MIDI_CC_IS_VALUE
+
+/* Private defines -----------------------------------------------------------*/
+#define RING_MASK (UMP_RING_WORDS - 1)
+
+#if (UMP_RING_WORDS & RING_MASK) != 0
+#error "UMP_RING_WORDS must be a power of two"
+#endif
+
+/* Exported variables --------------------------------------------------------*/
+const uint8_t ump_word_count[16] = {
+  1, 1, 1, 2,  // Utility, System, MIDI 1.0 Channel Voice, Data (SysEx7)
+  2, 4, 1, 1,  // MIDI 2.0 Channel Voice, Data (SysEx8 / Mixed Data Set), reserved 32-bit
+  2, 2, 2, 3,  // Reserved 64-bit, reserved 96-bit
+  3, 4, 4, 4,  // Reserved 96-bit, Flex Data, reserved 128-bit, UMP Stream
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static bool Append(UmpRing_t *ring, uint32_t stamp, const uint32_t *ump, TickType_t now);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an empty ring
+  * @param  ring: Ring instance
+  * @retval None
+  */
+void UMP_Ring_Init(UmpRing_t *ring)
+{
+  ring->head = 0;
+  ring->tail = 0;
+  ring->consumer = NULL;
+}
+
+/**
+  * @brief  Register the task that is notified when messages are written
+  * @param  ring: Ring instance
+  * @param  task: Consumer task handle (NULL to disable notifications)
+  * @retval None
+  */
+void UMP_Ring_SetConsumer(UmpRing_t *ring, TaskHandle_t task)
+{
+  ring->consumer = task;
+}
+
+/**
+  * @brief  Write one UMP message without blocking
+  * @note   The message size follows from its type. Either the whole message
+  *         is written or nothing.
+  * @param  ring: Ring instance
+  * @param  ump: UMP message
+  * @retval true if written, false if the ring has no room
+  */
+bool UMP_Ring_Write(UmpRing_t *ring, const uint32_t *ump)
+{
+  return UMP_Ring_WriteStamped(ring, 0, ump);
+}
+
+/**
+  * @brief  Write one UMP message behind its JR Timestamp without blocking
+  * @note   The timestamp and the message are written together or not at
+  *         all, so a timestamp never ends up ahead of an unrelated message.
+  * @param  ring: Ring instance
+  * @param  stamp: One-word JR Timestamp / Delta Clockstamp UMP (0: none)
+  * @param  ump: UMP message
+  * @retval true if written, false if the ring has no room for both
+  */
+bool UMP_Ring_WriteStamped(UmpRing_t *ring, uint32_t stamp, const uint32_t *ump)
+{
+  TickType_t now = xTaskGetTickCount();
+
+  taskENTER_CRITICAL();
+  bool written = Append(ring, stamp, ump, now);
+  taskEXIT_CRITICAL();
+
+  if (written && ring->consumer != NULL) {
+    xTaskNotifyGive(ring->consumer);
+  }
+  return written;
+}
+
+/**
+  * @brief  Write one UMP message, waiting up to timeout for free space
+  * @note   Used for messages that must not be lost when the consumer lags
+  *         (UMP Stream and MIDI-CI replies). Re-checks once per tick.
+  * @param  ring: Ring instance
+  * @param  ump: UMP message
+  * @param  timeout: Maximum time to wait for space
+  * @retval true if written
+  */
+bool UMP_Ring_WriteWait(UmpRing_t *ring, const uint32_t *ump, TickType_t timeout)
+{
+  TickType_t waited = 0;
+
+  while (!UMP_Ring_Write(ring, ump)) {
+    if (waited >= timeout) {
+      return false;
+    }
+    vTaskDelay(1);
+    waited++;
+  }
+  return true;
+}
+
+/**
+  * @brief  Write one UMP message from an interrupt without blocking
+  * @param  ring: Ring instance
+  * @param  ump: UMP message
+  * @param  pxHigherPriorityTaskWoken: Set if the consumer should run next
+  * @retval true if written, false if the ring has no room
+  */
+bool UMP_Ring_WriteFromISR(UmpRing_t *ring, const uint32_t *ump, BaseType_t *pxHigherPriorityTaskWoken)
+{
+  return UMP_Ring_WriteStampedFromISR(ring, 0, ump, pxHigherPriorityTaskWoken);
+}
+
+/**
+  * @brief  Write one UMP message behind its JR Timestamp from an interrupt
+  * @param  ring: Ring instance
+  * @param  stamp: One-word JR Timestamp / Delta Clockstamp UMP (0: none)
+  * @param  ump: UMP message
+  * @param  pxHigherPriorityTaskWoken: Set if the consumer should run next
+  * @retval true if written, false if the ring has no room for both
+  */
+bool UMP_Ring_WriteStampedFromISR(UmpRing_t *ring, uint32_t stamp, const uint32_t *ump,
+                                  BaseType_t *pxHigherPriorityTaskWoken)
+{
+  TickType_t now = xTaskGetTickCountFromISR();
+
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  bool written = Append(ring, stamp, ump, now);
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+
+  if (written && ring->consumer != NULL) {
+    vTaskNotifyGiveFromISR(ring->consumer, pxHigherPriorityTaskWoken);
+  }
+  return written;
+}
+
+/**
+  * @brief  Read as many complete messages as fit in max_words (consumer only)
+  * @param  ring: Ring instance
+  * @param  words: Destination buffer
+  * @param  max_words: Capacity of words
+  * @param  message_count: Set to the number of messages read
+  * @retval Number of words read
+  */
+uint32_t UMP_Ring_Read(UmpRing_t *ring, uint32_t *words, uint32_t max_words, uint32_t *message_count)
+{
+  uint32_t evicted = 0;
+  return UMP_Ring_ReadFresh(ring, words, max_words, message_count, 0, &evicted);
+}
+
+/**
+  * @brief  Read as many complete messages as fit in max_words, dropping stale
+  *         ones that may be lost (consumer only)
+  * @note   A message written more than max_age ticks ago is dropped if
+  *         UMP_IsEvictable. A JR Timestamp is read or dropped together with
+  *         the message it times. Dropped messages take no space in words.
+  * @param  ring: Ring instance
+  * @param  words: Destination buffer
+  * @param  max_words: Capacity of words
+  * @param  message_count: Set to the number of messages read
+  * @param  max_age: Age limit in ticks (0: no limit)
+  * @param  evicted: Incremented for each dropped message
+  * @retval Number of words read
+  */
+uint32_t UMP_Ring_ReadFresh(UmpRing_t *ring, uint32_t *words, uint32_t max_words, uint32_t *message_count,
+                            TickType_t max_age, uint32_t *evicted)
+{
+  uint32_t count = 0;
+  uint32_t messages = 0;
+  TickType_t now = xTaskGetTickCount();
+
+  taskENTER_CRITICAL();
+  uint32_t tail = ring->tail;
+  while (tail != ring->head) {
+    uint32_t first_word = ring->words[tail & RING_MASK];
+    uint32_t stamped = 0;
+    if (UMP_IS_JR_TIMESTAMP(first_word) && tail + 1 != ring->head) {
+      stamped = 1;
+      first_word = ring->words[(tail + 1) & RING_MASK];
+    }
+    uint32_t size = stamped + UMP_WORD_COUNT(first_word);
+    if (max_age > 0 && (TickType_t)(now - ring->times[(tail + stamped) & RING_MASK]) > max_age &&
+        UMP_IsEvictable(first_word)) {
+      tail += size;
+      (*evicted)++;
+      continue;
+    }
+    if (count + size > max_words) {
+      break;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+      words[count + i] = ring->words[(tail + i) & RING_MASK];
+    }
+    tail += size;
+    count += size;
+    messages += 1 + stamped;
+  }
+  ring->tail = tail;
+  taskEXIT_CRITICAL();
+
+  *message_count = messages;
+  return count;
+}
+
+/**
+  * @brief  Drop every message waiting in the ring
+  * @param  ring: Ring instance
+  * @retval None
+  */
+void UMP_Ring_Clear(UmpRing_t *ring)
+{
+  taskENTER_CRITICAL();
+  ring->tail = ring->head;
+  taskEXIT_CRITICAL();
+}
+
+/**
+  * @brief  Check whether a UMP message may be dropped once it is stale
+  * @note   Value controllers (MIDI_CC_IS_VALUE), pressure, pitch bend and
+  *         absolute RPN / NRPN / per-note controllers (a late value is worse
+  *         than a missing one), Timing Clock and Active Sensing. Notes,
+  *         program changes, selectors, switches, relative RPN / NRPN, SysEx,
+  *         transport, UMP Stream and Utility timing stay; a JR Timestamp
+  *         goes with its message (see UMP_Ring_ReadFresh).
+  * @param  first_word: First word of the UMP message
+  * @retval true if droppable
+  */
+bool UMP_IsEvictable(uint32_t first_word)
+{
+  uint8_t status = (uint8_t)((first_word >> 20) & 0xF);
+  uint8_t controller = (uint8_t)((first_word >> 8) & 0x7F);
+
+  switch (first_word >> 28) {
+    case 0x1: {
+      uint8_t system_status = (uint8_t)(first_word >> 16);
+      return system_status == 0xF8 || system_status == 0xFE;
+    }
+    case 0x2:  // MIDI 1.0 Channel Voice
+      return status == 0xA || status == 0xD || status == 0xE ||
+             (status == 0xB && MIDI_CC_IS_VALUE(controller));
+    case 0x4:  // MIDI 2.0 Channel Voice: per-note / registered / assignable controllers too
+      return status <= 0x3 || status == 0x6 || status == 0xA || status == 0xD || status == 0xE ||
+             (status == 0xB && MIDI_CC_IS_VALUE(controller));
+    default:
+      return false;
+  }
+}
+
+/**
+  * @brief  Get the number of words waiting in the ring
+  * @param  ring: Ring instance
+  * @retval Number of queued words
+  */
+uint32_t UMP_Ring_Count(const UmpRing_t *ring)
+{
+  return ring->head - ring->tail;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Add an optional one-word stamp and a message (critical section held)
+  * @param  ring: Ring instance
+  * @param  stamp: One-word UMP written first (0: none)
+  * @param  ump: UMP message
+  * @param  now: Write tick
+  * @retval false if the ring has no room for both
+  */
+static bool Append(UmpRing_t *ring, uint32_t stamp, const uint32_t *ump, TickType_t now)
+{
+  uint32_t count = UMP_WORD_COUNT(ump[0]);
+  uint32_t head = ring->head;
+
+  if (UMP_RING_WORDS - (head - ring->tail) < count + (stamp != 0 ? 1U : 0U)) {
+    return false;
+  }
+  if (stamp != 0) {
+    ring->words[head & RING_MASK] = stamp;
+    ring->times[head & RING_MASK] = now;
+    head++;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    ring->words[(head + i) & RING_MASK] = ump[i];
+  }
+  ring->times[head & RING_MASK] = now;
+  ring->head = head + count;
+  return true;
+}
@@ -9,98 +9,266 @@
 #include "midi_common.h"
 #include "midi2_task.h"
 #include "ump_discovery.h"
+#include "midi_time.h"
+#include "ump_ring.h"
+#include <string.h>
 
 /* Private function prototypes -----------------------------------------------*/
+static bool SendUmpWords(uint32_t *words, uint32_t *word_count, uint32_t *split_words);
 #ifdef TESTING
-// For testing, make the function non-static
+// For testing, make the functions non-static
+void DispatchUmp(uint32_t *ump_data, uint8_t word_count);
 uint8_t GetUmpWordCount(uint32_t first_word);
 #else
+static void DispatchUmp(uint32_t *ump_data, uint8_t word_count);
 static uint8_t GetUmpWordCount(uint32_t first_word);
 #endif
 
 /* External variables --------------------------------------------------------*/
-extern QueueHandle_t xUmpTxQueue;
 extern QueueHandle_t xUmpRxQueue;
 
+/* Private variables ---------------------------------------------------------*/
+static TaskHandle_t xUsbToUmpTaskHandle = NULL;  // Notified when the UMP OUT endpoint receives data
+#if MIDI_DIN_TX_TIMESTAMPS
+static bool din_timestamp_pending = false;  // The last UMP to DIN was a JR Timestamp / Delta Clockstamp
+#endif
+
 /* Public functions ----------------------------------------------------------*/
 
+/**
+  * @brief Wake the USB to UMP task after the UMP OUT endpoint received data
+  * @note  Called from tud_ump_rx_cb (TinyUSB device task context)
+  * @retval None
+  */
+void UMP_RxNotify(void) {
+  if (xUsbToUmpTaskHandle != NULL) {
+    xTaskNotifyGive(xUsbToUmpTaskHandle);
+  }
+}
+
 /**
   * @brief UMP to USB Task - sends UMP packets to USB
+  * @note  Each tud_ump_write carries as many complete messages as fit in one
+  *        bulk packet, realtime first. With SOF sync, messages are gathered
+  *        until just before the next USB frame. Words the TX FIFO cannot take
+  *        stay at the front of the packet and are retried a tick later.
   * @param pvParameters: Task parameters
   * @retval None
   */
 void vUmpToUsbTask(void *pvParameters) {
   (void) pvParameters;
-  uint32_t ump_data[4];  // UMP message buffer (up to 16 bytes)
+  uint32_t tx_words[UMP_TX_PACKET_WORDS];
+  uint32_t tx_count = 0;     // Words not yet taken by the TX FIFO
+  uint32_t split_words = 0;  // Leading words that end a partly written message
+  
+  UMP_Ring_SetConsumer(&ump_tx_ring, xTaskGetCurrentTaskHandle());
+  UMP_Ring_SetConsumer(&ump_tx_rt_ring, xTaskGetCurrentTaskHandle());
   
   while (1) {
-    // Wait for UMP packet from conversion task
-    if (xQueueReceive(xUmpTxQueue, ump_data, portMAX_DELAY) == pdTRUE) {
-      // Send UMP packet to USB
-      if (tud_ump_n_mounted(0)) {
-        // Try to write UMP packet with correct word count
-        uint8_t word_count = GetUmpWordCount(ump_data[0]);
-        
-        uint16_t written = tud_ump_write(0, ump_data, word_count);
-        if (written > 0) {
-          midi_stats.usb_tx_count++;
-        } else {
-          midi_stats.usb_errors++;
-          // Add delay when buffer is full
-          vTaskDelay(pdMS_TO_TICKS(1));
-        }
-      } else {
-        midi_stats.usb_errors++;
+    // Wait for UMP messages from the conversion and discovery tasks, or
+    // retry unsent words after a tick
+    ulTaskNotifyTake(pdTRUE, (tx_count == 0) ? portMAX_DELAY : 1);
+    if (tx_count == 0 && UMP_Ring_Count(&ump_tx_ring) == 0 && UMP_Ring_Count(&ump_tx_rt_ring) == 0) {
+      continue;
+    }
+    
+#if MIDI_USB_SOF_SYNC
+    // Realtime goes out at once, everything else waits for the frame flush point
+    uint32_t flush_time;
+    if (tx_count == 0 && UMP_Ring_Count(&ump_tx_rt_ring) == 0 &&
+        MIDI_Time_NextFrameFlush(MIDI_Time_Now(), MIDI_USB_SOF_FLUSH_LEAD_US, &flush_time)) {
+      MIDI_Time_SetAlarm(MIDI_TIME_ALARM_USB_FLUSH, flush_time, xTaskGetCurrentTaskHandle());
+      // Further writes notify this task too, so only the alarm or realtime ends the wait
+      while ((int32_t)(flush_time - MIDI_Time_Now()) > 0 && UMP_Ring_Count(&ump_tx_rt_ring) == 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2));
       }
+      MIDI_Time_CancelAlarm(MIDI_TIME_ALARM_USB_FLUSH);
     }
+#endif
+    
+    // Fill each packet behind any unsent words (so no message is split by
+    // another), realtime first, then the other messages in order
+    do {
+      uint32_t message_count;
+      tx_count += UMP_Ring_ReadFresh(&ump_tx_rt_ring, &tx_words[tx_count], UMP_TX_PACKET_WORDS - tx_count,
+                                     &message_count, pdMS_TO_TICKS(MIDI_UMP_TX_MAX_AGE_MS),
+                                     &midi_stats.evicted_ump_tx);
+      tx_count += UMP_Ring_ReadFresh(&ump_tx_ring, &tx_words[tx_count], UMP_TX_PACKET_WORDS - tx_count,
+                                     &message_count, pdMS_TO_TICKS(MIDI_UMP_TX_MAX_AGE_MS),
+                                     &midi_stats.evicted_ump_tx);
+    } while (tx_count > 0 && SendUmpWords(tx_words, &tx_count, &split_words));
   }
 }
 
 /**
   * @brief USB to UMP Task - receives UMP packets from USB
+  * @note  Reads every available word at once and splits the stream into
+  *        messages; a message cut off at the end of a read is completed by
+  *        the next one
   * @param pvParameters: Task parameters
   * @retval None
   */
 void vUsbToUmpTask(void *pvParameters) {
   (void) pvParameters;
-  uint32_t ump_data[4];  // UMP message buffer
+  // Room for 3 words past the last message: queue items are 4 words long
+  static uint32_t rx_words[UMP_RX_BULK_WORDS + 3];
+  uint32_t rx_count = 0;  // Words of an incomplete message kept from the last read
+  
+  xUsbToUmpTaskHandle = xTaskGetCurrentTaskHandle();
   
   while (1) {
-    // Check for incoming UMP data
-    if (tud_ump_n_mounted(0) && tud_ump_n_available(0) > 0) {
-      // Read UMP packet from USB
-      uint16_t words_read = tud_ump_read(0, ump_data, 4);
-      if (words_read > 0) {
-        midi_stats.usb_rx_count++;
-        
-        // Check message type
-        uint8_t message_type = (ump_data[0] >> 28) & 0xF;
-        uint8_t word_count = GetUmpWordCount(ump_data[0]);
-        
-        if (message_type == 0xF) {
-          // Process Stream messages for Discovery
-          UMP_ProcessStreamMessage(ump_data, word_count);
-        } else if (message_type == 0x3) {
-          // Process Data messages (SysEx) for MIDI-CI
-          UMP_ProcessDataMessage(ump_data, word_count);
-        } else {
-          // Send UMP packet to conversion task for normal MIDI messages
-          if (xQueueSend(xUmpRxQueue, ump_data, 0) != pdTRUE) {
-            midi_stats.queue_full_errors++;
-          }
-        }
+    // Handle all incoming UMP data
+    while (tud_ump_n_mounted(0) && tud_ump_n_available(0) > 0) {
+      uint32_t words_read = tud_ump_read(0, &rx_words[rx_count], UMP_RX_BULK_WORDS - rx_count);
+      if (words_read == 0) {
+        break;
       }
+      rx_count += words_read;
+      
+      uint32_t used = UMP_FrameMessages(rx_words, rx_count, DispatchUmp);
+      rx_count -= used;
+      memmove(rx_words, &rx_words[used], rx_count * sizeof(uint32_t));
     }
     
-    // Small delay to prevent overwhelming the CPU
-    vTaskDelay(pdMS_TO_TICKS(1));
+    if (!tud_ump_n_mounted(0)) {
+      rx_count = 0;
+    }
+    
+    // Sleep until tud_ump_rx_cb reports new data
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
+/**
+  * @brief Split a word stream into UMP messages
+  * @param words: Received words, starting at a message boundary
+  * @param count: Number of words
+  * @param dispatch: Called with each complete message, in place
+  * @retval Number of words used (a trailing incomplete message is left)
+  */
+uint32_t UMP_FrameMessages(uint32_t *words, uint32_t count, UmpDispatch_t dispatch) {
+  uint32_t offset = 0;
+  
+  while (offset < count) {
+    uint8_t word_count = GetUmpWordCount(words[offset]);
+    if (offset + word_count > count) {
+      break;
+    }
+    dispatch(&words[offset], word_count);
+    offset += word_count;
   }
+  return offset;
 }
 
 /* Private functions ---------------------------------------------------------*/
 
+/**
+  * @brief Route one received UMP message
+  * @param ump_data: Message words (readable up to 4 words)
+  * @param word_count: Number of words in the message
+  * @retval None
+  */
+#ifdef TESTING
+void DispatchUmp(uint32_t *ump_data, uint8_t word_count) {
+#else
+static void DispatchUmp(uint32_t *ump_data, uint8_t word_count) {
+#endif
+  uint8_t message_type = (ump_data[0] >> 28) & 0xF;
+  midi_stats.usb_rx_count++;
+  
+  // Messages to DIN carry their arrival tick for the age limit
+  UmpRxItem_t item;
+  memcpy(item.ump, ump_data, sizeof(item.ump));
+  item.time = xTaskGetTickCount();
+  
+  if (message_type == 0xF) {
+    // Process Stream messages for Discovery
+    UMP_ProcessStreamMessage(ump_data, word_count);
+  } else if (message_type == 0x3) {
+    // Process Data messages (SysEx) for MIDI-CI, and pass them on to DIN
+    UMP_ProcessDataMessage(ump_data, word_count);
+    if (xQueueSend(xUmpRxQueue, &item, 0) != pdTRUE) {
+      midi_stats.queue_full_errors++;
+    }
+  } else if (message_type == 0x1 && ((ump_data[0] >> 16) & 0xFF) >= MIDI_TIMING_CLOCK
+#if MIDI_DIN_TX_TIMESTAMPS
+             && !din_timestamp_pending  // A timestamped one stays behind its timestamp
+#endif
+             ) {
+    // System Real-Time overtakes queued messages on the way to DIN, on a
+    // lane of its own that keeps Start / Clock / Stop in order
+    if (!UMP_Ring_Write(&ump_rx_rt_ring, ump_data)) {
+      midi_stats.queue_full_errors++;
+    }
+  } else {
+    // Send UMP packet to conversion task for normal MIDI messages
+    if (xQueueSend(xUmpRxQueue, &item, 0) != pdTRUE) {
+      midi_stats.queue_full_errors++;
+    }
+  }
+  
+  if (message_type != 0xF) {
+#if MIDI_DIN_TX_TIMESTAMPS
+    uint8_t status = (ump_data[0] >> 20) & 0xF;
+    din_timestamp_pending = (message_type == 0x0 && (status == 0x2 || status == 0x4));
+#endif
+    MIDI2_NotifyDinOut();
+  }
+}
+
+/**
+  * @brief Write gathered UMP messages to USB
+  * @note  usb_tx_count counts a message once its last word is taken, so a
+  *        message split across two writes is counted by the second
+  * @param words: UMP words; the unsent ones are moved to the front
+  * @param word_count: Number of words; set to the number left unsent
+  * @param split_words: Leading words that end a message begun by an earlier
+  *        write; updated for the words left unsent
+  * @retval true if every word was taken (or discarded while unmounted), false
+  *         if the TX FIFO is full
+  */
+static bool SendUmpWords(uint32_t *words, uint32_t *word_count, uint32_t *split_words) {
+  if (!tud_ump_n_mounted(0)) {
+    midi_stats.usb_errors++;
+    *word_count = 0;
+    *split_words = 0;
+    return true;
+  }
+  
+  uint32_t written = tud_ump_write(0, words, *word_count);
+  
+  uint32_t offset = *split_words;
+  if (offset > written) {
+    *split_words = offset - written;
+  } else {
+    if (offset > 0) {
+      midi_stats.usb_tx_count++;
+    }
+    *split_words = 0;
+    while (offset < written) {
+      uint32_t size = GetUmpWordCount(words[offset]);
+      if (offset + size > written) {
+        *split_words = offset + size - written;
+        break;
+      }
+      midi_stats.usb_tx_count++;
+      offset += size;
+    }
+  }
+  
+  *word_count -= written;
+  if (*word_count > 0) {
+    midi_stats.usb_tx_retries++;
+    memmove(words, &words[written], *word_count * sizeof(uint32_t));
+    return false;
+  }
+  return true;
+}
+
 /**
   * @brief Determine the number of words in a UMP message based on message type
+  * @note  Sizes of all 16 message types per UMP 1.1, reserved types included,
+  *        so unknown messages are skipped without losing the framing
   * @param first_word: First word of the UMP message
   * @retval Number of words (1-4)
   */
@@ -109,25 +277,5 @@ uint8_t GetUmpWordCount(uint32_t first_word) {
 #else
 static uint8_t GetUmpWordCount(uint32_t first_word) {
 #endif
-  uint8_t message_type = (first_word >> 28) & 0xF;
-  
-  switch (message_type) {
-    case 0x0:  // Utility messages (32-bit)
-      return 1;
-    case 0x1:  // System messages (32-bit) - includes F8 Clock
-      return 1;
-    case 0x2:  // MIDI 1.0 Channel Voice messages (32-bit)
-      return 1;
-    case 0x3:  // Data messages (64-bit)
-      return 2;
-    case 0x4:  // MIDI 2.0 Channel Voice messages (64-bit)
-      return 2;
-    case 0x5:  // Data messages (128-bit)
-      return 4;
-    case 0xF:  // Stream messages (128-bit) - UMP Discovery, Protocol negotiation etc
-      return 4;
-    default:
-      // Default to 1 word for unknown message types
-      return 1;
-  }
+  return UMP_WORD_COUNT(first_word);
 }
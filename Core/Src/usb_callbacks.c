@@ -5,6 +5,10 @@
 #include "tusb.h"
 #include "mode_manager.h"
 #include "ump_discovery.h"
+#include "usb_midi_task.h"
+#include "ump_task.h"
+#include "midi2_task.h"
+#include "midi_clock.h"
 #include "FreeRTOS.h"
 #include "task.h"
 
@@ -14,13 +18,21 @@ extern UART_HandleTypeDef huart1;
 // Invoked when device is mounted
 void tud_mount_cb(void)
 {
-  // No debug message - keep it minimal
+  // The host that set a tempo may be gone: give the DIN clock back
+  MIDI_Clock_Reset();
+
+  // A new host session may have reset the DIN device's bank / parameter state,
+  // and starts in the default protocol until it sends a Stream Configuration Request
+  if (ModeManager_GetMode() == MIDI_MODE_2_0) {
+    MIDI2_InvalidateDinCache();
+    UMP_ResetProtocol();
+  }
 }
 
 // Invoked when device is unmounted
 void tud_umount_cb(void)
 {
-  // No debug message - keep it minimal
+  MIDI_Clock_Reset();
 }
 
 // Invoked when usb bus is suspended
@@ -51,10 +63,17 @@ void tud_midi_mount_cb(uint8_t itf)
 // Forward declaration for UMP mount callback (defined in usb_descriptors.c)
 extern void tud_ump_mount_cb(uint8_t itf, uint8_t alt_setting);
 
-// Optional: MIDI receive callback for debugging
+// Invoked when the MIDI OUT endpoint received data (MIDI 1.0 mode)
 void tud_midi_rx_cb(uint8_t itf)
 {
   (void) itf;
-  // Don't process data here - just signal the callback occurred
-  // Actual data processing should be done in the USB RX task
+  // Don't process data here - wake the USB RX task to drain it
+  USB_MIDI_RxNotify();
+}
+
+// Invoked when the UMP OUT endpoint received data (MIDI 2.0 mode)
+void tud_ump_rx_cb(uint8_t itf)
+{
+  (void) itf;
+  UMP_RxNotify();
 }
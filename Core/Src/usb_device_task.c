@@ -5,10 +5,16 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "usb_device_task.h"
+#include "midi_time.h"
+#include "device/usbd_pvt.h"  // For usbd_defer_func
 
 /* External variables --------------------------------------------------------*/
 extern UART_HandleTypeDef huart1;
 
+/* Private function prototypes -----------------------------------------------*/
+static void SofControl(bool enable, bool in_isr);
+static void SetSofInterrupt(void *param);
+
 /* Public functions ----------------------------------------------------------*/
 /**
   * @brief USB Device Driver task
@@ -28,9 +34,34 @@ void vUSBDeviceTask(void *pvParameters) {
   };
   tusb_rhport_init(0, &dev_init);
 
+  // The SOF interrupt is only unmasked while frame timing is in use, so an
+  // idle bus does not wake this task every frame
+  MIDI_Time_SetSofControl(SofControl);
+
   while (1) {
     tud_task(); // TinyUSB device task
     
     vTaskDelay(1);  // Allow lower priority tasks to run
   }
 }
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief SOF control for midi_time
+  * @note  The change is made from tud_task, which owns the USB stack state
+  * @param enable: true to unmask the SOF interrupt
+  * @param in_isr: true when called from an interrupt
+  * @retval None
+  */
+static void SofControl(bool enable, bool in_isr) {
+  usbd_defer_func(SetSofInterrupt, enable ? (void *)1 : NULL, in_isr);
+}
+
+/**
+  * @brief Unmask or mask the SOF interrupt (tud_task context)
+  * @param param: Non-NULL to unmask
+  * @retval None
+  */
+static void SetSofInterrupt(void *param) {
+  tud_sof_cb_enable(param != NULL);
+}
@@ -5,7 +5,12 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "usb_midi_task.h"
-#include "uart_midi_task.h"  // For UartTxBuffer_t and UART TX functions
+#include "uart_tx.h"
+#include "midi_parser.h"     // For USB-MIDI event word helpers
+#include "midi_scheduler.h"
+#include "midi_time.h"
+#include "midi_clock.h"
+#include "ump_discovery.h"  // For the device family / model of the config SysEx
 #include "tusb.h"
 #include "semphr.h"
 #include <string.h>
@@ -15,27 +20,62 @@ extern UART_HandleTypeDef huart1;
 extern UART_HandleTypeDef huart2;
 
 /* Private variables ---------------------------------------------------------*/
-// DMA TX buffer and control
-static UartTxBuffer_t uart_tx_buffers[2];  // Double buffering for continuous transmission
-static uint8_t current_tx_buffer = 0;
-SemaphoreHandle_t xUartTxCompleteSemaphore = NULL;
-volatile uint8_t uart_tx_dma_busy = 0;
-
-// SysEx buffer for accumulating multi-packet SysEx messages
-#define SYSEX_BUFFER_SIZE 1024  // Increased to handle larger SysEx messages
-static struct {
-  uint8_t data[SYSEX_BUFFER_SIZE];
-  uint16_t length;
-  bool in_sysex;
-  bool overflow;  // Track if buffer overflowed
-} sysex_buffer = {.length = 0, .in_sysex = false, .overflow = false};
+static TaskHandle_t xUsbRxTaskHandle = NULL;  // Notified when the MIDI OUT endpoint receives data
+static MidiScheduler_t din_scheduler;          // DIN OUT traffic classes (USB to UART task only)
+static uint32_t held_event = 0;                // Event waiting for scheduler room or its release time
+static bool has_held_event = false;
+static uint32_t held_rt_event = 0;             // Realtime event waiting for its release time
+static bool has_held_rt_event = false;
+static volatile uint32_t dejitter_us = MIDI_DIN_TX_DEJITTER_US;  // 0: de-jitter off
+static uint8_t config_sysex[USB_CONFIG_SYSEX_LENGTH];  // Config SysEx seen so far (USB RX task only)
+static uint8_t config_sysex_length = 0;                // Bytes in config_sysex (0: none)
+static uint32_t batch_time = 0;                // Release time of the first data event of a transfer
+static uint8_t batch_count = 0;                // Data events spread over the frame (0: send at once)
+static uint8_t batch_index = 0;                // Data events of the transfer admitted so far
 
 /* Private function prototypes -----------------------------------------------*/
-static void ProcessUsbMidiPacket(MIDIPacket_t *midi_packet, TickType_t *ledOnTime);
+static void ProcessUsbMidiData(const uint8_t *data, uint16_t length, uint32_t message_count, TickType_t *ledOnTime);
 static void ProcessActiveSensing(TickType_t *lastActiveSensingTime, TickType_t *ledOnTime);
 static void UpdateTxLedState(TickType_t *ledOnTime);
+static uint32_t ReadUsbEvents(uint32_t *events, uint32_t max_count);
+static void WatchConfigSysEx(uint32_t event);
+static void ForwardUsbEvents(const uint32_t *events, uint32_t count);
+static bool AdmitEvents(uint32_t *release_time);
+static bool IsReleased(uint32_t release, uint32_t now);
 
 /* Public functions ----------------------------------------------------------*/
+/**
+  * @brief Wake the USB RX task after the MIDI OUT endpoint received data
+  * @note  Called from tud_midi_rx_cb (TinyUSB device task context)
+  * @retval None
+  */
+void USB_MIDI_RxNotify(void) {
+  if (xUsbRxTaskHandle != NULL) {
+    xTaskNotifyGive(xUsbRxTaskHandle);
+  }
+}
+
+/**
+  * @brief Set the de-jitter delay of the USB to DIN path (MIDI 1.0 mode)
+  * @note  Each USB OUT transfer is stamped with the start of the frame it
+  *        arrived in, and its events leave delay_us later, spread over one
+  *        frame: longer delays trade latency for less jitter. The host sets
+  *        it with the USB_CONFIG_DEJITTER SysEx.
+  * @param delay_us: Constant delay in microseconds (0: off; at most USB_DEJITTER_MAX_US)
+  * @retval None
+  */
+void USB_MIDI_SetDejitterDelay(uint32_t delay_us) {
+  dejitter_us = (delay_us > USB_DEJITTER_MAX_US) ? USB_DEJITTER_MAX_US : delay_us;
+}
+
+/**
+  * @brief Get the de-jitter delay of the USB to DIN path
+  * @retval Delay in microseconds (0: off)
+  */
+uint32_t USB_MIDI_GetDejitterDelay(void) {
+  return dejitter_us;
+}
+
 /**
   * @brief USB RX MIDI Task - receives MIDI data from USB and forwards to UART
   * @param pvParameters: Task parameters
@@ -44,237 +84,175 @@ static void UpdateTxLedState(TickType_t *ledOnTime);
 void vUsbRxMidiTask(void* pvParameters) {
   (void) pvParameters;
   
+  xUsbRxTaskHandle = xTaskGetCurrentTaskHandle();
+  
   while (1) {
-    // Handle incoming USB MIDI data and forward to UART
-    while (tud_midi_available()) {
-      uint8_t packet[4];
-      if (tud_midi_packet_read(packet)) {
-        // Extract MIDI data from USB MIDI packet first
-        uint8_t cable = (packet[0] & 0xF0) >> 4;  // Cable Number in upper nibble (bits 7-4)
-        uint8_t cin = packet[0] & 0x0F;           // CIN in lower nibble (bits 3-0)
-        
-        MIDIPacket_t midi_packet;
-        
-        (void)cable;  // Currently only handling single cable, suppress unused warning
-        
-        // Determine MIDI message length based on Code Index Number (CIN)
-        uint8_t midi_length = 0;
-        bool is_sysex = false;
-        
-        switch (cin) {
-          case USB_MIDI_CIN_2BYTE_SYSCOM: // Two-byte System Common messages
-          case USB_MIDI_CIN_PROG_CHANGE:  // Program Change
-          case USB_MIDI_CIN_CHAN_PRESSURE: // Channel Pressure
-            midi_length = 2;
-            break;
-          case USB_MIDI_CIN_3BYTE_SYSCOM: // Three-byte System Common messages
-          case USB_MIDI_CIN_NOTE_OFF:     // Note-off
-          case USB_MIDI_CIN_NOTE_ON:      // Note-on
-          case USB_MIDI_CIN_POLY_KEYPRESS: // Poly-KeyPress
-          case USB_MIDI_CIN_CTRL_CHANGE:  // Control Change
-          case USB_MIDI_CIN_PITCH_BEND:   // PitchBend Change
-            midi_length = 3;
-            break;
-          case USB_MIDI_CIN_1BYTE: // Single-byte System Common Message or SysEx ends with 1 byte
-            // Check if it's a real-time message or SysEx end
-            if (packet[1] == 0xF7) { // SysEx End
-              is_sysex = true;
-              midi_length = 1;
-            } else {
-              midi_length = 1;
-            }
-            break;
-          case USB_MIDI_CIN_SYSEX_START: // SysEx starts or continues (3 bytes)
-            is_sysex = true;
-            midi_length = 3;
-            break;
-          case USB_MIDI_CIN_SYSEX_END_2: // SysEx ends with 2 bytes
-            is_sysex = true;
-            midi_length = 2;
-            break;
-          case USB_MIDI_CIN_SYSEX_END_3: // SysEx ends with 3 bytes
-            is_sysex = true;
-            midi_length = 3;
-            break;
-          default:
-            midi_length = 3; // Default to 3 bytes
-            break;
-        }
-        
-        // Handle SysEx messages differently
-        if (is_sysex) {
-          // Process SysEx data
-          if (cin == USB_MIDI_CIN_SYSEX_START) {
-            // Check if first byte is 0xF0 (SysEx start)
-            if (packet[1] == 0xF0) {
-              // Start new SysEx message
-              sysex_buffer.length = 0;
-              sysex_buffer.in_sysex = true;
-              sysex_buffer.overflow = false;
-              // Add all 3 bytes
-              for (int i = 0; i < 3; i++) {
-                if (sysex_buffer.length < SYSEX_BUFFER_SIZE) {
-                  sysex_buffer.data[sysex_buffer.length++] = packet[i + 1];
-                } else {
-                  sysex_buffer.overflow = true;
-                }
-              }
-            } else if (sysex_buffer.in_sysex) {
-              // Continue SysEx message (no 0xF0)
-              for (int i = 0; i < 3; i++) {
-                if (packet[i + 1] != 0x00) { // Skip padding bytes
-                  if (sysex_buffer.length < SYSEX_BUFFER_SIZE) {
-                    sysex_buffer.data[sysex_buffer.length++] = packet[i + 1];
-                  } else {
-                    sysex_buffer.overflow = true;
-                  }
-                }
-              }
-            }
-          } else if ((cin == USB_MIDI_CIN_SYSEX_END_2 || cin == USB_MIDI_CIN_SYSEX_END_3 || 
-                     (cin == USB_MIDI_CIN_1BYTE && packet[1] == 0xF7)) && sysex_buffer.in_sysex) {
-            // End of SysEx message
-            // Add remaining bytes
-            for (int i = 0; i < midi_length; i++) {
-              if (packet[i + 1] != 0x00) { // Skip padding bytes
-                if (sysex_buffer.length < SYSEX_BUFFER_SIZE) {
-                  sysex_buffer.data[sysex_buffer.length++] = packet[i + 1];
-                } else {
-                  sysex_buffer.overflow = true;
-                }
-              }
-            }
-            
-            // Send complete SysEx message to UART queue
-            if (sysex_buffer.length > 0 && !sysex_buffer.overflow) {
-              // Send directly to UART instead of chunking through queue
-              // This avoids queue overflow for large SysEx
-              MIDIPacket_t sysex_packet;
-              
-              // Send the entire SysEx message at once
-              // The UART task will handle the actual transmission
-              for (uint16_t offset = 0; offset < sysex_buffer.length; ) {
-                uint16_t remaining = sysex_buffer.length - offset;
-                uint8_t chunk_size = (remaining > 3) ? 3 : remaining;
-                
-                memcpy(sysex_packet.data, &sysex_buffer.data[offset], chunk_size);
-                sysex_packet.length = chunk_size;
-                
-                // Use blocking send with timeout to ensure delivery
-                if (xQueueSend(xUsbToUartQueue, &sysex_packet, pdMS_TO_TICKS(10)) == pdTRUE) {
-                  midi_stats.usb_rx_count++;
-                  offset += chunk_size;
-                } else {
-                  midi_stats.queue_full_errors++;
-                  break;  // Stop if queue is persistently full
-                }
-              }
-            } else if (sysex_buffer.overflow) {
-              // Log overflow error
-              midi_stats.queue_full_errors++;
-            }
-            
-            // Reset SysEx buffer
-            sysex_buffer.in_sysex = false;
-            sysex_buffer.length = 0;
-            sysex_buffer.overflow = false;
-          }
-        } else {
-          // Normal MIDI message
-          for (int i = 0; i < midi_length && i < 3; i++) {
-            midi_packet.data[i] = packet[i + 1];
-          }
-          midi_packet.length = midi_length;
-          
-          // Optional: Filter out Active Sensing to reduce UART traffic
-#if MIDI_FILTER_ACTIVE_SENSING
-          if (!(midi_length == 1 && midi_packet.data[0] == MIDI_ACTIVE_SENSING)) {
-#endif
-            // Send to UART output queue
-            if (xQueueSend(xUsbToUartQueue, &midi_packet, 0) == pdTRUE) {
-              midi_stats.usb_rx_count++;
-            } else {
-              midi_stats.queue_full_errors++;
-            }
-#if MIDI_FILTER_ACTIVE_SENSING
-          }
-#endif
-        }
-      }
+    // Handle all incoming USB MIDI data and forward to UART
+    uint32_t events[USB_RX_BATCH_SIZE];
+    uint32_t count;
+    while ((count = ReadUsbEvents(events, USB_RX_BATCH_SIZE)) > 0) {
+      ForwardUsbEvents(events, count);
     }
     
-    // Small delay to prevent overwhelming the CPU
-    vTaskDelay(pdMS_TO_TICKS(1));
+    // Sleep until tud_midi_rx_cb reports new data
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
   }
 }
 
 /**
-  * @brief Initialize UART TX DMA
-  * @retval None
+  * @brief Read the MIDI events waiting on the MIDI OUT endpoint
+  * @param events: Set to the events that carry MIDI data
+  * @param max_count: Capacity of events
+  * @retval Number of events
   */
-void UART_TX_DMA_Init(void) {
-  // Create semaphore for TX completion
-  xUartTxCompleteSemaphore = xSemaphoreCreateBinary();
-  if (xUartTxCompleteSemaphore != NULL) {
-    // Give semaphore initially (TX is ready)
-    xSemaphoreGive(xUartTxCompleteSemaphore);
-  }
+static uint32_t ReadUsbEvents(uint32_t *events, uint32_t max_count) {
+  uint32_t count = 0;
   
-  // Initialize buffers
-  for (int i = 0; i < 2; i++) {
-    uart_tx_buffers[i].in_use = 0;
-    uart_tx_buffers[i].length = 0;
+  while (count < max_count && tud_midi_available()) {
+    uint8_t packet[4];
+    if (!tud_midi_packet_read(packet)) {
+      break;
+    }
+    
+    // USB MIDI packets are forwarded as event words (cable/CIN + 3 bytes);
+    // currently only a single cable is handled, so the cable number is ignored
+    uint32_t event = MIDI_EVENT_FROM_PACKET(packet);
+    uint8_t midi_length = MIDI_Parser_EventLength(event);
+    
+    if (midi_length == 0) {
+      continue;  // Miscellaneous / cable event CINs carry no MIDI data
+    }
+    if (MIDI_EVENT_IS_SYSEX(event)) {
+      WatchConfigSysEx(event);
+    }
+    
+    // Optional: Filter out Active Sensing to reduce UART traffic
+#if MIDI_FILTER_ACTIVE_SENSING
+    if (midi_length == 1 && MIDI_EVENT_BYTE(event, 0) == MIDI_ACTIVE_SENSING) {
+      continue;
+    }
+#endif
+    events[count++] = event;
   }
+  return count;
 }
 
 /**
-  * @brief Send data via UART DMA
-  * @param data: Data to send
-  * @param length: Length of data
-  * @retval pdTRUE if successful, pdFALSE if busy
+  * @brief Follow the SysEx from the host and apply device configuration messages
+  * @note  See USB_CONFIG_SYSEX_LENGTH; other SysEx is ignored here
+  * @param event: SysEx event word
+  * @retval None
   */
-BaseType_t UART_TX_SendDMA(const uint8_t *data, uint16_t length) {
-  if (length == 0 || length > UART_TX_BUFFER_SIZE) {
-    return pdFALSE;
-  }
+static void WatchConfigSysEx(uint32_t event) {
+  static const uint8_t header[] = {
+    MIDI_SYSEX_START, MANUFACTURER_ID_BYTE1, DEVICE_FAMILY_ID_LSB, DEVICE_MODEL_ID_LSB
+  };
+  uint8_t length = MIDI_Parser_EventLength(event);
   
-  // Wait for DMA to be ready (with timeout)
-  if (xSemaphoreTake(xUartTxCompleteSemaphore, pdMS_TO_TICKS(10)) != pdTRUE) {
-    return pdFALSE;  // DMA still busy
+  for (uint8_t i = 0; i < length; i++) {
+    uint8_t byte = MIDI_EVENT_BYTE(event, i);
+    if (byte == MIDI_SYSEX_START) {
+      config_sysex_length = 0;
+    } else if (config_sysex_length == 0) {
+      continue;  // Not collecting
+    }
+    if (config_sysex_length == USB_CONFIG_SYSEX_LENGTH ||
+        (config_sysex_length < sizeof(header) && byte != header[config_sysex_length])) {
+      config_sysex_length = 0;  // Too long, or someone else's SysEx
+      continue;
+    }
+    config_sysex[config_sysex_length++] = byte;
+    if (byte == MIDI_SYSEX_END) {
+      if (config_sysex_length == USB_CONFIG_SYSEX_LENGTH && config_sysex[4] == USB_CONFIG_DEJITTER) {
+        USB_MIDI_SetDejitterDelay((uint32_t)config_sysex[5] * 1000U);
+      }
+      config_sysex_length = 0;
+    }
   }
+}
+
+/**
+  * @brief Hand the events of one USB OUT transfer to the USB to UART task
+  * @note  In de-jitter mode the events were produced by the host during the
+  *        frame before the one they arrived in. They are released over the
+  *        same span one de-jitter delay later: the data events through a
+  *        release marker ahead of them, realtime through its timestamp.
+  * @param events: Events with MIDI data
+  * @param count: Number of events
+  * @retval None
+  */
+static void ForwardUsbEvents(const uint32_t *events, uint32_t count) {
+  uint32_t now = MIDI_Time_Now();
+  uint32_t delay = dejitter_us;
+  uint32_t phase;
+  bool timed = (delay > 0 && MIDI_Time_FramePhase(now, &phase));
+  uint32_t first_time = timed ? now - phase - MIDI_TIME_FRAME_US + delay : now;
+  uint32_t data_count = 0;
   
-  // Select buffer and copy data
-  UartTxBuffer_t *tx_buffer = &uart_tx_buffers[current_tx_buffer];
-  memcpy(tx_buffer->data, data, length);
-  tx_buffer->length = length;
-  tx_buffer->in_use = 1;
-  
-  // Start DMA transmission
-  uart_tx_dma_busy = 1;
-  HAL_StatusTypeDef status = HAL_UART_Transmit_DMA(&huart2, tx_buffer->data, length);
-  if (status != HAL_OK) {
-    // DMA start failed
-    tx_buffer->in_use = 0;
-    uart_tx_dma_busy = 0;
-    xSemaphoreGive(xUartTxCompleteSemaphore);
-    return pdFALSE;
+  if (timed) {
+    for (uint32_t i = 0; i < count; i++) {
+      data_count += MIDI_EVENT_IS_REALTIME(events[i]) ? 0 : 1;
+    }
+    // The marker releases exactly data_count events, so it is only queued
+    // when all of them fit behind it (this task is the only producer).
+    // Otherwise the data goes out untimed rather than being torn apart
+    if (data_count > 0 && MIDI_RING_SIZE - MIDI_Ring_Count(&usb_to_uart_ring) > data_count) {
+      uint32_t marker = MIDI_EVENT_RELEASE(first_time, data_count);
+      MIDI_Ring_Push(&usb_to_uart_ring, &marker, 1);
+    } else if (data_count > 0) {
+      midi_stats.din_tx_dejitter_missed++;
+      data_count = 0;
+    }
   }
   
-  // Note: Semaphore will be given back in HAL_UART_TxCpltCallback
-  
-  // Switch to other buffer for next transmission
-  current_tx_buffer = 1 - current_tx_buffer;
-  
-  return pdTRUE;
+  uint32_t data_index = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    // Realtime takes its own lane so it can overtake queued data.
+    // SysEx is streamed packet by packet; wait for ring space so long
+    // dumps are not torn, drop other messages when the ring is full
+    uint32_t event = events[i];
+    uint32_t pushed;
+    uint32_t release = now;
+    bool realtime = MIDI_EVENT_IS_REALTIME(event);
+    if (timed) {
+      if (realtime) {
+        release = first_time + i * MIDI_TIME_FRAME_US / count;
+      } else if (data_count > 0) {
+        release = first_time + data_index++ * MIDI_TIME_FRAME_US / data_count;
+      }
+      if ((int32_t)(release - now) < 0) {
+        midi_stats.din_tx_sched_late++;  // The delay is shorter than the transfer took
+      }
+    }
+    if (realtime && MIDI_Clock_ToDin(MIDI_EVENT_BYTE(event, 0), release)) {
+      midi_stats.usb_rx_count++;  // Clock and transport are sent by the clock PLL
+      continue;
+    }
+    if (realtime) {
+      event = MIDI_Time_StampRealtime(event, release);
+      pushed = MIDI_Ring_Push(&usb_to_uart_rt_ring, &event, 1);
+    } else {
+      pushed = MIDI_EVENT_IS_SYSEX(event) ?
+               MIDI_Ring_PushWait(&usb_to_uart_ring, &event, 1, pdMS_TO_TICKS(10)) :
+               MIDI_Ring_Push(&usb_to_uart_ring, &event, 1);
+    }
+    if (pushed == 1) {
+      midi_stats.usb_rx_count++;
+    } else {
+      midi_stats.queue_full_errors++;
+    }
+  }
 }
 
 /**
-  * @brief Process USB MIDI packet and send to UART
-  * @param midi_packet: MIDI packet to process
+  * @brief Send a batch of MIDI bytes from USB to UART
+  * @param data: MIDI bytes of one or more complete messages
+  * @param length: Number of bytes
+  * @param message_count: Number of messages contained in data
   * @param ledOnTime: Pointer to LED on time
   * @retval None
   */
-static void ProcessUsbMidiPacket(MIDIPacket_t *midi_packet, TickType_t *ledOnTime) {
+static void ProcessUsbMidiData(const uint8_t *data, uint16_t length, uint32_t message_count, TickType_t *ledOnTime) {
   // Turn on TxMIDI LED before transmission
   if (xSemaphoreTake(xLedMutex, 0) == pdTRUE) {
     HAL_GPIO_WritePin(TxMIDI_GPIO_Port, TxMIDI_Pin, GPIO_PIN_SET);
@@ -282,13 +260,11 @@ static void ProcessUsbMidiPacket(MIDIPacket_t *midi_packet, TickType_t *ledOnTim
   }
   *ledOnTime = xTaskGetTickCount();
   
-  // Send MIDI data to UART2 (TX MIDI) via DMA
-  if (UART_TX_SendDMA(midi_packet->data, midi_packet->length) == pdTRUE) {
-    midi_stats.uart_tx_count++;
+  // Queue MIDI data for UART2 (TX MIDI); the DMA chain picks it up
+  if (UART_TX_Write(data, length) == pdTRUE) {
+    midi_stats.uart_tx_count += message_count;
   } else {
     midi_stats.uart_tx_errors++;
-    // If DMA is busy, wait a bit
-    vTaskDelay(pdMS_TO_TICKS(1));
   }
 }
 
@@ -303,7 +279,7 @@ static void ProcessActiveSensing(TickType_t *lastActiveSensingTime, TickType_t *
   TickType_t currentTime = xTaskGetTickCount();
   if ((currentTime - *lastActiveSensingTime) > pdMS_TO_TICKS(300)) {
     uint8_t activeSensing = MIDI_ACTIVE_SENSING;
-    if (UART_TX_SendDMA(&activeSensing, 1) == pdTRUE) {
+    if (UART_TX_Write(&activeSensing, 1) == pdTRUE) {
       *lastActiveSensingTime = currentTime;
       
       // Turn on LED for Active Sensing
@@ -337,6 +313,87 @@ static void UpdateTxLedState(TickType_t *ledOnTime) {
   }
 }
 
+/**
+  * @brief Move events from the USB RX rings into the DIN TX scheduler
+  * @note  An event the scheduler refuses (full queue, not Note On or a controller
+  *        value) stays held with the data ring unread, which back-pressures the
+  *        USB RX task instead of losing a Note Off or tearing a SysEx.
+  *        In de-jitter mode events also stay held until their release time.
+  * @param release_time: Set to the earliest release time still waited for
+  * @retval true if an event waits for its release time
+  */
+static bool AdmitEvents(uint32_t *release_time) {
+  uint32_t now = MIDI_Time_Now();
+  uint32_t wire_pending = UART_TX_Pending();
+  bool waiting = false;
+  
+  // Realtime stamps are release times (the arrival time when not de-jittered)
+  while (1) {
+    if (!has_held_rt_event) {
+      if (MIDI_Ring_PopFresh(&usb_to_uart_rt_ring, &held_rt_event, 1, pdMS_TO_TICKS(MIDI_USB_TO_UART_MAX_AGE_MS),
+                             &midi_stats.evicted_usb_to_uart) == 0) {
+        break;
+      }
+      has_held_rt_event = true;
+    }
+    uint32_t release = MIDI_Time_Expand(MIDI_EVENT_RELEASE_TIME(held_rt_event));
+    if (!IsReleased(release, now)) {
+      *release_time = release;
+      waiting = true;
+      break;
+    }
+    MIDI_Scheduler_Push(&din_scheduler, held_rt_event, now, wire_pending);
+    has_held_rt_event = false;
+  }
+  
+  while (1) {
+    if (!has_held_event) {
+      if (MIDI_Ring_PopFresh(&usb_to_uart_ring, &held_event, 1, pdMS_TO_TICKS(MIDI_USB_TO_UART_MAX_AGE_MS),
+                             &midi_stats.evicted_usb_to_uart) == 0) {
+        break;
+      }
+      if (MIDI_EVENT_IS_TIMESTAMP(held_event)) {
+        batch_time = MIDI_Time_Expand(MIDI_EVENT_RELEASE_TIME(held_event));
+        batch_count = MIDI_EVENT_RELEASE_COUNT(held_event);
+        batch_index = 0;
+        continue;
+      }
+      has_held_event = true;
+    }
+    if (batch_index < batch_count) {
+      uint32_t release = batch_time + batch_index * MIDI_TIME_FRAME_US / batch_count;
+      if (!IsReleased(release, now)) {
+        if (!waiting || (int32_t)(release - *release_time) < 0) {
+          *release_time = release;
+        }
+        waiting = true;
+        break;
+      }
+    }
+    if (!MIDI_Scheduler_Push(&din_scheduler, held_event, now, wire_pending)) {
+      break;
+    }
+    has_held_event = false;
+    if (batch_index < batch_count) {
+      batch_index++;
+    }
+  }
+  return waiting;
+}
+
+/**
+  * @brief Check whether an event may leave
+  * @note  A release time further ahead than any de-jitter delay comes from a
+  *        16-bit stamp that wrapped while the event waited; it goes at once.
+  * @param release: Release time of the event
+  * @param now: Current time
+  * @retval true if the event is due
+  */
+static bool IsReleased(uint32_t release, uint32_t now) {
+  uint32_t ahead = release - now;
+  return (int32_t)ahead <= 0 || ahead > USB_DEJITTER_MAX_US + MIDI_TIME_FRAME_US;
+}
+
 /**
   * @brief USB to UART Task - receives MIDI packets from queue and sends to UART
   * @param pvParameters: Task parameters
@@ -344,17 +401,82 @@ static void UpdateTxLedState(TickType_t *ledOnTime) {
   */
 void vUsbToUartTask(void *pvParameters) {
   (void) pvParameters;
-  MIDIPacket_t midi_packet;
+  uint8_t tx_data[USB_TO_UART_RT_MAX + USB_TO_UART_BURST_BYTES];
   TickType_t lastActiveSensingTime = xTaskGetTickCount();  // Initialize to current time for immediate Active Sensing
   TickType_t ledOnTime = 0;  // LED turn on time
   
+  MIDI_Scheduler_Init(&din_scheduler, MIDI_DIN_TX_COALESCE);
+  MIDI_Ring_SetConsumer(&usb_to_uart_ring, xTaskGetCurrentTaskHandle());
+  MIDI_Ring_SetConsumer(&usb_to_uart_rt_ring, xTaskGetCurrentTaskHandle());
+  
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  bool waiting = false;  // De-jittered events wait for their release time
+  uint32_t release_time = 0;
+  
   while (1) {
-    // Wait for MIDI packet from USB RX (with timeout for Active Sensing)
-    if (xQueueReceive(xUsbToUartQueue, &midi_packet, pdMS_TO_TICKS(10)) == pdTRUE) {
-      ProcessUsbMidiPacket(&midi_packet, &ledOnTime);
+    // Wait for MIDI events from USB RX (with timeout for Active Sensing)
+    // or the next release time
+    if (waiting) {
+      MIDI_Time_SetAlarm(MIDI_TIME_ALARM_DIN_OUT, release_time, self);
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+    MIDI_Time_CancelAlarm(MIDI_TIME_ALARM_DIN_OUT);
+    
+    // Send short bursts chosen by the scheduler. Each burst is queued once the
+    // wire is nearly idle, so realtime never waits behind a long queue and the
+    // scheduler, not the UART ring, decides what waits under overload.
+    while (1) {
+      waiting = AdmitEvents(&release_time);
+      if (MIDI_Scheduler_QueuedBytes(&din_scheduler) == 0) {
+        break;
+      }
+      if (UART_TX_Pending() > UART_TX_LOW_WATER) {
+        // Keep admitting new events while the wire drains
+        UART_TX_WaitPending(UART_TX_LOW_WATER, 1);
+        continue;
+      }
+      
+      uint16_t length = 0;
+      uint16_t data_length = 0;
+      uint16_t rt_count = 0;
+      uint32_t message_count = 0;
+      bool reset_active_sensing = false;
+      uint32_t now = MIDI_Time_Now();
+      uint32_t event;
+      
+      while (MIDI_Scheduler_Peek(&din_scheduler, now, &event)) {
+        uint8_t midi_length = MIDI_Parser_EventLength(event);
+        bool realtime = MIDI_EVENT_IS_REALTIME(event);
+        if (realtime ? (rt_count >= USB_TO_UART_RT_MAX) :
+            (data_length > 0 && data_length + midi_length > USB_TO_UART_BURST_BYTES)) {
+          break;  // Next burst
+        }
+        MIDI_Scheduler_Pop(&din_scheduler, now, &event);
+        
+        if (realtime) {
+          event = MIDI_Time_UnstampRealtime(event, &midi_stats.rt_out_latency_max_us);
+          rt_count++;
+          // Reset Active Sensing timer only on non-Active Sensing messages
+          if (MIDI_EVENT_BYTE(event, 0) != MIDI_ACTIVE_SENSING) {
+            reset_active_sensing = true;
+          }
+        } else {
+          data_length += midi_length;
+          reset_active_sensing = true;
+        }
+        for (uint8_t j = 0; j < midi_length; j++) {
+          tx_data[length++] = MIDI_EVENT_BYTE(event, j);
+        }
+        message_count++;
+      }
+      
+      if (length == 0) {
+        break;  // Waiting for the rest of a SysEx
+      }
+      
+      ProcessUsbMidiData(tx_data, length, message_count, &ledOnTime);
       
-      // Reset Active Sensing timer only on non-Active Sensing messages
-      if (!(midi_packet.length == 1 && midi_packet.data[0] == MIDI_ACTIVE_SENSING)) {
+      if (reset_active_sensing) {
         lastActiveSensingTime = xTaskGetTickCount();
       }
     }
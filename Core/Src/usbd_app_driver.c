@@ -7,6 +7,59 @@
 #include "device/usbd_pvt.h"
 #include "app_ump_device.h"
 #include "mode_manager.h"
+#include "midi_common.h"
+#include "midi_time.h"
+
+// SOF driver: claims no interface, only receives Start Of Frame events (ISR context)
+static void sofd_init(void) {
+}
+
+static bool sofd_deinit(void) {
+    return true;
+}
+
+static void sofd_reset(uint8_t rhport) {
+    (void) rhport;
+}
+
+static uint16_t sofd_open(uint8_t rhport, tusb_desc_interface_t const* itf_desc, uint16_t max_len) {
+    (void) rhport;
+    (void) itf_desc;
+    (void) max_len;
+    return 0;
+}
+
+static bool sofd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const* request) {
+    (void) rhport;
+    (void) stage;
+    (void) request;
+    return false;
+}
+
+static bool sofd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    (void) rhport;
+    (void) ep_addr;
+    (void) result;
+    (void) xferred_bytes;
+    return false;
+}
+
+static void sofd_sof(uint8_t rhport, uint32_t frame_count) {
+    (void) rhport;
+    MIDI_Time_SofFromISR(frame_count);
+    midi_stats.usb_sof_count++;
+}
+
+#define SOF_DRIVER {                          \
+        .name = "SOF",                        \
+        .init = sofd_init,                    \
+        .deinit = sofd_deinit,                \
+        .reset = sofd_reset,                  \
+        .open = sofd_open,                    \
+        .control_xfer_cb = sofd_control_xfer_cb, \
+        .xfer_cb = sofd_xfer_cb,              \
+        .sof = sofd_sof                       \
+    }
 
 // Application drivers array - UMP driver functions are implemented in ump_device.cpp
 static usbd_class_driver_t const _app_drivers[] = {
@@ -19,7 +72,13 @@ static usbd_class_driver_t const _app_drivers[] = {
         .control_xfer_cb = umpd_control_xfer_cb,
         .xfer_cb = umpd_xfer_cb,
         .sof = NULL
-    }
+    },
+    SOF_DRIVER
+};
+
+// MIDI 1.0 mode uses the built-in MIDI class; only frame timing is added
+static usbd_class_driver_t const _app_drivers_midi1[] = {
+    SOF_DRIVER
 };
 
 // TinyUSB callback to get application drivers
@@ -29,8 +88,8 @@ usbd_class_driver_t const* usbd_app_driver_get_cb(uint8_t* driver_count) {
         *driver_count = TU_ARRAY_SIZE(_app_drivers);
         return _app_drivers;
     } else {
-        // MIDI 1.0 mode: no application drivers, use standard MIDI only
-        *driver_count = 0;
-        return NULL;
+        // MIDI 1.0 mode: standard MIDI class plus the SOF driver
+        *driver_count = TU_ARRAY_SIZE(_app_drivers_midi1);
+        return _app_drivers_midi1;
     }
 }
@@ -0,0 +1,182 @@
+/**
+  * @file           : bench_din_coalesce.c
+  * @brief          : Host benchmark: DIN TX scheduler under controller overload
+  *
+  * Simulates one second of dense DAW automation (Pitch Bend, two CCs and
+  * Channel Pressure, about 7 kB/s) plus a note every 100 ms on a 31250 baud
+  * wire (3125 B/s), then half a second of silence. Reports the scheduler
+  * backlog, controller delay, and how closely the receiver follows the
+  * sender's controller values, with and without latest-value-wins coalescing.
+  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "midi_common.h"
+#include "midi_parser.h"
+#include "midi_scheduler.h"
+
+#define SIM_STEP_US      10
+#define SIM_ACTIVE_US    1000000
+#define SIM_END_US       1500000
+#define SAMPLE_US        1000
+
+// Tracked controllers: Pitch Bend ch1, CC1 ch1, CC74 ch1, Channel Pressure ch2
+#define TRACKED          4
+
+typedef struct {
+    uint32_t period_us;
+    uint32_t key;        // Event bits identifying the controller
+    uint32_t key_mask;
+    int max_value;
+} Controller_t;
+
+static const Controller_t controllers[TRACKED] = {
+    { 1000, 0x0000E00E, 0x0000FFFF, 16383 },  // Pitch Bend
+    { 2000, 0x0001B00B, 0x00FFFFFF, 127 },    // CC1 Modulation
+    { 2000, 0x004AB00B, 0x00FFFFFF, 127 },    // CC74 Brightness
+    { 2000, 0x0000D10D, 0x0000FFFF, 127 },    // Channel Pressure ch2
+};
+
+typedef struct {
+    double depth_avg;
+    uint32_t depth_max;
+    double error_avg[TRACKED];  // Mean |receiver - sender| in percent of range
+    int end_correct;
+    uint32_t sent_bytes;
+} Result_t;
+
+static int SenderValue(int c, uint32_t t)
+{
+    // Different sweep rates per controller
+    double phase = (double)t / 1e6 * (1.0 + c * 0.7) * 2.0 * M_PI;
+    double v = 0.5 + 0.5 * sin(phase);
+    return (int)lround(v * controllers[c].max_value);
+}
+
+static uint32_t MakeEvent(int c, int value)
+{
+    uint32_t event = controllers[c].key;
+    if (controllers[c].max_value > 127) {
+        return event | ((uint32_t)(value & 0x7F) << 16) | ((uint32_t)(value >> 7) << 24);
+    }
+    if (controllers[c].key_mask == 0x0000FFFF) {
+        return event | ((uint32_t)value << 16);
+    }
+    return event | ((uint32_t)value << 24);
+}
+
+static int EventValue(int c, uint32_t event)
+{
+    if (controllers[c].max_value > 127) {
+        return MIDI_EVENT_BYTE(event, 1) | (MIDI_EVENT_BYTE(event, 2) << 7);
+    }
+    return (controllers[c].key_mask == 0x0000FFFF) ? MIDI_EVENT_BYTE(event, 1) : MIDI_EVENT_BYTE(event, 2);
+}
+
+static void Run(bool coalesce, Result_t *result)
+{
+    static MidiScheduler_t scheduler;
+    int sender[TRACKED];
+    int receiver[TRACKED];
+    double error_sum[TRACKED] = {0};
+    uint64_t depth_sum = 0;
+    uint32_t samples = 0;
+    uint32_t wire_free_at = 0;
+
+    memset(result, 0, sizeof(*result));
+    memset(&midi_stats, 0, sizeof(midi_stats));
+    MIDI_Scheduler_Init(&scheduler, coalesce);
+    for (int c = 0; c < TRACKED; c++) {
+        sender[c] = receiver[c] = -1;
+    }
+
+    for (uint32_t t = 0; t < SIM_END_US; t += SIM_STEP_US) {
+        uint32_t wire_pending = (wire_free_at > t) ? (wire_free_at - t + MIDI_SCHEDULER_BYTE_US - 1) / MIDI_SCHEDULER_BYTE_US : 0;
+
+        if (t < SIM_ACTIVE_US) {
+            for (int c = 0; c < TRACKED; c++) {
+                if (t % controllers[c].period_us == 0) {
+                    int value = SenderValue(c, t);
+                    if (value != sender[c]) {
+                        sender[c] = value;
+                        MIDI_Scheduler_Push(&scheduler, MakeEvent(c, value), t, wire_pending);
+                    }
+                }
+            }
+            if (t % 100000 == 0) {
+                MIDI_Scheduler_Push(&scheduler, 0x64403C99, t, wire_pending);  // Note On ch10
+            }
+            if (t % 100000 == 50000) {
+                MIDI_Scheduler_Push(&scheduler, 0x40403C98, t, wire_pending);  // Note Off ch10
+            }
+        }
+
+        uint32_t event;
+        if (t >= wire_free_at && MIDI_Scheduler_Pop(&scheduler, t, &event)) {
+            uint8_t length = MIDI_Parser_EventLength(event);
+            wire_free_at = t + length * MIDI_SCHEDULER_BYTE_US;
+            result->sent_bytes += length;
+            for (int c = 0; c < TRACKED; c++) {
+                if ((event & controllers[c].key_mask) == controllers[c].key) {
+                    receiver[c] = EventValue(c, event);
+                }
+            }
+        }
+
+        if (t % SAMPLE_US == 0 && t < SIM_ACTIVE_US) {
+            uint32_t depth = MIDI_Scheduler_QueuedBytes(&scheduler);
+            depth_sum += depth;
+            if (depth > result->depth_max) {
+                result->depth_max = depth;
+            }
+            for (int c = 0; c < TRACKED; c++) {
+                if (sender[c] >= 0 && receiver[c] >= 0) {
+                    error_sum[c] += fabs((double)(receiver[c] - sender[c])) * 100.0 / controllers[c].max_value;
+                }
+            }
+            samples++;
+        }
+    }
+
+    result->depth_avg = (double)depth_sum / samples;
+    result->end_correct = 0;
+    for (int c = 0; c < TRACKED; c++) {
+        result->error_avg[c] = error_sum[c] / samples;
+        if (receiver[c] == sender[c]) {
+            result->end_correct++;
+        }
+    }
+}
+
+static void Print(const char *name, const Result_t *r)
+{
+    printf("  %-14s: backlog avg %5.1f / max %3u bytes, voice delay max %6.2f ms, "
+           "drops %4u, coalesced %5u\n",
+           name, r->depth_avg, (unsigned)r->depth_max,
+           midi_stats.din_tx_delay_max_us[MIDI_TX_CLASS_VOICE] / 1000.0,
+           (unsigned)midi_stats.din_tx_drops[MIDI_TX_CLASS_VOICE], (unsigned)midi_stats.din_tx_coalesced);
+    printf("  %-14s  value error PB %5.2f%%, CC1 %5.2f%%, CC74 %5.2f%%, Pressure %5.2f%%; "
+           "end values correct %d/%d; %u bytes sent\n",
+           "", r->error_avg[0], r->error_avg[1], r->error_avg[2], r->error_avg[3],
+           r->end_correct, TRACKED, (unsigned)r->sent_bytes);
+}
+
+int main(void)
+{
+    Result_t plain;
+    Result_t coalesced;
+
+    printf("DIN TX controller overload benchmark (%d ms of automation at ~7 kB/s, 3125 B/s wire)\n",
+           SIM_ACTIVE_US / 1000);
+
+    Run(false, &plain);
+    Print("no coalescing", &plain);
+    Run(true, &coalesced);
+    Print("coalescing", &coalesced);
+
+    return (coalesced.end_correct == TRACKED) ? 0 : 1;
+}
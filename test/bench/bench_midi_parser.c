@@ -0,0 +1,208 @@
+/**
+  * @file           : bench_midi_parser.c
+  * @brief          : Host benchmark: per-byte MIDI parser vs table-driven span parser
+  *
+  * The legacy parser reproduces the former uart_midi_task.c logic (volatile
+  * global state, one call per byte, branchy length/CIN selection). Both
+  * parsers consume the same mixed stream and report throughput in bytes/us.
+  */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "midi_common.h"
+#include "midi_parser.h"
+
+#define STREAM_SIZE   (64 * 1024)
+#define DMA_SPAN      64
+#define ITERATIONS    200
+
+/* Legacy per-byte parser ----------------------------------------------------*/
+static volatile uint8_t legacy_msg_buffer[3];
+static volatile uint8_t legacy_msg_index;
+static volatile uint8_t legacy_running_status;
+static uint8_t legacy_sysex[3];
+static uint8_t legacy_sysex_length;
+static uint8_t legacy_in_sysex;
+static uint32_t legacy_events[4];
+static uint32_t legacy_event_count;
+
+static void LegacyEmit(const uint8_t *data, uint8_t length)
+{
+    uint8_t cin;
+    if (data[length - 1] == MIDI_SYSEX_END) {
+        cin = (length == 1) ? USB_MIDI_CIN_1BYTE : (length == 2) ? USB_MIDI_CIN_SYSEX_END_2 : USB_MIDI_CIN_SYSEX_END_3;
+    } else if (data[0] == MIDI_SYSEX_START || (length == 3 && data[0] < 0x80)) {
+        cin = USB_MIDI_CIN_SYSEX_START;
+    } else {
+        cin = MIDI_GetCIN(data[0], length);
+    }
+    uint32_t word = cin;
+    for (uint8_t i = 0; i < length; i++) {
+        word |= (uint32_t)data[i] << (8 * (i + 1));
+    }
+    legacy_events[legacy_event_count++ & 3] = word;
+}
+
+static void LegacyFlushSysEx(void)
+{
+    if (legacy_sysex_length > 0) {
+        LegacyEmit(legacy_sysex, legacy_sysex_length);
+        legacy_sysex_length = 0;
+    }
+}
+
+static void LegacyProcessByte(uint8_t rx_byte)
+{
+    if (rx_byte & 0x80) {
+        if (rx_byte >= 0xF8) {
+            LegacyEmit(&rx_byte, 1);
+            return;
+        }
+        if (rx_byte == MIDI_SYSEX_START) {
+            legacy_running_status = 0;
+            legacy_msg_index = 0;
+            legacy_in_sysex = 1;
+            legacy_sysex[0] = rx_byte;
+            legacy_sysex_length = 1;
+            return;
+        } else if (rx_byte == MIDI_SYSEX_END) {
+            if (legacy_in_sysex) {
+                legacy_sysex[legacy_sysex_length++] = rx_byte;
+                LegacyFlushSysEx();
+                legacy_in_sysex = 0;
+            }
+            legacy_msg_index = 0;
+            return;
+        } else if (legacy_in_sysex) {
+            legacy_sysex[legacy_sysex_length++] = MIDI_SYSEX_END;
+            LegacyFlushSysEx();
+            legacy_in_sysex = 0;
+        }
+        legacy_running_status = (rx_byte >= 0xF0) ? 0 : rx_byte;
+        legacy_msg_buffer[0] = rx_byte;
+        legacy_msg_index = 1;
+    } else if (legacy_in_sysex) {
+        legacy_sysex[legacy_sysex_length++] = rx_byte;
+        if (legacy_sysex_length == 3) {
+            LegacyFlushSysEx();
+        }
+    } else if (legacy_running_status != 0 && legacy_msg_index < 3) {
+        legacy_msg_buffer[legacy_msg_index++] = rx_byte;
+        uint8_t expected_length = MIDI_GetExpectedLength(legacy_running_status);
+        if (legacy_msg_index >= expected_length) {
+            uint8_t message[3];
+            for (int i = 0; i < expected_length; i++) {
+                message[i] = legacy_msg_buffer[i];
+            }
+            LegacyEmit(message, expected_length);
+            legacy_msg_buffer[0] = legacy_running_status;
+            legacy_msg_index = 1;
+        }
+    }
+}
+
+/* Test stream ---------------------------------------------------------------*/
+static size_t BuildStream(uint8_t *stream, size_t size)
+{
+    size_t n = 0;
+    uint32_t seed = 12345;
+
+    while (n + 16 < size) {
+        seed = seed * 1103515245u + 12345u;
+        switch ((seed >> 16) % 6) {
+            case 0:  // Note On with running status
+                stream[n++] = 0x90;
+                stream[n++] = 0x3C; stream[n++] = 0x64;
+                stream[n++] = 0x40; stream[n++] = 0x00;
+                break;
+            case 1:  // Control Change
+                stream[n++] = 0xB0 | (seed & 0x0F);
+                stream[n++] = 0x07; stream[n++] = (seed >> 8) & 0x7F;
+                break;
+            case 2:  // Timing Clock
+                stream[n++] = 0xF8;
+                break;
+            case 3:  // Program Change
+                stream[n++] = 0xC1; stream[n++] = (seed >> 8) & 0x7F;
+                break;
+            case 4:  // Pitch Bend
+                stream[n++] = 0xE2; stream[n++] = 0x00; stream[n++] = 0x40;
+                break;
+            default:  // Short SysEx
+                stream[n++] = 0xF0;
+                for (int i = 0; i < 8; i++) {
+                    stream[n++] = (uint8_t)(i + (seed & 0x3F));
+                }
+                stream[n++] = 0xF7;
+                break;
+        }
+    }
+    return n;
+}
+
+static double NowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(void)
+{
+    static uint8_t stream[STREAM_SIZE];
+    size_t length = BuildStream(stream, sizeof(stream));
+    uint64_t legacy_total = 0;
+    uint64_t table_total = 0;
+
+    // Legacy: one call per byte
+    double start = NowUs();
+    for (int it = 0; it < ITERATIONS; it++) {
+        legacy_event_count = 0;
+        for (size_t i = 0; i < length; i++) {
+            LegacyProcessByte(stream[i]);
+        }
+        legacy_total += legacy_event_count;
+    }
+    double legacy_us = NowUs() - start;
+
+    // Table-driven: one call per DMA span
+    MidiParser_t parser;
+    uint32_t events[16];
+    MIDI_Parser_Init(&parser, 0);
+    start = NowUs();
+    for (int it = 0; it < ITERATIONS; it++) {
+        for (size_t offset = 0; offset < length; ) {
+            size_t span = (length - offset < DMA_SPAN) ? length - offset : DMA_SPAN;
+            const uint8_t *data = &stream[offset];
+            offset += span;
+            while (span > 0) {
+                size_t event_count;
+                size_t consumed = MIDI_Parser_Process(&parser, data, span, events, 16, &event_count);
+                data += consumed;
+                span -= consumed;
+                table_total += event_count;
+            }
+        }
+    }
+    double table_us = NowUs() - start;
+
+    double bytes = (double)length * ITERATIONS;
+    printf("MIDI parser benchmark (%zu bytes x %d iterations)\n", length, ITERATIONS);
+    printf("  legacy per-byte : %8.1f bytes/us (%llu events)\n",
+           bytes / legacy_us, (unsigned long long)legacy_total);
+    printf("  table-driven    : %8.1f bytes/us (%llu events)\n",
+           bytes / table_us, (unsigned long long)table_total);
+    printf("  speedup         : %8.2fx\n", legacy_us / table_us);
+
+    if (legacy_total != table_total) {
+        printf("  event count mismatch\n");
+        return 1;
+    }
+    return 0;
+}
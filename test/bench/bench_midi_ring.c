@@ -0,0 +1,180 @@
+/**
+  * @file           : bench_midi_ring.c
+  * @brief          : Host benchmark: SPSC event ring vs queue-style message passing
+  *
+  * The queue model mirrors what a FreeRTOS queue of MIDIPacket_t costs per
+  * message: a lock around every send/receive (critical section) and a memcpy
+  * of the item in and out. The ring side moves pre-encoded 32-bit event words
+  * with batch push/pop. Producer and consumer run on separate threads.
+  */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "midi_ring.h"
+
+#define EVENT_COUNT   (4u * 1000u * 1000u)
+#define QUEUE_LENGTH  64
+#define BATCH_SIZE    16
+
+/* Queue model ---------------------------------------------------------------*/
+typedef struct {
+    uint8_t data[4];
+    uint8_t length;
+} Packet_t;
+
+static struct {
+    pthread_mutex_t lock;
+    Packet_t items[QUEUE_LENGTH];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t count;
+} queue = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static int QueueSend(const Packet_t *item)
+{
+    int ok = 0;
+    pthread_mutex_lock(&queue.lock);
+    if (queue.count < QUEUE_LENGTH) {
+        memcpy(&queue.items[queue.head], item, sizeof(Packet_t));
+        queue.head = (queue.head + 1) % QUEUE_LENGTH;
+        queue.count++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&queue.lock);
+    return ok;
+}
+
+static int QueueReceive(Packet_t *item)
+{
+    int ok = 0;
+    pthread_mutex_lock(&queue.lock);
+    if (queue.count > 0) {
+        memcpy(item, &queue.items[queue.tail], sizeof(Packet_t));
+        queue.tail = (queue.tail + 1) % QUEUE_LENGTH;
+        queue.count--;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&queue.lock);
+    return ok;
+}
+
+static void *QueueProducer(void *arg)
+{
+    (void)arg;
+    Packet_t packet = {.data = {0x90, 0x3C, 0x64, 0}, .length = 3};
+    for (uint32_t i = 0; i < EVENT_COUNT; i++) {
+        packet.data[2] = (uint8_t)(i & 0x7F);
+        while (!QueueSend(&packet)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *QueueConsumer(void *arg)
+{
+    uint64_t *checksum = arg;
+    Packet_t packet;
+    for (uint32_t i = 0; i < EVENT_COUNT; i++) {
+        while (!QueueReceive(&packet)) {
+            sched_yield();
+        }
+        *checksum += packet.data[2];
+    }
+    return NULL;
+}
+
+/* Ring ----------------------------------------------------------------------*/
+static MidiRing_t ring;
+static uint32_t ring_batch = BATCH_SIZE;
+
+static void *RingProducer(void *arg)
+{
+    (void)arg;
+    uint32_t events[BATCH_SIZE];
+    for (uint32_t i = 0; i < EVENT_COUNT; ) {
+        uint32_t n = (EVENT_COUNT - i < ring_batch) ? EVENT_COUNT - i : ring_batch;
+        for (uint32_t j = 0; j < n; j++) {
+            events[j] = 0x003C9009u | ((uint32_t)((i + j) & 0x7F) << 24);
+        }
+        uint32_t pushed = 0;
+        while (pushed < n) {
+            uint32_t p = MIDI_Ring_Push(&ring, &events[pushed], n - pushed);
+            if (p == 0) {
+                sched_yield();
+            }
+            pushed += p;
+        }
+        i += n;
+    }
+    return NULL;
+}
+
+static void *RingConsumer(void *arg)
+{
+    uint64_t *checksum = arg;
+    uint32_t events[BATCH_SIZE];
+    for (uint32_t i = 0; i < EVENT_COUNT; ) {
+        uint32_t n = MIDI_Ring_Pop(&ring, events, ring_batch);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            *checksum += events[j] >> 24;
+        }
+        i += n;
+    }
+    return NULL;
+}
+
+/* Runner --------------------------------------------------------------------*/
+static double Run(void *(*producer)(void *), void *(*consumer)(void *), uint64_t *checksum)
+{
+    pthread_t p, c;
+    struct timespec start, end;
+
+    *checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&c, NULL, consumer, checksum);
+    pthread_create(&p, NULL, producer, NULL);
+    pthread_join(p, NULL);
+    pthread_join(c, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return EVENT_COUNT / seconds;
+}
+
+int main(void)
+{
+    uint64_t queue_sum, ring1_sum, ring_sum;
+
+    double queue_rate = Run(QueueProducer, QueueConsumer, &queue_sum);
+
+    MIDI_Ring_Init(&ring);
+    ring_batch = 1;
+    double ring1_rate = Run(RingProducer, RingConsumer, &ring1_sum);
+
+    MIDI_Ring_Init(&ring);
+    ring_batch = BATCH_SIZE;
+    double ring_rate = Run(RingProducer, RingConsumer, &ring_sum);
+
+    printf("MIDI event passing benchmark (%u events, producer/consumer threads)\n", EVENT_COUNT);
+    printf("  locked queue, 1 packet/op : %12.0f events/s\n", queue_rate);
+    printf("  SPSC ring, 1 event/op     : %12.0f events/s (%.2fx)\n", ring1_rate, ring1_rate / queue_rate);
+    printf("  SPSC ring, %2u events/op   : %12.0f events/s (%.2fx)\n", BATCH_SIZE, ring_rate, ring_rate / queue_rate);
+
+    if (queue_sum != ring1_sum || queue_sum != ring_sum) {
+        printf("  checksum mismatch\n");
+        return 1;
+    }
+    return 0;
+}
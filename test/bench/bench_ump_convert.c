@@ -0,0 +1,356 @@
+/**
+  * @file           : bench_ump_convert.c
+  * @brief          : Host benchmark: two-stage vs single-pass MIDI 1.0 to MIDI 2.0 conversion
+  *
+  * The two-stage model reproduces the structure of the AM MIDI 2.0 Library
+  * path used by vMidi2UartToUmpTask: every byte of a parsed event goes through
+  * an out-of-line call on an opaque handle into a byte stream to MIDI 1.0
+  * Protocol UMP converter, and every resulting word through a second handle
+  * that rescales the values bit by bit. The single-pass converter works on the
+  * parsed event directly. Both must produce the same words; the benchmark
+  * checks that before timing them.
+  */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "midi_common.h"
+#include "midi_parser.h"
+#include "midi_ump_converter.h"
+
+#define STREAM_SIZE   (16 * 1024)
+#define ITERATIONS    200
+#define MAX_EVENTS    (STREAM_SIZE)
+#define MAX_WORDS     (STREAM_SIZE * 2)
+
+/* Two-stage model -----------------------------------------------------------*/
+typedef struct {
+    uint32_t out[4];
+    uint8_t out_read, out_write;
+    uint8_t running, data[2], index, expected;
+    uint8_t sysex[6], sysex_count;
+    bool in_sysex, sysex_started;
+} BsToUmp_t;
+
+typedef struct {
+    uint32_t out[8];
+    uint8_t out_read, out_write;
+    uint8_t mt3_words, mt3_index;
+    uint32_t mt3[2];
+    uint8_t bank_msb[16], bank_lsb[16];
+} UmpToMidi2_t;
+
+typedef void *handle_t;
+
+static uint32_t ScaleUp(uint32_t value, uint8_t source_bits, uint8_t dest_bits)
+{
+    uint8_t scale_bits = dest_bits - source_bits;
+    uint32_t result = value << scale_bits;
+    if (value <= (1U << (source_bits - 1))) {
+        return result;
+    }
+    uint8_t repeat_bits = source_bits - 1;
+    uint32_t repeat = value & ((1U << repeat_bits) - 1U);
+    repeat = (scale_bits > repeat_bits) ? repeat << (scale_bits - repeat_bits) : repeat >> (repeat_bits - scale_bits);
+    while (repeat != 0) {
+        result |= repeat;
+        repeat >>= repeat_bits;
+    }
+    return result;
+}
+
+static void BsPush(BsToUmp_t *c, uint32_t word) { c->out[c->out_write++ & 3] = word; }
+
+static void BsSysExPacket(BsToUmp_t *c, uint8_t status)
+{
+    uint8_t b[6] = {0};
+    memcpy(b, c->sysex, c->sysex_count);
+    BsPush(c, 0x30000000U | ((uint32_t)status << 20) | ((uint32_t)c->sysex_count << 16) | ((uint32_t)b[0] << 8) | b[1]);
+    BsPush(c, ((uint32_t)b[2] << 24) | ((uint32_t)b[3] << 16) | ((uint32_t)b[4] << 8) | b[5]);
+    c->sysex_count = 0;
+}
+
+__attribute__((noinline)) static void bs_to_ump_process_byte(handle_t h, uint8_t byte)
+{
+    BsToUmp_t *c = (BsToUmp_t *)h;
+    if (byte == 0xF0) {
+        c->in_sysex = true; c->sysex_started = false; c->sysex_count = 0; c->running = 0;
+        return;
+    }
+    if (byte == 0xF7) {
+        if (c->in_sysex) {
+            c->in_sysex = false;
+            BsSysExPacket(c, c->sysex_started ? 3 : 0);
+        }
+        return;
+    }
+    if (byte & 0x80) {
+        if (byte >= 0xF0) {
+            c->running = 0;
+            uint8_t length = MIDI_GetExpectedLength(byte);
+            if (length <= 1) {
+                BsPush(c, 0x10000000U | ((uint32_t)byte << 16));
+                return;
+            }
+        }
+        c->running = byte; c->index = 0;
+        c->expected = MIDI_GetExpectedLength(byte) - 1;
+        return;
+    }
+    if (c->in_sysex) {
+        if (c->sysex_count == 6) {
+            BsSysExPacket(c, c->sysex_started ? 2 : 1);
+            c->sysex_started = true;
+        }
+        c->sysex[c->sysex_count++] = byte;
+        return;
+    }
+    if (c->running == 0) {
+        return;
+    }
+    c->data[c->index++] = byte;
+    if (c->index == c->expected) {
+        uint32_t mt = (c->running >= 0xF0) ? 0x10000000U : 0x20000000U;
+        BsPush(c, mt | ((uint32_t)c->running << 16) | ((uint32_t)c->data[0] << 8) | ((c->expected > 1) ? c->data[1] : 0));
+        c->index = 0;
+        if (c->running >= 0xF0) {
+            c->running = 0;
+        }
+    }
+}
+
+__attribute__((noinline)) static bool bs_to_ump_available(handle_t h)
+{
+    BsToUmp_t *c = (BsToUmp_t *)h;
+    return c->out_read != c->out_write;
+}
+
+__attribute__((noinline)) static uint32_t bs_to_ump_read(handle_t h)
+{
+    BsToUmp_t *c = (BsToUmp_t *)h;
+    return c->out[c->out_read++ & 3];
+}
+
+static void M2Push(UmpToMidi2_t *c, uint32_t word) { c->out[c->out_write++ & 7] = word; }
+
+__attribute__((noinline)) static void ump_to_midi2_process(handle_t h, uint32_t word)
+{
+    UmpToMidi2_t *c = (UmpToMidi2_t *)h;
+    if (c->mt3_words != 0) {
+        M2Push(c, c->mt3[0]);
+        M2Push(c, word);
+        c->mt3_words = 0;
+        return;
+    }
+    uint8_t mt = word >> 28;
+    if (mt == 0x3) {
+        c->mt3[0] = word;
+        c->mt3_words = 1;
+        return;
+    }
+    if (mt != 0x2) {
+        M2Push(c, word);
+        return;
+    }
+    uint8_t status = (word >> 16) & 0xF0;
+    uint8_t channel = (word >> 16) & 0x0F;
+    uint8_t v1 = (word >> 8) & 0x7F;
+    uint8_t v2 = word & 0x7F;
+    uint32_t header = 0x40000000U | (word & 0x0F000000U) | ((uint32_t)channel << 16);
+    switch (status) {
+        case 0x90:
+            if (v2 == 0) {
+                M2Push(c, header | (0x80U << 16) | ((uint32_t)v1 << 8));
+                M2Push(c, 0x8000U << 16);
+                break;
+            }
+            M2Push(c, header | (0x90U << 16) | ((uint32_t)v1 << 8));
+            M2Push(c, ScaleUp(v2, 7, 16) << 16);
+            break;
+        case 0x80:
+            M2Push(c, header | (0x80U << 16) | ((uint32_t)v1 << 8));
+            M2Push(c, ScaleUp(v2, 7, 16) << 16);
+            break;
+        case 0xA0:
+        case 0xB0:
+            if (status == 0xB0 && v1 == 0) { c->bank_msb[channel] = v2; break; }
+            if (status == 0xB0 && v1 == 32) { c->bank_lsb[channel] = v2; break; }
+            M2Push(c, header | ((uint32_t)status << 16) | ((uint32_t)v1 << 8));
+            M2Push(c, ScaleUp(v2, 7, 32));
+            break;
+        case 0xC0: {
+            uint32_t w0 = header | (0xC0U << 16);
+            uint32_t w1 = (uint32_t)v1 << 24;
+            if (c->bank_msb[channel] != 0xFF) {
+                w0 |= 1;
+                w1 |= ((uint32_t)c->bank_msb[channel] << 8) | ((c->bank_lsb[channel] != 0xFF) ? c->bank_lsb[channel] : 0);
+            }
+            M2Push(c, w0);
+            M2Push(c, w1);
+            break;
+        }
+        case 0xD0:
+            M2Push(c, header | (0xD0U << 16));
+            M2Push(c, ScaleUp(v1, 7, 32));
+            break;
+        default:
+            M2Push(c, header | (0xE0U << 16));
+            M2Push(c, ScaleUp(((uint32_t)v2 << 7) | v1, 14, 32));
+            break;
+    }
+}
+
+__attribute__((noinline)) static bool ump_to_midi2_available(handle_t h)
+{
+    UmpToMidi2_t *c = (UmpToMidi2_t *)h;
+    return c->out_read != c->out_write;
+}
+
+__attribute__((noinline)) static uint32_t ump_to_midi2_read(handle_t h)
+{
+    UmpToMidi2_t *c = (UmpToMidi2_t *)h;
+    return c->out[c->out_read++ & 7];
+}
+
+/* Test stream ---------------------------------------------------------------*/
+static size_t BuildStream(uint8_t *stream, size_t size)
+{
+    size_t n = 0;
+    uint32_t seed = 4711;
+
+    while (n + 16 < size) {
+        seed = seed * 1103515245u + 12345u;
+        uint8_t ch = (seed >> 4) & 0x0F;
+        uint8_t v = (seed >> 8) & 0x7F;
+        switch ((seed >> 16) % 8) {
+            case 0:  // Note On / Note Off (velocity 0) with running status
+                stream[n++] = 0x90 | ch;
+                stream[n++] = 0x3C; stream[n++] = v;
+                stream[n++] = 0x3C; stream[n++] = 0x00;
+                break;
+            case 1:
+            case 2:  // Control Change
+                stream[n++] = 0xB0 | ch;
+                stream[n++] = 1 + (v & 0x3F); stream[n++] = v;
+                break;
+            case 3:  // Bank Select + Program Change
+                stream[n++] = 0xB0 | ch; stream[n++] = 0x00; stream[n++] = v;
+                stream[n++] = 0xC0 | ch; stream[n++] = v;
+                break;
+            case 4:  // Pitch Bend
+                stream[n++] = 0xE0 | ch; stream[n++] = v; stream[n++] = 0x7F - v;
+                break;
+            case 5:  // Pressure
+                stream[n++] = 0xD0 | ch; stream[n++] = v;
+                stream[n++] = 0xA0 | ch; stream[n++] = 0x40; stream[n++] = v;
+                break;
+            case 6:  // System Common
+                stream[n++] = 0xF2; stream[n++] = v; stream[n++] = 0x01;
+                break;
+            default:  // SysEx
+                stream[n++] = 0xF0;
+                for (uint8_t i = 0; i < (v & 0x0F); i++) {
+                    stream[n++] = i;
+                }
+                stream[n++] = 0xF7;
+                break;
+        }
+    }
+    return n;
+}
+
+static double NowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static size_t RunTwoStage(const uint32_t *events, size_t event_count, uint32_t *out)
+{
+    static BsToUmp_t bs;
+    static UmpToMidi2_t m2;
+    memset(&bs, 0, sizeof(bs));
+    memset(&m2, 0, sizeof(m2));
+    memset(m2.bank_msb, 0xFF, sizeof(m2.bank_msb));
+    memset(m2.bank_lsb, 0xFF, sizeof(m2.bank_lsb));
+    handle_t h1 = &bs;
+    handle_t h2 = &m2;
+    size_t words = 0;
+
+    for (size_t e = 0; e < event_count; e++) {
+        uint8_t length = MIDI_Parser_EventLength(events[e]);
+        for (uint8_t i = 0; i < length; i++) {
+            bs_to_ump_process_byte(h1, MIDI_EVENT_BYTE(events[e], i));
+        }
+        while (bs_to_ump_available(h1)) {
+            ump_to_midi2_process(h2, bs_to_ump_read(h1));
+            while (ump_to_midi2_available(h2)) {
+                out[words++] = ump_to_midi2_read(h2);
+            }
+        }
+    }
+    return words;
+}
+
+static size_t RunSinglePass(const uint32_t *events, size_t event_count, uint32_t *out)
+{
+    MidiUmpConverter_t converter;
+    MIDI_UmpConverter_Init(&converter, 0);
+    size_t words = 0;
+
+    for (size_t e = 0; e < event_count; e++) {
+        words += MIDI_UmpConverter_Process(&converter, events[e], &out[words]);
+    }
+    return words;
+}
+
+int main(void)
+{
+    static uint8_t stream[STREAM_SIZE];
+    static uint32_t events[MAX_EVENTS];
+    static uint32_t two_stage_out[MAX_WORDS];
+    static uint32_t single_out[MAX_WORDS];
+    size_t length = BuildStream(stream, sizeof(stream));
+
+    MidiParser_t parser;
+    size_t event_count;
+    MIDI_Parser_Init(&parser, 0);
+    MIDI_Parser_Process(&parser, stream, length, events, MAX_EVENTS, &event_count);
+
+    // Same output first
+    size_t two_stage_words = RunTwoStage(events, event_count, two_stage_out);
+    size_t single_words = RunSinglePass(events, event_count, single_out);
+    if (two_stage_words != single_words ||
+        memcmp(two_stage_out, single_out, single_words * sizeof(uint32_t)) != 0) {
+        printf("UMP converter benchmark: outputs differ (%zu vs %zu words)\n", two_stage_words, single_words);
+        return 1;
+    }
+
+    volatile size_t sink = 0;
+    double start = NowUs();
+    for (int it = 0; it < ITERATIONS; it++) {
+        sink += RunTwoStage(events, event_count, two_stage_out);
+    }
+    double two_stage_us = NowUs() - start;
+
+    start = NowUs();
+    for (int it = 0; it < ITERATIONS; it++) {
+        sink += RunSinglePass(events, event_count, single_out);
+    }
+    double single_us = NowUs() - start;
+    (void)sink;
+
+    double messages = (double)event_count * ITERATIONS;
+    printf("UMP converter benchmark (%zu events -> %zu words, identical output, x %d iterations)\n",
+           event_count, single_words, ITERATIONS);
+    printf("  two-stage   : %6.1f ns/event\n", two_stage_us * 1e3 / messages);
+    printf("  single-pass : %6.1f ns/event (%.1fx)\n", single_us * 1e3 / messages, two_stage_us / single_us);
+    return 0;
+}
@@ -45,11 +45,27 @@ typedef enum {
 void HAL_GPIO_WritePin(void* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
 GPIO_PinState HAL_GPIO_ReadPin(void* GPIOx, uint16_t GPIO_Pin);
 
+// HAL status for testing
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum {
+    HAL_UART_STATE_READY = 0x20,
+    HAL_UART_STATE_BUSY_TX = 0x21
+} HAL_UART_StateTypeDef;
+
 // UART handle typedef for testing
 typedef struct {
     void* Instance;
+    volatile HAL_UART_StateTypeDef gState;
 } UART_HandleTypeDef;
 
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+
 #ifdef __cplusplus
 }
 #endif
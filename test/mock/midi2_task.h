@@ -4,6 +4,16 @@
 #include "mock_freertos.h"
 
 // Mock definitions for midi2_task.h
-extern QueueHandle_t xUmpTxQueue;
+#include "ump_ring.h"
+extern UmpRing_t ump_tx_ring;
+extern UmpRing_t ump_tx_rt_ring;
+extern UmpRing_t ump_rx_rt_ring;
+
+typedef struct {
+  uint32_t ump[4];
+  TickType_t time;
+} UmpRxItem_t;
+
+void MIDI2_NotifyDinOut(void);
 
 #endif /* __MIDI2_TASK_H__ */
\ No newline at end of file
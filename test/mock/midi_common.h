@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "mock_freertos.h"
+#include "midi_ring.h"
 
 // DMA buffer size
 #define DMA_RX_BUFFER_SIZE 64
@@ -23,6 +24,14 @@ typedef struct {
     uint8_t length;   // Actual length of MIDI data (1-3 bytes)
 } MIDIPacket_t;
 
+// Resolution of the frame-relative arrival time histogram
+#define MIDI_FRAME_PHASE_BINS 8
+
+// DIN TX scheduler traffic classes (see midi_scheduler.h)
+#define MIDI_TX_CLASS_COUNT 4
+
+#define MIDI_CLOCK_PATH_COUNT 2
+
 // MIDI statistics structure
 typedef struct {
     uint32_t uart_rx_count;
@@ -34,8 +43,58 @@ typedef struct {
     uint32_t usb_errors;
     uint32_t dma_overruns;
     uint32_t queue_full_errors;
+    uint32_t usb_tx_retries;         // USB IN packets held back by a full TX FIFO / busy endpoint
+    uint32_t usb_sof_count;          // USB frames seen (SOF sync)
+    uint32_t din_rx_frame_phase[MIDI_FRAME_PHASE_BINS];  // DIN arrivals per 1/8 USB frame after SOF
+    uint32_t rt_in_latency_max_us;   // Worst DIN RX -> USB IN realtime latency
+    uint32_t rt_out_latency_max_us;  // Worst USB OUT (or release time) -> DIN TX realtime latency
+    uint32_t din_tx_status_saved;    // Status bytes left out by running status
+    uint32_t din_tx_drops[MIDI_TX_CLASS_COUNT];         // Messages dropped per DIN TX class
+    uint32_t din_tx_late[MIDI_TX_CLASS_COUNT];          // Messages sent after the latency bound
+    uint32_t din_tx_delay_max_us[MIDI_TX_CLASS_COUNT];  // Worst queueing delay per class
+    uint32_t din_tx_coalesced;       // Controller values replaced by a newer queued value
+    uint32_t din_tx_selectors_skipped;  // Bank / RPN / NRPN selector CCs the receiver already had
+    uint32_t din_tx_sched_late;      // Timestamped messages that arrived after their release time
+    uint32_t din_tx_dejitter_missed; // USB OUT transfers sent at once for lack of ring space (de-jitter)
+    uint32_t ump_cc_merged;          // MIDI 1.0 CCs folded into a MIDI 2.0 controller message
+    uint32_t clock_in_jitter_us[MIDI_CLOCK_PATH_COUNT];   // Mean Timing Clock input deviation per path
+    uint32_t clock_out_jitter_us[MIDI_CLOCK_PATH_COUNT];  // Mean recovered clock interval deviation per path
+    uint32_t evicted_uart_to_usb;    // Stale DIN IN events dropped on the way to USB
+    uint32_t evicted_usb_to_uart;    // Stale USB OUT events dropped on the way to DIN (MIDI 1.0 mode)
+    uint32_t evicted_ump_tx;         // Stale UMPs dropped on the way to USB
+    uint32_t evicted_ump_rx;         // Stale UMPs dropped on the way to DIN
 } MIDIStats_t;
 
+// DIN OUT encoding
+#define MIDI_DIN_RUNNING_STATUS 1
+#define MIDI_DIN_NOTE_OFF_AS_NOTE_ON 0
+
+// DIN OUT scheduling
+#define MIDI_DIN_TX_LATENCY_BOUND_US 10000
+#define MIDI_DIN_TX_REORDER_US 2000
+#define MIDI_DIN_TX_STARVATION_US 30000
+#define MIDI_DIN_TX_COALESCE 1
+#define MIDI_DIN_TX_TIMESTAMPS 1
+#define MIDI_DIN_TX_LOOKAHEAD_US 2000
+#define MIDI_DIN_TX_DEJITTER_US 0
+
+// DIN IN to MIDI 2.0 upconversion
+#define MIDI_UMP_CC_AGGREGATION 1
+#define MIDI_UMP_CC_HOLD_OFF_US 3000
+#define MIDI_UMP_FUSED_CONVERTER 1
+#define MIDI_UMP_JR_CLOCK_INTERVAL_MS 200
+
+// Timing Clock recovery
+#define MIDI_CLOCK_PLL 1
+#define MIDI_CLOCK_PLL_DELAY_US 2000
+#define MIDI_CLOCK_GENERATOR 1
+
+// Stale event eviction
+#define MIDI_UART_TO_USB_MAX_AGE_MS 100
+#define MIDI_USB_TO_UART_MAX_AGE_MS 100
+#define MIDI_UMP_TX_MAX_AGE_MS 100
+#define MIDI_UMP_RX_MAX_AGE_MS 100
+
 // MIDI Status Bytes - Channel Voice Messages
 #define MIDI_NOTE_OFF              0x80
 #define MIDI_NOTE_ON               0x90
@@ -86,12 +145,15 @@ typedef struct {
 #define USB_MIDI_CIN_CHAN_PRESSURE 0x0D
 #define USB_MIDI_CIN_PITCH_BEND    0x0E
 #define USB_MIDI_CIN_SINGLE_BYTE   0x0F
+#define USB_MIDI_CIN_1BYTE_DATA    0x0F
 #define USB_MIDI_CIN_2BYTE_SYSCOM  0x02
 #define USB_MIDI_CIN_3BYTE_SYSCOM  0x03
 
 extern MIDIStats_t midi_stats;
-extern QueueHandle_t xUartToUsbQueue;
-extern QueueHandle_t xUsbToUartQueue;
+extern MidiRing_t uart_to_usb_ring;
+extern MidiRing_t usb_to_uart_ring;
+extern MidiRing_t uart_to_usb_rt_ring;
+extern MidiRing_t usb_to_uart_rt_ring;
 extern SemaphoreHandle_t xLedMutex;
 extern uint8_t dma_rx_buffer[DMA_RX_BUFFER_SIZE];
 
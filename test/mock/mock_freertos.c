@@ -5,6 +5,7 @@
 
 static uint32_t mock_queue_created = 0;
 static uint32_t mock_mutex_created = 0;
+static uint32_t mock_notify_count = 0;
 
 QueueHandle_t xQueueCreate(uint32_t uxQueueLength, uint32_t uxItemSize)
 {
@@ -30,6 +31,14 @@ BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void* pvItemToQueue, Tic
     return pdPASS;
 }
 
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait)
+{
+    (void)xQueue;
+    (void)pvItemToQueue;
+    (void)xTicksToWait;
+    return pdPASS;
+}
+
 BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait)
 {
     (void)xQueue;
@@ -63,13 +72,67 @@ BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
     return pdPASS;
 }
 
+static TickType_t tick_count = 0;
+
 TickType_t xTaskGetTickCount(void)
 {
-    static TickType_t tick_count = 0;
     return tick_count++;
 }
 
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return tick_count++;
+}
+
+void MockFreeRTOS_SetTickCount(TickType_t ticks)
+{
+    tick_count = ticks;
+}
+
 void vTaskDelay(const TickType_t xTicksToDelay)
 {
     (void)xTicksToDelay;
-}
\ No newline at end of file
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)(uintptr_t)1;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    (void)xTaskToNotify;
+    mock_notify_count++;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)xTaskToNotify;
+    mock_notify_count++;
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    uint32_t count = mock_notify_count;
+    if (xClearCountOnExit) {
+        mock_notify_count = 0;
+    } else if (mock_notify_count > 0) {
+        mock_notify_count--;
+    }
+    return count;
+}
+
+uint32_t MockFreeRTOS_GetNotifyCount(void)
+{
+    return mock_notify_count;
+}
+
+void MockFreeRTOS_ResetNotifyCount(void)
+{
+    mock_notify_count = 0;
+}
@@ -11,8 +11,10 @@
 // Mock FreeRTOS types
 typedef void* QueueHandle_t;
 typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
 typedef uint32_t TickType_t;
 typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
 
 #define pdTRUE  1
 #define pdFALSE 0
@@ -27,6 +29,7 @@ typedef int32_t BaseType_t;
 QueueHandle_t xQueueCreate(uint32_t uxQueueLength, uint32_t uxItemSize);
 BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait);
 BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait);
 BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait);
 BaseType_t xQueueReset(QueueHandle_t xQueue);
 
@@ -37,10 +40,22 @@ BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
 
 // Mock task functions
 TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+void MockFreeRTOS_SetTickCount(TickType_t ticks);
 void vTaskDelay(const TickType_t xTicksToDelay);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+// Mock task notification functions
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+uint32_t MockFreeRTOS_GetNotifyCount(void);
+void MockFreeRTOS_ResetNotifyCount(void);
 
 // Mock critical section macros
 #define taskENTER_CRITICAL() do {} while(0)
 #define taskEXIT_CRITICAL() do {} while(0)
+#define taskENTER_CRITICAL_FROM_ISR() ((UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(x) ((void)(x))
 
 #endif /* __MOCK_FREERTOS_H__ */
\ No newline at end of file
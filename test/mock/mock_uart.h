@@ -0,0 +1,28 @@
+#ifndef __MOCK_UART_H__
+#define __MOCK_UART_H__
+
+#include <stdint.h>
+#include "main.h"
+
+#define MOCK_UART_CAPTURE_SIZE 2048
+#define MOCK_UART_MAX_TRANSFERS 64
+
+// UART handle used by the code under test
+extern UART_HandleTypeDef huart2;
+
+// Reset captured transfers and make HAL_UART_Transmit_DMA succeed
+void MockUART_Reset(void);
+
+// Make the next HAL_UART_Transmit_DMA calls fail with the given status
+void MockUART_SetTransmitStatus(HAL_StatusTypeDef status);
+
+// Finish the running transfer (as the TX complete interrupt would)
+void MockUART_CompleteTransfer(void);
+
+// Captured output
+uint32_t MockUART_GetTransferCount(void);
+uint16_t MockUART_GetTransferLength(uint32_t index);
+uint32_t MockUART_GetSentCount(void);
+const uint8_t* MockUART_GetSent(void);
+
+#endif /* __MOCK_UART_H__ */
@@ -88,6 +88,9 @@ void UMP_SendProductInstanceIdNotification(void);
 void UMP_SendStreamConfigNotification(uint8_t protocol, bool rx_jr, bool tx_jr);
 void UMP_SendFunctionBlockInfoNotification(uint8_t fb_id);
 void UMP_SendFunctionBlockNameNotification(uint8_t fb_id);
+void UMP_ResetProtocol(void);
+uint8_t UMP_GetProtocol(void);
+bool UMP_GetTxJitterReduction(void);
 
 // MIDI-CI functions
 muid_t MIDICI_GenerateMUID(void);
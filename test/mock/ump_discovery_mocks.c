@@ -4,8 +4,10 @@
 #include "ump_discovery.h"
 #include "app_ump_device.h"
 #include "mock_freertos.h"
+#include "ump_ring.h"
 
-// Mock global queue for UMP TX
-QueueHandle_t xUmpTxQueue = NULL;
+// Mock global rings for UMP TX
+UmpRing_t ump_tx_ring;
+UmpRing_t ump_tx_rt_ring;
 
 // Note: MIDICI_* functions are implemented in ump_discovery.c itself
\ No newline at end of file
@@ -13,15 +13,25 @@
 #define tud_ump_n_available(x) (0)
 #define tud_ump_read(itf, data, count) (0)
 
+#define UMP_TX_PACKET_WORDS 16
+#define UMP_RX_BULK_WORDS 64
+
+typedef void (*UmpDispatch_t)(uint32_t *ump_data, uint8_t word_count);
+
 // Mock pdMS_TO_TICKS
+#ifndef pdMS_TO_TICKS
 #define pdMS_TO_TICKS(x) (x)
+#endif
 
 // Function declarations
 void vUmpToUsbTask(void *pvParameters);
 void vUsbToUmpTask(void *pvParameters);
+void UMP_RxNotify(void);
+uint32_t UMP_FrameMessages(uint32_t *words, uint32_t count, UmpDispatch_t dispatch);
 
 #ifdef TESTING
 uint8_t GetUmpWordCount(uint32_t first_word);
+void DispatchUmp(uint32_t *ump_data, uint8_t word_count);
 #endif
 
 #endif /* __UMP_TASK_H__ */
\ No newline at end of file
@@ -1,7 +1,28 @@
 #include <stdint.h>
 #include "ump_task.h"
+#include "ump_ring.h"
 
 // Mock global variables
 MIDIStats_t midi_stats = {0};
-QueueHandle_t xUmpTxQueue = NULL;
-QueueHandle_t xUmpRxQueue = NULL;
\ No newline at end of file
+UmpRing_t ump_tx_ring;
+UmpRing_t ump_tx_rt_ring;
+UmpRing_t ump_rx_rt_ring;
+QueueHandle_t xUmpRxQueue = NULL;
+
+// Wakes the UMP to DIN task
+void MIDI2_NotifyDinOut(void)
+{
+}
+
+// Message handlers called by the dispatcher
+void UMP_ProcessStreamMessage(uint32_t *ump_data, uint8_t word_count)
+{
+    (void)ump_data;
+    (void)word_count;
+}
+
+void UMP_ProcessDataMessage(uint32_t *ump_data, uint8_t word_count)
+{
+    (void)ump_data;
+    (void)word_count;
+}
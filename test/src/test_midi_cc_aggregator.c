@@ -0,0 +1,294 @@
+#include "test_common.h"
+#include <string.h>
+
+// Include the header files
+#include "midi_cc_aggregator.h"
+
+#define HOLD_OFF_US 3000
+
+static MidiCcAggregator_t aggregator;
+static uint32_t ump[MIDI_CC_AGGREGATOR_MAX_WORDS];
+static bool pass;
+
+// Helper to run one Control Change through the aggregator
+static uint32_t ProcessCC(uint8_t channel, uint8_t controller, uint8_t value, uint32_t now)
+{
+    uint32_t event = 0x0B | ((uint32_t)(0xB0 | channel) << 8) |
+                     ((uint32_t)controller << 16) | ((uint32_t)value << 24);
+    return MIDI_CcAggregator_Process(&aggregator, event, now, 0, ump, &pass);
+}
+
+void setUp(void)
+{
+    MIDI_CcAggregator_Init(&aggregator, HOLD_OFF_US, 0);
+    memset(ump, 0, sizeof(ump));
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_CcAggregator_ScaleUp(void)
+{
+    TEST_ASSERT_EQUAL_HEX32(0x00000000, MIDI_CcAggregator_ScaleUp(0, 7));
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, MIDI_CcAggregator_ScaleUp(64, 7));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, MIDI_CcAggregator_ScaleUp(127, 7));
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, MIDI_CcAggregator_ScaleUp(0x2000, 14));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, MIDI_CcAggregator_ScaleUp(0x3FFF, 14));
+    TEST_ASSERT_EQUAL_HEX32(0x00040000, MIDI_CcAggregator_ScaleUp(1, 14));
+}
+
+void test_MIDI_CcAggregator_RpnTransactionIsOneUmp(void)
+{
+    // Pitch Bend Sensitivity 2 semitones 0 cents on channel 3
+    TEST_ASSERT_EQUAL(0, ProcessCC(3, 101, 0, 0));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_EQUAL(0, ProcessCC(3, 100, 0, 1000));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_EQUAL(0, ProcessCC(3, 6, 2, 2000));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_TRUE(MIDI_CcAggregator_IsHolding(&aggregator));
+
+    TEST_ASSERT_EQUAL(2, ProcessCC(3, 38, 0, 3000));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_EQUAL_HEX32(0x40230000, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(MIDI_CcAggregator_ScaleUp(2 << 7, 14), ump[1]);
+    TEST_ASSERT_FALSE(MIDI_CcAggregator_IsHolding(&aggregator));
+    TEST_ASSERT_EQUAL(3, aggregator.merged);
+}
+
+void test_MIDI_CcAggregator_NrpnUsesAssignableController(void)
+{
+    ProcessCC(0, 99, 0x12, 0);
+    ProcessCC(0, 98, 0x34, 0);
+    ProcessCC(0, 6, 0x7F, 0);
+    TEST_ASSERT_EQUAL(2, ProcessCC(0, 38, 0x7F, 500));
+    TEST_ASSERT_EQUAL_HEX32(0x40301234, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, ump[1]);
+}
+
+void test_MIDI_CcAggregator_DataMsbAloneAfterHoldOff(void)
+{
+    ProcessCC(0, 101, 0, 0);
+    ProcessCC(0, 100, 0, 0);
+    ProcessCC(0, 6, 12, 100);
+
+    TEST_ASSERT_EQUAL(0, MIDI_CcAggregator_Flush(&aggregator, 100 + HOLD_OFF_US - 1, ump, 6));
+    TEST_ASSERT_EQUAL(2, MIDI_CcAggregator_Flush(&aggregator, 100 + HOLD_OFF_US, ump, 6));
+    TEST_ASSERT_EQUAL_HEX32(0x40200000, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(MIDI_CcAggregator_ScaleUp(12 << 7, 14), ump[1]);
+    TEST_ASSERT_FALSE(MIDI_CcAggregator_IsHolding(&aggregator));
+
+    // A later LSB refines the value with the last MSB
+    TEST_ASSERT_EQUAL(2, ProcessCC(0, 38, 50, 10000));
+    TEST_ASSERT_EQUAL_HEX32(MIDI_CcAggregator_ScaleUp((12 << 7) | 50, 14), ump[1]);
+}
+
+void test_MIDI_CcAggregator_DataEntryWithoutParameterPasses(void)
+{
+    TEST_ASSERT_EQUAL(0, ProcessCC(0, 6, 10, 0));
+    TEST_ASSERT_TRUE(pass);
+
+    // Null parameter deselects
+    ProcessCC(0, 101, 0, 0);
+    ProcessCC(0, 100, 0, 0);
+    ProcessCC(0, 101, 127, 0);
+    ProcessCC(0, 100, 127, 0);
+    TEST_ASSERT_EQUAL(0, ProcessCC(0, 6, 10, 0));
+    TEST_ASSERT_TRUE(pass);
+    TEST_ASSERT_FALSE(MIDI_CcAggregator_IsHolding(&aggregator));
+}
+
+void test_MIDI_CcAggregator_SevenBitControllerIsNotDelayed(void)
+{
+    TEST_ASSERT_EQUAL(2, ProcessCC(1, 7, 100, 0));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_EQUAL_HEX32(0x40B10700, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(MIDI_CcAggregator_ScaleUp(100, 7), ump[1]);
+    TEST_ASSERT_FALSE(MIDI_CcAggregator_IsHolding(&aggregator));
+}
+
+void test_MIDI_CcAggregator_MsbLsbPairIsOneUmp(void)
+{
+    // The first pair teaches the aggregator that CC 1 has an LSB
+    ProcessCC(0, 1, 0x40, 0);
+    TEST_ASSERT_EQUAL(2, ProcessCC(0, 33, 0x01, 500));
+    TEST_ASSERT_EQUAL_HEX32(0x40B00100, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(MIDI_CcAggregator_ScaleUp((0x40 << 7) | 0x01, 14), ump[1]);
+
+    // From now on the MSB waits for its LSB
+    TEST_ASSERT_EQUAL(0, ProcessCC(0, 1, 0x41, 1000));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_TRUE(MIDI_CcAggregator_IsHolding(&aggregator));
+    TEST_ASSERT_EQUAL(2, ProcessCC(0, 33, 0x02, 1500));
+    TEST_ASSERT_EQUAL_HEX32(0x40B00100, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(MIDI_CcAggregator_ScaleUp((0x41 << 7) | 0x02, 14), ump[1]);
+    TEST_ASSERT_EQUAL(1, aggregator.merged);
+}
+
+void test_MIDI_CcAggregator_HeldMsbFlushedBeforeOtherMessages(void)
+{
+    ProcessCC(0, 1, 0x40, 0);
+    ProcessCC(0, 33, 0x00, 0);
+    ProcessCC(0, 1, 0x7F, 100);
+
+    // Another channel does not disturb the hold
+    uint32_t note_ch1 = 0x09 | (0x91 << 8) | (60 << 16) | (100U << 24);
+    TEST_ASSERT_EQUAL(0, MIDI_CcAggregator_Process(&aggregator, note_ch1, 200, 0, ump, &pass));
+    TEST_ASSERT_TRUE(pass);
+    TEST_ASSERT_TRUE(MIDI_CcAggregator_IsHolding(&aggregator));
+
+    // A note on the same channel sends the MSB alone first
+    uint32_t note_ch0 = 0x09 | (0x90 << 8) | (60 << 16) | (100U << 24);
+    TEST_ASSERT_EQUAL(2, MIDI_CcAggregator_Process(&aggregator, note_ch0, 300, 0, ump, &pass));
+    TEST_ASSERT_TRUE(pass);
+    TEST_ASSERT_EQUAL_HEX32(0x40B00100, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, ump[1]);
+    TEST_ASSERT_FALSE(MIDI_CcAggregator_IsHolding(&aggregator));
+}
+
+void test_MIDI_CcAggregator_FlushAllBeforeSystemMessages(void)
+{
+    // Held CC 1 MSB on channel 0 and Data Entry MSB on channel 5
+    ProcessCC(0, 1, 0x40, 0);
+    ProcessCC(0, 33, 0x00, 0);
+    ProcessCC(0, 1, 0x7F, 100);
+    ProcessCC(5, 101, 0, 100);
+    ProcessCC(5, 100, 0, 100);
+    ProcessCC(5, 6, 2, 200);
+    TEST_ASSERT_TRUE(MIDI_CcAggregator_IsHolding(&aggregator));
+
+    // Both go out, long before their hold-off time, with a small buffer too
+    TEST_ASSERT_EQUAL(2, MIDI_CcAggregator_FlushAll(&aggregator, ump, 2));
+    TEST_ASSERT_EQUAL_HEX32(0x40B00100, ump[0]);
+    TEST_ASSERT_EQUAL(2, MIDI_CcAggregator_FlushAll(&aggregator, ump, 2));
+    TEST_ASSERT_EQUAL_HEX32(0x40250000, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(MIDI_CcAggregator_ScaleUp(2 << 7, 14), ump[1]);
+    TEST_ASSERT_EQUAL(0, MIDI_CcAggregator_FlushAll(&aggregator, ump, 2));
+    TEST_ASSERT_FALSE(MIDI_CcAggregator_IsHolding(&aggregator));
+}
+
+void test_MIDI_CcAggregator_HeldValueKeepsItsStamp(void)
+{
+    const uint32_t stamp_msb = 0x00200010;  // JR Timestamp UMPs
+    const uint32_t stamp_note = 0x00200020;
+    const uint32_t note = 0x09 | (0x90 << 8) | (60 << 16) | (100 << 24);
+
+    ProcessCC(0, 1, 0x40, 0);
+    ProcessCC(0, 33, 0x00, 0);
+
+    // The held MSB goes out with its own stamp ahead of the note
+    uint32_t event = 0x0B | (0xB0 << 8) | (1 << 16) | (0x7F << 24);
+    TEST_ASSERT_EQUAL(0, MIDI_CcAggregator_Process(&aggregator, event, 100, stamp_msb, ump, &pass));
+    TEST_ASSERT_EQUAL(3, MIDI_CcAggregator_Process(&aggregator, note, 200, stamp_note, ump, &pass));
+    TEST_ASSERT_TRUE(pass);
+    TEST_ASSERT_EQUAL_HEX32(stamp_msb, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x40B00100, ump[1]);
+
+    // Also when sent after its hold-off time
+    TEST_ASSERT_EQUAL(0, MIDI_CcAggregator_Process(&aggregator, event, 300, stamp_msb, ump, &pass));
+    TEST_ASSERT_EQUAL(0, MIDI_CcAggregator_Flush(&aggregator, 300 + HOLD_OFF_US, ump, 2));
+    TEST_ASSERT_EQUAL(3, MIDI_CcAggregator_Flush(&aggregator, 300 + HOLD_OFF_US, ump, 3));
+    TEST_ASSERT_EQUAL_HEX32(stamp_msb, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x40B00100, ump[1]);
+}
+
+void test_MIDI_CcAggregator_NewParameterFlushesHeldValue(void)
+{
+    ProcessCC(0, 101, 0, 0);
+    ProcessCC(0, 100, 1, 0);
+    ProcessCC(0, 6, 64, 0);
+
+    // Selecting another parameter sends the held Fine Tuning value first
+    TEST_ASSERT_EQUAL(2, ProcessCC(0, 100, 2, 100));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_EQUAL_HEX32(0x40200001, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, ump[1]);
+}
+
+void test_MIDI_CcAggregator_DataIncrementIsRelative(void)
+{
+    // Without a parameter the increment is converted as it is
+    TEST_ASSERT_EQUAL(0, ProcessCC(2, 96, 0, 0));
+    TEST_ASSERT_TRUE(pass);
+
+    // RPN 0/1 (Fine Tuning): one step up, one step down
+    ProcessCC(2, 101, 0, 0);
+    ProcessCC(2, 100, 1, 0);
+    TEST_ASSERT_EQUAL(2, ProcessCC(2, 96, 0, 100));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_EQUAL_HEX32(0x40420001, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x00040000, ump[1]);
+    TEST_ASSERT_EQUAL(2, ProcessCC(2, 97, 0, 200));
+    TEST_ASSERT_FALSE(pass);
+    TEST_ASSERT_EQUAL_HEX32(0x40420001, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFC0000, ump[1]);
+
+    // NRPN 1/2: a held Data Entry value goes before the increment
+    ProcessCC(2, 99, 1, 300);
+    ProcessCC(2, 98, 2, 300);
+    ProcessCC(2, 6, 64, 400);
+    TEST_ASSERT_EQUAL(4, ProcessCC(2, 96, 0, 500));
+    TEST_ASSERT_EQUAL_HEX32(0x40320102, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, ump[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x40520102, ump[2]);
+    TEST_ASSERT_EQUAL_HEX32(0x00040000, ump[3]);
+}
+
+void test_MIDI_CcAggregator_OtherControllersPass(void)
+{
+    TEST_ASSERT_EQUAL(0, ProcessCC(0, 0, 1, 0));     // Bank Select
+    TEST_ASSERT_TRUE(pass);
+    TEST_ASSERT_EQUAL(0, ProcessCC(0, 64, 127, 0));  // Sustain
+    TEST_ASSERT_TRUE(pass);
+    TEST_ASSERT_EQUAL(0, ProcessCC(0, 40, 5, 0));    // LSB without an MSB
+    TEST_ASSERT_TRUE(pass);
+
+    uint32_t sysex = 0x07 | (0xF0 << 8) | (0x7E << 16) | (0xF7U << 24);
+    TEST_ASSERT_EQUAL(0, MIDI_CcAggregator_Process(&aggregator, sysex, 0, 0, ump, &pass));
+    TEST_ASSERT_TRUE(pass);
+}
+
+void test_MIDI_CcAggregator_RpnSweepUmpCount(void)
+{
+    // 64 Data Entry MSB / LSB updates after one RPN selection: one UMP each
+    // instead of one per CC
+    uint32_t umps = 0;
+    uint32_t ccs = 2;
+    uint32_t now = 0;
+    umps += ProcessCC(0, 101, 0, now) / 2;
+    umps += ProcessCC(0, 100, 0, now) / 2;
+    for (uint32_t i = 0; i < 64; i++) {
+        now += 1000;
+        umps += ProcessCC(0, 6, (uint8_t)i, now) / 2;
+        now += 1000;
+        umps += ProcessCC(0, 38, (uint8_t)(127 - i), now) / 2;
+        ccs += 2;
+    }
+
+    TEST_ASSERT_EQUAL(64, umps);
+    TEST_ASSERT_EQUAL(ccs - umps, aggregator.merged);
+    printf("RPN sweep: %u CCs -> %u UMPs\n", (unsigned)ccs, (unsigned)umps);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_CcAggregator_ScaleUp);
+    RUN_TEST(test_MIDI_CcAggregator_RpnTransactionIsOneUmp);
+    RUN_TEST(test_MIDI_CcAggregator_NrpnUsesAssignableController);
+    RUN_TEST(test_MIDI_CcAggregator_DataMsbAloneAfterHoldOff);
+    RUN_TEST(test_MIDI_CcAggregator_DataEntryWithoutParameterPasses);
+    RUN_TEST(test_MIDI_CcAggregator_SevenBitControllerIsNotDelayed);
+    RUN_TEST(test_MIDI_CcAggregator_MsbLsbPairIsOneUmp);
+    RUN_TEST(test_MIDI_CcAggregator_HeldMsbFlushedBeforeOtherMessages);
+    RUN_TEST(test_MIDI_CcAggregator_FlushAllBeforeSystemMessages);
+    RUN_TEST(test_MIDI_CcAggregator_HeldValueKeepsItsStamp);
+    RUN_TEST(test_MIDI_CcAggregator_NewParameterFlushesHeldValue);
+    RUN_TEST(test_MIDI_CcAggregator_DataIncrementIsRelative);
+    RUN_TEST(test_MIDI_CcAggregator_OtherControllersPass);
+    RUN_TEST(test_MIDI_CcAggregator_RpnSweepUmpCount);
+
+    return UNITY_END();
+}
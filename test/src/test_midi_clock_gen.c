@@ -0,0 +1,157 @@
+#include "test_common.h"
+
+// Include the header file
+#include "midi_clock_gen.h"
+
+#define TEMPO_120 50000000U   // 500 ms per quarter (10 ns units)
+#define TEMPO_140 42857143U   // 428.571430 ms per quarter
+
+static MidiClockGen_t gen;
+
+// Take the next message at its time
+static uint32_t PopNext(uint8_t *status)
+{
+    uint32_t time = 0;
+    TEST_ASSERT_TRUE(MIDI_ClockGen_NextTime(&gen, &time));
+    TEST_ASSERT_TRUE(MIDI_ClockGen_Pop(&gen, time, status));
+    return time;
+}
+
+static uint32_t PopClock(void)
+{
+    uint8_t status;
+    uint32_t time = PopNext(&status);
+    TEST_ASSERT_EQUAL_HEX8(0xF8, status);
+    return time;
+}
+
+void setUp(void)
+{
+    MIDI_ClockGen_Init(&gen);
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_ClockGen_InactiveWithoutTempo(void)
+{
+    uint32_t time;
+    uint8_t status;
+    TEST_ASSERT_FALSE(MIDI_ClockGen_IsActive(&gen));
+    TEST_ASSERT_FALSE(MIDI_ClockGen_NextTime(&gen, &time));
+    TEST_ASSERT_FALSE(MIDI_ClockGen_Pop(&gen, 1000, &status));
+
+    // Out of range tempos are ignored
+    TEST_ASSERT_FALSE(MIDI_ClockGen_SetTempo(&gen, 0, 1000));
+    TEST_ASSERT_FALSE(MIDI_ClockGen_SetTempo(&gen, MIDI_CLOCK_GEN_MAX_TEMPO + 1, 1000));
+    TEST_ASSERT_FALSE(MIDI_ClockGen_IsActive(&gen));
+}
+
+void test_MIDI_ClockGen_ClocksAtTempo(void)
+{
+    TEST_ASSERT_TRUE(MIDI_ClockGen_SetTempo(&gen, TEMPO_120, 1000));
+    TEST_ASSERT_TRUE(MIDI_ClockGen_IsActive(&gen));
+
+    TEST_ASSERT_EQUAL_UINT32(1000, PopClock());
+    TEST_ASSERT_EQUAL_UINT32(1000 + 20833, PopClock());
+    TEST_ASSERT_EQUAL_UINT32(1000 + 41667, PopClock());
+
+    // Not due before its time
+    uint8_t status;
+    TEST_ASSERT_FALSE(MIDI_ClockGen_Pop(&gen, 1000 + 62499, &status));
+    TEST_ASSERT_TRUE(MIDI_ClockGen_Pop(&gen, 1000 + 62500, &status));
+}
+
+void test_MIDI_ClockGen_NoDriftOverManyBeats(void)
+{
+    MIDI_ClockGen_SetTempo(&gen, TEMPO_140, 0);
+
+    // 1000 beats of 428571.43 us
+    uint32_t time = 0;
+    for (uint32_t i = 0; i <= 1000 * MIDI_CLOCK_GEN_PPQN; i++) {
+        time = PopClock();
+    }
+    TEST_ASSERT_EQUAL_UINT32(428571430, time);
+}
+
+void test_MIDI_ClockGen_TempoChangesAtBeat(void)
+{
+    MIDI_ClockGen_SetTempo(&gen, TEMPO_120, 0);
+    for (uint32_t i = 0; i < 12; i++) {
+        PopClock();
+    }
+
+    // Half way through the beat: the rest of it keeps 120 BPM
+    MIDI_ClockGen_SetTempo(&gen, TEMPO_120 / 2, 250000);
+    uint32_t time = 0;
+    for (uint32_t i = 12; i < MIDI_CLOCK_GEN_PPQN; i++) {
+        time = PopClock();
+    }
+    TEST_ASSERT_EQUAL_UINT32(479167, time);
+    TEST_ASSERT_EQUAL_UINT32(500000, PopClock());
+    TEST_ASSERT_EQUAL_UINT32(500000 + 10417, PopClock());
+}
+
+void test_MIDI_ClockGen_StartRestartsBeat(void)
+{
+    uint8_t status;
+    MIDI_ClockGen_SetTempo(&gen, TEMPO_120, 0);
+    PopClock();
+    PopClock();
+
+    MIDI_ClockGen_Transport(&gen, 0xFA, 30000);
+    TEST_ASSERT_EQUAL_UINT32(30000, PopNext(&status));
+    TEST_ASSERT_EQUAL_HEX8(0xFA, status);
+    TEST_ASSERT_EQUAL_UINT32(30000, PopClock());
+    TEST_ASSERT_EQUAL_UINT32(30000 + 20833, PopClock());
+}
+
+void test_MIDI_ClockGen_StopKeepsClock(void)
+{
+    uint8_t status;
+    MIDI_ClockGen_SetTempo(&gen, TEMPO_120, 0);
+    PopClock();
+
+    MIDI_ClockGen_Transport(&gen, 0xFC, 5000);
+    TEST_ASSERT_EQUAL_UINT32(5000, PopNext(&status));
+    TEST_ASSERT_EQUAL_HEX8(0xFC, status);
+    TEST_ASSERT_EQUAL_UINT32(20833, PopClock());
+}
+
+void test_MIDI_ClockGen_HostClockAfterStopReleases(void)
+{
+    uint8_t status;
+    MIDI_ClockGen_SetTempo(&gen, TEMPO_120, 0);
+    PopClock();
+
+    // Host clock is dropped while running
+    MIDI_ClockGen_Transport(&gen, 0xFA, 1000);
+    TEST_ASSERT_TRUE(MIDI_ClockGen_HostClock(&gen));
+
+    // Stop not sent yet: still the master
+    MIDI_ClockGen_Transport(&gen, 0xFC, 5000);
+    TEST_ASSERT_TRUE(MIDI_ClockGen_HostClock(&gen));
+    PopNext(&status);
+    TEST_ASSERT_EQUAL_HEX8(0xFC, status);
+
+    // After Stop the host takes the clock back
+    TEST_ASSERT_FALSE(MIDI_ClockGen_HostClock(&gen));
+    TEST_ASSERT_FALSE(MIDI_ClockGen_IsActive(&gen));
+    TEST_ASSERT_FALSE(MIDI_ClockGen_HostClock(&gen));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_ClockGen_InactiveWithoutTempo);
+    RUN_TEST(test_MIDI_ClockGen_ClocksAtTempo);
+    RUN_TEST(test_MIDI_ClockGen_NoDriftOverManyBeats);
+    RUN_TEST(test_MIDI_ClockGen_TempoChangesAtBeat);
+    RUN_TEST(test_MIDI_ClockGen_StartRestartsBeat);
+    RUN_TEST(test_MIDI_ClockGen_StopKeepsClock);
+    RUN_TEST(test_MIDI_ClockGen_HostClockAfterStopReleases);
+
+    return UNITY_END();
+}
@@ -0,0 +1,149 @@
+#include "test_common.h"
+#include <stdlib.h>
+
+// Include the header file
+#include "midi_clock_pll.h"
+
+#define DELAY_US  2000U
+#define PERIOD_US 20833U  // 24 PPQN at 120 BPM
+
+static MidiClockPll_t pll;
+
+// Take the next message at its output time
+static uint32_t PopNext(uint8_t *status)
+{
+    uint32_t time = 0;
+    TEST_ASSERT_TRUE(MIDI_ClockPll_NextTime(&pll, &time));
+    TEST_ASSERT_TRUE(MIDI_ClockPll_Pop(&pll, time, status));
+    return time;
+}
+
+// Feed a clock and return its output time
+static uint32_t Clock(uint32_t time)
+{
+    uint8_t status;
+    TEST_ASSERT_TRUE(MIDI_ClockPll_Input(&pll, 0xF8, time));
+    uint32_t out = PopNext(&status);
+    TEST_ASSERT_EQUAL_HEX8(0xF8, status);
+    return out;
+}
+
+void setUp(void)
+{
+    MIDI_ClockPll_Init(&pll, DELAY_US);
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_ClockPll_LocksOnSecondClock(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(1000 + DELAY_US, Clock(1000));
+    TEST_ASSERT_FALSE(pll.locked);
+    TEST_ASSERT_EQUAL_UINT32(1000 + PERIOD_US + DELAY_US, Clock(1000 + PERIOD_US));
+    TEST_ASSERT_TRUE(pll.locked);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US, pll.period_us);
+}
+
+void test_MIDI_ClockPll_NotDueBeforeOutputTime(void)
+{
+    uint8_t status;
+    MIDI_ClockPll_Input(&pll, 0xF8, 1000);
+    TEST_ASSERT_FALSE(MIDI_ClockPll_Pop(&pll, 1000 + DELAY_US - 1, &status));
+    TEST_ASSERT_TRUE(MIDI_ClockPll_Pop(&pll, 1000 + DELAY_US, &status));
+    TEST_ASSERT_FALSE(MIDI_ClockPll_Pop(&pll, 1000 + DELAY_US, &status));
+}
+
+void test_MIDI_ClockPll_SmoothsFrameBunching(void)
+{
+    // Clocks quantized to 1 ms USB frames: up to 1 ms input jitter
+    uint32_t previous = 0;
+    int32_t worst = 0;
+    for (uint32_t i = 0; i < 200; i++) {
+        uint32_t ideal = 100000 + i * PERIOD_US;
+        uint32_t arrival = ideal - ideal % 1000 + 1000;
+        uint32_t out = Clock(arrival);
+        if (i >= 50) {
+            int32_t deviation = abs((int32_t)(out - previous) - (int32_t)PERIOD_US);
+            if (deviation > worst) {
+                worst = deviation;
+            }
+        }
+        previous = out;
+    }
+
+    // The output interval stays well inside the input jitter
+    TEST_ASSERT_TRUE(worst < 400);
+    TEST_ASSERT_UINT32_WITHIN(100, PERIOD_US, pll.period_us);
+    TEST_ASSERT_TRUE(pll.out_jitter_q4 < pll.in_jitter_q4);
+}
+
+void test_MIDI_ClockPll_StartKeepsOrderAndRealigns(void)
+{
+    uint8_t status;
+    Clock(1000);
+    Clock(1000 + PERIOD_US);
+
+    // A clock, then Start 5 ms later, then the first clock after Start
+    MIDI_ClockPll_Input(&pll, 0xF8, 1000 + 2 * PERIOD_US);
+    MIDI_ClockPll_Input(&pll, 0xFA, 1000 + 2 * PERIOD_US + 5000);
+    MIDI_ClockPll_Input(&pll, 0xF8, 1000 + 2 * PERIOD_US + 6000);
+
+    PopNext(&status);
+    TEST_ASSERT_EQUAL_HEX8(0xF8, status);
+    PopNext(&status);
+    TEST_ASSERT_EQUAL_HEX8(0xFA, status);
+    uint32_t out = PopNext(&status);
+    TEST_ASSERT_EQUAL_HEX8(0xF8, status);
+
+    // Phase follows the new clock, tempo is kept
+    TEST_ASSERT_EQUAL_UINT32(1000 + 2 * PERIOD_US + 6000 + DELAY_US, out);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US, pll.period_us);
+    TEST_ASSERT_TRUE(pll.locked);
+}
+
+void test_MIDI_ClockPll_TempoJumpRelocks(void)
+{
+    Clock(1000);
+    Clock(1000 + PERIOD_US);
+    Clock(1000 + 2 * PERIOD_US);
+
+    // Twice as fast
+    uint32_t t = 1000 + 2 * PERIOD_US + PERIOD_US / 2;
+    TEST_ASSERT_EQUAL_UINT32(t + DELAY_US, Clock(t));
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US / 2, pll.period_us);
+}
+
+void test_MIDI_ClockPll_GapUnlocks(void)
+{
+    Clock(1000);
+    Clock(1000 + PERIOD_US);
+
+    uint32_t t = 1000 + PERIOD_US + MIDI_CLOCK_PLL_MAX_PERIOD_US + 1;
+    TEST_ASSERT_EQUAL_UINT32(t + DELAY_US, Clock(t));
+    TEST_ASSERT_FALSE(pll.locked);
+}
+
+void test_MIDI_ClockPll_FullRefuses(void)
+{
+    for (uint32_t i = 0; i < MIDI_CLOCK_PLL_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(MIDI_ClockPll_Input(&pll, 0xF8, 1000 + i * PERIOD_US));
+    }
+    TEST_ASSERT_FALSE(MIDI_ClockPll_Input(&pll, 0xFC, 1000 + 16 * PERIOD_US));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_ClockPll_LocksOnSecondClock);
+    RUN_TEST(test_MIDI_ClockPll_NotDueBeforeOutputTime);
+    RUN_TEST(test_MIDI_ClockPll_SmoothsFrameBunching);
+    RUN_TEST(test_MIDI_ClockPll_StartKeepsOrderAndRealigns);
+    RUN_TEST(test_MIDI_ClockPll_TempoJumpRelocks);
+    RUN_TEST(test_MIDI_ClockPll_GapUnlocks);
+    RUN_TEST(test_MIDI_ClockPll_FullRefuses);
+
+    return UNITY_END();
+}
@@ -6,8 +6,8 @@
 #include "midi_common.h"
 
 // Declare external variables for testing
-extern QueueHandle_t xUartToUsbQueue;
-extern QueueHandle_t xUsbToUartQueue;
+extern MidiRing_t uart_to_usb_ring;
+extern MidiRing_t usb_to_uart_ring;
 extern MIDIStats_t midi_stats;
 
 void setUp(void)
@@ -0,0 +1,271 @@
+#include "test_common.h"
+#include <string.h>
+
+// Include the header file
+#include "midi_parser.h"
+
+static MidiParser_t parser;
+static uint32_t events[64];
+static size_t event_count;
+
+// Helper to build an expected USB-MIDI event word
+static uint32_t Event(uint8_t cable, uint8_t cin, uint8_t b0, uint8_t b1, uint8_t b2)
+{
+    return ((uint32_t)cable << 4) | cin | ((uint32_t)b0 << 8) | ((uint32_t)b1 << 16) | ((uint32_t)b2 << 24);
+}
+
+// Helper to parse a whole byte sequence
+static void Parse(const uint8_t *data, size_t length)
+{
+    size_t consumed = MIDI_Parser_Process(&parser, data, length, events, 64, &event_count);
+    TEST_ASSERT_EQUAL(length, consumed);
+}
+
+void setUp(void)
+{
+    MIDI_Parser_Init(&parser, 0);
+    memset(events, 0, sizeof(events));
+    event_count = 0;
+}
+
+void tearDown(void)
+{
+}
+
+// Table tests
+void test_MIDI_Parser_Table_ChannelVoice(void)
+{
+    TEST_ASSERT_EQUAL_HEX8(MIDI_PARSER_KIND_CHANNEL, midi_parser_table[0x90] & MIDI_PARSER_KIND_MASK);
+    TEST_ASSERT_EQUAL_HEX8(0x9, midi_parser_table[0x9F] & MIDI_PARSER_CIN_MASK);
+    TEST_ASSERT_EQUAL_HEX8(2 << MIDI_PARSER_LENGTH_SHIFT, midi_parser_table[0xC5] & MIDI_PARSER_LENGTH_MASK);
+    TEST_ASSERT_EQUAL_HEX8(3 << MIDI_PARSER_LENGTH_SHIFT, midi_parser_table[0xE0] & MIDI_PARSER_LENGTH_MASK);
+    TEST_ASSERT_EQUAL_HEX8(MIDI_PARSER_KIND_DATA, midi_parser_table[0x7F] & MIDI_PARSER_KIND_MASK);
+    TEST_ASSERT_EQUAL_HEX8(MIDI_PARSER_KIND_REALTIME, midi_parser_table[0xF8] & MIDI_PARSER_KIND_MASK);
+}
+
+// Channel message tests
+void test_MIDI_Parser_NoteOn(void)
+{
+    const uint8_t data[] = {0x90, 0x3C, 0x64};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(1, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x9, 0x90, 0x3C, 0x64), events[0]);
+    TEST_ASSERT_EQUAL(3, MIDI_Parser_EventLength(events[0]));
+}
+
+void test_MIDI_Parser_RunningStatus(void)
+{
+    const uint8_t data[] = {0x91, 0x3C, 0x64, 0x3E, 0x50, 0x40, 0x00};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(3, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x9, 0x91, 0x3C, 0x64), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x9, 0x91, 0x3E, 0x50), events[1]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x9, 0x91, 0x40, 0x00), events[2]);
+}
+
+void test_MIDI_Parser_TwoByteMessages(void)
+{
+    const uint8_t data[] = {0xC2, 0x05, 0x06, 0xD3, 0x7F};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(3, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0xC, 0xC2, 0x05, 0x00), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0xC, 0xC2, 0x06, 0x00), events[1]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0xD, 0xD3, 0x7F, 0x00), events[2]);
+    TEST_ASSERT_EQUAL(2, MIDI_Parser_EventLength(events[2]));
+}
+
+void test_MIDI_Parser_MessageSplitAcrossSpans(void)
+{
+    const uint8_t first[] = {0xB0, 0x07};
+    const uint8_t second[] = {0x64};
+    Parse(first, sizeof(first));
+    TEST_ASSERT_EQUAL(0, event_count);
+    Parse(second, sizeof(second));
+    TEST_ASSERT_EQUAL(1, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0xB, 0xB0, 0x07, 0x64), events[0]);
+}
+
+void test_MIDI_Parser_StrayDataIgnored(void)
+{
+    const uint8_t data[] = {0x10, 0x20, 0x80, 0x3C, 0x00};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(1, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x8, 0x80, 0x3C, 0x00), events[0]);
+}
+
+void test_MIDI_Parser_CableNumber(void)
+{
+    const uint8_t data[] = {0x90, 0x3C, 0x64};
+    MIDI_Parser_Init(&parser, 3);
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL_HEX32(Event(3, 0x9, 0x90, 0x3C, 0x64), events[0]);
+}
+
+// System message tests
+void test_MIDI_Parser_RealtimeInsideMessage(void)
+{
+    const uint8_t data[] = {0x90, 0x3C, 0xF8, 0x64};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(2, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0xF, 0xF8, 0x00, 0x00), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x9, 0x90, 0x3C, 0x64), events[1]);
+}
+
+void test_MIDI_Parser_SystemCommon(void)
+{
+    const uint8_t data[] = {0xF2, 0x10, 0x20, 0xF3, 0x05, 0xF1, 0x31, 0xF6};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(4, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x3, 0xF2, 0x10, 0x20), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x2, 0xF3, 0x05, 0x00), events[1]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x2, 0xF1, 0x31, 0x00), events[2]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x5, 0xF6, 0x00, 0x00), events[3]);
+}
+
+void test_MIDI_Parser_SystemCommonClearsRunningStatus(void)
+{
+    const uint8_t data[] = {0x90, 0x3C, 0x64, 0xF6, 0x3E, 0x50};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(2, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x5, 0xF6, 0x00, 0x00), events[1]);
+}
+
+// SysEx tests
+void test_MIDI_Parser_SysExStreamed(void)
+{
+    const uint8_t data[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(2, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x4, 0xF0, 0x7E, 0x7F), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x7, 0x06, 0x01, 0xF7), events[1]);
+}
+
+void test_MIDI_Parser_SysExEndLengths(void)
+{
+    const uint8_t one[] = {0xF0, 0x01, 0x02, 0xF7};
+    const uint8_t two[] = {0xF0, 0xF7};
+    const uint8_t three[] = {0xF0, 0x01, 0xF7};
+
+    Parse(one, sizeof(one));
+    TEST_ASSERT_EQUAL(2, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x5, 0xF7, 0x00, 0x00), events[1]);
+    TEST_ASSERT_EQUAL(1, MIDI_Parser_EventLength(events[1]));
+
+    Parse(two, sizeof(two));
+    TEST_ASSERT_EQUAL(1, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x6, 0xF0, 0xF7, 0x00), events[0]);
+
+    Parse(three, sizeof(three));
+    TEST_ASSERT_EQUAL(1, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x7, 0xF0, 0x01, 0xF7), events[0]);
+}
+
+void test_MIDI_Parser_SysExWithRealtime(void)
+{
+    const uint8_t data[] = {0xF0, 0x01, 0xF8, 0x02, 0xF7};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(3, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0xF, 0xF8, 0x00, 0x00), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x4, 0xF0, 0x01, 0x02), events[1]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x5, 0xF7, 0x00, 0x00), events[2]);
+    TEST_ASSERT_EQUAL(0, parser.errors);
+}
+
+void test_MIDI_Parser_SysExAbortedByStatus(void)
+{
+    const uint8_t data[] = {0xF0, 0x01, 0x90, 0x3C, 0x64};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(2, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x7, 0xF0, 0x01, 0xF7), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x9, 0x90, 0x3C, 0x64), events[1]);
+    TEST_ASSERT_EQUAL(1, parser.errors);
+}
+
+void test_MIDI_Parser_SysExAbortedByTuneRequest(void)
+{
+    const uint8_t data[] = {0xF0, 0x01, 0x02, 0xF6};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(3, event_count);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x5, 0xF7, 0x00, 0x00), events[1]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0, 0x5, 0xF6, 0x00, 0x00), events[2]);
+    TEST_ASSERT_EQUAL(1, parser.errors);
+}
+
+void test_MIDI_Parser_StopsWhenOutputFull(void)
+{
+    const uint8_t data[] = {0xF8, 0xF8, 0xF8, 0xF8};
+    size_t consumed = MIDI_Parser_Process(&parser, data, sizeof(data), events, 3, &event_count);
+    TEST_ASSERT_EQUAL(2, consumed);
+    TEST_ASSERT_EQUAL(2, event_count);
+}
+
+void test_MIDI_Parser_Reset(void)
+{
+    const uint8_t first[] = {0x90, 0x3C};
+    const uint8_t second[] = {0x64, 0x3E, 0x50};
+    Parse(first, sizeof(first));
+    MIDI_Parser_Reset(&parser);
+    Parse(second, sizeof(second));
+    TEST_ASSERT_EQUAL(0, event_count);
+}
+
+void test_MIDI_Event_IsRealtime(void)
+{
+    const uint8_t data[] = {0xF0, 0x01, 0xF8, 0x02, 0xF7, 0x90, 0x3C, 0xFA, 0x64, 0xF6};
+    Parse(data, sizeof(data));
+    TEST_ASSERT_EQUAL(6, event_count);
+    TEST_ASSERT_TRUE(MIDI_EVENT_IS_REALTIME(events[0]));   // F8 inside SysEx
+    TEST_ASSERT_FALSE(MIDI_EVENT_IS_REALTIME(events[1]));  // SysEx chunk
+    TEST_ASSERT_FALSE(MIDI_EVENT_IS_REALTIME(events[2]));  // SysEx end (CIN 0x5)
+    TEST_ASSERT_TRUE(MIDI_EVENT_IS_REALTIME(events[3]));   // FA inside Note On
+    TEST_ASSERT_FALSE(MIDI_EVENT_IS_REALTIME(events[4]));  // Note On
+    TEST_ASSERT_FALSE(MIDI_EVENT_IS_REALTIME(events[5]));  // Tune Request (CIN 0x5)
+
+    // Realtime received from USB with the single-byte CIN
+    TEST_ASSERT_TRUE(MIDI_EVENT_IS_REALTIME(Event(0, 0x5, 0xFC, 0x00, 0x00)));
+}
+
+void test_MIDI_Event_ReleaseMarker(void)
+{
+    uint32_t marker = MIDI_EVENT_RELEASE(0x12345678, 5);
+
+    // Never mistaken for MIDI data, and carries the low 16 bits of the time
+    TEST_ASSERT_TRUE(MIDI_EVENT_IS_TIMESTAMP(marker));
+    TEST_ASSERT_EQUAL_UINT8(0, MIDI_Parser_EventLength(marker));
+    TEST_ASSERT_EQUAL_HEX16(0x5678, MIDI_EVENT_RELEASE_TIME(marker));
+    TEST_ASSERT_EQUAL_UINT8(5, MIDI_EVENT_RELEASE_COUNT(marker));
+    TEST_ASSERT_FALSE(MIDI_EVENT_IS_TIMESTAMP(Event(0, 0x9, 0x90, 0x3C, 0x64)));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_Parser_Table_ChannelVoice);
+
+    // Channel message tests
+    RUN_TEST(test_MIDI_Parser_NoteOn);
+    RUN_TEST(test_MIDI_Parser_RunningStatus);
+    RUN_TEST(test_MIDI_Parser_TwoByteMessages);
+    RUN_TEST(test_MIDI_Parser_MessageSplitAcrossSpans);
+    RUN_TEST(test_MIDI_Parser_StrayDataIgnored);
+    RUN_TEST(test_MIDI_Parser_CableNumber);
+
+    // System message tests
+    RUN_TEST(test_MIDI_Parser_RealtimeInsideMessage);
+    RUN_TEST(test_MIDI_Parser_SystemCommon);
+    RUN_TEST(test_MIDI_Parser_SystemCommonClearsRunningStatus);
+
+    // SysEx tests
+    RUN_TEST(test_MIDI_Parser_SysExStreamed);
+    RUN_TEST(test_MIDI_Parser_SysExEndLengths);
+    RUN_TEST(test_MIDI_Parser_SysExWithRealtime);
+    RUN_TEST(test_MIDI_Parser_SysExAbortedByStatus);
+    RUN_TEST(test_MIDI_Parser_SysExAbortedByTuneRequest);
+    RUN_TEST(test_MIDI_Parser_StopsWhenOutputFull);
+    RUN_TEST(test_MIDI_Parser_Reset);
+    RUN_TEST(test_MIDI_Event_IsRealtime);
+    RUN_TEST(test_MIDI_Event_ReleaseMarker);
+
+    return UNITY_END();
+}
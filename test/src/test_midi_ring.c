@@ -0,0 +1,222 @@
+#include "test_common.h"
+#include "mock_freertos.h"
+#include <string.h>
+
+// Include the header file
+#include "midi_ring.h"
+
+static MidiRing_t ring;
+
+void setUp(void)
+{
+    MIDI_Ring_Init(&ring);
+    MockFreeRTOS_ResetNotifyCount();
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_Ring_InitEmpty(void)
+{
+    uint32_t event;
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_Count(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_Pop(&ring, &event, 1));
+}
+
+void test_MIDI_Ring_PushPopOrder(void)
+{
+    const uint32_t in[] = {0x643C9009, 0x00409008, 0x0000F80F};
+    uint32_t out[4] = {0};
+
+    TEST_ASSERT_EQUAL_UINT32(3, MIDI_Ring_Push(&ring, in, 3));
+    TEST_ASSERT_EQUAL_UINT32(3, MIDI_Ring_Count(&ring));
+    TEST_ASSERT_EQUAL_UINT32(3, MIDI_Ring_Pop(&ring, out, 4));
+    TEST_ASSERT_EQUAL_HEX32(in[0], out[0]);
+    TEST_ASSERT_EQUAL_HEX32(in[1], out[1]);
+    TEST_ASSERT_EQUAL_HEX32(in[2], out[2]);
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_Count(&ring));
+}
+
+void test_MIDI_Ring_PartialPop(void)
+{
+    const uint32_t in[] = {1, 2, 3, 4, 5};
+    uint32_t out[2];
+
+    MIDI_Ring_Push(&ring, in, 5);
+    TEST_ASSERT_EQUAL_UINT32(2, MIDI_Ring_Pop(&ring, out, 2));
+    TEST_ASSERT_EQUAL_UINT32(1, out[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, out[1]);
+    TEST_ASSERT_EQUAL_UINT32(3, MIDI_Ring_Count(&ring));
+}
+
+void test_MIDI_Ring_FullRejectsExtra(void)
+{
+    uint32_t in[MIDI_RING_SIZE + 4];
+    for (uint32_t i = 0; i < MIDI_RING_SIZE + 4; i++) {
+        in[i] = i;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(MIDI_RING_SIZE, MIDI_Ring_Push(&ring, in, MIDI_RING_SIZE + 4));
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_Push(&ring, in, 1));
+    TEST_ASSERT_EQUAL_UINT32(MIDI_RING_SIZE, MIDI_Ring_Count(&ring));
+}
+
+void test_MIDI_Ring_WrapAround(void)
+{
+    uint32_t in[MIDI_RING_SIZE];
+    uint32_t out[MIDI_RING_SIZE];
+
+    // Move the indices close to the end of the buffer, then cross it
+    for (uint32_t i = 0; i < MIDI_RING_SIZE - 2; i++) {
+        in[i] = i;
+    }
+    MIDI_Ring_Push(&ring, in, MIDI_RING_SIZE - 2);
+    MIDI_Ring_Pop(&ring, out, MIDI_RING_SIZE - 2);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        in[i] = 0x1000 + i;
+    }
+    TEST_ASSERT_EQUAL_UINT32(8, MIDI_Ring_Push(&ring, in, 8));
+    TEST_ASSERT_EQUAL_UINT32(8, MIDI_Ring_Pop(&ring, out, MIDI_RING_SIZE));
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_HEX32(0x1000 + i, out[i]);
+    }
+}
+
+void test_MIDI_Ring_NotifiesConsumer(void)
+{
+    const uint32_t in[] = {1, 2};
+
+    // No consumer registered: no notification
+    MIDI_Ring_Push(&ring, in, 2);
+    TEST_ASSERT_EQUAL_UINT32(0, MockFreeRTOS_GetNotifyCount());
+
+    // One notification per batch, none for an empty push
+    MIDI_Ring_SetConsumer(&ring, xTaskGetCurrentTaskHandle());
+    MIDI_Ring_Push(&ring, in, 2);
+    TEST_ASSERT_EQUAL_UINT32(1, MockFreeRTOS_GetNotifyCount());
+    MIDI_Ring_Push(&ring, in, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, MockFreeRTOS_GetNotifyCount());
+}
+
+void test_MIDI_Ring_PushWaitTimesOut(void)
+{
+    uint32_t in[MIDI_RING_SIZE];
+    memset(in, 0, sizeof(in));
+
+    MIDI_Ring_Push(&ring, in, MIDI_RING_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_PushWait(&ring, in, 1, 3));
+}
+
+void test_MIDI_Ring_PopFreshEvictsStale(void)
+{
+    // CC, Note Off, Timing Clock, Note On, Active Sensing
+    const uint32_t in[] = {0x7F07B00B, 0x00409008, 0x0000F80F, 0x643C9009, 0x0000FE0F};
+    uint32_t out[8] = {0};
+    uint32_t evicted = 0;
+
+    MockFreeRTOS_SetTickCount(1000);
+    MIDI_Ring_Push(&ring, in, 5);
+
+    // Still fresh: everything comes out
+    MockFreeRTOS_SetTickCount(1100);
+    TEST_ASSERT_EQUAL_UINT32(2, MIDI_Ring_PopFresh(&ring, out, 2, 100, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(0, evicted);
+
+    // Stale: the clock and Active Sensing go, notes stay
+    MockFreeRTOS_SetTickCount(1200);
+    TEST_ASSERT_EQUAL_UINT32(1, MIDI_Ring_PopFresh(&ring, out, 8, 100, &evicted));
+    TEST_ASSERT_EQUAL_HEX32(in[3], out[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, evicted);
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_Count(&ring));
+}
+
+void test_MIDI_Ring_PopFreshKeepsMarkersAndSelectors(void)
+{
+    // Capture time + CC 7, capture time + Note On, release marker,
+    // Sustain, Bank Select MSB, Reset All Controllers
+    const uint32_t in[] = {0x12340000, 0x7F07B00B, 0x56780000, 0x643C9009,
+                           0x9ABC0200, 0x7F40B00B, 0x0000B00B, 0x0079B00B};
+    uint32_t out[8] = {0};
+    uint32_t evicted = 0;
+
+    MockFreeRTOS_SetTickCount(1000);
+    MIDI_Ring_Push(&ring, in, 8);
+
+    // The stale CC takes its capture time along; everything else stays
+    MockFreeRTOS_SetTickCount(1200);
+    TEST_ASSERT_EQUAL_UINT32(6, MIDI_Ring_PopFresh(&ring, out, 8, 100, &evicted));
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(&in[2], out, 6);
+    TEST_ASSERT_EQUAL_UINT32(1, evicted);
+}
+
+void test_MIDI_Ring_PopFreshCaptureTimeWaitsForEvent(void)
+{
+    const uint32_t note_off = 0x00409008;
+    const uint32_t marker = 0x12340000;
+    uint32_t out[2] = {0};
+    uint32_t evicted = 0;
+
+    // A capture time is not popped without its event, nor split from it
+    MIDI_Ring_Push(&ring, &note_off, 1);
+    MIDI_Ring_Push(&ring, &marker, 1);
+    TEST_ASSERT_EQUAL_UINT32(1, MIDI_Ring_PopFresh(&ring, out, 2, 100, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_PopFresh(&ring, out, 2, 100, &evicted));
+
+    MIDI_Ring_Push(&ring, &note_off, 1);
+    TEST_ASSERT_EQUAL_UINT32(2, MIDI_Ring_PopFresh(&ring, out, 2, 100, &evicted));
+    TEST_ASSERT_EQUAL_HEX32(marker, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(note_off, out[1]);
+}
+
+void test_MIDI_Ring_PopFreshCaptureTimeNeedsTwoSlots(void)
+{
+    const uint32_t note_off = 0x00409008;
+    const uint32_t marker = 0x12340000;
+    uint32_t out[2] = {0};
+    uint32_t evicted = 0;
+
+    // With room for one event only, the marker stays with its event
+    MIDI_Ring_Push(&ring, &marker, 1);
+    MIDI_Ring_Push(&ring, &note_off, 1);
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Ring_PopFresh(&ring, out, 1, 100, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(2, MIDI_Ring_Count(&ring));
+
+    TEST_ASSERT_EQUAL_UINT32(2, MIDI_Ring_PopFresh(&ring, out, 2, 100, &evicted));
+    TEST_ASSERT_EQUAL_HEX32(marker, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(note_off, out[1]);
+}
+
+void test_MIDI_Ring_PopFreshNoLimit(void)
+{
+    const uint32_t cc = 0x7F07B00B;
+    uint32_t out;
+    uint32_t evicted = 0;
+
+    MockFreeRTOS_SetTickCount(0);
+    MIDI_Ring_Push(&ring, &cc, 1);
+    MockFreeRTOS_SetTickCount(100000);
+    TEST_ASSERT_EQUAL_UINT32(1, MIDI_Ring_PopFresh(&ring, &out, 1, 0, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(0, evicted);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_Ring_InitEmpty);
+    RUN_TEST(test_MIDI_Ring_PushPopOrder);
+    RUN_TEST(test_MIDI_Ring_PartialPop);
+    RUN_TEST(test_MIDI_Ring_FullRejectsExtra);
+    RUN_TEST(test_MIDI_Ring_WrapAround);
+    RUN_TEST(test_MIDI_Ring_NotifiesConsumer);
+    RUN_TEST(test_MIDI_Ring_PushWaitTimesOut);
+    RUN_TEST(test_MIDI_Ring_PopFreshEvictsStale);
+    RUN_TEST(test_MIDI_Ring_PopFreshKeepsMarkersAndSelectors);
+    RUN_TEST(test_MIDI_Ring_PopFreshCaptureTimeWaitsForEvent);
+    RUN_TEST(test_MIDI_Ring_PopFreshCaptureTimeNeedsTwoSlots);
+    RUN_TEST(test_MIDI_Ring_PopFreshNoLimit);
+
+    return UNITY_END();
+}
@@ -0,0 +1,212 @@
+#include "test_common.h"
+#include <stdio.h>
+#include <string.h>
+
+// Include the header files
+#include "midi_running_status.h"
+#include "midi_parser.h"
+
+static MidiRunningStatus_t encoder;
+static uint8_t out[1024];
+
+// Recorded USB -> DIN traffic: a played phrase with controller sweeps
+static uint8_t recorded[1024];
+static size_t recorded_length;
+
+static void Record(const uint8_t *bytes, size_t length)
+{
+    memcpy(&recorded[recorded_length], bytes, length);
+    recorded_length += length;
+}
+
+static void BuildRecording(void)
+{
+    recorded_length = 0;
+
+    // Mod wheel sweep on channel 1 with clock interleaved
+    for (uint8_t value = 0; value < 128; value += 4) {
+        const uint8_t cc[] = {0xB0, 0x01, value};
+        Record(cc, sizeof(cc));
+        if ((value & 0x0F) == 0) {
+            const uint8_t clock = 0xF8;
+            Record(&clock, 1);
+        }
+    }
+
+    // Chord on channel 1, then released
+    static const uint8_t chord[] = {0x3C, 0x40, 0x43, 0x48};
+    for (size_t i = 0; i < sizeof(chord); i++) {
+        const uint8_t on[] = {0x90, chord[i], 0x64};
+        Record(on, sizeof(on));
+    }
+    for (size_t i = 0; i < sizeof(chord); i++) {
+        const uint8_t off[] = {0x80, chord[i], 0x40};
+        Record(off, sizeof(off));
+    }
+
+    // Pitch bend sweep on channel 2, interrupted by a SysEx
+    for (uint8_t msb = 0x30; msb < 0x50; msb += 2) {
+        const uint8_t bend[] = {0xE1, 0x00, msb};
+        Record(bend, sizeof(bend));
+        if (msb == 0x40) {
+            const uint8_t sysex[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7};
+            Record(sysex, sizeof(sysex));
+        }
+    }
+
+    // Drum pattern on channel 10 using Note Off
+    for (int step = 0; step < 8; step++) {
+        const uint8_t note = (step & 1) ? 0x2A : 0x24;
+        const uint8_t on[] = {0x99, note, 0x70};
+        const uint8_t off[] = {0x89, note, 0x00};
+        Record(on, sizeof(on));
+        Record(off, sizeof(off));
+    }
+}
+
+// Parse a byte stream into event words
+static size_t ParseStream(const uint8_t *data, size_t length, uint32_t *events, size_t max_events)
+{
+    MidiParser_t parser;
+    size_t count = 0;
+
+    MIDI_Parser_Init(&parser, 0);
+    MIDI_Parser_Process(&parser, data, length, events, max_events, &count);
+    return count;
+}
+
+void setUp(void)
+{
+    MIDI_RunningStatus_Init(&encoder, false);
+    BuildRecording();
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_RunningStatus_OmitsRepeatedStatus(void)
+{
+    const uint8_t input[] = {0xB0, 0x07, 0x10, 0xB0, 0x07, 0x20, 0xB1, 0x07, 0x30};
+    const uint8_t expected[] = {0xB0, 0x07, 0x10, 0x07, 0x20, 0xB1, 0x07, 0x30};
+
+    size_t count = MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out);
+
+    TEST_ASSERT_EQUAL(sizeof(expected), count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, count);
+}
+
+void test_MIDI_RunningStatus_TwoByteMessages(void)
+{
+    const uint8_t input[] = {0xD0, 0x10, 0xD0, 0x20, 0xD0, 0x30};
+    const uint8_t expected[] = {0xD0, 0x10, 0x20, 0x30};
+
+    size_t count = MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out);
+
+    TEST_ASSERT_EQUAL(sizeof(expected), count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, count);
+}
+
+void test_MIDI_RunningStatus_RealtimeKeepsStatus(void)
+{
+    const uint8_t input[] = {0x90, 0x3C, 0x64, 0xF8, 0x90, 0x3E, 0x64, 0xFE, 0x90, 0x40, 0x64};
+    const uint8_t expected[] = {0x90, 0x3C, 0x64, 0xF8, 0x3E, 0x64, 0xFE, 0x40, 0x64};
+
+    size_t count = MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out);
+
+    TEST_ASSERT_EQUAL(sizeof(expected), count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, count);
+}
+
+void test_MIDI_RunningStatus_SystemCommonClearsStatus(void)
+{
+    const uint8_t input[] = {0x90, 0x3C, 0x64, 0xF3, 0x01, 0x90, 0x3E, 0x64,
+                             0xF0, 0x7D, 0xF7, 0x90, 0x40, 0x64};
+
+    size_t count = MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out);
+
+    TEST_ASSERT_EQUAL(sizeof(input), count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(input, out, count);
+}
+
+void test_MIDI_RunningStatus_ResetResendsStatus(void)
+{
+    const uint8_t input[] = {0xB0, 0x07, 0x10};
+
+    MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out);
+    TEST_ASSERT_EQUAL(2, MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out));
+
+    MIDI_RunningStatus_Reset(&encoder);
+    TEST_ASSERT_EQUAL(3, MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out));
+}
+
+void test_MIDI_RunningStatus_NoteOffAsNoteOn(void)
+{
+    const uint8_t input[] = {0x90, 0x3C, 0x64, 0x80, 0x3C, 0x40, 0x90, 0x3E, 0x64, 0x80, 0x3E, 0x40};
+    const uint8_t expected[] = {0x90, 0x3C, 0x64, 0x3C, 0x00, 0x3E, 0x64, 0x3E, 0x00};
+
+    MIDI_RunningStatus_Init(&encoder, true);
+    size_t count = MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out);
+
+    TEST_ASSERT_EQUAL(sizeof(expected), count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, count);
+}
+
+void test_MIDI_RunningStatus_NoteOffKeptByDefault(void)
+{
+    const uint8_t input[] = {0x90, 0x3C, 0x64, 0x80, 0x3C, 0x40};
+
+    size_t count = MIDI_RunningStatus_Encode(&encoder, input, sizeof(input), out);
+
+    TEST_ASSERT_EQUAL(sizeof(input), count);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(input, out, count);
+}
+
+void test_MIDI_RunningStatus_RecordedTrafficDecodesIdentically(void)
+{
+    static uint32_t expected[512];
+    static uint32_t decoded[512];
+
+    size_t count = MIDI_RunningStatus_Encode(&encoder, recorded, recorded_length, out);
+    size_t expected_count = ParseStream(recorded, recorded_length, expected, 512);
+    size_t decoded_count = ParseStream(out, count, decoded, 512);
+
+    TEST_ASSERT_EQUAL(expected_count, decoded_count);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(expected, decoded, expected_count);
+}
+
+void test_MIDI_RunningStatus_RecordedTrafficSavings(void)
+{
+    size_t plain = MIDI_RunningStatus_Encode(&encoder, recorded, recorded_length, out);
+
+    MIDI_RunningStatus_Init(&encoder, true);
+    size_t note_on = MIDI_RunningStatus_Encode(&encoder, recorded, recorded_length, out);
+
+    printf("Recorded traffic: %zu bytes\n", recorded_length);
+    printf("  running status:             %zu bytes (%.1f%% saved, %.2f ms at 31250 baud)\n",
+           plain, 100.0 * (recorded_length - plain) / recorded_length,
+           (recorded_length - plain) * 0.32);
+    printf("  running status + NoteOn v0: %zu bytes (%.1f%% saved, %.2f ms at 31250 baud)\n",
+           note_on, 100.0 * (recorded_length - note_on) / recorded_length,
+           (recorded_length - note_on) * 0.32);
+
+    TEST_ASSERT_TRUE(plain < recorded_length * 4 / 5);
+    TEST_ASSERT_TRUE(note_on < plain);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_RunningStatus_OmitsRepeatedStatus);
+    RUN_TEST(test_MIDI_RunningStatus_TwoByteMessages);
+    RUN_TEST(test_MIDI_RunningStatus_RealtimeKeepsStatus);
+    RUN_TEST(test_MIDI_RunningStatus_SystemCommonClearsStatus);
+    RUN_TEST(test_MIDI_RunningStatus_ResetResendsStatus);
+    RUN_TEST(test_MIDI_RunningStatus_NoteOffAsNoteOn);
+    RUN_TEST(test_MIDI_RunningStatus_NoteOffKeptByDefault);
+    RUN_TEST(test_MIDI_RunningStatus_RecordedTrafficDecodesIdentically);
+    RUN_TEST(test_MIDI_RunningStatus_RecordedTrafficSavings);
+
+    return UNITY_END();
+}
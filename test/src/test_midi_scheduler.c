@@ -0,0 +1,358 @@
+#include "test_common.h"
+#include "mock_freertos.h"
+#include <string.h>
+
+// Include the header files
+#include "midi_scheduler.h"
+#include "midi_common.h"
+
+static MidiScheduler_t scheduler;
+
+// Helper to build a USB-MIDI event word on cable 0
+static uint32_t Event(uint8_t cin, uint8_t b0, uint8_t b1, uint8_t b2)
+{
+    return cin | ((uint32_t)b0 << 8) | ((uint32_t)b1 << 16) | ((uint32_t)b2 << 24);
+}
+
+#define NOTE_ON(n)   Event(0x9, 0x90, (n), 0x64)
+#define NOTE_OFF(n)  Event(0x8, 0x80, (n), 0x40)
+#define CC(c, v)     Event(0xB, 0xB0, (c), (v))
+#define CLOCK        Event(0xF, 0xF8, 0x00, 0x00)
+
+static uint32_t PopAt(uint32_t now)
+{
+    uint32_t event = 0;
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Pop(&scheduler, now, &event));
+    return event;
+}
+
+void setUp(void)
+{
+    MIDI_Scheduler_Init(&scheduler, false);
+    memset(&midi_stats, 0, sizeof(midi_stats));
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_Scheduler_Classify(void)
+{
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_REALTIME, MIDI_Scheduler_Classify(CLOCK));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_NOTE, MIDI_Scheduler_Classify(NOTE_ON(0x3C)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_NOTE, MIDI_Scheduler_Classify(NOTE_OFF(0x3C)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_VOICE, MIDI_Scheduler_Classify(CC(1, 0)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_VOICE, MIDI_Scheduler_Classify(Event(0xC, 0xC0, 0x05, 0)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_VOICE, MIDI_Scheduler_Classify(Event(0x2, 0xF1, 0x10, 0)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_VOICE, MIDI_Scheduler_Classify(Event(0x5, 0xF6, 0, 0)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_SYSEX, MIDI_Scheduler_Classify(Event(0x4, 0xF0, 0x7E, 0x7F)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_SYSEX, MIDI_Scheduler_Classify(Event(0x5, 0xF7, 0, 0)));
+    TEST_ASSERT_EQUAL(MIDI_TX_CLASS_SYSEX, MIDI_Scheduler_Classify(Event(0x7, 0x01, 0x02, 0xF7)));
+}
+
+void test_MIDI_Scheduler_ArrivalOrderWhileBacklogShort(void)
+{
+    MIDI_Scheduler_Push(&scheduler, Event(0xC, 0xC0, 0x05, 0), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 0, 0);
+
+    // A Note On must not overtake the Program Change it depends on
+    TEST_ASSERT_EQUAL_HEX32(Event(0xC, 0xC0, 0x05, 0), PopAt(100));
+    TEST_ASSERT_EQUAL_HEX32(NOTE_ON(0x3C), PopAt(100));
+    TEST_ASSERT_EQUAL_UINT32(0, MIDI_Scheduler_QueuedBytes(&scheduler));
+}
+
+void test_MIDI_Scheduler_RealtimeFirst(void)
+{
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CLOCK, 10, 0);
+
+    TEST_ASSERT_EQUAL_HEX32(CLOCK, PopAt(20));
+    TEST_ASSERT_EQUAL_HEX32(NOTE_ON(0x3C), PopAt(20));
+}
+
+void test_MIDI_Scheduler_PriorityUnderCongestion(void)
+{
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0x4, 0xF0, 0x7E, 0x7F), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x3C), 0, 0);
+
+    uint32_t now = MIDI_DIN_TX_REORDER_US;
+    TEST_ASSERT_EQUAL_HEX32(NOTE_OFF(0x3C), PopAt(now));
+    TEST_ASSERT_EQUAL_HEX32(CC(1, 0x10), PopAt(now));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x4, 0xF0, 0x7E, 0x7F), PopAt(now));
+}
+
+void test_MIDI_Scheduler_NoteWaitsForOlderProgramChange(void)
+{
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0xC, 0xC0, 0x05, 0), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(7, 0x40), 0, 0);
+
+    // The note plays with the new program; the later CC still waits
+    uint32_t now = MIDI_DIN_TX_REORDER_US;
+    TEST_ASSERT_EQUAL_HEX32(CC(1, 0x10), PopAt(now));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xC, 0xC0, 0x05, 0), PopAt(now));
+    TEST_ASSERT_EQUAL_HEX32(NOTE_ON(0x3C), PopAt(now));
+    TEST_ASSERT_EQUAL_HEX32(CC(7, 0x40), PopAt(now));
+}
+
+void test_MIDI_Scheduler_StarvingMessageGoesFirst(void)
+{
+    MIDI_Scheduler_Push(&scheduler, CC(7, 0x40), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 20000, 0);
+
+    TEST_ASSERT_EQUAL_HEX32(NOTE_ON(0x3C), PopAt(25000));
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3E), 26000, 0);
+    TEST_ASSERT_EQUAL_HEX32(CC(7, 0x40), PopAt(MIDI_DIN_TX_STARVATION_US));
+}
+
+void test_MIDI_Scheduler_LatencyBoundDropsNoteOnKeepsNoteOff(void)
+{
+    // Enough bytes already on the way to exceed the bound
+    uint32_t wire_pending = MIDI_DIN_TX_LATENCY_BOUND_US / MIDI_SCHEDULER_BYTE_US;
+
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 0, wire_pending));
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, CC(1, 0x10), 0, wire_pending));
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x3C), 0, wire_pending));
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, Event(0x9, 0x90, 0x3E, 0x00), 0, wire_pending));
+
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_drops[MIDI_TX_CLASS_NOTE]);
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_drops[MIDI_TX_CLASS_VOICE]);
+    TEST_ASSERT_EQUAL_UINT32(6, MIDI_Scheduler_QueuedBytes(&scheduler));
+    TEST_ASSERT_EQUAL_HEX32(NOTE_OFF(0x3C), PopAt(0));
+}
+
+void test_MIDI_Scheduler_LatencyBoundKeepsOrderedMessages(void)
+{
+    uint32_t wire_pending = MIDI_DIN_TX_LATENCY_BOUND_US / MIDI_SCHEDULER_BYTE_US;
+
+    MIDI_Scheduler_Push(&scheduler, Event(0xC, 0xC0, 0x05, 0), 0, wire_pending);
+    MIDI_Scheduler_Push(&scheduler, CC(0, 1), 0, wire_pending);
+    MIDI_Scheduler_Push(&scheduler, CC(101, 0), 0, wire_pending);
+    MIDI_Scheduler_Push(&scheduler, CC(6, 2), 0, wire_pending);
+
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_drops[MIDI_TX_CLASS_VOICE]);
+    TEST_ASSERT_EQUAL_UINT32(11, MIDI_Scheduler_QueuedBytes(&scheduler));
+}
+
+void test_MIDI_Scheduler_LatencyBoundKeepsSustainOff(void)
+{
+    uint32_t wire_pending = MIDI_DIN_TX_LATENCY_BOUND_US / MIDI_SCHEDULER_BYTE_US;
+
+    // Nothing queued to coalesce into: the pedal release must still go out
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, CC(64, 0), 0, wire_pending));
+
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_drops[MIDI_TX_CLASS_VOICE]);
+    TEST_ASSERT_EQUAL_HEX32(CC(64, 0), PopAt(0));
+}
+
+void test_MIDI_Scheduler_BoundCountsHigherClasses(void)
+{
+    // Notes ahead of a CC delay it; a CC ahead of a note does not
+    uint32_t notes = MIDI_DIN_TX_LATENCY_BOUND_US / (3 * MIDI_SCHEDULER_BYTE_US);
+    for (uint32_t i = 0; i < notes; i++) {
+        MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x30 + i), 0, 0);
+    }
+
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x10), 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_drops[MIDI_TX_CLASS_VOICE]);
+
+    MIDI_Scheduler_Init(&scheduler, false);
+    for (uint32_t i = 0; i < notes - 1; i++) {
+        MIDI_Scheduler_Push(&scheduler, CC(1, i), 0, 0);
+    }
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_drops[MIDI_TX_CLASS_NOTE]);
+}
+
+void test_MIDI_Scheduler_SysExNotInterrupted(void)
+{
+    uint32_t event;
+
+    MIDI_Scheduler_Push(&scheduler, Event(0x4, 0xF0, 0x7E, 0x7F), 0, 0);
+    TEST_ASSERT_EQUAL_HEX32(Event(0x4, 0xF0, 0x7E, 0x7F), PopAt(0));
+
+    // The rest of the SysEx has not arrived yet: only realtime may go
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 100, 0);
+    MIDI_Scheduler_Push(&scheduler, CLOCK, 100, 0);
+    TEST_ASSERT_EQUAL_HEX32(CLOCK, PopAt(200));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_Pop(&scheduler, 200, &event));
+
+    MIDI_Scheduler_Push(&scheduler, Event(0x6, 0x06, 0xF7, 0), 300, 0);
+    TEST_ASSERT_EQUAL_HEX32(Event(0x6, 0x06, 0xF7, 0), PopAt(400));
+    TEST_ASSERT_EQUAL_HEX32(NOTE_ON(0x3C), PopAt(400));
+}
+
+void test_MIDI_Scheduler_AbandonedSysExReleasesQueue(void)
+{
+    MIDI_Scheduler_Push(&scheduler, Event(0x4, 0xF0, 0x7E, 0x7F), 0, 0);
+    PopAt(0);
+    MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x3C), 100, 0);
+
+    TEST_ASSERT_EQUAL_HEX32(NOTE_OFF(0x3C), PopAt(100 + MIDI_DIN_TX_STARVATION_US));
+    TEST_ASSERT_FALSE(scheduler.in_sysex);
+}
+
+void test_MIDI_Scheduler_SysExBackPressure(void)
+{
+    for (uint32_t i = 0; i < MIDI_SCHEDULER_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, Event(0x4, 0x01, 0x02, 0x03), 0, 0));
+    }
+    TEST_ASSERT_FALSE(MIDI_Scheduler_Push(&scheduler, Event(0x4, 0x01, 0x02, 0x03), 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_drops[MIDI_TX_CLASS_SYSEX]);
+
+    // Other classes drop instead of blocking
+    for (uint32_t i = 0; i <= MIDI_SCHEDULER_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, CLOCK, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_drops[MIDI_TX_CLASS_REALTIME]);
+}
+
+void test_MIDI_Scheduler_NoteOffBackPressure(void)
+{
+    uint32_t event;
+
+    for (uint32_t i = 0; i < MIDI_SCHEDULER_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x20 + i), 0, 0));
+    }
+    TEST_ASSERT_FALSE(MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x7F), 0, 0));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_Push(&scheduler, Event(0x9, 0x90, 0x7E, 0x00), 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_drops[MIDI_TX_CLASS_NOTE]);
+
+    // Room again after one is sent: the refused Note Off is taken on retry
+    TEST_ASSERT_EQUAL_HEX32(NOTE_OFF(0x20), PopAt(0));
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x7F), 0, 0));
+    for (uint32_t i = 1; i < MIDI_SCHEDULER_QUEUE_SIZE; i++) {
+        TEST_ASSERT_EQUAL_HEX32(NOTE_OFF(0x20 + i), PopAt(0));
+    }
+    TEST_ASSERT_EQUAL_HEX32(NOTE_OFF(0x7F), PopAt(0));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_Pop(&scheduler, 0, &event));
+
+    // A full queue still drops Note On
+    for (uint32_t i = 0; i < MIDI_SCHEDULER_QUEUE_SIZE; i++) {
+        MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x20 + i), 0, 0);
+    }
+    TEST_ASSERT_TRUE(MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_drops[MIDI_TX_CLASS_NOTE]);
+}
+
+void test_MIDI_Scheduler_DelayCounters(void)
+{
+    MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x3C), 1000, 0);
+    MIDI_Scheduler_Push(&scheduler, NOTE_OFF(0x3E), 1000, 0);
+
+    PopAt(1500);
+    PopAt(1000 + MIDI_DIN_TX_LATENCY_BOUND_US + 1);
+
+    TEST_ASSERT_EQUAL_UINT32(MIDI_DIN_TX_LATENCY_BOUND_US + 1,
+                             midi_stats.din_tx_delay_max_us[MIDI_TX_CLASS_NOTE]);
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_late[MIDI_TX_CLASS_NOTE]);
+}
+
+void test_MIDI_Scheduler_CoalesceReplacesQueuedValue(void)
+{
+    MIDI_Scheduler_Init(&scheduler, true);
+
+    MIDI_Scheduler_Push(&scheduler, Event(0xE, 0xE0, 0x00, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x10), 10, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0xE, 0xE0, 0x00, 0x20), 20, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x20), 30, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(6, MIDI_Scheduler_QueuedBytes(&scheduler));
+    TEST_ASSERT_EQUAL_UINT32(2, midi_stats.din_tx_coalesced);
+    TEST_ASSERT_EQUAL_HEX32(Event(0xE, 0xE0, 0x00, 0x20), PopAt(100));
+    TEST_ASSERT_EQUAL_HEX32(CC(1, 0x20), PopAt(100));
+}
+
+void test_MIDI_Scheduler_CoalesceKeepsDistinctKeys(void)
+{
+    MIDI_Scheduler_Init(&scheduler, true);
+
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(2, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0xB, 0xB1, 0x01, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0xA, 0xA0, 0x3C, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0xA, 0xA0, 0x3E, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0xD, 0xD0, 0x10, 0x00), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, Event(0xD, 0xD0, 0x20, 0x00), 0, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_coalesced);
+    TEST_ASSERT_EQUAL_UINT32(17, MIDI_Scheduler_QueuedBytes(&scheduler));
+}
+
+void test_MIDI_Scheduler_CoalesceNeverPassesOrderedMessages(void)
+{
+    MIDI_Scheduler_Init(&scheduler, true);
+
+    // Volume must still be 0x10 when the note starts
+    MIDI_Scheduler_Push(&scheduler, CC(7, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, NOTE_ON(0x3C), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(7, 0x7F), 0, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_coalesced);
+    TEST_ASSERT_EQUAL_HEX32(CC(7, 0x10), PopAt(0));
+    TEST_ASSERT_EQUAL_HEX32(NOTE_ON(0x3C), PopAt(0));
+    TEST_ASSERT_EQUAL_HEX32(CC(7, 0x7F), PopAt(0));
+}
+
+void test_MIDI_Scheduler_ParameterControllersNotCoalesced(void)
+{
+    MIDI_Scheduler_Init(&scheduler, true);
+
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(0, 1)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(32, 1)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(6, 1)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(38, 1)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(101, 0)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(123, 0)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(Event(0xC, 0xC0, 0x05, 0)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(64, 0x7F)));
+    TEST_ASSERT_FALSE(MIDI_Scheduler_IsCoalescable(CC(69, 0x7F)));
+    TEST_ASSERT_TRUE(MIDI_Scheduler_IsCoalescable(CC(70, 0x40)));
+
+    // RPN 0 (pitch bend range) to 2 then 12 semitones: every step is kept
+    MIDI_Scheduler_Push(&scheduler, CC(101, 0), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(100, 0), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(6, 2), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(6, 12), 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_coalesced);
+    TEST_ASSERT_EQUAL_UINT32(12, MIDI_Scheduler_QueuedBytes(&scheduler));
+}
+
+void test_MIDI_Scheduler_CoalesceDisabled(void)
+{
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x10), 0, 0);
+    MIDI_Scheduler_Push(&scheduler, CC(1, 0x20), 0, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.din_tx_coalesced);
+    TEST_ASSERT_EQUAL_UINT32(6, MIDI_Scheduler_QueuedBytes(&scheduler));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_Scheduler_Classify);
+    RUN_TEST(test_MIDI_Scheduler_ArrivalOrderWhileBacklogShort);
+    RUN_TEST(test_MIDI_Scheduler_RealtimeFirst);
+    RUN_TEST(test_MIDI_Scheduler_PriorityUnderCongestion);
+    RUN_TEST(test_MIDI_Scheduler_NoteWaitsForOlderProgramChange);
+    RUN_TEST(test_MIDI_Scheduler_StarvingMessageGoesFirst);
+    RUN_TEST(test_MIDI_Scheduler_LatencyBoundDropsNoteOnKeepsNoteOff);
+    RUN_TEST(test_MIDI_Scheduler_LatencyBoundKeepsOrderedMessages);
+    RUN_TEST(test_MIDI_Scheduler_LatencyBoundKeepsSustainOff);
+    RUN_TEST(test_MIDI_Scheduler_BoundCountsHigherClasses);
+    RUN_TEST(test_MIDI_Scheduler_SysExNotInterrupted);
+    RUN_TEST(test_MIDI_Scheduler_AbandonedSysExReleasesQueue);
+    RUN_TEST(test_MIDI_Scheduler_SysExBackPressure);
+    RUN_TEST(test_MIDI_Scheduler_NoteOffBackPressure);
+    RUN_TEST(test_MIDI_Scheduler_DelayCounters);
+    RUN_TEST(test_MIDI_Scheduler_CoalesceReplacesQueuedValue);
+    RUN_TEST(test_MIDI_Scheduler_CoalesceKeepsDistinctKeys);
+    RUN_TEST(test_MIDI_Scheduler_CoalesceNeverPassesOrderedMessages);
+    RUN_TEST(test_MIDI_Scheduler_ParameterControllersNotCoalesced);
+    RUN_TEST(test_MIDI_Scheduler_CoalesceDisabled);
+
+    return UNITY_END();
+}
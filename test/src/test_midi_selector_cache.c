@@ -0,0 +1,152 @@
+#include "test_common.h"
+#include <string.h>
+
+// Include the header files
+#include "midi_selector_cache.h"
+#include "midi_running_status.h"
+
+static MidiSelectorCache_t cache;
+
+// Helper to filter one Control Change
+static bool FilterCC(uint8_t channel, uint8_t controller, uint8_t value)
+{
+    const uint8_t message[] = {(uint8_t)(0xB0 | channel), controller, value};
+    return MIDI_SelectorCache_Filter(&cache, message, 3);
+}
+
+void setUp(void)
+{
+    MIDI_SelectorCache_Invalidate(&cache);
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_SelectorCache_BankSelectSentOnChange(void)
+{
+    const uint8_t program[] = {0xC0, 0x05};
+
+    TEST_ASSERT_TRUE(FilterCC(0, 0, 1));
+    TEST_ASSERT_TRUE(FilterCC(0, 32, 2));
+    TEST_ASSERT_TRUE(MIDI_SelectorCache_Filter(&cache, program, 2));
+
+    // Same bank: only the Program Change goes out
+    TEST_ASSERT_FALSE(FilterCC(0, 0, 1));
+    TEST_ASSERT_FALSE(FilterCC(0, 32, 2));
+    TEST_ASSERT_TRUE(MIDI_SelectorCache_Filter(&cache, program, 2));
+
+    // New LSB only
+    TEST_ASSERT_FALSE(FilterCC(0, 0, 1));
+    TEST_ASSERT_TRUE(FilterCC(0, 32, 3));
+}
+
+void test_MIDI_SelectorCache_ChannelsAreIndependent(void)
+{
+    TEST_ASSERT_TRUE(FilterCC(0, 0, 1));
+    TEST_ASSERT_TRUE(FilterCC(1, 0, 1));
+    TEST_ASSERT_FALSE(FilterCC(1, 0, 1));
+}
+
+void test_MIDI_SelectorCache_RpnSelectorSkipped(void)
+{
+    TEST_ASSERT_TRUE(FilterCC(0, 101, 0));
+    TEST_ASSERT_TRUE(FilterCC(0, 100, 0));
+    TEST_ASSERT_TRUE(FilterCC(0, 6, 2));
+    TEST_ASSERT_TRUE(FilterCC(0, 38, 0));
+
+    TEST_ASSERT_FALSE(FilterCC(0, 101, 0));
+    TEST_ASSERT_FALSE(FilterCC(0, 100, 0));
+    TEST_ASSERT_TRUE(FilterCC(0, 6, 12));
+    TEST_ASSERT_TRUE(FilterCC(0, 38, 0));
+
+    // Another RPN with the same MSB
+    TEST_ASSERT_FALSE(FilterCC(0, 101, 0));
+    TEST_ASSERT_TRUE(FilterCC(0, 100, 1));
+}
+
+void test_MIDI_SelectorCache_SwitchingRpnAndNrpnResendsBoth(void)
+{
+    FilterCC(0, 101, 0);
+    FilterCC(0, 100, 0);
+
+    TEST_ASSERT_TRUE(FilterCC(0, 99, 0));
+    TEST_ASSERT_TRUE(FilterCC(0, 98, 0));
+    TEST_ASSERT_FALSE(FilterCC(0, 99, 0));
+
+    TEST_ASSERT_TRUE(FilterCC(0, 101, 0));
+    TEST_ASSERT_TRUE(FilterCC(0, 100, 0));
+}
+
+void test_MIDI_SelectorCache_ResetsInvalidate(void)
+{
+    const uint8_t system_reset = 0xFF;
+
+    FilterCC(0, 0, 1);
+    FilterCC(0, 101, 0);
+    FilterCC(0, 100, 0);
+
+    // Reset All Controllers clears the parameter but not the bank
+    TEST_ASSERT_TRUE(FilterCC(0, 121, 0));
+    TEST_ASSERT_TRUE(FilterCC(0, 101, 0));
+    TEST_ASSERT_FALSE(FilterCC(0, 0, 1));
+
+    TEST_ASSERT_TRUE(MIDI_SelectorCache_Filter(&cache, &system_reset, 1));
+    TEST_ASSERT_TRUE(FilterCC(0, 0, 1));
+
+    MIDI_SelectorCache_Invalidate(&cache);
+    TEST_ASSERT_TRUE(FilterCC(0, 0, 1));
+}
+
+void test_MIDI_SelectorCache_OtherMessagesPass(void)
+{
+    const uint8_t note_on[] = {0x90, 0x3C, 0x64};
+    const uint8_t clock = 0xF8;
+
+    TEST_ASSERT_TRUE(MIDI_SelectorCache_Filter(&cache, note_on, 3));
+    TEST_ASSERT_TRUE(MIDI_SelectorCache_Filter(&cache, &clock, 1));
+    TEST_ASSERT_TRUE(FilterCC(0, 7, 100));
+    TEST_ASSERT_TRUE(FilterCC(0, 7, 100));
+}
+
+void test_MIDI_SelectorCache_RpnSweepWireBytes(void)
+{
+    // A MIDI 2.0 RPN sweep (pitch bend sensitivity) as MIDI 1.0 CC sequences
+    MidiRunningStatus_t plain_encoder;
+    MidiRunningStatus_t cached_encoder;
+    uint8_t out[4];
+    size_t plain_bytes = 0;
+    size_t cached_bytes = 0;
+
+    MIDI_RunningStatus_Init(&plain_encoder, false);
+    MIDI_RunningStatus_Init(&cached_encoder, false);
+    for (uint8_t value = 0; value < 64; value++) {
+        const uint8_t sequence[4][3] = {
+            {0xB0, 101, 0}, {0xB0, 100, 0}, {0xB0, 6, value}, {0xB0, 38, 0}
+        };
+        for (int i = 0; i < 4; i++) {
+            plain_bytes += MIDI_RunningStatus_Encode(&plain_encoder, sequence[i], 3, out);
+            if (MIDI_SelectorCache_Filter(&cache, sequence[i], 3)) {
+                cached_bytes += MIDI_RunningStatus_Encode(&cached_encoder, sequence[i], 3, out);
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL(64 * 8 + 1, plain_bytes);
+    TEST_ASSERT_EQUAL(64 * 4 + 4 + 1, cached_bytes);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_SelectorCache_BankSelectSentOnChange);
+    RUN_TEST(test_MIDI_SelectorCache_ChannelsAreIndependent);
+    RUN_TEST(test_MIDI_SelectorCache_RpnSelectorSkipped);
+    RUN_TEST(test_MIDI_SelectorCache_SwitchingRpnAndNrpnResendsBoth);
+    RUN_TEST(test_MIDI_SelectorCache_ResetsInvalidate);
+    RUN_TEST(test_MIDI_SelectorCache_OtherMessagesPass);
+    RUN_TEST(test_MIDI_SelectorCache_RpnSweepWireBytes);
+
+    return UNITY_END();
+}
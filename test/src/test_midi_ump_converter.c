@@ -0,0 +1,224 @@
+#include "test_common.h"
+#include <string.h>
+
+// Include the header files
+#include "midi_ump_converter.h"
+#include "midi_parser.h"
+
+static MidiUmpConverter_t converter;
+static uint32_t ump[MIDI_UMP_CONVERTER_MAX_WORDS];
+
+// Helper to build an event word
+static uint32_t Event(uint8_t cin, uint8_t b0, uint8_t b1, uint8_t b2)
+{
+    return cin | ((uint32_t)b0 << 8) | ((uint32_t)b1 << 16) | ((uint32_t)b2 << 24);
+}
+
+// Helper to convert a byte stream with the parser and collect all UMP words
+static uint32_t ConvertStream(const uint8_t *data, size_t length, uint32_t *out, uint32_t max_words)
+{
+    MidiParser_t parser;
+    uint32_t events[64];
+    size_t event_count;
+    uint32_t count = 0;
+
+    MIDI_Parser_Init(&parser, 0);
+    MIDI_Parser_Process(&parser, data, length, events, 64, &event_count);
+    for (size_t i = 0; i < event_count; i++) {
+        uint32_t words = MIDI_UmpConverter_Process(&converter, events[i], ump);
+        TEST_ASSERT_TRUE(count + words <= max_words);
+        memcpy(&out[count], ump, words * sizeof(uint32_t));
+        count += words;
+    }
+    return count;
+}
+
+void setUp(void)
+{
+    MIDI_UmpConverter_Init(&converter, 0);
+    memset(ump, 0, sizeof(ump));
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_UmpConverter_ScaleTables(void)
+{
+    TEST_ASSERT_EQUAL_HEX16(0x0000, midi_ump_scale7to16[0]);
+    TEST_ASSERT_EQUAL_HEX16(0x8000, midi_ump_scale7to16[64]);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, midi_ump_scale7to16[127]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, midi_ump_scale7to32[64]);
+    TEST_ASSERT_EQUAL_HEX32(0x82082082, midi_ump_scale7to32[65]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, midi_ump_scale7to32[127]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, MIDI_UmpConverter_Scale14To32(0x2000));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, MIDI_UmpConverter_Scale14To32(0x3FFF));
+
+    // Monotonic
+    for (int i = 1; i < 128; i++) {
+        TEST_ASSERT_TRUE(midi_ump_scale7to16[i] > midi_ump_scale7to16[i - 1]);
+        TEST_ASSERT_TRUE(midi_ump_scale7to32[i] > midi_ump_scale7to32[i - 1]);
+    }
+}
+
+void test_MIDI_UmpConverter_NoteOnOff(void)
+{
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0x9, 0x92, 60, 127), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40923C00, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFF0000, ump[1]);
+
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0x8, 0x82, 60, 64), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40823C00, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, ump[1]);
+
+    // Note On velocity 0 is a Note Off
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0x9, 0x92, 60, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40823C00, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, ump[1]);
+}
+
+void test_MIDI_UmpConverter_ControllersAndPressure(void)
+{
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xB, 0xB5, 7, 100), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40B50700, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(midi_ump_scale7to32[100], ump[1]);
+
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xA, 0xA0, 60, 127), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40A03C00, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, ump[1]);
+
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xD, 0xDF, 64, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40DF0000, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, ump[1]);
+
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xE, 0xE1, 0x00, 0x40), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40E10000, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, ump[1]);
+}
+
+void test_MIDI_UmpConverter_ProgramChangeWithBank(void)
+{
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xC, 0xC0, 5, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40C00000, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x05000000, ump[1]);
+
+    // Bank Select is held for the next Program Change
+    TEST_ASSERT_EQUAL(0, MIDI_UmpConverter_Process(&converter, Event(0xB, 0xB0, 0, 1), ump));
+    TEST_ASSERT_EQUAL(0, MIDI_UmpConverter_Process(&converter, Event(0xB, 0xB0, 32, 2), ump));
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xC, 0xC0, 5, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40C00001, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x05000102, ump[1]);
+
+    // Other channels have no bank
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xC, 0xC1, 5, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40C10000, ump[0]);
+}
+
+void test_MIDI_UmpConverter_SystemCommon(void)
+{
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0x2, 0xF1, 0x25, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x10F12500, ump[0]);
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0x3, 0xF2, 0x10, 0x20), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x10F21020, ump[0]);
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0x5, 0xF6, 0, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x10F60000, ump[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x10F80000, MIDI_UMP_SYSTEM(0, 0xF8, 0, 0));
+}
+
+void test_MIDI_UmpConverter_ShortSysExIsComplete(void)
+{
+    const uint8_t sysex[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7};
+    uint32_t out[8];
+
+    TEST_ASSERT_EQUAL(2, ConvertStream(sysex, sizeof(sysex), out, 8));
+    TEST_ASSERT_EQUAL_HEX32(0x30047E7F, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x06010000, out[1]);
+}
+
+void test_MIDI_UmpConverter_SixByteSysExIsOnePacket(void)
+{
+    const uint8_t sysex[] = {0xF0, 1, 2, 3, 4, 5, 6, 0xF7};
+    uint32_t out[8];
+
+    TEST_ASSERT_EQUAL(2, ConvertStream(sysex, sizeof(sysex), out, 8));
+    TEST_ASSERT_EQUAL_HEX32(0x30060102, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x03040506, out[1]);
+}
+
+void test_MIDI_UmpConverter_LongSysExIsSplit(void)
+{
+    const uint8_t sysex[] = {0xF0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0xF7};
+    uint32_t out[8];
+
+    TEST_ASSERT_EQUAL(6, ConvertStream(sysex, sizeof(sysex), out, 8));
+    TEST_ASSERT_EQUAL_HEX32(0x30160102, out[0]);  // Start
+    TEST_ASSERT_EQUAL_HEX32(0x03040506, out[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x30260708, out[2]);  // Continue
+    TEST_ASSERT_EQUAL_HEX32(0x090A0B0C, out[3]);
+    TEST_ASSERT_EQUAL_HEX32(0x30310D00, out[4]);  // End
+    TEST_ASSERT_EQUAL_HEX32(0x00000000, out[5]);
+}
+
+void test_MIDI_UmpConverter_RunningStatusStream(void)
+{
+    const uint8_t stream[] = {0x90, 60, 100, 62, 0, 0xB3, 74, 10, 75, 11};
+    uint32_t out[16];
+
+    TEST_ASSERT_EQUAL(8, ConvertStream(stream, sizeof(stream), out, 16));
+    TEST_ASSERT_EQUAL_HEX32(0x40903C00, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x40803E00, out[2]);
+    TEST_ASSERT_EQUAL_HEX32(0x40B34A00, out[4]);
+    TEST_ASSERT_EQUAL_HEX32(0x40B34B00, out[6]);
+}
+
+void test_MIDI_UmpConverter_GroupInOutput(void)
+{
+    MIDI_UmpConverter_Init(&converter, 3);
+    MIDI_UmpConverter_Process(&converter, Event(0x9, 0x90, 60, 100), ump);
+    TEST_ASSERT_EQUAL_HEX32(0x43903C00, ump[0]);
+    MIDI_UmpConverter_Process(&converter, Event(0x2, 0xF3, 1, 0), ump);
+    TEST_ASSERT_EQUAL_HEX32(0x13F30100, ump[0]);
+}
+
+void test_MIDI_UmpConverter_Midi1Protocol(void)
+{
+    MIDI_UmpConverter_SetProtocol(&converter, true);
+
+    // Channel voice is wrapped as is in one word, Note On velocity 0 included
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0x9, 0x92, 60, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x20923C00, ump[0]);
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0xB, 0xB0, 0, 1), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x20B00001, ump[0]);
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0xC, 0xC0, 5, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x20C00500, ump[0]);
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0xE, 0xE1, 0x00, 0x40), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x20E10040, ump[0]);
+
+    // System messages and SysEx are the same in both protocols
+    TEST_ASSERT_EQUAL(1, MIDI_UmpConverter_Process(&converter, Event(0x2, 0xF1, 0x25, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x10F12500, ump[0]);
+
+    // Switching back does not apply the Bank Select passed through above
+    MIDI_UmpConverter_SetProtocol(&converter, false);
+    TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, Event(0xC, 0xC0, 5, 0), ump));
+    TEST_ASSERT_EQUAL_HEX32(0x40C00000, ump[0]);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_UmpConverter_ScaleTables);
+    RUN_TEST(test_MIDI_UmpConverter_NoteOnOff);
+    RUN_TEST(test_MIDI_UmpConverter_ControllersAndPressure);
+    RUN_TEST(test_MIDI_UmpConverter_ProgramChangeWithBank);
+    RUN_TEST(test_MIDI_UmpConverter_SystemCommon);
+    RUN_TEST(test_MIDI_UmpConverter_ShortSysExIsComplete);
+    RUN_TEST(test_MIDI_UmpConverter_SixByteSysExIsOnePacket);
+    RUN_TEST(test_MIDI_UmpConverter_LongSysExIsSplit);
+    RUN_TEST(test_MIDI_UmpConverter_RunningStatusStream);
+    RUN_TEST(test_MIDI_UmpConverter_GroupInOutput);
+    RUN_TEST(test_MIDI_UmpConverter_Midi1Protocol);
+
+    return UNITY_END();
+}
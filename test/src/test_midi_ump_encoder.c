@@ -0,0 +1,219 @@
+#include "test_common.h"
+#include <string.h>
+
+// Include the header files
+#include "midi_ump_encoder.h"
+#include "midi_ump_converter.h"
+#include "midi_parser.h"
+
+static MidiUmpEncoder_t encoder;
+static uint32_t events[MIDI_UMP_ENCODER_MAX_EVENTS];
+
+// Helper to build an event word
+static uint32_t Event(uint8_t cin, uint8_t b0, uint8_t b1, uint8_t b2)
+{
+    return cin | ((uint32_t)b0 << 8) | ((uint32_t)b1 << 16) | ((uint32_t)b2 << 24);
+}
+
+// Helper to encode a UMP given as up to two words
+static uint32_t Encode(uint32_t word0, uint32_t word1)
+{
+    const uint32_t ump[4] = {word0, word1, 0, 0};
+    return MIDI_UmpEncoder_Process(&encoder, ump, events);
+}
+
+void setUp(void)
+{
+    MIDI_UmpEncoder_Init(&encoder);
+    memset(events, 0, sizeof(events));
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_UmpEncoder_SystemMessages(void)
+{
+    TEST_ASSERT_EQUAL(1, Encode(0x10F80000, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xF, 0xF8, 0, 0), events[0]);
+    TEST_ASSERT_TRUE(MIDI_EVENT_IS_REALTIME(events[0]));
+
+    TEST_ASSERT_EQUAL(1, Encode(0x10F21020, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x3, 0xF2, 0x10, 0x20), events[0]);
+
+    TEST_ASSERT_EQUAL(1, Encode(0x10F12500, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x2, 0xF1, 0x25, 0), events[0]);
+
+    // Undefined and SysEx statuses are not System messages
+    TEST_ASSERT_EQUAL(0, Encode(0x10F40000, 0));
+    TEST_ASSERT_EQUAL(0, Encode(0x10F00000, 0));
+}
+
+void test_MIDI_UmpEncoder_Midi1ChannelVoice(void)
+{
+    TEST_ASSERT_EQUAL(1, Encode(0x20903C64, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x9, 0x90, 0x3C, 0x64), events[0]);
+
+    TEST_ASSERT_EQUAL(1, Encode(0x20C50700, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xC, 0xC5, 0x07, 0), events[0]);
+
+    // Note On velocity 0 stays as it is in the MIDI 1.0 Protocol
+    TEST_ASSERT_EQUAL(1, Encode(0x20903C00, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x9, 0x90, 0x3C, 0x00), events[0]);
+}
+
+void test_MIDI_UmpEncoder_ZeroPayloadWordIsUsed(void)
+{
+    // The value word of these messages is 0 and must not be skipped
+    TEST_ASSERT_EQUAL(1, Encode(0x40B30700, 0x00000000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB3, 0x07, 0x00), events[0]);
+
+    TEST_ASSERT_EQUAL(1, Encode(0x40E00000, 0x00000000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xE, 0xE0, 0x00, 0x00), events[0]);
+
+    TEST_ASSERT_EQUAL(1, Encode(0x40803C00, 0x00000000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x8, 0x80, 0x3C, 0x00), events[0]);
+}
+
+void test_MIDI_UmpEncoder_Midi2ChannelVoice(void)
+{
+    TEST_ASSERT_EQUAL(1, Encode(0x40913C00, 0xFFFF0000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x9, 0x91, 0x3C, 0x7F), events[0]);
+
+    // A velocity that scales to 0 is sent as 1, not as a Note Off
+    TEST_ASSERT_EQUAL(1, Encode(0x40913C00, 0x01000000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x9, 0x91, 0x3C, 0x01), events[0]);
+
+    TEST_ASSERT_EQUAL(1, Encode(0x40A23C00, 0x80000000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xA, 0xA2, 0x3C, 0x40), events[0]);
+
+    TEST_ASSERT_EQUAL(1, Encode(0x40D20000, 0xFFFFFFFF));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xD, 0xD2, 0x7F, 0), events[0]);
+
+    TEST_ASSERT_EQUAL(1, Encode(0x40E20000, 0x80000000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xE, 0xE2, 0x00, 0x40), events[0]);
+}
+
+void test_MIDI_UmpEncoder_RegisteredControllerIsRpnSequence(void)
+{
+    // Pitch Bend Sensitivity: 2 semitones, 50 cents
+    uint32_t value = MIDI_UmpConverter_Scale14To32((2 << 7) | 50);
+    TEST_ASSERT_EQUAL(4, Encode(0x40200000, value));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB0, 101, 0), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB0, 100, 0), events[1]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB0, 6, 2), events[2]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB0, 38, 50), events[3]);
+
+    TEST_ASSERT_EQUAL(4, Encode(0x40311234, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB1, 99, 0x12), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB1, 98, 0x34), events[1]);
+}
+
+void test_MIDI_UmpEncoder_ProgramChangeWithBank(void)
+{
+    TEST_ASSERT_EQUAL(1, Encode(0x40C00000, 0x05000000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xC, 0xC0, 0x05, 0), events[0]);
+
+    TEST_ASSERT_EQUAL(3, Encode(0x40C00001, 0x05000102));
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB0, 0, 1), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0xB, 0xB0, 32, 2), events[1]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0xC, 0xC0, 0x05, 0), events[2]);
+}
+
+void test_MIDI_UmpEncoder_SysExComplete(void)
+{
+    // F0 7E 7F 06 01 F7
+    TEST_ASSERT_EQUAL(2, Encode(0x30047E7F, 0x06010000));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x4, 0xF0, 0x7E, 0x7F), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0x7, 0x06, 0x01, 0xF7), events[1]);
+}
+
+void test_MIDI_UmpEncoder_SysExAcrossPackets(void)
+{
+    // F0 01..0D F7 in Start / Continue / End packets
+    uint8_t bytes[32];
+    size_t length = 0;
+    const uint32_t packets[3][2] = {
+        {0x30160102, 0x03040506},
+        {0x30260708, 0x090A0B0C},
+        {0x30310D00, 0x00000000},
+    };
+
+    for (int p = 0; p < 3; p++) {
+        uint32_t count = Encode(packets[p][0], packets[p][1]);
+        for (uint32_t e = 0; e < count; e++) {
+            for (uint8_t i = 0; i < MIDI_Parser_EventLength(events[e]); i++) {
+                bytes[length++] = MIDI_EVENT_BYTE(events[e], i);
+            }
+            TEST_ASSERT_TRUE(MIDI_EVENT_IS_SYSEX(events[e]));
+        }
+    }
+
+    TEST_ASSERT_EQUAL(15, length);
+    TEST_ASSERT_EQUAL_HEX8(0xF0, bytes[0]);
+    for (int i = 1; i <= 13; i++) {
+        TEST_ASSERT_EQUAL_HEX8(i, bytes[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(0xF7, bytes[14]);
+}
+
+void test_MIDI_UmpEncoder_UnterminatedSysExIsClosed(void)
+{
+    TEST_ASSERT_EQUAL(1, Encode(0x30120102, 0));  // Start, 2 bytes: F0 01 02
+    TEST_ASSERT_EQUAL_HEX32(Event(0x4, 0xF0, 0x01, 0x02), events[0]);
+
+    // A new Complete packet ends the previous SysEx first
+    TEST_ASSERT_EQUAL(2, Encode(0x30017E00, 0));
+    TEST_ASSERT_EQUAL_HEX32(Event(0x5, 0xF7, 0, 0), events[0]);
+    TEST_ASSERT_EQUAL_HEX32(Event(0x7, 0xF0, 0x7E, 0xF7), events[1]);
+
+    // Continue without a Start is ignored
+    TEST_ASSERT_EQUAL(0, Encode(0x30220102, 0));
+}
+
+void test_MIDI_UmpEncoder_OtherTypesIgnored(void)
+{
+    TEST_ASSERT_EQUAL(0, Encode(0x00200000, 0));  // JR Timestamp
+    TEST_ASSERT_EQUAL(0, Encode(0x40003C00, 0));  // Registered Per-Note Controller
+    TEST_ASSERT_EQUAL(0, Encode(0xF0000000, 0));  // UMP Stream
+    TEST_ASSERT_EQUAL(0, Encode(0xD0100000, 0));  // Flex Data
+}
+
+void test_MIDI_UmpEncoder_RoundTripWithConverter(void)
+{
+    // MIDI 1.0 -> MIDI 2.0 -> MIDI 1.0 keeps 7- and 14-bit values
+    MidiUmpConverter_t converter;
+    uint32_t ump[MIDI_UMP_CONVERTER_MAX_WORDS];
+    MIDI_UmpConverter_Init(&converter, 0);
+
+    for (uint8_t v = 0; v < 128; v++) {
+        uint32_t cc = Event(0xB, 0xB0, 7, v);
+        TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, cc, ump));
+        TEST_ASSERT_EQUAL(1, MIDI_UmpEncoder_Process(&encoder, ump, events));
+        TEST_ASSERT_EQUAL_HEX32(cc, events[0]);
+
+        uint32_t bend = Event(0xE, 0xE0, 127 - v, v);
+        TEST_ASSERT_EQUAL(2, MIDI_UmpConverter_Process(&converter, bend, ump));
+        TEST_ASSERT_EQUAL(1, MIDI_UmpEncoder_Process(&encoder, ump, events));
+        TEST_ASSERT_EQUAL_HEX32(bend, events[0]);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_UmpEncoder_SystemMessages);
+    RUN_TEST(test_MIDI_UmpEncoder_Midi1ChannelVoice);
+    RUN_TEST(test_MIDI_UmpEncoder_ZeroPayloadWordIsUsed);
+    RUN_TEST(test_MIDI_UmpEncoder_Midi2ChannelVoice);
+    RUN_TEST(test_MIDI_UmpEncoder_RegisteredControllerIsRpnSequence);
+    RUN_TEST(test_MIDI_UmpEncoder_ProgramChangeWithBank);
+    RUN_TEST(test_MIDI_UmpEncoder_SysExComplete);
+    RUN_TEST(test_MIDI_UmpEncoder_SysExAcrossPackets);
+    RUN_TEST(test_MIDI_UmpEncoder_UnterminatedSysExIsClosed);
+    RUN_TEST(test_MIDI_UmpEncoder_OtherTypesIgnored);
+    RUN_TEST(test_MIDI_UmpEncoder_RoundTripWithConverter);
+
+    return UNITY_END();
+}
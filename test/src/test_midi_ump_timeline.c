@@ -0,0 +1,169 @@
+#include "test_common.h"
+#include <string.h>
+
+// Include the header file
+#include "midi_ump_timeline.h"
+
+#define LOOKAHEAD_US 2000U
+
+static MidiUmpTimeline_t timeline;
+
+static const uint32_t note_on[4] = {0x20903C64, 0, 0, 0};
+static const uint32_t note_off[4] = {0x20803C40, 0, 0, 0};
+static const uint32_t clock[4] = {0x10F80000, 0, 0, 0};
+
+// Push a UMP Utility message (status 0x0-0x4) carrying a 16 / 20-bit value
+static void PushUtility(uint8_t status, uint32_t value, uint32_t now)
+{
+    uint32_t ump[4] = {((uint32_t)status << 20) | value, 0, 0, 0};
+    TEST_ASSERT_TRUE(MIDI_UmpTimeline_Push(&timeline, ump, now));
+}
+
+static uint32_t NextTime(void)
+{
+    uint32_t time = 0;
+    TEST_ASSERT_TRUE(MIDI_UmpTimeline_NextTime(&timeline, &time));
+    return time;
+}
+
+void setUp(void)
+{
+    MIDI_UmpTimeline_Init(&timeline, LOOKAHEAD_US);
+}
+
+void tearDown(void)
+{
+}
+
+void test_MIDI_UmpTimeline_UntimedDueAtOnce(void)
+{
+    TEST_ASSERT_NULL(MIDI_UmpTimeline_Peek(&timeline, 1000));
+
+    TEST_ASSERT_TRUE(MIDI_UmpTimeline_Push(&timeline, note_on, 1000));
+    TEST_ASSERT_TRUE(MIDI_UmpTimeline_Push(&timeline, note_off, 1000));
+    TEST_ASSERT_EQUAL_UINT32(1000, NextTime());
+
+    const uint32_t *ump = MIDI_UmpTimeline_Peek(&timeline, 1000);
+    TEST_ASSERT_NOT_NULL(ump);
+    TEST_ASSERT_EQUAL_HEX32(note_on[0], ump[0]);
+    MIDI_UmpTimeline_Pop(&timeline);
+    TEST_ASSERT_EQUAL_HEX32(note_off[0], MIDI_UmpTimeline_Peek(&timeline, 1000)[0]);
+    MIDI_UmpTimeline_Pop(&timeline);
+    TEST_ASSERT_FALSE(MIDI_UmpTimeline_NextTime(&timeline, &(uint32_t){0}));
+}
+
+void test_MIDI_UmpTimeline_UtilityNotQueued(void)
+{
+    PushUtility(0x0, 0, 1000);       // NOOP
+    PushUtility(0x3, 96, 1000);      // DCTPQ
+    TEST_ASSERT_EQUAL_UINT32(0, timeline.count);
+}
+
+void test_MIDI_UmpTimeline_JrTimestampsRemoveJitter(void)
+{
+    // First timestamp: sender time 1000 arrives at local 64000 (JR 2000)
+    PushUtility(0x2, 1000, 64000);
+    MIDI_UmpTimeline_Push(&timeline, note_on, 64000);
+    TEST_ASSERT_EQUAL_UINT32(64000 + LOOKAHEAD_US, NextTime());
+    MIDI_UmpTimeline_Pop(&timeline);
+
+    // 10.24 ms later at the sender, but delivered 900 us late by USB
+    PushUtility(0x2, 1000 + 320, 64000 + 10240 + 900);
+    MIDI_UmpTimeline_Push(&timeline, note_off, 64000 + 10240 + 900);
+    TEST_ASSERT_NULL(MIDI_UmpTimeline_Peek(&timeline, 64000 + 10240 + 900));
+    TEST_ASSERT_EQUAL_UINT32(64000 + 10240 + LOOKAHEAD_US, NextTime());
+    TEST_ASSERT_EQUAL_UINT32(0, timeline.late);
+}
+
+void test_MIDI_UmpTimeline_JrClockSetsOffset(void)
+{
+    // Two JR Clocks: the second arrives with 320 us less delay and wins
+    PushUtility(0x1, 100, 100 * 32 + 640);
+    PushUtility(0x1, 200, 200 * 32 + 320);
+
+    // A message stamped at sender time 300 arriving late keeps the clock offset
+    PushUtility(0x2, 300, 300 * 32 + 1500);
+    MIDI_UmpTimeline_Push(&timeline, note_on, 300 * 32 + 1500);
+    TEST_ASSERT_EQUAL_UINT32(300 * 32 + 320 + LOOKAHEAD_US, NextTime());
+}
+
+void test_MIDI_UmpTimeline_LateCountedAndSentAtOnce(void)
+{
+    PushUtility(0x1, 1000, 32000);
+
+    // Stamped 10 ms before the clock: behind by more than the look-ahead
+    PushUtility(0x2, 1000 - 10000 / 32, 32000);
+    MIDI_UmpTimeline_Push(&timeline, note_on, 32000);
+    TEST_ASSERT_EQUAL_UINT32(1, timeline.late);
+    TEST_ASSERT_NOT_NULL(MIDI_UmpTimeline_Peek(&timeline, 32000));
+
+    // The timestamp applied to one message only
+    MIDI_UmpTimeline_Push(&timeline, note_off, 32000);
+    TEST_ASSERT_EQUAL_UINT32(1, timeline.late);
+}
+
+void test_MIDI_UmpTimeline_DeltaClockstamps(void)
+{
+    // Delta Clockstamps before DCTPQ have no unit and are ignored
+    PushUtility(0x4, 10, 1000);
+    MIDI_UmpTimeline_Push(&timeline, note_on, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1000, NextTime());
+    MIDI_UmpTimeline_Pop(&timeline);
+
+    // 96 ticks per quarter at 120 BPM: one tick is 5208 us
+    PushUtility(0x3, 96, 1000);
+    PushUtility(0x4, 0, 1000);
+    MIDI_UmpTimeline_Push(&timeline, note_on, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1000 + LOOKAHEAD_US, NextTime());
+
+    // The next delta counts from the previous message, not from arrival
+    PushUtility(0x4, 48, 1500);
+    MIDI_UmpTimeline_Push(&timeline, note_off, 1500);
+    MIDI_UmpTimeline_Pop(&timeline);
+    TEST_ASSERT_EQUAL_UINT32(1000 + LOOKAHEAD_US + 250000, NextTime());
+}
+
+void test_MIDI_UmpTimeline_KeepsTimeOrder(void)
+{
+    PushUtility(0x2, 1000, 32000);
+    MIDI_UmpTimeline_Push(&timeline, note_on, 32000);   // Due at 34000
+
+    // Untimed goes before the future message
+    MIDI_UmpTimeline_Push(&timeline, clock, 33000);
+    TEST_ASSERT_EQUAL_HEX32(clock[0], MIDI_UmpTimeline_Peek(&timeline, 33000)[0]);
+    MIDI_UmpTimeline_Pop(&timeline);
+    TEST_ASSERT_NULL(MIDI_UmpTimeline_Peek(&timeline, 33999));
+
+    // ... but never before a message that is already due
+    MIDI_UmpTimeline_Push(&timeline, note_off, 34500);
+    TEST_ASSERT_EQUAL_HEX32(note_on[0], MIDI_UmpTimeline_Peek(&timeline, 34500)[0]);
+    MIDI_UmpTimeline_Pop(&timeline);
+    TEST_ASSERT_EQUAL_HEX32(note_off[0], MIDI_UmpTimeline_Peek(&timeline, 34500)[0]);
+}
+
+void test_MIDI_UmpTimeline_FullRefuses(void)
+{
+    for (int i = 0; i < MIDI_UMP_TIMELINE_SIZE; i++) {
+        TEST_ASSERT_TRUE(MIDI_UmpTimeline_Push(&timeline, note_on, 1000));
+    }
+    TEST_ASSERT_FALSE(MIDI_UmpTimeline_Push(&timeline, note_off, 1000));
+
+    // Utility messages need no room
+    PushUtility(0x3, 96, 1000);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_MIDI_UmpTimeline_UntimedDueAtOnce);
+    RUN_TEST(test_MIDI_UmpTimeline_UtilityNotQueued);
+    RUN_TEST(test_MIDI_UmpTimeline_JrTimestampsRemoveJitter);
+    RUN_TEST(test_MIDI_UmpTimeline_JrClockSetsOffset);
+    RUN_TEST(test_MIDI_UmpTimeline_LateCountedAndSentAtOnce);
+    RUN_TEST(test_MIDI_UmpTimeline_DeltaClockstamps);
+    RUN_TEST(test_MIDI_UmpTimeline_KeepsTimeOrder);
+    RUN_TEST(test_MIDI_UmpTimeline_FullRefuses);
+
+    return UNITY_END();
+}
@@ -0,0 +1,189 @@
+#include "test_common.h"
+#include "mock_freertos.h"
+#include "mock_uart.h"
+#include <string.h>
+
+// Include the header files
+#include "uart_tx.h"
+#include "midi_common.h"
+
+static void Complete(void)
+{
+    BaseType_t woken = pdFALSE;
+    MockUART_CompleteTransfer();
+    UART_TX_CompleteFromISR(&woken);
+}
+
+void setUp(void)
+{
+    MockUART_Reset();
+    UART_TX_Init();
+    memset(&midi_stats, 0, sizeof(midi_stats));
+}
+
+void tearDown(void)
+{
+}
+
+void test_UART_TX_WriteStartsTransfer(void)
+{
+    const uint8_t note_on[] = {0x90, 0x3C, 0x64};
+
+    TEST_ASSERT_EQUAL(pdTRUE, UART_TX_Write(note_on, 3));
+    TEST_ASSERT_EQUAL_UINT32(1, MockUART_GetTransferCount());
+    TEST_ASSERT_EQUAL_UINT16(3, MockUART_GetTransferLength(0));
+    TEST_ASSERT_EQUAL_UINT16(3, UART_TX_Pending());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(note_on, MockUART_GetSent(), 3);
+}
+
+void test_UART_TX_WritesQueueWhileBusyAndChain(void)
+{
+    const uint8_t note_on[] = {0x90, 0x3C, 0x64};
+    const uint8_t program[] = {0xC0, 0x05};
+    const uint8_t clock = 0xF8;
+
+    UART_TX_Write(note_on, 3);
+    UART_TX_Write(program, 2);
+    UART_TX_Write(&clock, 1);
+    TEST_ASSERT_EQUAL_UINT32(1, MockUART_GetTransferCount());
+    TEST_ASSERT_EQUAL_UINT16(6, UART_TX_Pending());
+
+    // Everything queued behind the first transfer goes out as one span
+    Complete();
+    TEST_ASSERT_EQUAL_UINT32(2, MockUART_GetTransferCount());
+    TEST_ASSERT_EQUAL_UINT16(3, MockUART_GetTransferLength(1));
+    TEST_ASSERT_EQUAL_UINT16(3, UART_TX_Pending());
+
+    Complete();
+    TEST_ASSERT_EQUAL_UINT32(2, MockUART_GetTransferCount());
+    TEST_ASSERT_EQUAL_UINT16(0, UART_TX_Pending());
+
+    const uint8_t expected[] = {0x90, 0x3C, 0x64, 0xC0, 0x05, 0xF8};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, MockUART_GetSent(), sizeof(expected));
+}
+
+void test_UART_TX_ChainsAcrossWrap(void)
+{
+    uint8_t data[UART_TX_RING_SIZE];
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)i;
+    }
+
+    // Move the ring indices close to the end
+    UART_TX_Write(data, UART_TX_RING_SIZE - 12);
+    Complete();
+
+    // 20 bytes cross the end of the buffer: two spans, in order
+    UART_TX_Write(data, 1);
+    UART_TX_Write(&data[1], 19);
+    Complete();
+    TEST_ASSERT_EQUAL_UINT16(11, MockUART_GetTransferLength(2));
+    Complete();
+    TEST_ASSERT_EQUAL_UINT16(8, MockUART_GetTransferLength(3));
+    Complete();
+    TEST_ASSERT_EQUAL_UINT16(0, UART_TX_Pending());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, &MockUART_GetSent()[UART_TX_RING_SIZE - 12], 20);
+}
+
+void test_UART_TX_FullRejectsWholeMessage(void)
+{
+    uint8_t data[UART_TX_RING_SIZE];
+    memset(data, 0x7F, sizeof(data));
+
+    TEST_ASSERT_EQUAL(pdTRUE, UART_TX_Write(data, UART_TX_RING_SIZE - 1));
+    TEST_ASSERT_EQUAL(pdFALSE, UART_TX_Write(data, 2));
+    TEST_ASSERT_EQUAL_UINT16(UART_TX_RING_SIZE - 1, UART_TX_Pending());
+    TEST_ASSERT_EQUAL(pdTRUE, UART_TX_Write(data, 1));
+    TEST_ASSERT_EQUAL(pdFALSE, UART_TX_Write(data, 0));
+}
+
+void test_UART_TX_StartFailureIsRetried(void)
+{
+    const uint8_t note_on[] = {0x90, 0x3C, 0x64};
+    const uint8_t note_off[] = {0x80, 0x3C, 0x00};
+
+    MockUART_SetTransmitStatus(HAL_ERROR);
+    TEST_ASSERT_EQUAL(pdTRUE, UART_TX_Write(note_on, 3));
+    TEST_ASSERT_EQUAL_UINT32(0, MockUART_GetTransferCount());
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.uart_tx_errors);
+
+    // The next write sends both messages
+    MockUART_SetTransmitStatus(HAL_OK);
+    UART_TX_Write(note_off, 3);
+    TEST_ASSERT_EQUAL_UINT32(1, MockUART_GetTransferCount());
+    TEST_ASSERT_EQUAL_UINT16(6, MockUART_GetTransferLength(0));
+}
+
+void test_UART_TX_ErrorSkipsAbortedSpan(void)
+{
+    const uint8_t note_on[] = {0x90, 0x3C, 0x64};
+    const uint8_t clock = 0xF8;
+    BaseType_t woken = pdFALSE;
+
+    UART_TX_Write(note_on, 3);
+    UART_TX_Write(&clock, 1);
+
+    // An error that leaves the transfer running is ignored
+    UART_TX_ErrorFromISR(&woken);
+    TEST_ASSERT_EQUAL_UINT32(0, midi_stats.uart_tx_errors);
+
+    // An aborted transfer is dropped and the chain continues
+    huart2.gState = HAL_UART_STATE_READY;
+    UART_TX_ErrorFromISR(&woken);
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.uart_tx_errors);
+    TEST_ASSERT_EQUAL_UINT32(2, MockUART_GetTransferCount());
+    TEST_ASSERT_EQUAL_UINT16(1, UART_TX_Pending());
+}
+
+void test_UART_TX_RunningStatusAcrossWrites(void)
+{
+    const uint8_t cc1[] = {0xB0, 0x01, 0x10};
+    const uint8_t cc2[] = {0xB0, 0x01, 0x20};
+    const uint8_t expected[] = {0xB0, 0x01, 0x10, 0x01, 0x20};
+    BaseType_t woken = pdFALSE;
+
+    UART_TX_Write(cc1, 3);
+    UART_TX_Write(cc2, 3);
+    TEST_ASSERT_EQUAL_UINT16(5, UART_TX_Pending());
+    TEST_ASSERT_EQUAL_UINT32(1, midi_stats.din_tx_status_saved);
+    Complete();
+    Complete();
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, MockUART_GetSent(), sizeof(expected));
+
+    // After an aborted transfer the status is sent again
+    UART_TX_Write(cc1, 3);
+    huart2.gState = HAL_UART_STATE_READY;
+    UART_TX_ErrorFromISR(&woken);
+    UART_TX_Write(cc2, 3);
+    TEST_ASSERT_EQUAL_UINT16(3, UART_TX_Pending());
+}
+
+void test_UART_TX_WaitPending(void)
+{
+    uint8_t data[16] = {0};
+
+    TEST_ASSERT_EQUAL(pdTRUE, UART_TX_WaitPending(0, 0));
+
+    UART_TX_Write(data, sizeof(data));
+    TEST_ASSERT_EQUAL(pdTRUE, UART_TX_WaitPending(16, 3));
+    TEST_ASSERT_EQUAL(pdFALSE, UART_TX_WaitPending(4, 3));
+
+    Complete();
+    TEST_ASSERT_EQUAL(pdTRUE, UART_TX_WaitPending(0, 3));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_UART_TX_WriteStartsTransfer);
+    RUN_TEST(test_UART_TX_WritesQueueWhileBusyAndChain);
+    RUN_TEST(test_UART_TX_ChainsAcrossWrap);
+    RUN_TEST(test_UART_TX_FullRejectsWholeMessage);
+    RUN_TEST(test_UART_TX_StartFailureIsRetried);
+    RUN_TEST(test_UART_TX_ErrorSkipsAbortedSpan);
+    RUN_TEST(test_UART_TX_RunningStatusAcrossWrites);
+    RUN_TEST(test_UART_TX_WaitPending);
+
+    return UNITY_END();
+}
@@ -1,8 +1,13 @@
 #include "test_common.h"
 #include "ump_discovery.h"
+#include "ump_ring.h"
 #include <string.h>
 
+extern UmpRing_t ump_tx_ring;
+
 void setUp(void) {
+    UMP_Ring_Init(&ump_tx_ring);
+    UMP_ResetProtocol();
 }
 
 void tearDown(void) {
@@ -43,12 +48,79 @@ void test_MIDICI_GenerateMUID_NotBroadcast(void) {
     }
 }
 
+// Send a Stream Configuration Request and return the notification's first word
+static uint32_t RequestStreamConfig(uint8_t protocol, uint8_t jr_flags) {
+    uint32_t request[4] = {0xF0050000 | ((uint32_t)protocol << 8) | jr_flags, 0, 0, 0};
+    uint32_t reply[4] = {0};
+    uint32_t messages;
+    
+    UMP_ProcessStreamMessage(request, 4);
+    TEST_ASSERT_EQUAL_UINT32(4, UMP_Ring_Read(&ump_tx_ring, reply, 4, &messages));
+    return reply[0];
+}
+
+void test_UMP_StreamConfig_SelectsMidi1Protocol(void) {
+    TEST_ASSERT_EQUAL_UINT8(UMP_PROTOCOL_MIDI_2_0, UMP_GetProtocol());
+    
+    TEST_ASSERT_EQUAL_HEX32(0xF0060100, RequestStreamConfig(UMP_PROTOCOL_MIDI_1_0, 0));
+    TEST_ASSERT_EQUAL_UINT8(UMP_PROTOCOL_MIDI_1_0, UMP_GetProtocol());
+    
+    TEST_ASSERT_EQUAL_HEX32(0xF0060200, RequestStreamConfig(UMP_PROTOCOL_MIDI_2_0, 0));
+    TEST_ASSERT_EQUAL_UINT8(UMP_PROTOCOL_MIDI_2_0, UMP_GetProtocol());
+}
+
+void test_UMP_StreamConfig_RefusesUnsupported(void) {
+    // Unknown protocols keep the current one
+    TEST_ASSERT_EQUAL_HEX32(0xF0060200, RequestStreamConfig(0x03, 0));
+    TEST_ASSERT_EQUAL_HEX32(0xF0060103, RequestStreamConfig(UMP_PROTOCOL_MIDI_1_0, 0x03));
+    TEST_ASSERT_TRUE(UMP_GetTxJitterReduction());
+    
+    UMP_ResetProtocol();
+    TEST_ASSERT_EQUAL_UINT8(UMP_PROTOCOL_MIDI_2_0, UMP_GetProtocol());
+    TEST_ASSERT_FALSE(UMP_GetTxJitterReduction());
+    TEST_ASSERT_EQUAL_HEX32(0xF0060200, RequestStreamConfig(0x03, 0));
+}
+
+void test_UMP_StreamConfig_TxJitterReduction(void) {
+    TEST_ASSERT_FALSE(UMP_GetTxJitterReduction());
+    
+    TEST_ASSERT_EQUAL_HEX32(0xF0060201, RequestStreamConfig(UMP_PROTOCOL_MIDI_2_0, 0x01));
+    TEST_ASSERT_TRUE(UMP_GetTxJitterReduction());
+    
+    // Each request sets the JR state again
+    TEST_ASSERT_EQUAL_HEX32(0xF0060200, RequestStreamConfig(UMP_PROTOCOL_MIDI_2_0, 0));
+    TEST_ASSERT_FALSE(UMP_GetTxJitterReduction());
+}
+
+void test_UMP_StreamConfig_RxJitterReduction(void) {
+    // The host may send JR Timestamps to time DIN output
+    TEST_ASSERT_EQUAL_HEX32(0xF0060202, RequestStreamConfig(UMP_PROTOCOL_MIDI_2_0, 0x02));
+    TEST_ASSERT_FALSE(UMP_GetTxJitterReduction());
+    TEST_ASSERT_EQUAL_HEX32(0xF0060200, RequestStreamConfig(UMP_PROTOCOL_MIDI_2_0, 0));
+}
+
+void test_UMP_EndpointInfo_AdvertisesJitterReduction(void) {
+    uint32_t request[4] = {0xF0000101, 0x00000001, 0, 0};
+    uint32_t reply[4] = {0};
+    uint32_t messages;
+    
+    UMP_ProcessStreamMessage(request, 4);
+    TEST_ASSERT_EQUAL_UINT32(4, UMP_Ring_Read(&ump_tx_ring, reply, 4, &messages));
+    TEST_ASSERT_EQUAL_HEX32(0xF0010000, reply[0] & 0xFFFF0000);
+    TEST_ASSERT_EQUAL_HEX32(0x03, reply[1] & 0x03);
+}
+
 int main(void) {
     UNITY_BEGIN();
     
     RUN_TEST(test_MIDICI_GenerateMUID_UniqueValues);
     RUN_TEST(test_MIDICI_GenerateMUID_ValidRange);
     RUN_TEST(test_MIDICI_GenerateMUID_NotBroadcast);
+    RUN_TEST(test_UMP_StreamConfig_SelectsMidi1Protocol);
+    RUN_TEST(test_UMP_StreamConfig_RefusesUnsupported);
+    RUN_TEST(test_UMP_StreamConfig_TxJitterReduction);
+    RUN_TEST(test_UMP_StreamConfig_RxJitterReduction);
+    RUN_TEST(test_UMP_EndpointInfo_AdvertisesJitterReduction);
     
     return UNITY_END();
 }
\ No newline at end of file
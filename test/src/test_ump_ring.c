@@ -0,0 +1,285 @@
+#include "test_common.h"
+#include "mock_freertos.h"
+#include <string.h>
+
+// Include the header file
+#include "ump_ring.h"
+
+static UmpRing_t ring;
+
+void setUp(void)
+{
+    UMP_Ring_Init(&ring);
+    MockFreeRTOS_ResetNotifyCount();
+}
+
+void tearDown(void)
+{
+}
+
+void test_UMP_Ring_InitEmpty(void)
+{
+    uint32_t words[4];
+    uint32_t messages = 99;
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_Ring_Count(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_Ring_Read(&ring, words, 4, &messages));
+    TEST_ASSERT_EQUAL_UINT32(0, messages);
+}
+
+void test_UMP_Ring_PacksBySize(void)
+{
+    const uint32_t clock[4] = {0x10F80000, 0xAAAAAAAA, 0xAAAAAAAA, 0xAAAAAAAA};
+    const uint32_t note[4] = {0x40903C00, 0xC0000000, 0xAAAAAAAA, 0xAAAAAAAA};
+    const uint32_t stream[4] = {0xF0010101, 1, 2, 3};
+    uint32_t out[8];
+    uint32_t messages;
+
+    // Only the words of each message are stored
+    TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, clock));
+    TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, note));
+    TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, stream));
+    TEST_ASSERT_EQUAL_UINT32(7, UMP_Ring_Count(&ring));
+
+    TEST_ASSERT_EQUAL_UINT32(7, UMP_Ring_Read(&ring, out, 8, &messages));
+    TEST_ASSERT_EQUAL_UINT32(3, messages);
+    TEST_ASSERT_EQUAL_HEX32(0x10F80000, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x40903C00, out[1]);
+    TEST_ASSERT_EQUAL_HEX32(0xC0000000, out[2]);
+    TEST_ASSERT_EQUAL_HEX32(0xF0010101, out[3]);
+    TEST_ASSERT_EQUAL_HEX32(3, out[6]);
+}
+
+void test_UMP_Ring_ReadStopsAtWholeMessage(void)
+{
+    const uint32_t note[2] = {0x40903C00, 0xC0000000};
+    uint32_t out[16];
+    uint32_t messages;
+
+    for (int i = 0; i < 9; i++) {
+        UMP_Ring_Write(&ring, note);
+    }
+
+    // A 64-byte packet takes 8 messages of 2 words; an odd space leaves a word unused
+    TEST_ASSERT_EQUAL_UINT32(16, UMP_Ring_Read(&ring, out, 16, &messages));
+    TEST_ASSERT_EQUAL_UINT32(8, messages);
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_Ring_Read(&ring, out, 1, &messages));
+    TEST_ASSERT_EQUAL_UINT32(0, messages);
+    TEST_ASSERT_EQUAL_UINT32(2, UMP_Ring_Read(&ring, out, 3, &messages));
+    TEST_ASSERT_EQUAL_UINT32(1, messages);
+}
+
+void test_UMP_Ring_FullRejectsWholeMessage(void)
+{
+    const uint32_t note[2] = {0x40903C00, 0xC0000000};
+    const uint32_t stream[4] = {0xF0010101, 1, 2, 3};
+    const uint32_t clock = 0x10F80000;
+
+    for (uint32_t i = 0; i < (UMP_RING_WORDS - 4) / 2; i++) {
+        TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, note));
+    }
+    TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, &clock));
+
+    // Three words left: a 4-word message is refused, not torn
+    TEST_ASSERT_FALSE(UMP_Ring_Write(&ring, stream));
+    TEST_ASSERT_EQUAL_UINT32(UMP_RING_WORDS - 3, UMP_Ring_Count(&ring));
+    TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, &clock));
+}
+
+void test_UMP_Ring_WriteStampedKeepsPair(void)
+{
+    const uint32_t note[2] = {0x40903C00, 0xC0000000};
+    const uint32_t jr = 0x00201234;
+    uint32_t out[UMP_RING_WORDS];
+    uint32_t messages;
+
+    TEST_ASSERT_TRUE(UMP_Ring_WriteStamped(&ring, jr, note));
+    TEST_ASSERT_TRUE(UMP_Ring_WriteStamped(&ring, 0, note));
+    TEST_ASSERT_EQUAL_UINT32(5, UMP_Ring_Read(&ring, out, UMP_RING_WORDS, &messages));
+    TEST_ASSERT_EQUAL_UINT32(3, messages);
+    TEST_ASSERT_EQUAL_HEX32(jr, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x40903C00, out[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x40903C00, out[3]);
+
+    // Room for the message alone: neither is written
+    for (uint32_t i = 0; i < (UMP_RING_WORDS - 2) / 2; i++) {
+        UMP_Ring_Write(&ring, note);
+    }
+    TEST_ASSERT_FALSE(UMP_Ring_WriteStamped(&ring, jr, note));
+    TEST_ASSERT_EQUAL_UINT32(UMP_RING_WORDS - 2, UMP_Ring_Count(&ring));
+    TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, note));
+}
+
+void test_UMP_Ring_WrapAround(void)
+{
+    const uint32_t note[2] = {0x40903C00, 0xC0000000};
+    const uint32_t stream[4] = {0xF0010101, 1, 2, 3};
+    uint32_t out[UMP_RING_WORDS];
+    uint32_t messages;
+
+    // Move the indices to 2 words before the end, then cross it
+    for (uint32_t i = 0; i < (UMP_RING_WORDS - 2) / 2; i++) {
+        UMP_Ring_Write(&ring, note);
+    }
+    UMP_Ring_Read(&ring, out, UMP_RING_WORDS, &messages);
+
+    TEST_ASSERT_TRUE(UMP_Ring_Write(&ring, stream));
+    TEST_ASSERT_EQUAL_UINT32(4, UMP_Ring_Read(&ring, out, UMP_RING_WORDS, &messages));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(stream, out, 4);
+}
+
+void test_UMP_Ring_Clear(void)
+{
+    const uint32_t note[2] = {0x40903C00, 0xC0000000};
+    uint32_t out[2];
+    uint32_t messages;
+
+    UMP_Ring_Write(&ring, note);
+    UMP_Ring_Clear(&ring);
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_Ring_Count(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_Ring_Read(&ring, out, 2, &messages));
+}
+
+void test_UMP_Ring_NotifiesConsumer(void)
+{
+    const uint32_t clock = 0x10F80000;
+
+    // No consumer registered: no notification
+    UMP_Ring_Write(&ring, &clock);
+    TEST_ASSERT_EQUAL_UINT32(0, MockFreeRTOS_GetNotifyCount());
+
+    UMP_Ring_SetConsumer(&ring, xTaskGetCurrentTaskHandle());
+    UMP_Ring_Write(&ring, &clock);
+    TEST_ASSERT_EQUAL_UINT32(1, MockFreeRTOS_GetNotifyCount());
+}
+
+void test_UMP_Ring_WriteFromISR(void)
+{
+    const uint32_t clock = 0x10F80000;
+    const uint32_t stream[4] = {0xF0010101, 1, 2, 3};
+    BaseType_t woken = pdFALSE;
+    uint32_t out[4];
+    uint32_t messages;
+
+    UMP_Ring_SetConsumer(&ring, xTaskGetCurrentTaskHandle());
+    TEST_ASSERT_TRUE(UMP_Ring_WriteFromISR(&ring, &clock, &woken));
+    TEST_ASSERT_EQUAL(pdTRUE, woken);
+    TEST_ASSERT_EQUAL_UINT32(1, MockFreeRTOS_GetNotifyCount());
+
+    for (uint32_t i = 0; i < UMP_RING_WORDS / 4 - 1; i++) {
+        UMP_Ring_Write(&ring, stream);
+    }
+    TEST_ASSERT_FALSE(UMP_Ring_WriteFromISR(&ring, stream, &woken));
+    TEST_ASSERT_EQUAL_UINT32(1, UMP_Ring_Read(&ring, out, 1, &messages));
+    TEST_ASSERT_EQUAL_HEX32(clock, out[0]);
+}
+
+void test_UMP_Ring_WriteWaitTimesOut(void)
+{
+    const uint32_t stream[4] = {0xF0010101, 1, 2, 3};
+
+    for (uint32_t i = 0; i < UMP_RING_WORDS / 4; i++) {
+        UMP_Ring_Write(&ring, stream);
+    }
+    TEST_ASSERT_FALSE(UMP_Ring_WriteWait(&ring, stream, 3));
+}
+
+void test_UMP_Ring_ReadFreshEvictsStale(void)
+{
+    const uint32_t cc[2] = {0x40B00700, 0xFFFFFFFF};       // MIDI 2.0 CC
+    const uint32_t note_off[2] = {0x40803C00, 0x80000000};
+    const uint32_t clock = 0x10F80000;
+    uint32_t out[8];
+    uint32_t messages;
+    uint32_t evicted = 0;
+
+    MockFreeRTOS_SetTickCount(1000);
+    UMP_Ring_Write(&ring, cc);
+    UMP_Ring_Write(&ring, note_off);
+    UMP_Ring_Write(&ring, &clock);
+
+    MockFreeRTOS_SetTickCount(1200);
+    TEST_ASSERT_EQUAL_UINT32(2, UMP_Ring_ReadFresh(&ring, out, 8, &messages, 100, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(1, messages);
+    TEST_ASSERT_EQUAL_HEX32(note_off[0], out[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, evicted);
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_Ring_Count(&ring));
+}
+
+void test_UMP_Ring_ReadFreshKeepsTimestampWithMessage(void)
+{
+    const uint32_t cc[2] = {0x40B00700, 0xFFFFFFFF};       // MIDI 2.0 CC
+    const uint32_t note_off[2] = {0x40803C00, 0x80000000};
+    uint32_t out[8];
+    uint32_t messages;
+    uint32_t evicted = 0;
+
+    MockFreeRTOS_SetTickCount(1000);
+    UMP_Ring_WriteStamped(&ring, 0x00201111, cc);
+    UMP_Ring_WriteStamped(&ring, 0x00202222, note_off);
+
+    // The stale CC takes its JR Timestamp along; the Note Off keeps its own
+    MockFreeRTOS_SetTickCount(1200);
+    TEST_ASSERT_EQUAL_UINT32(3, UMP_Ring_ReadFresh(&ring, out, 8, &messages, 100, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(2, messages);
+    TEST_ASSERT_EQUAL_HEX32(0x00202222, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(note_off[0], out[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, evicted);
+}
+
+void test_UMP_Ring_ReadFreshKeepsTimestampInSameRead(void)
+{
+    const uint32_t note_off[2] = {0x40803C00, 0x80000000};
+    uint32_t out[4];
+    uint32_t messages;
+    uint32_t evicted = 0;
+
+    // A timestamp is not read without the message it times
+    UMP_Ring_WriteStamped(&ring, 0x00201111, note_off);
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_Ring_ReadFresh(&ring, out, 2, &messages, 100, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(3, UMP_Ring_ReadFresh(&ring, out, 4, &messages, 100, &evicted));
+    TEST_ASSERT_EQUAL_UINT32(2, messages);
+}
+
+void test_UMP_IsEvictable(void)
+{
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x00201234));  // JR Timestamp (goes with its message)
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x00101234));  // JR Clock
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x00400100));  // Delta Clockstamp
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x00300060));  // DCTPQ
+    TEST_ASSERT_TRUE(UMP_IsEvictable(0x10FE0000));   // Active Sensing
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x10FA0000));  // Start
+    TEST_ASSERT_TRUE(UMP_IsEvictable(0x20E00040));   // MIDI 1.0 Pitch Bend
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x20803C40));  // MIDI 1.0 Note Off
+    TEST_ASSERT_TRUE(UMP_IsEvictable(0x20B00740));   // MIDI 1.0 CC 7
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x20B0407F));  // MIDI 1.0 Sustain
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x20B06500));  // MIDI 1.0 RPN MSB select
+    TEST_ASSERT_TRUE(UMP_IsEvictable(0x40203C00));   // MIDI 2.0 RPN
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x40403C00));  // MIDI 2.0 relative RPN
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x40503C00));  // MIDI 2.0 relative NRPN
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x40B04000));  // MIDI 2.0 Sustain
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x40C00000));  // MIDI 2.0 Program Change
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0x30160000));  // SysEx7
+    TEST_ASSERT_FALSE(UMP_IsEvictable(0xF0010101));  // UMP Stream
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_UMP_Ring_InitEmpty);
+    RUN_TEST(test_UMP_Ring_PacksBySize);
+    RUN_TEST(test_UMP_Ring_ReadStopsAtWholeMessage);
+    RUN_TEST(test_UMP_Ring_FullRejectsWholeMessage);
+    RUN_TEST(test_UMP_Ring_WriteStampedKeepsPair);
+    RUN_TEST(test_UMP_Ring_WrapAround);
+    RUN_TEST(test_UMP_Ring_Clear);
+    RUN_TEST(test_UMP_Ring_NotifiesConsumer);
+    RUN_TEST(test_UMP_Ring_WriteFromISR);
+    RUN_TEST(test_UMP_Ring_WriteWaitTimesOut);
+    RUN_TEST(test_UMP_Ring_ReadFreshEvictsStale);
+    RUN_TEST(test_UMP_Ring_ReadFreshKeepsTimestampWithMessage);
+    RUN_TEST(test_UMP_Ring_ReadFreshKeepsTimestampInSameRead);
+    RUN_TEST(test_UMP_IsEvictable);
+
+    return UNITY_END();
+}
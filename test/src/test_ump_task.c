@@ -3,12 +3,15 @@
 
 #include <stdint.h>
 #include "unity.h"
+#include "ump_task.h"
+#include "midi2_task.h"
 
 // External declaration of the function to test
 extern uint8_t GetUmpWordCount(uint32_t first_word);
 
 void setUp(void)
 {
+    UMP_Ring_Init(&ump_rx_rt_ring);
 }
 
 void tearDown(void)
@@ -69,26 +72,26 @@ void test_GetUmpWordCount_DataMessages128(void)
 // Test Reserved Types
 void test_GetUmpWordCount_ReservedTypes(void)
 {
-    // All reserved types default to 1 word in the actual implementation
+    // Reserved types have fixed sizes in UMP 1.1, so they can be skipped
     TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(0x60000000));  // Type 6
     TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(0x70000000));  // Type 7
-    TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(0x80000000));  // Type 8
-    TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(0x90000000));  // Type 9
-    TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(0xA0000000));  // Type A
-    TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(0xB0000000));  // Type B
-    TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(0xC0000000));  // Type C
+    TEST_ASSERT_EQUAL_UINT8(2, GetUmpWordCount(0x80000000));  // Type 8
+    TEST_ASSERT_EQUAL_UINT8(2, GetUmpWordCount(0x90000000));  // Type 9
+    TEST_ASSERT_EQUAL_UINT8(2, GetUmpWordCount(0xA0000000));  // Type A
+    TEST_ASSERT_EQUAL_UINT8(3, GetUmpWordCount(0xB0000000));  // Type B
+    TEST_ASSERT_EQUAL_UINT8(3, GetUmpWordCount(0xC0000000));  // Type C
 }
 
 // Test Flex Data and Stream Messages
 void test_GetUmpWordCount_FlexAndStream(void)
 {
-    // Flex Data type = 0xD - defaults to 1 word in actual implementation
+    // Flex Data type = 0xD - 4 words
     uint32_t msg = 0xD0000000;  // Type D
-    TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(msg));
+    TEST_ASSERT_EQUAL_UINT8(4, GetUmpWordCount(msg));
     
-    // Reserved type = 0xE - defaults to 1 word
+    // Reserved type = 0xE - 4 words
     msg = 0xE0000000;  // Type E
-    TEST_ASSERT_EQUAL_UINT8(1, GetUmpWordCount(msg));
+    TEST_ASSERT_EQUAL_UINT8(4, GetUmpWordCount(msg));
     
     // Stream Messages type = 0xF - 4 words
     msg = 0xF0000000;  // Type F
@@ -112,6 +115,80 @@ void test_GetUmpWordCount_EdgeCases(void)
     TEST_ASSERT_EQUAL_UINT8(4, GetUmpWordCount(msg));
 }
 
+// Messages seen by the framer
+static uint32_t *dispatched[16];
+static uint8_t dispatched_words[16];
+static int dispatched_count;
+
+static void RecordDispatch(uint32_t *ump_data, uint8_t word_count)
+{
+    dispatched[dispatched_count] = ump_data;
+    dispatched_words[dispatched_count] = word_count;
+    dispatched_count++;
+}
+
+// Test framing of densely packed messages
+void test_UMP_FrameMessages_SplitsPackedMessages(void)
+{
+    uint32_t words[] = {
+        0x20903C64,                                  // MIDI 1.0 Note On
+        0x40B30700, 0x00000000,                      // MIDI 2.0 CC, value 0
+        0x10F80000,                                  // Timing Clock
+        0xD0100000, 0x00000001, 0x00000002, 0x00000003,  // Flex Data
+        0x30047E7F, 0x06010000,                      // SysEx7
+    };
+    dispatched_count = 0;
+    
+    TEST_ASSERT_EQUAL_UINT32(10, UMP_FrameMessages(words, 10, RecordDispatch));
+    TEST_ASSERT_EQUAL(5, dispatched_count);
+    
+    // Messages are handed over in place
+    TEST_ASSERT_EQUAL_PTR(&words[0], dispatched[0]);
+    TEST_ASSERT_EQUAL_PTR(&words[1], dispatched[1]);
+    TEST_ASSERT_EQUAL_PTR(&words[3], dispatched[2]);
+    TEST_ASSERT_EQUAL_PTR(&words[4], dispatched[3]);
+    TEST_ASSERT_EQUAL_PTR(&words[8], dispatched[4]);
+    TEST_ASSERT_EQUAL_UINT8(1, dispatched_words[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, dispatched_words[1]);
+    TEST_ASSERT_EQUAL_UINT8(1, dispatched_words[2]);
+    TEST_ASSERT_EQUAL_UINT8(4, dispatched_words[3]);
+    TEST_ASSERT_EQUAL_UINT8(2, dispatched_words[4]);
+}
+
+// Test that an incomplete message is left for the next read
+void test_UMP_FrameMessages_LeavesIncompleteMessage(void)
+{
+    uint32_t words[] = {
+        0x20903C64,
+        0xF0010000, 0x00000000,  // First half of a Stream message
+    };
+    dispatched_count = 0;
+    
+    TEST_ASSERT_EQUAL_UINT32(1, UMP_FrameMessages(words, 3, RecordDispatch));
+    TEST_ASSERT_EQUAL(1, dispatched_count);
+    
+    TEST_ASSERT_EQUAL_UINT32(0, UMP_FrameMessages(&words[1], 2, RecordDispatch));
+    TEST_ASSERT_EQUAL(1, dispatched_count);
+}
+
+// Test that realtime read at once reaches the DIN lane in arrival order
+void test_DispatchUmp_RealtimeKeepsOrder(void)
+{
+    uint32_t words[] = {
+        0x10FA0000,  // Start
+        0x10F80000,  // Timing Clock
+        0x10F80000,  // Timing Clock
+        0x10FC0000,  // Stop
+    };
+    uint32_t out[4];
+    uint32_t messages;
+    
+    TEST_ASSERT_EQUAL_UINT32(4, UMP_FrameMessages(words, 4, DispatchUmp));
+    TEST_ASSERT_EQUAL_UINT32(4, UMP_Ring_Read(&ump_rx_rt_ring, out, 4, &messages));
+    TEST_ASSERT_EQUAL_UINT32(4, messages);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(words, out, 4);
+}
+
 int main(void)
 {
     UNITY_BEGIN();
@@ -125,6 +202,9 @@ int main(void)
     RUN_TEST(test_GetUmpWordCount_ReservedTypes);
     RUN_TEST(test_GetUmpWordCount_FlexAndStream);
     RUN_TEST(test_GetUmpWordCount_EdgeCases);
+    RUN_TEST(test_UMP_FrameMessages_SplitsPackedMessages);
+    RUN_TEST(test_UMP_FrameMessages_LeavesIncompleteMessage);
+    RUN_TEST(test_DispatchUmp_RealtimeKeepsOrder);
     
     return UNITY_END();
 }
\ No newline at end of file